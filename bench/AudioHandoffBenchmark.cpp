@@ -0,0 +1,166 @@
+#include "AudioHandoffBenchmark.h"
+
+#include "AudioCaptureImpl_SDL.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/JSON/Array.h>
+
+#include <Poco/Util/Application.h>
+
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Exposes the capture callback, so the benchmark can deliver the audio data itself.
+ */
+class HandoffCapture : public AudioCaptureImpl
+{
+public:
+    HandoffCapture()
+        : AudioCaptureImpl(Poco::Util::Application::instance().config().createView("audio"))
+    {
+    }
+
+    ~HandoffCapture()
+    {
+        StopRecording();
+    }
+
+    /**
+     * @brief Opens the default capture device, but keeps it paused.
+     * @param projectMHandle The projectM instance receiving the audio data.
+     * @param channels The number of channels the delivered data has.
+     */
+    void Open(projectm_handle projectMHandle, unsigned int channels)
+    {
+        _projectMHandle = projectMHandle;
+        // The benchmark delivers float data at the requested rate.
+        _nativeRate = false;
+        _nativeFormat = false;
+        if (!OpenAudioDevice())
+        {
+            throw Poco::IOException("Could not open audio capture device", SDL_GetError());
+        }
+
+        SDL_AudioSpec deliveredSpecs{};
+        deliveredSpecs.freq = static_cast<int>(_requestedSampleFrequency);
+        deliveredSpecs.format = AUDIO_F32SYS;
+        deliveredSpecs.channels = static_cast<Uint8>(channels);
+        deliveredSpecs.samples = static_cast<Uint16>(_requestedSampleCount);
+        SetupConversion(*_device, deliveredSpecs, channels);
+        _channels = channels;
+
+        // Audio is delivered as fast as possible, not in real time, so pacing it to the wall clock makes no sense.
+        _audioSync.SetEnabled(false);
+    }
+
+    /**
+     * @brief Passes samples to the capture callback, holding the device lock like SDL's audio thread does.
+     * @param samples The interleaved samples.
+     * @param sampleCount The number of samples, all channels.
+     */
+    void Deliver(float* samples, size_t sampleCount)
+    {
+        SDL_LockAudioDevice(_device->_deviceID);
+        AudioInputCallback(_device.get(), reinterpret_cast<unsigned char*>(samples), static_cast<int>(sampleCount * sizeof(float)));
+        SDL_UnlockAudioDevice(_device->_deviceID);
+    }
+};
+
+} // namespace
+
+AudioHandoffBenchmark::AudioHandoffBenchmark(bool quick, projectm_handle projectMHandle)
+    : Benchmark(quick)
+    , _projectMHandle(projectMHandle)
+{
+}
+
+const char* AudioHandoffBenchmark::Name() const
+{
+    return "audioHandoff";
+}
+
+Poco::JSON::Object::Ptr AudioHandoffBenchmark::Run()
+{
+    Poco::JSON::Array::Ptr runs = new Poco::JSON::Array;
+
+    // projectM only accepts mono and stereo data.
+    for (unsigned int channels : {1U, 2U})
+    {
+        for (unsigned int chunkFrames : {64U, 256U, 512U, 1024U, 4096U})
+        {
+            runs->add(MeasureHandoff(chunkFrames, channels));
+        }
+    }
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("runs", runs);
+
+    return result;
+}
+
+Poco::JSON::Object::Ptr AudioHandoffBenchmark::MeasureHandoff(unsigned int chunkFrames, unsigned int channels) const
+{
+    constexpr unsigned int sampleRate{44100};
+    constexpr unsigned int fps{60};
+
+    HandoffCapture capture;
+    capture.Open(_projectMHandle, channels);
+
+    std::vector<float> chunk(static_cast<size_t>(chunkFrames) * channels);
+    for (size_t sample = 0; sample < chunk.size(); sample++)
+    {
+        chunk[sample] = static_cast<float>(std::sin(static_cast<double>(sample / channels) * 0.05));
+    }
+
+    // Ten seconds of audio.
+    int videoFrames = Iterations(static_cast<int>(fps) * 10);
+
+    std::vector<double> callbackTimes;
+    std::vector<double> fillTimes;
+    callbackTimes.reserve(videoFrames);
+    fillTimes.reserve(videoFrames);
+
+    uint64_t deliveredFrames{0};
+    Poco::Clock::ClockDiff totalTime{0};
+
+    for (int videoFrame = 1; videoFrame <= videoFrames; videoFrame++)
+    {
+        // Deliver as many chunks as the device would have captured until this video frame.
+        uint64_t targetFrames = static_cast<uint64_t>(videoFrame) * sampleRate / fps;
+        int chunkCount{0};
+
+        Poco::Clock callbackStart;
+        while (deliveredFrames < targetFrames)
+        {
+            capture.Deliver(chunk.data(), chunk.size());
+            deliveredFrames += chunkFrames;
+            chunkCount++;
+        }
+        auto callbackTime = callbackStart.elapsed();
+
+        Poco::Clock fillStart;
+        capture.FillBuffer();
+        auto fillTime = fillStart.elapsed();
+
+        if (chunkCount > 0)
+        {
+            callbackTimes.push_back(static_cast<double>(callbackTime) * 1000.0 / chunkCount);
+        }
+        fillTimes.push_back(static_cast<double>(fillTime));
+        totalTime += callbackTime + fillTime;
+    }
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("chunkFrames", chunkFrames);
+    result->set("channels", channels);
+    result->set("callbackNsPerChunk", Summarize(callbackTimes));
+    result->set("fillBufferUs", Summarize(fillTimes));
+    result->set("megaSamplesPerSecond", totalTime > 0
+                                            ? static_cast<double>(deliveredFrames * channels) / static_cast<double>(totalTime)
+                                            : 0.0);
+
+    return result;
+}
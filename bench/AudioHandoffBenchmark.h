@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <projectM-4/projectM.h>
+
+/**
+ * @brief Measures the throughput of passing captured audio from the SDL audio callback to projectM.
+ *
+ * Audio is delivered in chunks of different sizes, as different drivers and buffer settings would, and drained into
+ * projectM once per 60 FPS frame. Uses a paused device of SDL's "dummy" driver, so only the benchmark delivers data
+ * while the device lock behaves as in a real capture.
+ */
+class AudioHandoffBenchmark : public Benchmark
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param quick If true, runs fewer iterations.
+     * @param projectMHandle The projectM instance receiving the audio data.
+     */
+    AudioHandoffBenchmark(bool quick, projectm_handle projectMHandle);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+
+protected:
+    /**
+     * @brief Streams audio in chunks of the given size and measures the time spent in the callback and FillBuffer().
+     * @param chunkFrames Number of sample frames passed to each callback invocation.
+     * @param channels Number of interleaved channels.
+     * @return The results for this combination.
+     */
+    Poco::JSON::Object::Ptr MeasureHandoff(unsigned int chunkFrames, unsigned int channels) const;
+
+    projectm_handle _projectMHandle{nullptr}; //!< The projectM instance receiving the audio data.
+};
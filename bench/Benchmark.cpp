@@ -0,0 +1,41 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+Benchmark::Benchmark(bool quick)
+    : _quick(quick)
+{
+}
+
+int Benchmark::Iterations(int iterations) const
+{
+    return std::max(1, _quick ? iterations / 10 : iterations);
+}
+
+Poco::JSON::Object::Ptr Benchmark::Summarize(std::vector<double>& samples)
+{
+    Poco::JSON::Object::Ptr summary = new Poco::JSON::Object;
+
+    summary->set("count", samples.size());
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](double percent) {
+        auto index = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(samples.size()))) - 1;
+        return samples[std::min(index, samples.size() - 1)];
+    };
+
+    summary->set("mean", std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()));
+    summary->set("p50", percentile(50.0));
+    summary->set("p99", percentile(99.0));
+    summary->set("min", samples.front());
+    summary->set("max", samples.back());
+
+    return summary;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Poco/JSON/Object.h>
+
+#include <vector>
+
+/**
+ * @brief Base class for a single benchmark of the frontend's hot paths.
+ *
+ * Each benchmark returns its results as a JSON object, which is added to the report under the benchmark's name.
+ */
+class Benchmark
+{
+public:
+    virtual ~Benchmark() = default;
+
+    /**
+     * @brief Returns the benchmark name, used as key in the JSON report and for filtering.
+     * @return The benchmark name.
+     */
+    virtual const char* Name() const = 0;
+
+    /**
+     * @brief Runs the benchmark.
+     * @return The benchmark results.
+     * @throws Poco::Exception if the benchmark could not be run.
+     */
+    virtual Poco::JSON::Object::Ptr Run() = 0;
+
+protected:
+    /**
+     * @brief Constructor.
+     * @param quick If true, all iteration counts are reduced to a tenth, e.g. for smoke testing.
+     */
+    explicit Benchmark(bool quick);
+
+    /**
+     * @brief Returns the number of iterations to run.
+     * @param iterations The number of iterations for a full run.
+     * @return The given iterations, or a tenth of it in quick mode, but at least one.
+     */
+    int Iterations(int iterations) const;
+
+    /**
+     * @brief Calculates the mean, median, 99th percentile, minimum and maximum of a list of measurements.
+     * @param samples The measurements. Sorted in place.
+     * @return A JSON object with the statistics, in the unit of the samples.
+     */
+    static Poco::JSON::Object::Ptr Summarize(std::vector<double>& samples);
+
+    bool _quick{false}; //!< Run fewer iterations.
+};
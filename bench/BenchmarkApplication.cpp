@@ -0,0 +1,205 @@
+// Keep it as the first line, as SDL2 will otherwise redefine
+// BenchmarkApplication::main to BenchmarkApplication::SDL_main
+#define SDL_MAIN_HANDLED
+
+#include "BenchmarkApplication.h"
+
+#include "EventPollingBenchmark.h"
+#include "FPSLimiterBenchmark.h"
+#include "ResamplerBenchmark.h"
+#include "ViewportCheckBenchmark.h"
+
+#ifdef PROJECTMSDL_BENCH_AUDIO_HANDOFF
+#include "AudioHandoffBenchmark.h"
+#include "CaptureModeBenchmark.h"
+#endif
+
+#include "AudioCapture.h"
+#include "ProjectMWrapper.h"
+#include "SDLRenderingWindow.h"
+#include "ZoneManager.h"
+
+#include <Poco/DateTimeFormat.h>
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/Environment.h>
+#include <Poco/FileStream.h>
+#include <Poco/Timestamp.h>
+
+#include <Poco/Util/HelpFormatter.h>
+
+#include <SDL2/SDL_opengl.h>
+
+#include <iostream>
+#include <memory>
+
+BenchmarkApplication::BenchmarkApplication()
+    : Poco::Util::Application()
+{
+    // The audio handoff benchmark needs a capture device that never delivers data on its own.
+    if (!Poco::Environment::has("SDL_AUDIODRIVER"))
+    {
+        Poco::Environment::set("SDL_AUDIODRIVER", "dummy");
+    }
+
+    // Same order as in the application.
+    addSubsystem(new SDLRenderingWindow);
+    addSubsystem(new ProjectMWrapper);
+    addSubsystem(new AudioCapture);
+    addSubsystem(new ZoneManager);
+}
+
+const char* BenchmarkApplication::name() const
+{
+    return "projectMSDL-bench";
+}
+
+void BenchmarkApplication::initialize(Poco::Util::Application& self)
+{
+    _settings->setBool("window.hidden", true);
+    _settings->setBool("window.fullscreen", false);
+    _settings->setBool("window.waitForVerticalSync", false);
+    _settings->setInt("window.width", 1280);
+    _settings->setInt("window.height", 720);
+    _settings->setBool("audio.enabled", false);
+    _settings->setBool("projectM.enableSplash", false);
+    _settings->setString("projectM.presetPath", "");
+    _settings->setInt("projectM.fps", 60);
+
+    config().add(_settings, PRIO_APPLICATION);
+
+    Application::initialize(self);
+}
+
+void BenchmarkApplication::defineOptions(Poco::Util::OptionSet& options)
+{
+    using Poco::Util::Option;
+    using Poco::Util::OptionCallback;
+
+    options.addOption(Option("help", "h", "Display this help text and exit.")
+                          .callback(
+                              OptionCallback<BenchmarkApplication>(this, &BenchmarkApplication::DisplayHelp)));
+
+    options.addOption(Option("output", "o", "Writes the JSON results into the given file instead of standard output.",
+                             false, "<file>", true)
+                          .binding("bench.output", _settings));
+
+    options.addOption(Option("filter", "f", "Only runs benchmarks with the given text in their name.",
+                             false, "<text>", true)
+                          .binding("bench.filter", _settings));
+
+    options.addOption(Option("quick", "q", "Runs a tenth of the iterations, e.g. to check that all benchmarks work.")
+                          .callback(
+                              OptionCallback<BenchmarkApplication>(this, &BenchmarkApplication::QuickMode)));
+}
+
+int BenchmarkApplication::main(POCO_UNUSED const std::vector<std::string>& args)
+{
+    bool quick = config().getBool("bench.quick", false);
+    auto filter = config().getString("bench.filter", "");
+
+    std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    benchmarks.emplace_back(new FPSLimiterBenchmark(quick));
+#ifdef PROJECTMSDL_BENCH_AUDIO_HANDOFF
+    benchmarks.emplace_back(new AudioHandoffBenchmark(quick, getSubsystem<ProjectMWrapper>().ProjectM()));
+    benchmarks.emplace_back(new CaptureModeBenchmark(quick, getSubsystem<ProjectMWrapper>().ProjectM()));
+#endif
+    benchmarks.emplace_back(new ResamplerBenchmark(quick));
+    benchmarks.emplace_back(new EventPollingBenchmark(quick));
+    benchmarks.emplace_back(new ViewportCheckBenchmark(quick));
+
+    Poco::JSON::Object::Ptr results = new Poco::JSON::Object;
+    int exitCode{EXIT_OK};
+
+    for (const auto& benchmark : benchmarks)
+    {
+        if (!filter.empty() && std::string(benchmark->Name()).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        poco_information_f1(logger(), "Running benchmark %s...", std::string(benchmark->Name()));
+
+        try
+        {
+            results->set(benchmark->Name(), benchmark->Run());
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(logger(), "Benchmark %s failed: %s", std::string(benchmark->Name()), ex.displayText());
+
+            Poco::JSON::Object::Ptr failure = new Poco::JSON::Object;
+            failure->set("error", ex.displayText());
+            results->set(benchmark->Name(), failure);
+
+            exitCode = EXIT_SOFTWARE;
+        }
+    }
+
+    Poco::JSON::Object report;
+    report.set("version", std::string(PROJECTMSDL_VERSION));
+    report.set("timestamp", Poco::DateTimeFormatter::format(Poco::Timestamp(), Poco::DateTimeFormat::ISO8601_FORMAT));
+    report.set("quick", quick);
+    report.set("system", SystemInformation());
+    report.set("benchmarks", results);
+
+    auto outputFile = config().getString("bench.output", "");
+    if (outputFile.empty())
+    {
+        report.stringify(std::cout, 4);
+        std::cout << std::endl;
+    }
+    else
+    {
+        try
+        {
+            Poco::FileOutputStream output(outputFile);
+            report.stringify(output, 4);
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(logger(), R"(Could not write results to "%s": %s)", outputFile, ex.displayText());
+            return EXIT_CANTCREAT;
+        }
+    }
+
+    return exitCode;
+}
+
+void BenchmarkApplication::DisplayHelp(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    Poco::Util::HelpFormatter formatter(options());
+
+    formatter.setUsage(config().getString("application.name") + " [options]");
+    formatter.setHeader("\nBenchmarks the projectM SDL frontend's hot paths and prints the results as JSON.");
+
+    formatter.format(std::cerr);
+
+    exit(EXIT_SUCCESS);
+}
+
+void BenchmarkApplication::QuickMode(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _settings->setBool("bench.quick", true);
+}
+
+Poco::JSON::Object::Ptr BenchmarkApplication::SystemInformation() const
+{
+    Poco::JSON::Object::Ptr system = new Poco::JSON::Object;
+
+    system->set("os", Poco::Environment::osName() + " " + Poco::Environment::osVersion());
+    system->set("architecture", Poco::Environment::osArchitecture());
+    system->set("processorCount", Poco::Environment::processorCount());
+
+    SDL_version sdlLoaded;
+    SDL_GetVersion(&sdlLoaded);
+    system->set("sdlVersion", Poco::format("%?d.%?d.%?d", sdlLoaded.major, sdlLoaded.minor, sdlLoaded.patch));
+
+    auto* projectMVersion = projectm_get_version_string();
+    system->set("projectMVersion", std::string(projectMVersion));
+    projectm_free_string(projectMVersion);
+
+    auto glRenderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    system->set("glRenderer", std::string(glRenderer ? glRenderer : "unknown"));
+
+    return system;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Poco/JSON/Object.h>
+
+#include <Poco/Util/Application.h>
+#include <Poco/Util/MapConfiguration.h>
+
+/**
+ * @brief Runs the frontend hot path benchmarks and writes the results as JSON.
+ *
+ * Uses the same subsystems as the application, with a hidden window and without audio capture. The user's
+ * configuration file is not loaded, so results only depend on the machine.
+ */
+class BenchmarkApplication : public Poco::Util::Application
+{
+public:
+    BenchmarkApplication();
+
+    const char* name() const override;
+
+protected:
+    void initialize(Application& self) override;
+
+    void defineOptions(Poco::Util::OptionSet& options) override;
+
+    int main(const std::vector<std::string>& args) override;
+
+    /**
+     * @brief Display help and exit.
+     * @param name Unused.
+     * @param value Unused.
+     */
+    void DisplayHelp(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Enables quick mode.
+     * @param name Unused.
+     * @param value Unused.
+     */
+    void QuickMode(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Returns information about the system the benchmarks ran on.
+     * @return A JSON object with the system information.
+     */
+    Poco::JSON::Object::Ptr SystemInformation() const;
+
+    Poco::AutoPtr<Poco::Util::MapConfiguration> _settings{
+        new Poco::Util::MapConfiguration() }; //!< Fixed benchmark settings and command line overrides.
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "RenderLoop.h"
+
+/**
+ * @brief Render loop exposing the per-frame steps, so they can be benchmarked without rendering.
+ */
+class BenchmarkRenderLoop : public RenderLoop
+{
+public:
+    using RenderLoop::RenderLoop;
+
+    using RenderLoop::PollEvents;
+    using RenderLoop::CheckViewportSize;
+
+    /**
+     * @brief Returns the viewport width last seen by CheckViewportSize().
+     * @return The viewport width in pixels.
+     */
+    int RenderWidth() const
+    {
+        return _renderWidth;
+    }
+};
@@ -0,0 +1,154 @@
+#include "CaptureModeBenchmark.h"
+
+#include "AudioCaptureImpl_SDL.h"
+#include "FPSLimiter.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/JSON/Array.h>
+
+#include <Poco/Util/Application.h>
+
+#include <sys/resource.h>
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Exposes the capture mode, so the benchmark can select it without changing the configuration.
+ */
+class ModeCapture : public AudioCaptureImpl
+{
+public:
+    ModeCapture()
+        : AudioCaptureImpl(Poco::Util::Application::instance().config().createView("audio"))
+    {
+    }
+
+    ~ModeCapture()
+    {
+        StopRecording();
+    }
+
+    /**
+     * @brief Opens and starts the default capture device.
+     * @param projectMHandle The projectM instance receiving the audio data.
+     * @param pullMode If true, reads the audio with SDL_DequeueAudio() instead of the callback.
+     */
+    void Open(projectm_handle projectMHandle, bool pullMode)
+    {
+        _projectMHandle = projectMHandle;
+        _pullMode = pullMode;
+        // Latency is measured in samples passed to projectM, so keep the rate and don't add a lookahead.
+        _nativeRate = false;
+        if (!OpenAudioDevice())
+        {
+            throw Poco::IOException("Could not open audio capture device", SDL_GetError());
+        }
+        _audioSync.SetEnabled(false);
+
+        SDL_PauseAudioDevice(_device->_deviceID, false);
+    }
+};
+
+/**
+ * @brief Returns the number of voluntary and involuntary context switches of this process so far.
+ * @return The context switch count.
+ */
+long ContextSwitches()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+} // namespace
+
+CaptureModeBenchmark::CaptureModeBenchmark(bool quick, projectm_handle projectMHandle)
+    : Benchmark(quick)
+    , _projectMHandle(projectMHandle)
+{
+}
+
+const char* CaptureModeBenchmark::Name() const
+{
+    return "captureMode";
+}
+
+Poco::JSON::Object::Ptr CaptureModeBenchmark::Run()
+{
+    Poco::JSON::Array::Ptr runs = new Poco::JSON::Array;
+
+    runs->add(MeasureMode(false));
+    runs->add(MeasureMode(true));
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("runs", runs);
+
+    return result;
+}
+
+Poco::JSON::Object::Ptr CaptureModeBenchmark::MeasureMode(bool pullMode) const
+{
+    constexpr int fps{60};
+    constexpr double sampleRate{44100.0};
+
+    ModeCapture capture;
+    capture.Open(_projectMHandle, pullMode);
+
+    FPSLimiter limiter;
+    limiter.TargetFPS(fps);
+
+    // Let the device start delivering data before measuring.
+    for (int frame = 0; frame < fps / 2; frame++)
+    {
+        limiter.StartFrame();
+        capture.FillBuffer();
+        limiter.EndFrame();
+    }
+
+    // Ten seconds of real-time capture.
+    int videoFrames = Iterations(fps * 10);
+
+    std::vector<double> latencies;
+    latencies.reserve(videoFrames);
+    int emptyFrames{0};
+
+    auto startSwitches = ContextSwitches();
+    auto startCpuTime = std::clock();
+    Poco::Clock start;
+
+    for (int frame = 0; frame < videoFrames; frame++)
+    {
+        limiter.StartFrame();
+
+        // All samples passed to projectM were captured since the last frame, so the oldest is as old as their length.
+        auto frames = capture.FillBuffer();
+        if (frames > 0)
+        {
+            latencies.push_back(static_cast<double>(frames) * 1000.0 / sampleRate);
+        }
+        else
+        {
+            emptyFrames++;
+        }
+
+        limiter.EndFrame();
+    }
+
+    auto wallTime = static_cast<double>(start.elapsed()) / 1000000.0;
+    auto cpuTime = static_cast<double>(std::clock() - startCpuTime) / CLOCKS_PER_SEC;
+    auto switches = ContextSwitches() - startSwitches;
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("mode", std::string(pullMode ? "pull" : "callback"));
+    result->set("cpuPercent", wallTime > 0.0 ? cpuTime * 100.0 / wallTime : 0.0);
+    result->set("contextSwitchesPerSecond", wallTime > 0.0 ? static_cast<double>(switches) / wallTime : 0.0);
+    result->set("latencyMs", Summarize(latencies));
+    result->set("emptyFrames", emptyFrames);
+
+    return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <projectM-4/projectM.h>
+
+/**
+ * @brief Compares the CPU use and latency of the SDL capture callback with pull mode.
+ *
+ * Captures from the default device in real time for each mode, draining the audio once per 60 FPS frame like the
+ * render loop does. Reports the process CPU time relative to the wall time, the context switches per second and the
+ * age of the oldest sample passed to projectM in each frame. With SDL's "dummy" driver, only the frontend's own
+ * overhead is measured, so set SDL_AUDIODRIVER to the platform's driver to measure a real device.
+ */
+class CaptureModeBenchmark : public Benchmark
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param quick If true, runs fewer iterations.
+     * @param projectMHandle The projectM instance receiving the audio data.
+     */
+    CaptureModeBenchmark(bool quick, projectm_handle projectMHandle);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+
+protected:
+    /**
+     * @brief Captures audio in one mode and measures CPU use and latency.
+     * @param pullMode If true, uses pull mode, otherwise the capture callback.
+     * @return The results for this mode.
+     */
+    Poco::JSON::Object::Ptr MeasureMode(bool pullMode) const;
+
+    projectm_handle _projectMHandle{nullptr}; //!< The projectM instance receiving the audio data.
+};
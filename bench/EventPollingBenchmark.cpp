@@ -0,0 +1,129 @@
+#include "EventPollingBenchmark.h"
+
+#include "AudioCapture.h"
+#include "BenchmarkRenderLoop.h"
+#include "ProjectMWrapper.h"
+#include "SDLRenderingWindow.h"
+
+#include <Poco/Clock.h>
+
+#include <Poco/Util/Application.h>
+
+EventPollingBenchmark::EventPollingBenchmark(bool quick)
+    : Benchmark(quick)
+{
+}
+
+const char* EventPollingBenchmark::Name() const
+{
+    return "pollEvents";
+}
+
+Poco::JSON::Object::Ptr EventPollingBenchmark::Run()
+{
+    auto& app = Poco::Util::Application::instance();
+
+    BenchmarkRenderLoop mainLoop;
+    BenchmarkRenderLoop zoneLoop(app.getSubsystem<AudioCapture>(),
+                                 app.getSubsystem<ProjectMWrapper>(),
+                                 app.getSubsystem<SDLRenderingWindow>());
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+
+    for (const auto& kind : {"mouseMotion", "keyboard", "mouseButtons"})
+    {
+        Poco::JSON::Object::Ptr floods = new Poco::JSON::Object;
+
+        for (int count : {100, 1000, 10000})
+        {
+            auto events = CreateFlood(kind, count);
+
+            Poco::JSON::Object::Ptr flood = new Poco::JSON::Object;
+            flood->set("sdlQueueNsPerEvent", MeasureFlood(mainLoop, events, true));
+            flood->set("zoneQueueNsPerEvent", MeasureFlood(zoneLoop, events, false));
+
+            floods->set(std::to_string(count), flood);
+        }
+
+        result->set(kind, floods);
+    }
+
+    return result;
+}
+
+std::vector<SDL_Event> EventPollingBenchmark::CreateFlood(const std::string& kind, int count)
+{
+    std::vector<SDL_Event> events(count);
+
+    for (int index = 0; index < count; index++)
+    {
+        auto& event = events[index];
+        SDL_zero(event);
+
+        if (kind == "keyboard")
+        {
+            // Modifier keys only update the key states.
+            event.type = index % 2 ? SDL_KEYUP : SDL_KEYDOWN;
+            event.key.state = index % 2 ? SDL_RELEASED : SDL_PRESSED;
+            event.key.keysym.sym = SDLK_LSHIFT;
+            event.key.keysym.scancode = SDL_SCANCODE_LSHIFT;
+        }
+        else if (kind == "mouseButtons")
+        {
+            // Left clicks without shift pressed don't add waveforms.
+            event.type = index % 2 ? SDL_MOUSEBUTTONUP : SDL_MOUSEBUTTONDOWN;
+            event.button.button = SDL_BUTTON_LEFT;
+            event.button.state = index % 2 ? SDL_RELEASED : SDL_PRESSED;
+            event.button.x = index % 800;
+            event.button.y = index % 600;
+        }
+        else
+        {
+            event.type = SDL_MOUSEMOTION;
+            event.motion.x = index % 800;
+            event.motion.y = index % 600;
+            event.motion.xrel = 1;
+            event.motion.yrel = 1;
+        }
+    }
+
+    return events;
+}
+
+Poco::JSON::Object::Ptr EventPollingBenchmark::MeasureFlood(BenchmarkRenderLoop& renderLoop,
+                                                            const std::vector<SDL_Event>& events,
+                                                            bool sdlQueue) const
+{
+    int iterations = Iterations(20);
+
+    std::vector<double> times;
+    times.reserve(iterations);
+
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        if (sdlQueue)
+        {
+            SDL_PumpEvents();
+            SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+            for (auto event : events)
+            {
+                SDL_PushEvent(&event);
+            }
+        }
+        else
+        {
+            for (const auto& event : events)
+            {
+                renderLoop.PushEvent(event);
+            }
+        }
+
+        Poco::Clock start;
+        renderLoop.PollEvents();
+        auto elapsed = start.elapsed();
+
+        times.push_back(static_cast<double>(elapsed) * 1000.0 / static_cast<double>(events.size()));
+    }
+
+    return Summarize(times);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <SDL2/SDL.h>
+
+#include <string>
+#include <vector>
+
+class BenchmarkRenderLoop;
+
+/**
+ * @brief Measures RenderLoop::PollEvents() when flooded with synthetic input events.
+ *
+ * Both event paths are measured: the main loop polling SDL's event queue, and a render zone loop handling events
+ * pushed by the main thread.
+ */
+class EventPollingBenchmark : public Benchmark
+{
+public:
+    explicit EventPollingBenchmark(bool quick);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+
+protected:
+    /**
+     * @brief Creates a flood of events of a single kind. None of them triggers expensive actions.
+     * @param kind The event kind, "mouseMotion", "keyboard" or "mouseButtons".
+     * @param count The number of events.
+     * @return The events.
+     */
+    static std::vector<SDL_Event> CreateFlood(const std::string& kind, int count);
+
+    /**
+     * @brief Measures handling a flood of events.
+     * @param renderLoop The loop to measure.
+     * @param events The events to handle in each iteration.
+     * @param sdlQueue If true, the events are pushed into SDL's event queue, otherwise passed via PushEvent().
+     * @return The time per event in nanoseconds.
+     */
+    Poco::JSON::Object::Ptr MeasureFlood(BenchmarkRenderLoop& renderLoop, const std::vector<SDL_Event>& events,
+                                         bool sdlQueue) const;
+};
@@ -0,0 +1,85 @@
+#include "FPSLimiterBenchmark.h"
+
+#include "FPSLimiter.h"
+
+#include <Poco/Clock.h>
+
+#include <numeric>
+#include <string>
+
+FPSLimiterBenchmark::FPSLimiterBenchmark(bool quick)
+    : Benchmark(quick)
+{
+}
+
+const char* FPSLimiterBenchmark::Name() const
+{
+    return "fpsLimiter";
+}
+
+Poco::JSON::Object::Ptr FPSLimiterBenchmark::Run()
+{
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+
+    // Overhead of the bookkeeping alone, without any delays.
+    {
+        FPSLimiter limiter;
+        limiter.TargetFPS(0);
+
+        int frames = Iterations(1000000);
+
+        Poco::Clock start;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            limiter.StartFrame();
+            limiter.EndFrame();
+        }
+        auto elapsed = start.elapsed();
+
+        result->set("overheadNsPerFrame", static_cast<double>(elapsed) * 1000.0 / frames);
+    }
+
+    Poco::JSON::Object::Ptr accuracy = new Poco::JSON::Object;
+    for (int fps : {30, 60, 120, 144})
+    {
+        accuracy->set(std::to_string(fps), MeasureAccuracy(fps));
+    }
+    result->set("accuracy", accuracy);
+
+    return result;
+}
+
+Poco::JSON::Object::Ptr FPSLimiterBenchmark::MeasureAccuracy(int fps) const
+{
+    FPSLimiter limiter;
+    limiter.TargetFPS(fps);
+
+    // Five seconds per target.
+    int frames = Iterations(fps * 5);
+
+    std::vector<double> intervals;
+    intervals.reserve(frames);
+
+    Poco::Clock frameStart;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        limiter.StartFrame();
+        limiter.EndFrame();
+
+        Poco::Clock frameEnd;
+        intervals.push_back(static_cast<double>(frameEnd - frameStart) / 1000.0);
+        frameStart = frameEnd;
+    }
+
+    double totalTime = std::accumulate(intervals.begin(), intervals.end(), 0.0);
+    double targetInterval = 1000.0 / fps;
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("targetIntervalMs", targetInterval);
+    result->set("achievedFPS", totalTime > 0.0 ? frames * 1000.0 / totalTime : 0.0);
+    result->set("reportedFPS", limiter.FPS());
+    result->set("meanErrorMs", totalTime / frames - targetInterval);
+    result->set("intervalMs", Summarize(intervals));
+
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Benchmark.h"
+
+/**
+ * @brief Measures the overhead of FPSLimiter and how accurately it hits a range of target frame rates.
+ */
+class FPSLimiterBenchmark : public Benchmark
+{
+public:
+    explicit FPSLimiterBenchmark(bool quick);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+
+protected:
+    /**
+     * @brief Runs empty frames with the limiter set to the given target and measures the actual frame intervals.
+     * @param fps The target frames per second.
+     * @return The accuracy results for this target.
+     */
+    Poco::JSON::Object::Ptr MeasureAccuracy(int fps) const;
+};
@@ -0,0 +1,200 @@
+#include "ResamplerBenchmark.h"
+
+#include "PolyphaseResampler.h"
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/JSON/Array.h>
+
+#include <cmath>
+
+namespace {
+
+constexpr unsigned int OutputRate{44100};
+constexpr unsigned int Channels{2};
+constexpr double Pi{3.14159265358979323846};
+
+} // namespace
+
+ResamplerBenchmark::ResamplerBenchmark(bool quick)
+    : Benchmark(quick)
+{
+}
+
+const char* ResamplerBenchmark::Name() const
+{
+    return "resampler";
+}
+
+Poco::JSON::Object::Ptr ResamplerBenchmark::Run()
+{
+    Poco::JSON::Array::Ptr runs = new Poco::JSON::Array;
+
+    for (unsigned int inputRate : {48000U, 96000U})
+    {
+        for (unsigned int taps : {0U, 16U, 32U, 64U})
+        {
+            runs->add(MeasureConverter(inputRate, taps));
+        }
+    }
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("runs", runs);
+
+    return result;
+}
+
+Poco::JSON::Object::Ptr ResamplerBenchmark::MeasureConverter(unsigned int inputRate, unsigned int taps) const
+{
+    // Speed, with a full minute of audio.
+    int64_t elapsedTime{0};
+    int seconds = Iterations(60);
+    auto output = ConvertTone(inputRate, taps, 1000.0, seconds, elapsedTime);
+    auto outputFrames = output.size() / Channels;
+
+    // Quality, using a tone in the passband and one between the output and input Nyquist frequencies.
+    int64_t unused{0};
+    auto snr = ToneSNR(ConvertTone(inputRate, taps, 1000.0, 2, unused), 1000.0);
+    auto aliasFrequency = (OutputRate / 2.0 + inputRate / 2.0) / 2.0;
+    auto aliasLevel = SignalLevel(ConvertTone(inputRate, taps, aliasFrequency, 2, unused));
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+    result->set("converter", std::string(taps > 0 ? "polyphase" : "sdl"));
+    result->set("inputRate", inputRate);
+    result->set("taps", taps);
+    result->set("nsPerOutputFrame", outputFrames > 0
+                                        ? static_cast<double>(elapsedTime) * 1000.0 / static_cast<double>(outputFrames)
+                                        : 0.0);
+    result->set("realtimeFactor", elapsedTime > 0
+                                      ? static_cast<double>(seconds) * 1000000.0 / static_cast<double>(elapsedTime)
+                                      : 0.0);
+    result->set("toneSnrDb", snr);
+    result->set("aliasFrequencyHz", aliasFrequency);
+    result->set("aliasLevelDb", aliasLevel);
+
+    return result;
+}
+
+std::vector<float> ResamplerBenchmark::ConvertTone(unsigned int inputRate, unsigned int taps, double frequency,
+                                                   int seconds, int64_t& elapsedTime)
+{
+    auto chunkFrames = inputRate / 60;
+    std::vector<float> chunk(static_cast<size_t>(chunkFrames) * Channels);
+    std::vector<float> chunkOutput;
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(OutputRate) * Channels * (seconds + 1));
+
+    PolyphaseResampler resampler;
+    SDL_AudioStream* stream{nullptr};
+    if (taps > 0)
+    {
+        resampler.Configure(inputRate, OutputRate, Channels, taps);
+    }
+    else
+    {
+        stream = SDL_NewAudioStream(AUDIO_F32, Channels, static_cast<int>(inputRate), AUDIO_F32, Channels, OutputRate);
+        if (!stream)
+        {
+            throw Poco::RuntimeException("Could not create SDL audio stream", SDL_GetError());
+        }
+        chunkOutput.resize(static_cast<size_t>(OutputRate) * Channels);
+    }
+
+    elapsedTime = 0;
+    uint64_t position{0};
+    for (unsigned int chunkIndex = 0; chunkIndex < static_cast<unsigned int>(seconds) * 60; chunkIndex++)
+    {
+        for (unsigned int frame = 0; frame < chunkFrames; frame++)
+        {
+            auto sample = static_cast<float>(std::sin(2.0 * Pi * frequency * static_cast<double>(position + frame) / inputRate));
+            chunk[frame * Channels] = sample;
+            chunk[frame * Channels + 1] = sample;
+        }
+        position += chunkFrames;
+
+        Poco::Clock start;
+        size_t frames{0};
+        if (stream)
+        {
+            SDL_AudioStreamPut(stream, chunk.data(), static_cast<int>(chunk.size() * sizeof(float)));
+            auto bytes = SDL_AudioStreamGet(stream, chunkOutput.data(), static_cast<int>(chunkOutput.size() * sizeof(float)));
+            frames = bytes > 0 ? static_cast<size_t>(bytes) / sizeof(float) / Channels : 0;
+        }
+        else
+        {
+            frames = resampler.Process(chunk.data(), chunkFrames, chunkOutput);
+        }
+        elapsedTime += start.elapsed();
+
+        output.insert(output.end(), chunkOutput.begin(), chunkOutput.begin() + static_cast<std::ptrdiff_t>(frames * Channels));
+    }
+
+    if (stream)
+    {
+        SDL_FreeAudioStream(stream);
+    }
+
+    return output;
+}
+
+double ResamplerBenchmark::ToneSNR(const std::vector<float>& output, double frequency)
+{
+    // Fit a * sin + b * cos to the second half, so the result is independent of the converters' delays.
+    auto frames = output.size() / Channels;
+    double sinSin{0.0}, cosCos{0.0}, sinCos{0.0}, signalSin{0.0}, signalCos{0.0};
+    for (size_t frame = frames / 2; frame < frames; frame++)
+    {
+        double phase = 2.0 * Pi * frequency * static_cast<double>(frame) / OutputRate;
+        double sine = std::sin(phase);
+        double cosine = std::cos(phase);
+        double signal = output[frame * Channels];
+        sinSin += sine * sine;
+        cosCos += cosine * cosine;
+        sinCos += sine * cosine;
+        signalSin += signal * sine;
+        signalCos += signal * cosine;
+    }
+
+    double determinant = sinSin * cosCos - sinCos * sinCos;
+    if (determinant == 0.0)
+    {
+        return 0.0;
+    }
+
+    double sineWeight = (signalSin * cosCos - signalCos * sinCos) / determinant;
+    double cosineWeight = (signalCos * sinSin - signalSin * sinCos) / determinant;
+
+    double signalPower{0.0};
+    double noisePower{0.0};
+    for (size_t frame = frames / 2; frame < frames; frame++)
+    {
+        double phase = 2.0 * Pi * frequency * static_cast<double>(frame) / OutputRate;
+        double fitted = sineWeight * std::sin(phase) + cosineWeight * std::cos(phase);
+        double residual = output[frame * Channels] - fitted;
+        signalPower += fitted * fitted;
+        noisePower += residual * residual;
+    }
+
+    return noisePower > 0.0 ? 10.0 * std::log10(signalPower / noisePower) : 200.0;
+}
+
+double ResamplerBenchmark::SignalLevel(const std::vector<float>& output)
+{
+    auto frames = output.size() / Channels;
+    double power{0.0};
+    for (size_t frame = frames / 2; frame < frames; frame++)
+    {
+        power += static_cast<double>(output[frame * Channels]) * output[frame * Channels];
+    }
+
+    auto count = frames - frames / 2;
+    if (count == 0 || power == 0.0)
+    {
+        return -200.0;
+    }
+
+    // A full-scale sine has a mean power of 0.5.
+    return 10.0 * std::log10(power / static_cast<double>(count) / 0.5);
+}
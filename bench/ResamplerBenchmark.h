@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compares the capture resampler against SDL's built-in rate conversion in speed and quality.
+ *
+ * Converts common device rates to projectM's 44.1 kHz with the polyphase resampler at different filter lengths and
+ * with an SDL audio stream, which is what SDL uses when a capture device is opened at a different rate. Quality is
+ * measured as the signal-to-noise ratio of a 1 kHz tone and the attenuation of a tone above the output Nyquist
+ * frequency, which would alias into the audible range.
+ */
+class ResamplerBenchmark : public Benchmark
+{
+public:
+    explicit ResamplerBenchmark(bool quick);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+
+protected:
+    /**
+     * @brief Measures one converter with one input rate.
+     * @param inputRate The input sample rate in Hz.
+     * @param taps Filter taps per phase of the polyphase resampler, or 0 to measure SDL's conversion.
+     * @return The results for this combination.
+     */
+    Poco::JSON::Object::Ptr MeasureConverter(unsigned int inputRate, unsigned int taps) const;
+
+    /**
+     * @brief Converts a stereo sine tone, delivered in chunks of one 60 FPS frame each.
+     * @param inputRate The input sample rate in Hz.
+     * @param taps Filter taps per phase, or 0 for SDL's conversion.
+     * @param frequency The tone frequency in Hz.
+     * @param seconds Length of the tone in seconds.
+     * @param[out] elapsedTime Receives the time spent converting in microseconds.
+     * @return The interleaved stereo output at 44.1 kHz.
+     */
+    static std::vector<float> ConvertTone(unsigned int inputRate, unsigned int taps, double frequency, int seconds,
+                                          int64_t& elapsedTime);
+
+    /**
+     * @brief Calculates the signal-to-noise ratio of a tone, using a least-squares fit of the expected sine.
+     * @param output Interleaved stereo samples at 44.1 kHz. Only the second half of the first channel is used.
+     * @param frequency The tone frequency in Hz.
+     * @return The ratio of the fitted sine's power to the residual power in dB.
+     */
+    static double ToneSNR(const std::vector<float>& output, double frequency);
+
+    /**
+     * @brief Calculates the level of a signal relative to a full-scale sine.
+     * @param output Interleaved stereo samples. Only the second half of the first channel is used.
+     * @return The level in dB.
+     */
+    static double SignalLevel(const std::vector<float>& output);
+};
@@ -0,0 +1,79 @@
+#include "ViewportCheckBenchmark.h"
+
+#include "BenchmarkRenderLoop.h"
+#include "SDLRenderingWindow.h"
+
+#include <Poco/Clock.h>
+
+#include <Poco/Util/Application.h>
+
+ViewportCheckBenchmark::ViewportCheckBenchmark(bool quick)
+    : Benchmark(quick)
+{
+}
+
+const char* ViewportCheckBenchmark::Name() const
+{
+    return "checkViewportSize";
+}
+
+Poco::JSON::Object::Ptr ViewportCheckBenchmark::Run()
+{
+    auto& renderingWindow = Poco::Util::Application::instance().getSubsystem<SDLRenderingWindow>();
+
+    BenchmarkRenderLoop renderLoop;
+    renderLoop.CheckViewportSize();
+
+    Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+
+    // Called every frame, while the size practically never changes.
+    {
+        int calls = Iterations(100000);
+
+        Poco::Clock start;
+        for (int call = 0; call < calls; call++)
+        {
+            renderLoop.CheckViewportSize();
+        }
+        auto elapsed = start.elapsed();
+
+        result->set("unchangedNsPerCall", static_cast<double>(elapsed) * 1000.0 / calls);
+    }
+
+    // Resizes, including reallocating projectM's render targets.
+    {
+        int resizes = Iterations(50);
+
+        std::vector<double> times;
+        times.reserve(resizes);
+
+        for (int resize = 0; resize < resizes; resize++)
+        {
+            if (resize % 2)
+            {
+                renderingWindow.SetSize(1280, 720);
+            }
+            else
+            {
+                renderingWindow.SetSize(1920, 1080);
+            }
+            SDL_PumpEvents();
+
+            int previousWidth = renderLoop.RenderWidth();
+
+            Poco::Clock start;
+            renderLoop.CheckViewportSize();
+            auto elapsed = start.elapsed();
+
+            // Some window systems apply the new size asynchronously. Only count calls which actually resized.
+            if (renderLoop.RenderWidth() != previousWidth)
+            {
+                times.push_back(static_cast<double>(elapsed));
+            }
+        }
+
+        result->set("resizeUs", Summarize(times));
+    }
+
+    return result;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Benchmark.h"
+
+/**
+ * @brief Measures RenderLoop::CheckViewportSize(), both for the common case of an unchanged size and for resizes.
+ */
+class ViewportCheckBenchmark : public Benchmark
+{
+public:
+    explicit ViewportCheckBenchmark(bool quick);
+
+    const char* Name() const override;
+
+    Poco::JSON::Object::Ptr Run() override;
+};
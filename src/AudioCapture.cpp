@@ -1,6 +1,9 @@
 #include "AudioCapture.h"
 
 #include "ProjectMWrapper.h"
+#include "Tracer.h"
+
+#include <Poco/StringTokenizer.h>
 
 #include <Poco/Util/Application.h>
 
@@ -11,24 +14,46 @@ const char* AudioCapture::name() const
 
 void AudioCapture::initialize(Poco::Util::Application& app)
 {
-    _config = app.config().createView("audio");
+    TRACE_ZONE("AudioCapture::initialize", "init");
 
     auto& projectMWrapper = app.getSubsystem<ProjectMWrapper>();
 
-    _impl = std::make_unique<AudioCaptureImpl>();
+    initialize(app.config().createView("audio"), projectMWrapper.ProjectM());
+}
+
+void AudioCapture::initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, projectm_handle projectMHandle)
+{
+    _config = config;
+
+    if (!_config->getBool("enabled", true))
+    {
+        poco_information(_logger, "Audio capture is disabled.");
+        return;
+    }
+
+    _impl = std::make_unique<AudioCaptureImpl>(_config);
 
     auto deviceList = _impl->AudioDeviceList();
     int audioDeviceIndex = GetInitialAudioDeviceIndex(deviceList);
 
     PrintDeviceList(deviceList);
 
-    _impl->StartRecording(projectMWrapper.ProjectM(), audioDeviceIndex);
+    Poco::StringTokenizer devicePriority(_config->getString("devicePriority", ""), ";",
+                                         Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    _impl->SetDevicePriority({devicePriority.begin(), devicePriority.end()});
+
+    _impl->StartRecording(projectMHandle, audioDeviceIndex);
+
+    AddSources(deviceList);
 }
 
 void AudioCapture::uninitialize()
 {
-    _impl->StopRecording();
-    _impl.reset();
+    if (_impl)
+    {
+        _impl->StopRecording();
+        _impl.reset();
+    }
 }
 
 void AudioCapture::NextAudioDevice()
@@ -39,24 +64,68 @@ void AudioCapture::NextAudioDevice()
     }
 }
 
-std::string AudioCapture::AudioDeviceName() const
+const std::string& AudioCapture::AudioDeviceName() const
 {
+    static const std::string noDevice;
+
     if (!_impl)
     {
-        return {};
+        return noDevice;
     }
 
     return _impl->AudioDeviceName();
 }
 
-void AudioCapture::FillBuffer()
+unsigned int AudioCapture::FillBuffer()
 {
     if (!_impl)
     {
-        return;
+        return 0;
+    }
+
+    return _impl->FillBuffer();
+}
+
+void AudioCapture::AddReceiver(projectm_handle projectMHandle)
+{
+    if (_impl)
+    {
+        _impl->AddReceiver(projectMHandle);
+    }
+}
+
+void AudioCapture::RemoveReceiver(projectm_handle projectMHandle)
+{
+    if (_impl)
+    {
+        _impl->RemoveReceiver(projectMHandle);
+    }
+}
+
+void AudioCapture::SetSampleCallback(AudioCaptureImpl::SampleCallback callback)
+{
+    if (_impl)
+    {
+        _impl->SetSampleCallback(std::move(callback));
+    }
+}
+
+AudioLevelMeter::Level AudioCapture::AudioLevel()
+{
+    if (_impl)
+    {
+        return _impl->AudioLevel();
     }
 
-    _impl->FillBuffer();
+    return {};
+}
+
+void AudioCapture::AudioDeviceEvent(const SDL_AudioDeviceEvent& event)
+{
+    if (_impl)
+    {
+        _impl->HandleDeviceEvent(event);
+    }
 }
 
 void AudioCapture::PrintDeviceList(const std::map<int, std::string>& deviceList) const
@@ -72,26 +141,37 @@ void AudioCapture::PrintDeviceList(const std::map<int, std::string>& deviceList)
 }
 
 int AudioCapture::GetInitialAudioDeviceIndex(const std::map<int, std::string>& deviceList)
+{
+    int audioDeviceIndex = FindAudioDeviceIndex(deviceList, "device");
+
+    poco_information_f2(_logger, R"(Recording audio from device "%s" (ID %?d).)",
+                        deviceList.at(audioDeviceIndex), audioDeviceIndex);
+
+    return audioDeviceIndex;
+}
+
+int AudioCapture::FindAudioDeviceIndex(const std::map<int, std::string>& deviceList, const std::string& key)
 {
     int audioDeviceIndex{ -1 };
 
     // Check if configured device is a number or string
     try
     {
-        audioDeviceIndex = _config->getInt("device", -1);
+        audioDeviceIndex = _config->getInt(key, -1);
         if (deviceList.find(audioDeviceIndex) == deviceList.end())
         {
-            poco_debug(_logger,
-                       "audio.device was set to a numerical value, but out of bounds. Reverting to default device.");
+            poco_debug_f1(_logger,
+                          "audio.%s was set to a numerical value, but out of bounds. Reverting to default device.",
+                          key);
             audioDeviceIndex = -1;
         }
     }
     catch (Poco::SyntaxException& ex)
     {
-        auto audioDeviceName = _config->getString("device", "");
+        auto audioDeviceName = _config->getString(key, "");
 
-        poco_debug_f1(_logger, R"(audio.device is set to non-numerical value. Searching for device name "%s".)",
-                      audioDeviceName);
+        poco_debug_f2(_logger, R"(audio.%s is set to non-numerical value. Searching for device name "%s".)",
+                      key, audioDeviceName);
 
         for (const auto& device: deviceList)
         {
@@ -103,8 +183,36 @@ int AudioCapture::GetInitialAudioDeviceIndex(const std::map<int, std::string>& d
         }
     }
 
-    poco_information_f2(_logger, R"(Recording audio from device "%s" (ID %?d).)",
-                        deviceList.at(audioDeviceIndex), audioDeviceIndex);
-
     return audioDeviceIndex;
+}
+
+void AudioCapture::AddSources(const std::map<int, std::string>& deviceList)
+{
+    auto sourcesConfig = _config->createView("sources");
+
+    Poco::Util::AbstractConfiguration::Keys sourceNames;
+    sourcesConfig->keys(sourceNames);
+
+    if (sourceNames.empty())
+    {
+        return;
+    }
+
+    _impl->SetGain(static_cast<float>(_config->getDouble("gain", 1.0)));
+
+    for (const auto& sourceName : sourceNames)
+    {
+        if (!sourcesConfig->getBool(sourceName + ".enabled", true))
+        {
+            continue;
+        }
+
+        int audioDeviceIndex = FindAudioDeviceIndex(deviceList, "sources." + sourceName + ".device");
+        auto gain = static_cast<float>(sourcesConfig->getDouble(sourceName + ".gain", 1.0));
+
+        if (!_impl->AddSource(audioDeviceIndex, gain))
+        {
+            poco_error_f1(_logger, R"(Could not add audio source "%s".)", sourceName);
+        }
+    }
 }
\ No newline at end of file
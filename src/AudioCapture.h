@@ -7,6 +7,8 @@
 #include <Poco/Util/Subsystem.h>
 #include <Poco/Util/AbstractConfiguration.h>
 
+#include <projectM-4/projectM.h>
+
 #include <memory>
 
 /**
@@ -21,6 +23,13 @@ public:
 
     void initialize(Poco::Util::Application& app) override;
 
+    /**
+     * @brief Starts capturing audio using the given configuration.
+     * @param config View of the "audio" configuration subkey to use.
+     * @param projectMHandle projectM instance handle that will receive the captured data.
+     */
+    void initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, projectm_handle projectMHandle);
+
     void uninitialize() override;
 
     /**
@@ -29,15 +38,46 @@ public:
     void NextAudioDevice();
 
     /**
-     * @brief Retrieves the current audio device name.
-     * @return The name of the currently selected audio recording device.
+     * @brief Retrieves the current audio device name without allocating.
+     * @return The name of the currently selected audio recording device. Only valid until the device changes.
      */
-    std::string AudioDeviceName() const;
+    const std::string& AudioDeviceName() const;
 
     /**
      * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     * @return The number of sample frames passed to projectM.
+     */
+    unsigned int FillBuffer();
+
+    /**
+     * @brief Adds an additional projectM instance which will receive the same audio data.
+     * @param projectMHandle The projectM instance to add.
      */
-    void FillBuffer();
+    void AddReceiver(projectm_handle projectMHandle);
+
+    /**
+     * @brief Removes a projectM instance previously added with AddReceiver().
+     * @param projectMHandle The projectM instance to remove.
+     */
+    void RemoveReceiver(projectm_handle projectMHandle);
+
+    /**
+     * @brief Sets a callback which receives a copy of all audio data passed to projectM.
+     * @param callback The callback, or an empty function to remove it.
+     */
+    void SetSampleCallback(AudioCaptureImpl::SampleCallback callback);
+
+    /**
+     * @brief Returns the level of the audio passed to projectM since the previous call.
+     * @return The RMS and peak level. All values are zero if nothing was captured.
+     */
+    AudioLevelMeter::Level AudioLevel();
+
+    /**
+     * @brief Handles SDL's audio device hotplug events, failing over if the recording device was removed.
+     * @param event The SDL_AUDIODEVICEADDED or SDL_AUDIODEVICEREMOVED event.
+     */
+    void AudioDeviceEvent(const SDL_AudioDeviceEvent& event);
 
 protected:
     /**
@@ -60,6 +100,20 @@ protected:
      */
     int GetInitialAudioDeviceIndex(const std::map<int, std::string>& deviceList);
 
+    /**
+     * @brief Looks up a device configured by name or index.
+     * @param deviceList The list of available audio devices.
+     * @param key The configuration key, relative to the "audio" subkey.
+     * @return The device index, or -1 if the device wasn't found or isn't configured.
+     */
+    int FindAudioDeviceIndex(const std::map<int, std::string>& deviceList, const std::string& key);
+
+    /**
+     * @brief Starts capturing the additional sources configured in the "audio.sources" subkeys.
+     * @param deviceList The list of available audio devices.
+     */
+    void AddSources(const std::map<int, std::string>& deviceList);
+
     Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "audio" configuration subkey.
 
     std::unique_ptr<AudioCaptureImpl> _impl; //!< The OS-specific capture implementation.
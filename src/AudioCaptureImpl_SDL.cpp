@@ -1,50 +1,57 @@
 #include "AudioCaptureImpl_SDL.h"
 
-#include <Poco/Util/Application.h>
+#include "Metrics.h"
+#include "Tracer.h"
+
+#include <Poco/String.h>
 
 #include <projectM-4/projectM.h>
 
-AudioCaptureImpl::AudioCaptureImpl()
-    : _requestedSampleCount(projectm_pcm_get_max_samples())
+#include <algorithm>
+
+AudioCaptureImpl::AudioCaptureImpl(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
 {
-    auto targetFps = Poco::Util::Application::instance().config().getUInt("projectM.fps", 60);
-    if (targetFps > 0)
-    {
-        _requestedSampleCount = std::min(_requestedSampleFrequency / targetFps, _requestedSampleCount);
-        // Don't let the buffer get too small to prevent excessive updates calls.
-        // 300 samples is enough for 144 FPS.
-        _requestedSampleCount = std::max(_requestedSampleCount, 300U);
-    }
+    // All settings are read from the capture's own view, so render zones can override each of them.
+    _audioSync.Configure(config->createView("sync"));
+
+    auto resamplerConfig = config->createView("resampler");
+    _nativeRate = resamplerConfig->getBool("enabled", true);
+    _resamplerTaps = resamplerConfig->getUInt("taps", 32);
+
+    _nativeFormat = config->getBool("nativeFormat", true);
+    _pullMode = config->getBool("pullMode", false);
+
+    _downmixConfig = config->createView("downmix");
+
+    _streamConfig = config->createView("stream");
+    _streamSource = _streamConfig->getString("source", "");
+
+    auto switchingConfig = config->createView("switching");
+    _crossfadeFrames = static_cast<size_t>(_requestedSampleFrequency) * switchingConfig->getUInt("crossfadeMs", 100) / 1000;
+    _switchTimeout = static_cast<Poco::Clock::ClockDiff>(switchingConfig->getUInt("timeoutMs", 3000)) * 1000;
 
 #ifdef SDL_HINT_AUDIO_INCLUDE_MONITORS
     SDL_SetHint(SDL_HINT_AUDIO_INCLUDE_MONITORS, "1");
 #endif
     SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+    _registry.Refresh();
 }
 
 AudioCaptureImpl::~AudioCaptureImpl()
 {
+    StopRecording();
+    _mixer.CloseSources();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
 std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
 {
-    std::map<int, std::string> deviceList{
-        {-1, "Default capturing device"}};
-
-    auto recordingDeviceCount = SDL_GetNumAudioDevices(true);
+    std::map<int, std::string> deviceList;
 
-    for (int i = 0; i < recordingDeviceCount; i++)
+    for (const auto& device : _registry.Devices())
     {
-        auto deviceName = SDL_GetAudioDeviceName(i, true);
-        if (deviceName)
-        {
-            deviceList.insert(std::make_pair(i, deviceName));
-        }
-        else
-        {
-            poco_error_f2(_logger, "Could not get device name for device ID %d: %s", i, std::string(SDL_GetError()));
-        }
+        deviceList.insert(std::make_pair(device._index, device._name));
     }
 
     return deviceList;
@@ -53,11 +60,26 @@ std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
 void AudioCaptureImpl::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
 {
     _projectMHandle = projectMHandle;
-    _currentAudioDeviceIndex = audioDeviceIndex;
+
+    // Use the FPS of the projectM instance this capture feeds, which may be a render zone's own setting.
+    UpdateSampleCount(projectm_get_fps(projectMHandle));
+
+    if (!_streamSource.empty())
+    {
+        auto device = OpenStream(_channels);
+        if (device)
+        {
+            ActivateDevice(std::move(device));
+        }
+        return;
+    }
+
+    auto registryDevice = _registry.FindByIndex(audioDeviceIndex);
+    _currentDeviceId = registryDevice ? registryDevice->_id : 0;
 
     if (OpenAudioDevice())
     {
-        SDL_PauseAudioDevice(_currentAudioDeviceID, false);
+        SDL_PauseAudioDevice(_device->_deviceID, false);
 
         poco_debug(_logger, "Started audio recording.");
     }
@@ -65,40 +87,246 @@ void AudioCaptureImpl::StartRecording(projectm* projectMHandle, int audioDeviceI
 
 void AudioCaptureImpl::StopRecording()
 {
-    if (_currentAudioDeviceID)
+    // Wait for pending switches, so no device is opened after this.
+    _worker.Stop();
+
+    _deviceOpened = false;
+    _devicesEnumerated = false;
+    _switching = false;
+    _switchQueued = false;
+    _pendingBuffer.clear();
+    _crossfadePosition = 0;
+
+    if (!_device && !_pendingDevice && !_openedDevice)
     {
-        SDL_PauseAudioDevice(_currentAudioDeviceID, true);
-        SDL_CloseAudioDevice(_currentAudioDeviceID);
-        _currentAudioDeviceID = 0;
+        return;
+    }
 
-        poco_debug(_logger, "Stopped audio recording and closed device.");
+    for (auto* device : {&_openedDevice, &_pendingDevice, &_device})
+    {
+        if (*device)
+        {
+            // Streams have no SDL device and stop reading when destroyed.
+            if ((*device)->_deviceID)
+            {
+                SDL_PauseAudioDevice((*device)->_deviceID, true);
+                SDL_CloseAudioDevice((*device)->_deviceID);
+            }
+            device->reset();
+        }
     }
+
+    poco_debug(_logger, "Stopped audio recording and closed device.");
 }
 
 void AudioCaptureImpl::NextAudioDevice()
 {
-    StopRecording();
+    if (!_streamSource.empty())
+    {
+        poco_information(_logger, "Reading a PCM stream, audio devices can't be switched.");
+        return;
+    }
 
     // Will wrap around to default capture device (-1).
-    int nextAudioDeviceId = ((_currentAudioDeviceIndex + 2) % (SDL_GetNumAudioDevices(true) + 1)) - 1;
-
-    StartRecording(_projectMHandle, nextAudioDeviceId);
+    SwitchAudioDevice(_registry.Next(_currentDeviceId));
 }
 
-std::string AudioCaptureImpl::AudioDeviceName() const
+const std::string& AudioCaptureImpl::AudioDeviceName() const
 {
-    if (_currentAudioDeviceIndex >= 0)
+    static const std::string defaultDeviceName{"Default capturing device"};
+
+    if (_device)
     {
-        return SDL_GetAudioDeviceName(_currentAudioDeviceIndex, true);
+        return _device->_name;
     }
     else
     {
-        return "Default capturing device";
+        return defaultDeviceName;
+    }
+}
+
+unsigned int AudioCaptureImpl::FillBuffer()
+{
+    UpdateSwitch();
+
+    if (!_device)
+    {
+        return 0;
+    }
+
+    const float* samples{nullptr};
+    Poco::Clock captureTime;
+    auto frames = ReadDevice(*_device, samples, captureTime);
+
+    if (_pendingDevice)
+    {
+        samples = Crossfade(samples, frames);
+    }
+
+    if (_mixer.Active() && frames > 0)
+    {
+        samples = _mixer.Mix(samples, frames);
+    }
+
+    if (_audioSync.Enabled())
+    {
+        _audioSync.Append(samples, frames, captureTime);
+        frames = _audioSync.Read(_syncedBuffer);
+        samples = _syncedBuffer.data();
+    }
+
+    if (frames == 0)
+    {
+        Metrics::Instance().AudioUnderrun();
+        return 0;
+    }
+
+    _levelMeter.Process(samples, frames * _channels);
+
+    projectm_pcm_add_float(_projectMHandle, samples, frames, static_cast<projectm_channels>(_channels));
+
+    for (auto receiver : _additionalReceivers)
+    {
+        projectm_pcm_add_float(receiver, samples, frames, static_cast<projectm_channels>(_channels));
+    }
+
+    if (_sampleCallback)
+    {
+        _sampleCallback(samples, frames, _channels);
+    }
+
+    return frames;
+}
+
+void AudioCaptureImpl::AddReceiver(projectm* projectMHandle)
+{
+    _additionalReceivers.push_back(projectMHandle);
+}
+
+void AudioCaptureImpl::RemoveReceiver(projectm* projectMHandle)
+{
+    _additionalReceivers.erase(std::remove(_additionalReceivers.begin(), _additionalReceivers.end(), projectMHandle),
+                               _additionalReceivers.end());
+}
+
+void AudioCaptureImpl::SetSampleCallback(SampleCallback callback)
+{
+    _sampleCallback = std::move(callback);
+}
+
+AudioLevelMeter::Level AudioCaptureImpl::AudioLevel()
+{
+    return _levelMeter.Read();
+}
+
+void AudioCaptureImpl::SetGain(float gain)
+{
+    _mixer.SetPrimaryGain(gain);
+}
+
+bool AudioCaptureImpl::AddSource(int audioDeviceIndex, float gain)
+{
+    // Indices are only valid for the current enumeration, the mixer keeps the device's stable name.
+    const auto* device = _registry.FindByIndex(audioDeviceIndex);
+    if (!device)
+    {
+        poco_error_f1(_logger, "No audio device with index %?d to add as source.", audioDeviceIndex);
+        return false;
+    }
+
+    return _mixer.AddSource(*device, gain);
+}
+
+void AudioCaptureImpl::SetDevicePriority(std::vector<std::string> deviceNames)
+{
+    _devicePriority = std::move(deviceNames);
+}
+
+void AudioCaptureImpl::HandleDeviceEvent(const SDL_AudioDeviceEvent& event)
+{
+    // A PCM stream is never replaced by a device.
+    if (!event.iscapture || !_projectMHandle || !_streamSource.empty())
+    {
+        return;
+    }
+
+    if (event.type == SDL_AUDIODEVICEREMOVED)
+    {
+        // For removed devices, "which" is the device ID of an opened device.
+        if (_pendingDevice && _pendingDevice->_deviceID == event.which)
+        {
+            poco_warning_f1(_logger, R"(Audio device "%s" was removed before switching to it.)", _pendingDevice->_name);
+            RetireDevice(std::move(_pendingDevice));
+            _pendingBuffer.clear();
+            _crossfadePosition = 0;
+        }
+
+        if (_device && _device->_deviceID == event.which)
+        {
+            poco_warning_f1(_logger, R"(Audio recording device "%s" was removed.)", _device->_name);
+            _registry.DeviceRemoved(_device->_registryId);
+            RetireDevice(std::move(_device));
+
+            // The pending device, if any, takes over right away.
+            if (_pendingDevice)
+            {
+                ActivateDevice(std::move(_pendingDevice));
+                _pendingBuffer.clear();
+                _crossfadePosition = 0;
+            }
+            else if (!_switching)
+            {
+                FailOver();
+            }
+        }
+    }
+    else if (event.type == SDL_AUDIODEVICEADDED && !_switching && !_pendingDevice)
+    {
+        // For added devices, "which" is the device index.
+        auto registryDevice = _registry.DeviceAdded(static_cast<int>(event.which));
+        if (!registryDevice)
+        {
+            return;
+        }
+
+        // Also recovers if no device could be opened after the recording device was removed.
+        if (!_device || DevicePriority(registryDevice->_name) < DevicePriority(AudioDeviceName()))
+        {
+            poco_information_f1(_logger, R"(Audio device "%s" was connected, switching to it.)", registryDevice->_name);
+            SwitchAudioDevice(*registryDevice);
+        }
+    }
+    else if (event.type == SDL_AUDIODEVICEADDED)
+    {
+        _registry.DeviceAdded(static_cast<int>(event.which));
     }
 }
 
 bool AudioCaptureImpl::OpenAudioDevice()
 {
+    auto registryDevice = _registry.FindById(_currentDeviceId);
+    auto device = OpenDevice(registryDevice ? *registryDevice : _registry.Devices().front(), _channels);
+    if (!device)
+    {
+        _registry.Refresh();
+        return false;
+    }
+
+    ActivateDevice(std::move(device));
+
+    return true;
+}
+
+std::unique_ptr<AudioCaptureImpl::Device> AudioCaptureImpl::OpenDevice(const AudioDeviceRegistry::Device& registryDevice,
+                                                                        unsigned int outputChannels) const
+{
+    auto audioDeviceIndex = registryDevice._index;
+
+    std::unique_ptr<Device> device(new Device);
+    device->_registryId = registryDevice._id;
+    device->_name = registryDevice._name;
+    device->_pullMode = _pullMode;
+
     SDL_AudioSpec requestedSpecs{};
     SDL_AudioSpec actualSpecs{};
 
@@ -106,40 +334,526 @@ bool AudioCaptureImpl::OpenAudioDevice()
     requestedSpecs.format = AUDIO_F32;
     requestedSpecs.channels = 2;
     requestedSpecs.samples = _requestedSampleCount;
-    requestedSpecs.callback = AudioCaptureImpl::AudioInputCallback;
-    requestedSpecs.userdata = this;
+    // Without a callback, SDL queues the captured audio until it is dequeued in FillBuffer().
+    requestedSpecs.callback = _pullMode ? nullptr : AudioCaptureImpl::AudioInputCallback;
+    requestedSpecs.userdata = _pullMode ? nullptr : device.get();
 
-    // Will be NULL on error, which happens if the requested index is -1. This automatically selects the default device.
-    auto deviceName = SDL_GetAudioDeviceName(_currentAudioDeviceIndex, true);
-    _currentAudioDeviceID = SDL_OpenAudioDevice(deviceName, true, &requestedSpecs, &actualSpecs, 0);
+    // Opening the device in its native format avoids SDL's generic conversion on the audio thread. The audio is
+    // converted, downmixed and resampled in FillBuffer() instead.
+    int allowedChanges{_nativeRate ? SDL_AUDIO_ALLOW_FREQUENCY_CHANGE : 0};
+#if SDL_VERSION_ATLEAST(2, 0, 16)
+    SDL_AudioSpec deviceSpecs{};
+    if ((_nativeRate || _nativeFormat) && audioDeviceIndex >= 0 &&
+        SDL_GetAudioDeviceSpec(audioDeviceIndex, true, &deviceSpecs) == 0)
+    {
+        if (_nativeRate && deviceSpecs.freq > 0)
+        {
+            requestedSpecs.freq = deviceSpecs.freq;
+        }
 
-    if (_currentAudioDeviceID == 0)
+        if (_nativeFormat &&
+            (deviceSpecs.format == AUDIO_F32SYS || deviceSpecs.format == AUDIO_S16SYS || deviceSpecs.format == AUDIO_S32SYS))
+        {
+            requestedSpecs.format = deviceSpecs.format;
+        }
+
+        if (_nativeFormat && deviceSpecs.channels >= 1 && deviceSpecs.channels <= AudioDownmix::MaxChannels)
+        {
+            requestedSpecs.channels = deviceSpecs.channels;
+        }
+    }
+#endif
+
+    // NULL for the default device, which lets SDL select it.
+    auto deviceName = audioDeviceIndex >= 0 ? registryDevice._name.c_str() : nullptr;
+    device->_deviceID = SDL_OpenAudioDevice(deviceName, true, &requestedSpecs, &actualSpecs, allowedChanges);
+
+    if (device->_deviceID == 0)
     {
         poco_error_f3(_logger, R"(Failed to open audio device "%s" (ID %?d): %s)",
                       std::string(deviceName ? deviceName : "System default capturing device"),
-                      _currentAudioDeviceIndex,
+                      audioDeviceIndex,
                       std::string(SDL_GetError()));
-        return false;
+        return {};
     }
 
-    _channels = actualSpecs.channels;
+    // The callback only starts after unpausing, so the device can still be set up here.
+    SetupConversion(*device, actualSpecs, outputChannels);
 
     poco_information_f4(_logger, R"(Opened audio recording device "%s" (ID %?d) with %?d channels at %?d Hz.)",
                         std::string(deviceName ? deviceName : "System default capturing device"),
-                        _currentAudioDeviceIndex,
+                        audioDeviceIndex,
                         actualSpecs.channels,
                         actualSpecs.freq);
 
-    return true;
+    if (!device->_downmix.Passthrough())
+    {
+        poco_debug_f2(_logger, "Converting captured audio from %?d bit samples with %?d channels.",
+                      SDL_AUDIO_BITSIZE(actualSpecs.format), actualSpecs.channels);
+    }
+
+    if (device->_resampler.Active())
+    {
+        poco_debug_f2(_logger, "Resampling captured audio from %?d Hz to %?d Hz.", actualSpecs.freq, _requestedSampleFrequency);
+    }
+
+    if (_pullMode)
+    {
+        poco_debug(_logger, "Reading captured audio in pull mode.");
+    }
+
+    return device;
+}
+
+std::unique_ptr<AudioCaptureImpl::Device> AudioCaptureImpl::OpenStream(unsigned int outputChannels) const
+{
+    auto format = Poco::toLower(_streamConfig->getString("format", "f32"));
+    auto channels = _streamConfig->getUInt("channels", 2);
+    auto rate = _streamConfig->getUInt("rate", _requestedSampleFrequency);
+
+    if ((format != "f32" && format != "s16") || channels < 1 || channels > AudioDownmix::MaxChannels || rate == 0)
+    {
+        poco_error_f3(_logger, R"(Unsupported PCM stream format "%s" with %?d channels at %?d Hz. Supported are "f32" and "s16" with up to 8 channels.)",
+                      format, channels, rate);
+        return {};
+    }
+
+    std::unique_ptr<Device> device(new Device);
+    device->_name = "PCM stream " + _streamSource;
+    device->_stream.reset(new PcmStreamReader);
+
+    // Describes the stream like an opened device, so it's converted the same way.
+    SDL_AudioSpec streamSpecs{};
+    streamSpecs.freq = static_cast<int>(rate);
+    streamSpecs.format = format == "s16" ? AUDIO_S16SYS : AUDIO_F32SYS;
+    streamSpecs.channels = static_cast<Uint8>(channels);
+    streamSpecs.samples = static_cast<Uint16>(static_cast<uint64_t>(_requestedSampleCount) * rate / _requestedSampleFrequency);
+    SetupConversion(*device, streamSpecs, outputChannels);
+
+    // Keeps one second of audio, like the capture buffer of a device.
+    if (!device->_stream->Open(_streamSource, device->_frameSize, static_cast<size_t>(rate) * device->_frameSize))
+    {
+        return {};
+    }
+
+    poco_information_f4(_logger, R"(Reading PCM stream "%s" as %s with %?d channels at %?d Hz.)",
+                        _streamSource, format, channels, rate);
+
+    return device;
+}
+
+void AudioCaptureImpl::UpdateSampleCount(int targetFps)
+{
+    _requestedSampleCount = projectm_pcm_get_max_samples();
+    if (targetFps > 0)
+    {
+        _requestedSampleCount = std::min(_requestedSampleFrequency / static_cast<uint32_t>(targetFps), _requestedSampleCount);
+        // Don't let the buffer get too small to prevent excessive updates calls.
+        // 300 samples is enough for 144 FPS.
+        _requestedSampleCount = std::max(_requestedSampleCount, 300U);
+    }
+}
+
+void AudioCaptureImpl::SetupConversion(Device& device, const SDL_AudioSpec& specs, unsigned int outputChannels) const
+{
+    auto format = AudioDownmix::SampleFormat::Float32;
+    if (specs.format == AUDIO_S16SYS)
+    {
+        format = AudioDownmix::SampleFormat::Int16;
+    }
+    else if (specs.format == AUDIO_S32SYS)
+    {
+        format = AudioDownmix::SampleFormat::Int32;
+    }
+
+    device._downmix.Configure(_downmixConfig, format, specs.channels,
+                              outputChannels);
+    device._frameSize = device._downmix.FrameSize();
+
+    // Keep up to one second of audio, in case rendering stalls. Reserved upfront to avoid allocations in the callback.
+    // Both buffers are swapped when reading, so both are locked to keep the callback from page-faulting.
+    device._sampleBufferLock.Unlock();
+    device._drainBufferLock.Unlock();
+    device._sampleBuffer.clear();
+    device._sampleBuffer.reserve(static_cast<size_t>(specs.freq) * device._frameSize);
+    device._drainBuffer.reserve(device._sampleBuffer.capacity());
+    device._sampleBufferLock.Lock(device._sampleBuffer.data(), device._sampleBuffer.capacity());
+    device._drainBufferLock.Lock(device._drainBuffer.data(), device._drainBuffer.capacity());
+
+    auto deviceRate = static_cast<unsigned int>(std::max(1, specs.freq));
+    auto budgetFrames = (static_cast<uint64_t>(projectm_pcm_get_max_samples()) * deviceRate + _requestedSampleFrequency - 1) / _requestedSampleFrequency;
+    device._pullBudget = std::min(static_cast<size_t>(budgetFrames) * device._frameSize, device._sampleBuffer.capacity());
+
+    device._resampler.Configure(deviceRate, _requestedSampleFrequency, device._downmix.OutputChannels(), _resamplerTaps);
+    device._periodFrames = static_cast<unsigned int>(static_cast<uint64_t>(specs.samples) * _requestedSampleFrequency / deviceRate);
+}
+
+void AudioCaptureImpl::ActivateDevice(std::unique_ptr<Device> device)
+{
+    _device = std::move(device);
+    _currentDeviceId = _device->_registryId;
+
+    // All later devices are converted to the first device's channel count, so the processing below stays the same.
+    if (_channels != _device->_downmix.OutputChannels())
+    {
+        _channels = _device->_downmix.OutputChannels();
+        _syncedBuffer.reserve(static_cast<size_t>(_requestedSampleFrequency) * _channels);
+        _audioSync.Reset(_requestedSampleFrequency, _channels, _device->_periodFrames);
+        _mixer.Configure(_requestedSampleFrequency, _channels, _requestedSampleCount);
+    }
+}
+
+unsigned int AudioCaptureImpl::ReadDevice(Device& device, const float*& samples, Poco::Clock& captureTime) const
+{
+    if (device._stream)
+    {
+        // Like dequeued samples, streamed samples are as recent as the time they are read.
+        captureTime.update();
+        device._stream->Read(device._drainBuffer, device._pullBudget);
+    }
+    else if (device._pullMode)
+    {
+        // Dequeued samples are as recent as the time they are read.
+        captureTime.update();
+        DequeueAudio(device);
+    }
+    else
+    {
+        // Swap buffers, so the audio thread is only blocked for a moment.
+        device._drainBuffer.clear();
+        SDL_LockAudioDevice(device._deviceID);
+        device._drainBuffer.swap(device._sampleBuffer);
+        captureTime = device._captureTime;
+        SDL_UnlockAudioDevice(device._deviceID);
+    }
+
+    auto frames = static_cast<unsigned int>(device._drainBuffer.size() / device._frameSize);
+    samples = reinterpret_cast<const float*>(device._drainBuffer.data());
+
+    if (!device._downmix.Passthrough())
+    {
+        TRACE_ZONE("DownmixAudio", "audio");
+        frames = static_cast<unsigned int>(device._downmix.Process(device._drainBuffer.data(), frames, device._downmixedBuffer));
+        samples = device._downmixedBuffer.data();
+    }
+
+    if (device._resampler.Active())
+    {
+        TRACE_ZONE("ResampleAudio", "audio");
+        frames = static_cast<unsigned int>(device._resampler.Process(samples, frames, device._resampledBuffer));
+        samples = device._resampledBuffer.data();
+    }
+
+    return frames;
+}
+
+void AudioCaptureImpl::DequeueAudio(Device& device)
+{
+    TRACE_ZONE("DequeueAudio", "audio");
+
+    auto queuedBytes = SDL_GetQueuedAudioSize(device._deviceID) / device._frameSize * device._frameSize;
+
+    if (queuedBytes > device._pullBudget)
+    {
+        // Renderer is lagging behind, drop the oldest samples. Dequeued in chunks to stay within the reserved buffer.
+        Metrics::Instance().AudioOverrun();
+        while (queuedBytes > device._pullBudget)
+        {
+            auto dropCount = std::min(queuedBytes - device._pullBudget, device._drainBuffer.capacity());
+            device._drainBuffer.resize(dropCount);
+            SDL_DequeueAudio(device._deviceID, device._drainBuffer.data(), static_cast<Uint32>(dropCount));
+            queuedBytes -= dropCount;
+        }
+    }
+
+    device._drainBuffer.resize(queuedBytes);
+    auto dequeuedBytes = SDL_DequeueAudio(device._deviceID, device._drainBuffer.data(), static_cast<Uint32>(queuedBytes));
+    device._drainBuffer.resize(dequeuedBytes / device._frameSize * device._frameSize);
+}
+
+void AudioCaptureImpl::SwitchAudioDevice(const AudioDeviceRegistry::Device& registryDevice)
+{
+    if (_switching || _pendingDevice)
+    {
+        // Only the last requested device is opened after the current switch.
+        _queuedDevice = registryDevice;
+        _switchQueued = true;
+        return;
+    }
+
+    _switching = true;
+    _currentDeviceId = registryDevice._id;
+
+    auto outputChannels = _channels;
+    _worker.Post([this, registryDevice, outputChannels]() {
+        auto device = OpenDevice(registryDevice, outputChannels);
+        if (device)
+        {
+            SDL_PauseAudioDevice(device->_deviceID, false);
+        }
+
+        Poco::FastMutex::ScopedLock lock(_switchMutex);
+        _openedDevice = std::move(device);
+        _deviceOpened = true;
+    });
+}
+
+void AudioCaptureImpl::UpdateSwitch()
+{
+    if (_devicesEnumerated)
+    {
+        Poco::FastMutex::ScopedLock lock(_switchMutex);
+        _registry.Update(_enumeratedDevices);
+        _devicesEnumerated = false;
+    }
+
+    if (_deviceOpened)
+    {
+        std::unique_ptr<Device> device;
+        {
+            Poco::FastMutex::ScopedLock lock(_switchMutex);
+            device = std::move(_openedDevice);
+            _deviceOpened = false;
+        }
+        _switching = false;
+
+        if (device && _device)
+        {
+            _pendingDevice = std::move(device);
+            _pendingBuffer.clear();
+            _crossfadePosition = 0;
+            _pendingSince.update();
+        }
+        else if (device)
+        {
+            // Nothing to crossfade from, e.g. after the recording device was removed.
+            ActivateDevice(std::move(device));
+            poco_information_f1(_logger, R"(Switched audio recording to "%s".)", _device->_name);
+        }
+        else
+        {
+            // The device list is probably outdated, e.g. the device was unplugged while not being used.
+            RefreshDevices();
+            if (_device)
+            {
+                _currentDeviceId = _device->_registryId;
+            }
+        }
+    }
+
+    if (_pendingDevice && _crossfadePosition == 0 && _pendingBuffer.empty() && _pendingSince.isElapsed(_switchTimeout))
+    {
+        poco_warning_f1(_logger, R"(Audio device "%s" didn't deliver any audio, keeping the current device.)",
+                        _pendingDevice->_name);
+        RetireDevice(std::move(_pendingDevice));
+        if (_device)
+        {
+            _currentDeviceId = _device->_registryId;
+        }
+    }
+
+    if (_switchQueued && !_switching && !_pendingDevice)
+    {
+        _switchQueued = false;
+        SwitchAudioDevice(_queuedDevice);
+    }
+}
+
+void AudioCaptureImpl::RefreshDevices()
+{
+    _worker.Post([this]() {
+        auto deviceNames = AudioDeviceRegistry::Enumerate();
+
+        Poco::FastMutex::ScopedLock lock(_switchMutex);
+        _enumeratedDevices = std::move(deviceNames);
+        _devicesEnumerated = true;
+    });
+}
+
+const float* AudioCaptureImpl::Crossfade(const float* samples, unsigned int& frames)
+{
+    TRACE_ZONE("CrossfadeAudio", "audio");
+
+    // Both devices were converted to the same channel count.
+    const float* newSamples{nullptr};
+    Poco::Clock unused;
+    auto newFrames = ReadDevice(*_pendingDevice, newSamples, unused);
+    _pendingBuffer.insert(_pendingBuffer.end(), newSamples, newSamples + newFrames * _channels);
+
+    auto pendingFrames = _pendingBuffer.size() / _channels;
+    if (pendingFrames == 0)
+    {
+        return samples;
+    }
+
+    auto mixFrames = std::min<size_t>(frames, pendingFrames);
+    _crossfadeBuffer.assign(samples, samples + static_cast<size_t>(frames) * _channels);
+
+    for (size_t frame = 0; frame < mixFrames; frame++)
+    {
+        auto weight = std::min(1.0f, static_cast<float>(_crossfadePosition + frame) / static_cast<float>(std::max<size_t>(_crossfadeFrames, 1)));
+        for (unsigned int channel = 0; channel < _channels; channel++)
+        {
+            auto& sample = _crossfadeBuffer[frame * _channels + channel];
+            sample += (_pendingBuffer[frame * _channels + channel] - sample) * weight;
+        }
+    }
+
+    _crossfadePosition += mixFrames;
+    _pendingBuffer.erase(_pendingBuffer.begin(), _pendingBuffer.begin() + static_cast<std::ptrdiff_t>(mixFrames * _channels));
+
+    if (_crossfadePosition >= _crossfadeFrames)
+    {
+        // The new device took over, so its remaining audio follows directly and the old device's rest is dropped.
+        _crossfadeBuffer.resize(mixFrames * _channels);
+        _crossfadeBuffer.insert(_crossfadeBuffer.end(), _pendingBuffer.begin(), _pendingBuffer.end());
+        _pendingBuffer.clear();
+        _crossfadePosition = 0;
+
+        RetireDevice(std::move(_device));
+        ActivateDevice(std::move(_pendingDevice));
+
+        poco_information_f1(_logger, R"(Switched audio recording to "%s".)", _device->_name);
+    }
+    else if (_pendingBuffer.size() > static_cast<size_t>(_requestedSampleFrequency) * _channels)
+    {
+        // The old device stopped delivering, keep only the newest second.
+        _pendingBuffer.erase(_pendingBuffer.begin(), _pendingBuffer.end() - static_cast<std::ptrdiff_t>(_requestedSampleFrequency * _channels));
+    }
+
+    frames = static_cast<unsigned int>(_crossfadeBuffer.size() / _channels);
+    return _crossfadeBuffer.data();
+}
+
+void AudioCaptureImpl::RetireDevice(std::unique_ptr<Device> device)
+{
+    if (!device)
+    {
+        return;
+    }
+
+    // SDL waits for the device's audio thread to finish, which can block for a while.
+    std::shared_ptr<Device> retiredDevice(std::move(device));
+    _worker.Post([retiredDevice]() {
+        SDL_CloseAudioDevice(retiredDevice->_deviceID);
+    });
+}
+
+size_t AudioCaptureImpl::DevicePriority(const std::string& deviceName) const
+{
+    auto entry = std::find(_devicePriority.begin(), _devicePriority.end(), deviceName);
+    return static_cast<size_t>(entry - _devicePriority.begin());
+}
+
+void AudioCaptureImpl::FailOver()
+{
+    for (const auto& preferredName : _devicePriority)
+    {
+        auto registryDevice = _registry.FindByName(preferredName);
+        if (registryDevice)
+        {
+            poco_information_f1(_logger, R"(Failing over to audio device "%s".)", preferredName);
+            SwitchAudioDevice(*registryDevice);
+            return;
+        }
+    }
+
+    poco_information(_logger, "Failing over to the default audio device.");
+    SwitchAudioDevice(_registry.Devices().front());
 }
 
 void AudioCaptureImpl::AudioInputCallback(void* userData, unsigned char* stream, int len)
 {
+    TRACE_ZONE("AudioCallback", "audio");
+
+    RealtimeThreads::Instance().TuneCurrentThread(RealtimeThreads::Role::Audio);
+
     poco_assert_dbg(userData);
-    auto instance = reinterpret_cast<AudioCaptureImpl*>(userData);
+    auto device = reinterpret_cast<Device*>(userData);
+
+    auto byteCount = static_cast<size_t>(len);
+
+    // SDL holds the audio device lock while calling this function, FillBuffer() uses the same lock.
+    auto& buffer = device->_sampleBuffer;
+    if (byteCount > buffer.capacity())
+    {
+        return;
+    }
+
+    if (buffer.size() + byteCount > buffer.capacity())
+    {
+        // Renderer is lagging behind, drop the oldest samples.
+        Metrics::Instance().AudioOverrun();
+        auto frameSize = device->_frameSize;
+        size_t dropCount = buffer.size() + byteCount - buffer.capacity();
+        dropCount = (dropCount + frameSize - 1) / frameSize * frameSize;
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(std::min(dropCount, buffer.size())));
+    }
+
+    buffer.insert(buffer.end(), stream, stream + byteCount);
+    device->_captureTime.update();
+}
+
+AudioCaptureImpl::DeviceWorker::~DeviceWorker()
+{
+    Stop();
+}
+
+void AudioCaptureImpl::DeviceWorker::Post(std::function<void()> task)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    _tasks.push_back(std::move(task));
+
+    if (!_thread.isRunning())
+    {
+        _stop = false;
+        _thread.start(*this);
+    }
 
-    unsigned int samples = len / sizeof(float) / instance->_channels;
+    _wakeUp.set();
+}
 
-    projectm_pcm_add_float(instance->_projectMHandle, reinterpret_cast<float*>(stream), samples,
-                           static_cast<projectm_channels>(instance->_channels));
+void AudioCaptureImpl::DeviceWorker::Stop()
+{
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        if (!_thread.isRunning())
+        {
+            return;
+        }
+        _stop = true;
+        _wakeUp.set();
+    }
+
+    _thread.join();
+}
+
+void AudioCaptureImpl::DeviceWorker::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+            if (!_tasks.empty())
+            {
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            else if (_stop)
+            {
+                return;
+            }
+        }
+
+        if (task)
+        {
+            task();
+        }
+        else
+        {
+            _wakeUp.wait();
+        }
+    }
 }
@@ -1,9 +1,29 @@
 #pragma once
 
+#include "AudioDeviceRegistry.h"
+#include "AudioDownmix.h"
+#include "AudioLevelMeter.h"
+#include "AudioMixer.h"
+#include "AudioSync.h"
+#include "PcmStreamReader.h"
+#include "PolyphaseResampler.h"
+#include "RealtimeThreads.h"
+
 #include <SDL2/SDL.h>
 
+#include <Poco/Clock.h>
+#include <Poco/Event.h>
 #include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,16 +33,38 @@ class projectm;
  * @brief SDL-based audio capturing thread.
  *
  * Uses SDL's audio API to capture PCM data from any supported drivers.
+ *
+ * Opening and closing devices can block for a long time with some audio servers, so device switches are done on a
+ * background thread. The previous device keeps delivering audio until the new one produces data, then both are
+ * crossfaded. If the recording device is unplugged, capturing fails over to the first available device of the
+ * configured priority list.
+ *
+ * Device names and indices are served from a registry, which is only enumerated again after hotplug events.
+ *
+ * Instead of a device, raw PCM can be read from standard input, a FIFO or a Unix domain socket if "stream.source"
+ * is set in the audio configuration. The stream then takes the place of the recording device and goes through the same conversion.
  */
 class AudioCaptureImpl
 {
 public:
-    AudioCaptureImpl();
+    /**
+     * @brief Callback receiving a copy of all audio data passed to projectM.
+     */
+    using SampleCallback = std::function<void(const float* samples, unsigned int frames, unsigned int channels)>;
+
+    /**
+     * @brief Constructor.
+     * @param config View of the "audio" configuration subkey of the application or render zone.
+     */
+    explicit AudioCaptureImpl(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
 
     ~AudioCaptureImpl();
 
     /**
      * @brief Returns a map of available recording devices.
+     *
+     * Builds a new map on each call. Only meant for selecting and listing devices at startup.
+     *
      * @return A vector of available audio device IDs and names.
      */
     std::map<int, std::string> AudioDeviceList();
@@ -42,48 +84,302 @@ public:
 
     /**
      * @brief Switches to the next available audio recording device.
+     *
+     * The device is opened in the background, the current device is used until the new one delivers audio.
      */
     void NextAudioDevice();
 
     /**
-     * @brief Retrieves the current audio device name.
-     * @return The name of the currently selected audio recording device.
+     * @brief Retrieves the current audio device name without allocating.
+     * @return The name of the currently selected audio recording device. Only valid until the device changes.
      */
-    std::string AudioDeviceName() const;
+    const std::string& AudioDeviceName() const;
 
     /**
-     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     * @brief Passes all audio data captured since the last call to projectM.
      *
-     * As of now, SDL uses async callbacks to directly fill projectM's audio buffer.
+     * In callback mode, SDL delivers audio data asynchronously on its own thread. It is buffered there and only
+     * passed to projectM here, so each frame receives a well-defined block of samples. In pull mode, the samples
+     * queued by SDL since the last frame are dequeued here instead. If enabled, the samples are paced to the frame
+     * timing by the audio synchronizer first.
      *
-     * @todo Store audio samples internally and push them to projectM when requested.
+     * @return The number of sample frames passed to projectM.
      */
-    void FillBuffer(){};
+    unsigned int FillBuffer();
+
+    /**
+     * @brief Adds an additional projectM instance which will receive the same audio data.
+     * @param projectMHandle The projectM instance to add.
+     */
+    void AddReceiver(projectm* projectMHandle);
+
+    /**
+     * @brief Removes a projectM instance previously added with AddReceiver().
+     * @param projectMHandle The projectM instance to remove.
+     */
+    void RemoveReceiver(projectm* projectMHandle);
+
+    /**
+     * @brief Sets a callback which receives all audio data passed to projectM, e.g. for recording.
+     * @param callback The callback, or an empty function to remove it.
+     */
+    void SetSampleCallback(SampleCallback callback);
+
+    /**
+     * @brief Returns the level of the audio passed to projectM since the previous call.
+     * @return The RMS and peak level.
+     */
+    AudioLevelMeter::Level AudioLevel();
+
+    /**
+     * @brief Sets the gain of the recording device's audio when mixed with additional sources.
+     * @param gain The linear gain.
+     */
+    void SetGain(float gain);
+
+    /**
+     * @brief Captures an additional device and mixes its audio into the recording device's audio.
+     *
+     * The source stays open when switching the recording device.
+     *
+     * @param audioDeviceIndex The device index, or -1 for the default device.
+     * @param gain The linear gain applied to the source.
+     * @return True if the device was opened.
+     */
+    bool AddSource(int audioDeviceIndex, float gain);
+
+    /**
+     * @brief Sets the device names to fail over to if the recording device is removed, in order of preference.
+     *
+     * A newly connected device is also switched to if it is preferred over the current one.
+     *
+     * @param deviceNames The device names.
+     */
+    void SetDevicePriority(std::vector<std::string> deviceNames);
+
+    /**
+     * @brief Handles SDL's audio device hotplug events. Never blocks.
+     * @param event The SDL_AUDIODEVICEADDED or SDL_AUDIODEVICEREMOVED event.
+     */
+    void HandleDeviceEvent(const SDL_AudioDeviceEvent& event);
 
 protected:
     /**
-     * @brief Opens the SDL audio device with the currently selected index.
-     * @return
+     * @brief An opened capture device and its conversion to the format passed to projectM.
+     */
+    struct Device
+    {
+        unsigned int _registryId{0}; //!< ID of the device in the registry, 0 for the default device.
+        std::string _name; //!< The device name.
+        SDL_AudioDeviceID _deviceID{0}; //!< SDL device ID of the opened device.
+        bool _pullMode{false}; //!< If true, the device has no callback and is read with SDL_DequeueAudio().
+        std::unique_ptr<PcmStreamReader> _stream; //!< Reads the PCM stream if this is a stream instead of an SDL device.
+
+        std::vector<uint8_t> _sampleBuffer; //!< Audio in the device format captured since the last read. Protected by the audio device lock.
+        Poco::Clock _captureTime; //!< Time of the last callback. Protected by the audio device lock.
+
+        size_t _frameSize{2 * sizeof(float)}; //!< Size of a sample frame in the device format in bytes.
+        size_t _pullBudget{0}; //!< Most bytes dequeued per frame in pull mode, projectM's sample limit at the device rate.
+        unsigned int _periodFrames{0}; //!< The device's buffer size, in sample frames after resampling.
+        AudioDownmix _downmix; //!< Converts the device format to mono or stereo float.
+        PolyphaseResampler _resampler; //!< Converts the device rate to _requestedSampleFrequency, if they differ.
+
+        std::vector<uint8_t> _drainBuffer; //!< Audio in the device format currently being converted.
+        LockedBuffer _sampleBufferLock; //!< Keeps the storage reserved for _sampleBuffer locked in memory.
+        LockedBuffer _drainBufferLock; //!< Keeps the storage reserved for _drainBuffer locked in memory.
+        std::vector<float> _downmixedBuffer; //!< Converted samples of the current read.
+        std::vector<float> _resampledBuffer; //!< Resampled samples of the current read.
+    };
+
+    /**
+     * @brief Runs blocking device operations on a background thread, in the order they were posted.
+     */
+    class DeviceWorker : public Poco::Runnable
+    {
+    public:
+        ~DeviceWorker() override;
+
+        /**
+         * @brief Queues a task, starting the thread if needed.
+         * @param task The task to run.
+         */
+        void Post(std::function<void()> task);
+
+        /**
+         * @brief Runs all queued tasks and stops the thread.
+         */
+        void Stop();
+
+        void run() override;
+
+    protected:
+        Poco::Thread _thread{"Audio device worker"}; //!< The worker thread.
+        Poco::FastMutex _mutex; //!< Protects the task queue and the stop flag.
+        Poco::Event _wakeUp; //!< Signaled when a task was queued or the worker should stop.
+        std::deque<std::function<void()>> _tasks; //!< Queued tasks.
+        bool _stop{false}; //!< If true, the thread exits after running all queued tasks.
+    };
+
+    /**
+     * @brief Opens the SDL audio device with the currently selected index and makes it the recording device.
+     *
+     * Blocks until the device is opened. The device is paused.
+     *
+     * @return True if the device was opened.
      */
     bool OpenAudioDevice();
 
+    /**
+     * @brief Opens a capture device and sets up its conversion. Paused, can be called from any thread.
+     * @param registryDevice The device's registry entry.
+     * @param outputChannels Channel count passed to projectM, or 0 to use the device's layout.
+     * @return The device, or nullptr if it could not be opened.
+     */
+    std::unique_ptr<Device> OpenDevice(const AudioDeviceRegistry::Device& registryDevice, unsigned int outputChannels) const;
+
+    /**
+     * @brief Opens the configured PCM stream as the recording device.
+     * @param outputChannels Channel count passed to projectM, or 0 to use the stream's layout.
+     * @return The stream device, or nullptr if the stream could not be opened.
+     */
+    std::unique_ptr<Device> OpenStream(unsigned int outputChannels) const;
+
+    /**
+     * @brief Sizes the device buffers, so about one buffer of new audio arrives per rendered frame.
+     * @param targetFps The FPS projectM renders at, 0 if unlimited.
+     */
+    void UpdateSampleCount(int targetFps);
+
+    /**
+     * @brief Sets up the conversion of a device's audio to the format passed to projectM.
+     * @param device The device.
+     * @param specs The actual specs of the opened device.
+     * @param outputChannels Channel count passed to projectM, or 0 to use the device's layout.
+     */
+    void SetupConversion(Device& device, const SDL_AudioSpec& specs, unsigned int outputChannels) const;
+
+    /**
+     * @brief Makes a device the recording device and sets up the processing following the conversion.
+     * @param device The device.
+     */
+    void ActivateDevice(std::unique_ptr<Device> device);
+
+    /**
+     * @brief Reads and converts all audio a device captured since the last read.
+     * @param device The device.
+     * @param[out] samples Receives the converted samples, valid until the next read.
+     * @param[out] captureTime Receives the time the newest samples were captured.
+     * @return The number of sample frames.
+     */
+    unsigned int ReadDevice(Device& device, const float*& samples, Poco::Clock& captureTime) const;
+
+    /**
+     * @brief Dequeues the audio captured since the last frame into the drain buffer in pull mode.
+     *
+     * Takes at most the sample budget. Older samples, e.g. queued while rendering stalled, are discarded, as
+     * projectM only keeps the newest samples anyway.
+     *
+     * @param device The device.
+     */
+    static void DequeueAudio(Device& device);
+
+    /**
+     * @brief Opens a device in the background and switches to it once it delivers audio.
+     * @param registryDevice The device's registry entry.
+     */
+    void SwitchAudioDevice(const AudioDeviceRegistry::Device& registryDevice);
+
+    /**
+     * @brief Picks up a device opened in the background and starts the crossfade or the next queued switch.
+     *
+     * Also applies a device enumeration finished in the background.
+     */
+    void UpdateSwitch();
+
+    /**
+     * @brief Enumerates the devices again in the background, e.g. after opening a listed device failed.
+     */
+    void RefreshDevices();
+
+    /**
+     * @brief Crossfades a block of the recording device's audio to the new device's audio.
+     *
+     * Once the crossfade is finished, the new device becomes the recording device.
+     *
+     * @param samples The recording device's samples.
+     * @param frames Number of sample frames. Receives the number of frames in the returned samples.
+     * @return The crossfaded samples.
+     */
+    const float* Crossfade(const float* samples, unsigned int& frames);
+
+    /**
+     * @brief Closes a device on the background thread.
+     * @param device The device to close.
+     */
+    void RetireDevice(std::unique_ptr<Device> device);
+
+    /**
+     * @brief Returns the position of a device in the priority list.
+     * @param deviceName The device name.
+     * @return The position, or the size of the list if the device isn't in it.
+     */
+    size_t DevicePriority(const std::string& deviceName) const;
+
+    /**
+     * @brief Switches to the most preferred available device after the recording device was removed.
+     */
+    void FailOver();
+
     /**
      * @brief SDL audio capture callback.
      *
      * Called everytime if there is new data available in the audio recording buffer.
      *
-     * @param userData
+     * @param userData The device.
      * @param stream
      * @param len
      */
     static void AudioInputCallback(void* userData, unsigned char* stream, int len);
 
     projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
-    int32_t _currentAudioDeviceIndex{-1}; //!< Currently selected audio device index.
-    SDL_AudioDeviceID _currentAudioDeviceID{0}; //!< Device ID of the currently opened audio device.
-    uint32_t _channels{2};
+    std::vector<projectm*> _additionalReceivers; //!< Additional projectM instances receiving the same audio data.
+    SampleCallback _sampleCallback; //!< Optional callback receiving a copy of the audio data.
+    AudioLevelMeter _levelMeter; //!< Measures the level of the audio passed to projectM.
+    bool _nativeFormat{true}; //!< If true, the device is opened in its native sample format and channel count.
+    bool _pullMode{false}; //!< If true, the device is opened without a callback and read with SDL_DequeueAudio().
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _downmixConfig; //!< View of the "downmix" subkey of the audio configuration.
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _streamConfig; //!< View of the "stream" subkey of the audio configuration.
+    std::string _streamSource; //!< PCM stream read instead of a device, empty to capture from devices.
+    bool _nativeRate{true}; //!< If true, the device is opened at its native rate and resampled.
+    unsigned int _resamplerTaps{32}; //!< Filter taps per phase of the resampler.
+    AudioMixer _mixer; //!< Mixes additional capture devices into the recording device's audio.
+    AudioSync _audioSync; //!< Paces the captured audio to the frame timing.
+    std::vector<float> _syncedBuffer; //!< Synchronized samples being passed to projectM in FillBuffer().
+    AudioDeviceRegistry _registry; //!< Cached list of capture devices.
+    unsigned int _currentDeviceId{0}; //!< Registry ID of the currently selected audio device.
+    uint32_t _channels{0}; //!< Number of channels passed to projectM, one or two. 0 until the first device is opened.
+
+    std::unique_ptr<Device> _device; //!< The recording device.
+    std::unique_ptr<Device> _pendingDevice; //!< Device being switched to, crossfaded in once it delivers audio.
+    std::vector<float> _pendingBuffer; //!< Converted audio of the pending device not crossfaded yet.
+    std::vector<float> _crossfadeBuffer; //!< Crossfaded samples of the current FillBuffer() call.
+    size_t _crossfadePosition{0}; //!< Sample frames of the crossfade done so far.
+    size_t _crossfadeFrames{4410}; //!< Length of the crossfade in sample frames.
+    Poco::Clock _pendingSince; //!< Time the pending device was picked up.
+    Poco::Clock::ClockDiff _switchTimeout{3000000}; //!< Time the pending device may take to deliver audio, in microseconds.
+    std::vector<std::string> _devicePriority; //!< Device names to fail over to, in order of preference.
+
+    DeviceWorker _worker; //!< Opens and closes devices in the background.
+    Poco::FastMutex _switchMutex; //!< Protects _openedDevice and _enumeratedDevices.
+    std::unique_ptr<Device> _openedDevice; //!< Device opened by the worker, not picked up yet.
+    std::atomic_bool _deviceOpened{false}; //!< True if the worker finished opening a device, even if it failed.
+    std::vector<std::string> _enumeratedDevices; //!< Device names enumerated by the worker, not applied yet.
+    std::atomic_bool _devicesEnumerated{false}; //!< True if the worker finished enumerating the devices.
+    bool _switching{false}; //!< True from requesting a switch until the new device was picked up.
+    bool _switchQueued{false}; //!< If true, _queuedDevice is switched to after the current switch.
+    AudioDeviceRegistry::Device _queuedDevice; //!< Device to switch to after the current switch.
 
-    constexpr static uint32_t _requestedSampleFrequency{44100}; //!< Requested sample frequency. Currently hardcoded as 44100 Hz, as this is what the spectrum analyzer expects.
+    constexpr static uint32_t _requestedSampleFrequency{44100}; //!< Sample frequency passed to projectM, as this is what the spectrum analyzer expects.
     uint32_t _requestedSampleCount{44100U / 60U}; //!< Requested audio buffer size. Determines how often SDL will call AudioInputCallback() with new data, and how much data is delivered on each call.
 
     Poco::Logger& _logger{Poco::Logger::get("AudioCapture.SDL")}; //!< The class logger.
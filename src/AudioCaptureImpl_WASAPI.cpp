@@ -1,15 +1,24 @@
 #include "AudioCaptureImpl_WASAPI.h"
 
+#include "Metrics.h"
+#include "RealtimeThreads.h"
+#include "Tracer.h"
+
 #include <projectM-4/projectM.h>
 
+#include <algorithm>
+
 #include <Poco/UnicodeConverter.h>
 
+#include <Poco/Util/Application.h>
+
 #include <functiondiscoverykeys_devpkey.h>
 #include <mmdeviceapi.h>
 #include <objbase.h>
 
-AudioCaptureImpl::AudioCaptureImpl()
-    : _captureThread(this, &AudioCaptureImpl::CaptureThread)
+AudioCaptureImpl::AudioCaptureImpl(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+    : _config(config)
+    , _captureThread(this, &AudioCaptureImpl::CaptureThread)
 {
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 }
@@ -47,6 +56,27 @@ void AudioCaptureImpl::StartRecording(projectm* projectMHandle, int audioDeviceI
     _projectMHandle = projectMHandle;
     _currentAudioDeviceIndex = audioDeviceIndex;
 
+    // Looked up once here, as enumerating the devices allocates and calls into the audio service.
+    if (_currentAudioDeviceIndex < 0)
+    {
+        _currentAudioDeviceName = "System Default Audio Device";
+    }
+    else
+    {
+        IMMDeviceEnumerator* enumerator{GetDeviceEnumerator()};
+        auto captureDevices{GetAudioDeviceList(enumerator)};
+        enumerator->Release();
+
+        _currentAudioDeviceName = _currentAudioDeviceIndex < static_cast<int>(captureDevices.size())
+                                      ? captureDevices.at(_currentAudioDeviceIndex).FriendlyName()
+                                      : std::string();
+    }
+
+    if (!_config->getString("stream.source", "").empty())
+    {
+        poco_warning(_logger, "PCM streams are not supported by the WASAPI audio capture implementation, capturing from a device instead.");
+    }
+
     _isCapturing = true;
     _captureThreadResult = _captureThread();
 }
@@ -77,26 +107,12 @@ void AudioCaptureImpl::NextAudioDevice()
     StartRecording(_projectMHandle, nextAudioDeviceId);
 }
 
-std::string AudioCaptureImpl::AudioDeviceName() const
+const std::string& AudioCaptureImpl::AudioDeviceName() const
 {
-    if (_currentAudioDeviceIndex < 0)
-    {
-        return "System Default Audio Device";
-    }
-
-    IMMDeviceEnumerator* enumerator{GetDeviceEnumerator()};
-    auto captureDevices{GetAudioDeviceList(enumerator)};
-    enumerator->Release();
-
-    if (captureDevices.empty() || _currentAudioDeviceIndex >= static_cast<int>(captureDevices.size()))
-    {
-        return {};
-    }
-
-    return captureDevices.at(_currentAudioDeviceIndex).FriendlyName();
+    return _currentAudioDeviceName;
 }
 
-void AudioCaptureImpl::FillBuffer()
+unsigned int AudioCaptureImpl::FillBuffer()
 {
     if (_isCapturing)
     {
@@ -111,6 +127,65 @@ void AudioCaptureImpl::FillBuffer()
             poco_debug(_logger, "Timeout waiting for audio buffer fill");
         }
     }
+
+    auto frames = _filledFrames.exchange(0);
+    if (_isCapturing && frames == 0)
+    {
+        Metrics::Instance().AudioUnderrun();
+    }
+
+    return frames;
+}
+
+void AudioCaptureImpl::AddReceiver(projectm* projectMHandle)
+{
+    Poco::FastMutex::ScopedLock lock(_receiverMutex);
+    _additionalReceivers.push_back(projectMHandle);
+}
+
+void AudioCaptureImpl::RemoveReceiver(projectm* projectMHandle)
+{
+    Poco::FastMutex::ScopedLock lock(_receiverMutex);
+    _additionalReceivers.erase(std::remove(_additionalReceivers.begin(), _additionalReceivers.end(), projectMHandle),
+                               _additionalReceivers.end());
+}
+
+void AudioCaptureImpl::SetSampleCallback(SampleCallback callback)
+{
+    Poco::FastMutex::ScopedLock lock(_receiverMutex);
+    _sampleCallback = std::move(callback);
+}
+
+AudioLevelMeter::Level AudioCaptureImpl::AudioLevel()
+{
+    return _levelMeter.Read();
+}
+
+void AudioCaptureImpl::SetGain(float gain)
+{
+    if (gain != 1.0f)
+    {
+        poco_warning(_logger, "The WASAPI audio capture implementation doesn't support an audio gain.");
+    }
+}
+
+bool AudioCaptureImpl::AddSource(int audioDeviceIndex, POCO_UNUSED float gain)
+{
+    poco_warning_f1(_logger, "The WASAPI audio capture implementation can't mix additional audio devices, ignoring device %?d.",
+                    audioDeviceIndex);
+    return false;
+}
+
+void AudioCaptureImpl::SetDevicePriority(std::vector<std::string> deviceNames)
+{
+    if (!deviceNames.empty())
+    {
+        poco_warning(_logger, "The WASAPI audio capture implementation doesn't support a device priority list.");
+    }
+}
+
+void AudioCaptureImpl::HandleDeviceEvent(POCO_UNUSED const SDL_AudioDeviceEvent& event)
+{
 }
 
 HRESULT AudioCaptureImpl::QueryInterface(const IID& riid, void** ppvObject)
@@ -313,6 +388,8 @@ void AudioCaptureImpl::CaptureThread()
 {
     poco_debug(_logger, "Audio capture thread starting.");
 
+    RealtimeThreads::Instance().TuneCurrentThread(RealtimeThreads::Role::Audio);
+
     HRESULT result = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
     if (FAILED(result))
@@ -407,6 +484,8 @@ void AudioCaptureImpl::CaptureThread()
             _audioCaptureClient->GetNextPacketSize(&packetLength);
             while (packetLength != 0)
             {
+                TRACE_ZONE("AudioCallback", "audio");
+
                 BYTE* data;
                 UINT32 framesAvailable;
                 DWORD flags;
@@ -419,6 +498,12 @@ void AudioCaptureImpl::CaptureThread()
                     break;
                 }
 
+                if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY)
+                {
+                    // WASAPI dropped captured data because it wasn't read in time.
+                    Metrics::Instance().AudioOverrun();
+                }
+
                 if (flags & AUDCLNT_BUFFERFLAGS_SILENT)
                 {
                     data = nullptr;
@@ -428,7 +513,22 @@ void AudioCaptureImpl::CaptureThread()
 
                 if (framesAvailable > 0 && data != nullptr)
                 {
+                    _levelMeter.Process(reinterpret_cast<float*>(data), framesAvailable * _channels);
+
                     projectm_pcm_add_float(_projectMHandle, reinterpret_cast<float*>(data), framesAvailable, static_cast<projectm_channels>(_channels));
+
+                    Poco::FastMutex::ScopedLock lock(_receiverMutex);
+                    for (auto receiver : _additionalReceivers)
+                    {
+                        projectm_pcm_add_float(receiver, reinterpret_cast<float*>(data), framesAvailable, static_cast<projectm_channels>(_channels));
+                    }
+
+                    if (_sampleCallback)
+                    {
+                        _sampleCallback(reinterpret_cast<float*>(data), framesAvailable, _channels);
+                    }
+
+                    _filledFrames += framesAvailable;
                 }
 
                 _audioCaptureClient->ReleaseBuffer(framesAvailable);
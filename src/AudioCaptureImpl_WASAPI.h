@@ -1,13 +1,22 @@
 #pragma once
 
+#include "AudioLevelMeter.h"
+
 #include <Poco/Logger.h>
 
+#include <SDL2/SDL.h>
+
 #include <Audioclient.h>
 
 #include <Poco/ActiveMethod.h>
 #include <Poco/Event.h>
+#include <Poco/Mutex.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
 
 #include <mmdeviceapi.h>
+#include <atomic>
+#include <functional>
 #include <string>
 
 struct projectm;
@@ -27,10 +36,16 @@ struct projectm;
 class AudioCaptureImpl : public IMMNotificationClient
 {
 public:
+    /**
+     * @brief Callback receiving a copy of all audio data passed to projectM.
+     */
+    using SampleCallback = std::function<void(const float* samples, unsigned int frames, unsigned int channels)>;
+
     /**
      * Constructor.
+     * @param config View of the "audio" configuration subkey of the application or render zone.
      */
-    AudioCaptureImpl();
+    explicit AudioCaptureImpl(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
 
     /**
      * Destructor.
@@ -39,6 +54,9 @@ public:
 
     /**
      * @brief Returns a map of available recording devices.
+     *
+     * Builds a new map on each call. Only meant for selecting and listing devices at startup.
+     *
      * @return A vector of available audio device IDs and names.
      */
     std::map<int, std::string> AudioDeviceList();
@@ -62,15 +80,84 @@ public:
     void NextAudioDevice();
 
     /**
-     * @brief Retrieves the current audio device name.
-     * @return The name of the currently selected audio recording device.
+     * @brief Retrieves the current audio device name without allocating.
+     * @return The name of the currently selected audio recording device. Only valid until the device changes.
      */
-    std::string AudioDeviceName() const;
+    const std::string& AudioDeviceName() const;
 
     /**
      * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     * @return The number of sample frames passed to projectM since the last call.
+     */
+    unsigned int FillBuffer();
+
+    /**
+     * @brief Adds an additional projectM instance which will receive the same audio data.
+     * @param projectMHandle The projectM instance to add.
      */
-    void FillBuffer();
+    void AddReceiver(projectm* projectMHandle);
+
+    /**
+     * @brief Removes a projectM instance previously added with AddReceiver().
+     * @param projectMHandle The projectM instance to remove.
+     */
+    void RemoveReceiver(projectm* projectMHandle);
+
+    /**
+     * @brief Sets a callback which receives all audio data passed to projectM, e.g. for recording.
+     *
+     * The callback is called on the capture thread while FillBuffer() waits for it.
+     *
+     * @param callback The callback, or an empty function to remove it.
+     */
+    void SetSampleCallback(SampleCallback callback);
+
+    /**
+     * @brief Returns the level of the audio passed to projectM since the previous call.
+     *
+     * The level is measured on the capture thread. Blocks flagged as silent by WASAPI aren't measured.
+     *
+     * @return The RMS and peak level.
+     */
+    AudioLevelMeter::Level AudioLevel();
+
+    /**
+     * @brief Sets the gain of the recording device's audio when mixed with additional sources.
+     *
+     * Not supported by the WASAPI implementation, as it can't mix additional sources.
+     *
+     * @param gain The linear gain.
+     */
+    void SetGain(float gain);
+
+    /**
+     * @brief Captures an additional device and mixes its audio into the recording device's audio.
+     *
+     * Not supported by the WASAPI implementation, always logs a warning.
+     *
+     * @param audioDeviceIndex The device index, or -1 for the default device.
+     * @param gain The linear gain applied to the source.
+     * @return Always false.
+     */
+    bool AddSource(int audioDeviceIndex, float gain);
+
+    /**
+     * @brief Sets the device names to fail over to if the recording device is removed, in order of preference.
+     *
+     * Not supported by the WASAPI implementation, which follows the system's default device instead.
+     *
+     * @param deviceNames The device names.
+     */
+    void SetDevicePriority(std::vector<std::string> deviceNames);
+
+    /**
+     * @brief Handles SDL's audio device hotplug events.
+     *
+     * Does nothing, as the WASAPI implementation doesn't use SDL's audio subsystem.
+     *
+     * @param event The SDL_AUDIODEVICEADDED or SDL_AUDIODEVICEREMOVED event.
+     */
+    void HandleDeviceEvent(const SDL_AudioDeviceEvent& event);
 
     /**
      * @brief Converts a widechar/unicode string to a UTF-8-encoded string
@@ -268,8 +355,15 @@ protected:
 
     Poco::Logger& _logger{Poco::Logger::get("AudioCapture.WASAPI")}; //!< The class logger.
 
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "audio" configuration subkey.
+
     projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    std::vector<projectm*> _additionalReceivers; //!< Additional projectM instances receiving the same audio data.
+    SampleCallback _sampleCallback; //!< Optional callback receiving a copy of the audio data.
+    AudioLevelMeter _levelMeter; //!< Measures the level of the audio passed to projectM.
+    Poco::FastMutex _receiverMutex; //!< Protects _additionalReceivers and _sampleCallback, which are used in the capture thread.
     int _currentAudioDeviceIndex{-1}; //!< Currently selected audio device index.
+    std::string _currentAudioDeviceName; //!< Name of the currently selected audio device.
     IAudioClient* _audioClient{nullptr}; //!< Currently used audio client.
     IAudioCaptureClient* _audioCaptureClient{nullptr}; //!< Currently used capture client.
 
@@ -284,6 +378,7 @@ protected:
     std::atomic_bool _restartCapturing{false}; //!< If true, the capture thread will stop and restart capturing without exiting.
     Poco::Event _fillBufferEvent; //!< Event which gets set if a frame is to be rendered or the capture client should exit.
     Poco::Event _bufferFilledEvent; //!< Event which gets set if the buffer has been filled.
+    std::atomic<unsigned int> _filledFrames{0}; //!< Sample frames passed to projectM since the last FillBuffer() call.
 
     static constexpr char _defaultDeviceName[] = "System Default Playback Device"; //!< Display name for the default device (index -1).
 };
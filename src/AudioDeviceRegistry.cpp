@@ -0,0 +1,160 @@
+#include "AudioDeviceRegistry.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+
+AudioDeviceRegistry::AudioDeviceRegistry()
+{
+    _devices.push_back({0, -1, "Default capturing device"});
+}
+
+void AudioDeviceRegistry::Refresh()
+{
+    Update(Enumerate());
+}
+
+std::vector<std::string> AudioDeviceRegistry::Enumerate()
+{
+    std::vector<std::string> deviceNames;
+
+    auto recordingDeviceCount = SDL_GetNumAudioDevices(true);
+
+    for (int index = 0; index < recordingDeviceCount; index++)
+    {
+        auto deviceName = SDL_GetAudioDeviceName(index, true);
+        if (!deviceName)
+        {
+            poco_error_f2(Poco::Logger::get("AudioDeviceRegistry"), "Could not get device name for device ID %d: %s",
+                          index, std::string(SDL_GetError()));
+        }
+
+        // Keeps the indices in place, devices without a name are skipped in Update().
+        deviceNames.emplace_back(deviceName ? deviceName : "");
+    }
+
+    return deviceNames;
+}
+
+void AudioDeviceRegistry::Update(const std::vector<std::string>& deviceNames)
+{
+    std::vector<Device> devices;
+    devices.push_back(_devices.front());
+
+    for (size_t index = 0; index < deviceNames.size(); index++)
+    {
+        const auto& deviceName = deviceNames[index];
+        if (deviceName.empty())
+        {
+            continue;
+        }
+
+        // Keep the ID of a known device with the same name, each only once if several have the same name.
+        auto known = std::find_if(_devices.begin() + 1, _devices.end(), [&deviceName, &devices](const Device& device) {
+            return device._name == deviceName &&
+                   std::none_of(devices.begin(), devices.end(), [&device](const Device& added) {
+                       return added._id == device._id;
+                   });
+        });
+
+        devices.push_back({known != _devices.end() ? known->_id : _nextId++, static_cast<int>(index), deviceName});
+    }
+
+    _devices.swap(devices);
+
+    poco_debug_f1(_logger, "Found %?d audio capture devices.", _devices.size() - 1);
+}
+
+const AudioDeviceRegistry::Device* AudioDeviceRegistry::DeviceAdded(int index)
+{
+    auto existing = FindByIndex(index);
+    if (existing)
+    {
+        return existing;
+    }
+
+    auto deviceName = SDL_GetAudioDeviceName(index, true);
+    if (!deviceName)
+    {
+        return nullptr;
+    }
+
+    // SDL assigns new devices the next free index, so the list stays ordered.
+    _devices.push_back({_nextId++, index, deviceName});
+
+    return &_devices.back();
+}
+
+void AudioDeviceRegistry::DeviceRemoved(unsigned int id)
+{
+    auto removed = std::find_if(_devices.begin() + 1, _devices.end(), [id](const Device& device) {
+        return device._id == id;
+    });
+
+    if (removed == _devices.end())
+    {
+        return;
+    }
+
+    auto removedIndex = removed->_index;
+    _devices.erase(removed);
+
+    for (auto& device : _devices)
+    {
+        if (device._index > removedIndex)
+        {
+            device._index--;
+        }
+    }
+}
+
+const std::vector<AudioDeviceRegistry::Device>& AudioDeviceRegistry::Devices() const
+{
+    return _devices;
+}
+
+int AudioDeviceRegistry::Count() const
+{
+    return static_cast<int>(_devices.size()) - 1;
+}
+
+const AudioDeviceRegistry::Device* AudioDeviceRegistry::FindByIndex(int index) const
+{
+    auto device = std::find_if(_devices.begin(), _devices.end(), [index](const Device& device) {
+        return device._index == index;
+    });
+
+    return device != _devices.end() ? &*device : nullptr;
+}
+
+const AudioDeviceRegistry::Device* AudioDeviceRegistry::FindById(unsigned int id) const
+{
+    auto device = std::find_if(_devices.begin(), _devices.end(), [id](const Device& device) {
+        return device._id == id;
+    });
+
+    return device != _devices.end() ? &*device : nullptr;
+}
+
+const AudioDeviceRegistry::Device* AudioDeviceRegistry::FindByName(const std::string& name) const
+{
+    auto device = std::find_if(_devices.begin() + 1, _devices.end(), [&name](const Device& device) {
+        return device._name == name;
+    });
+
+    return device != _devices.end() ? &*device : nullptr;
+}
+
+const AudioDeviceRegistry::Device& AudioDeviceRegistry::Next(unsigned int id) const
+{
+    auto device = std::find_if(_devices.begin(), _devices.end(), [id](const Device& device) {
+        return device._id == id;
+    });
+
+    if (device == _devices.end() || ++device == _devices.end())
+    {
+        return _devices.front();
+    }
+
+    return *device;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cached list of SDL's audio capture devices.
+ *
+ * Some SDL audio backends, e.g. PulseAudio, query the audio server each time the device list is read. The registry
+ * enumerates the devices once and is then updated from SDL's hotplug events, so looking up device names and indices
+ * doesn't call into SDL or allocate.
+ *
+ * Each device gets an ID that is kept as long as the device stays connected, even if SDL's device indices change.
+ * SDL reports new devices with their index, which is added directly. Removals are only reported for opened
+ * devices, so the list is enumerated again in that case, or if opening a listed device failed.
+ *
+ * Must only be used from the thread handling SDL's events.
+ */
+class AudioDeviceRegistry
+{
+public:
+    /**
+     * @brief A capture device.
+     */
+    struct Device
+    {
+        unsigned int _id{0}; //!< Stable device ID, never reused. 0 is the default device.
+        int _index{-1}; //!< SDL's current device index, or -1 for the default device.
+        std::string _name; //!< The device name.
+    };
+
+    AudioDeviceRegistry();
+
+    /**
+     * @brief Enumerates all capture devices again. Devices still connected keep their IDs.
+     */
+    void Refresh();
+
+    /**
+     * @brief Returns the names of all capture devices, ordered by index.
+     *
+     * Only calls SDL, so it can be run on a background thread and applied with Update() later.
+     *
+     * @return The device names.
+     */
+    static std::vector<std::string> Enumerate();
+
+    /**
+     * @brief Replaces the device list with an enumeration result. Devices still connected keep their IDs.
+     * @param deviceNames The device names, ordered by index.
+     */
+    void Update(const std::vector<std::string>& deviceNames);
+
+    /**
+     * @brief Adds a device reported by an SDL_AUDIODEVICEADDED event.
+     * @param index SDL's index of the new device.
+     * @return The added device, or nullptr if SDL didn't return a name for the index.
+     */
+    const Device* DeviceAdded(int index);
+
+    /**
+     * @brief Removes an opened device reported by an SDL_AUDIODEVICEREMOVED event.
+     *
+     * SDL closes the gap in the indices, so all following devices move down by one.
+     *
+     * @param id The device ID.
+     */
+    void DeviceRemoved(unsigned int id);
+
+    /**
+     * @brief Returns all devices, the default device first, the others ordered by index.
+     * @return The device list.
+     */
+    const std::vector<Device>& Devices() const;
+
+    /**
+     * @brief Returns the number of devices, not counting the default device.
+     * @return The device count.
+     */
+    int Count() const;
+
+    /**
+     * @brief Looks up a device by its SDL index.
+     * @param index The index, or -1 for the default device.
+     * @return The device, or nullptr if there is no device with this index.
+     */
+    const Device* FindByIndex(int index) const;
+
+    /**
+     * @brief Looks up a device by its ID.
+     * @param id The device ID.
+     * @return The device, or nullptr if the device is no longer connected.
+     */
+    const Device* FindById(unsigned int id) const;
+
+    /**
+     * @brief Looks up a device by its name.
+     * @param name The device name.
+     * @return The first device with this name, or nullptr if there is none.
+     */
+    const Device* FindByName(const std::string& name) const;
+
+    /**
+     * @brief Returns the device following another one, wrapping around to the default device.
+     * @param id The device ID.
+     * @return The next device.
+     */
+    const Device& Next(unsigned int id) const;
+
+protected:
+    std::vector<Device> _devices; //!< The default device followed by all capture devices, ordered by index.
+    unsigned int _nextId{1}; //!< ID assigned to the next new device.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioDeviceRegistry")}; //!< The class logger.
+};
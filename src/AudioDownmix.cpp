@@ -0,0 +1,285 @@
+#include "AudioDownmix.h"
+
+#include "PolyphaseResampler.h"
+
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DOWNMIX_USE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DOWNMIX_USE_NEON 1
+#endif
+
+constexpr unsigned int AudioDownmix::MaxChannels;
+
+void AudioDownmix::Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, SampleFormat format, unsigned int channels,
+                             unsigned int outputChannels)
+{
+    _format = format;
+    _channels = std::min(MaxChannels, std::max(1U, channels));
+    _outputChannels = outputChannels == 1 || outputChannels == 2 ? outputChannels : (_channels == 1 ? 1 : 2);
+    _stride = (_channels + 3) / 4 * 4;
+
+    std::vector<float> matrix;
+    if (_channels == 1)
+    {
+        // Mono is copied to both output channels.
+        matrix.assign(_outputChannels, 1.0f);
+    }
+    else
+    {
+        auto key = "matrix." + std::to_string(_channels);
+        auto value = config->getString(key, "");
+        if (value.empty() || !ParseMatrix(value, _channels, matrix))
+        {
+            if (!value.empty())
+            {
+                poco_warning_f2(_logger, R"(Invalid downmix matrix "%s" in audio.downmix.%s, using the default.)", value, key);
+            }
+            matrix = DefaultMatrix(_channels, static_cast<float>(config->getDouble("lfeLevel", 0.5)));
+        }
+
+        if (_outputChannels == 1)
+        {
+            // Mono output is the average of the stereo downmix.
+            for (unsigned int column = 0; column < _channels; column++)
+            {
+                matrix[column] = (matrix[column] + matrix[_channels + column]) * 0.5f;
+            }
+            matrix.resize(_channels);
+        }
+    }
+
+    // Pad each row to the stride, so the padded frames can be mixed with whole vectors.
+    _matrix.assign(_outputChannels * _stride, 0.0f);
+    _identity = _channels == _outputChannels;
+    for (unsigned int row = 0; row < _outputChannels; row++)
+    {
+        for (unsigned int column = 0; column < _channels; column++)
+        {
+            auto coefficient = matrix[row * _channels + column];
+            _matrix[row * _stride + column] = coefficient;
+            if (coefficient != (row == column ? 1.0f : 0.0f))
+            {
+                _identity = false;
+            }
+        }
+    }
+
+    _converted.clear();
+    _padded.clear();
+}
+
+unsigned int AudioDownmix::OutputChannels() const
+{
+    return _outputChannels;
+}
+
+size_t AudioDownmix::FrameSize() const
+{
+    return _channels * (_format == SampleFormat::Int16 ? sizeof(int16_t) : sizeof(float));
+}
+
+bool AudioDownmix::Passthrough() const
+{
+    return _format == SampleFormat::Float32 && _identity;
+}
+
+size_t AudioDownmix::Process(const uint8_t* input, size_t frames, std::vector<float>& output)
+{
+    auto count = frames * _channels;
+
+    // Without mixing, convert straight into the output.
+    auto& converted = _identity ? output : _converted;
+    converted.resize(count);
+
+    switch (_format)
+    {
+        case SampleFormat::Float32:
+            std::memcpy(converted.data(), input, count * sizeof(float));
+            break;
+
+        case SampleFormat::Int16:
+            Int16ToFloat(reinterpret_cast<const int16_t*>(input), converted.data(), count);
+            break;
+
+        case SampleFormat::Int32:
+            Int32ToFloat(reinterpret_cast<const int32_t*>(input), converted.data(), count);
+            break;
+    }
+
+    if (_identity)
+    {
+        return frames;
+    }
+
+    const float* source = _converted.data();
+    if (_stride != _channels)
+    {
+        _padded.assign(frames * _stride, 0.0f);
+        for (size_t frame = 0; frame < frames; frame++)
+        {
+            std::memcpy(&_padded[frame * _stride], &_converted[frame * _channels], _channels * sizeof(float));
+        }
+        source = _padded.data();
+    }
+
+    output.resize(frames * _outputChannels);
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        for (unsigned int channel = 0; channel < _outputChannels; channel++)
+        {
+            output[frame * _outputChannels + channel] =
+                PolyphaseResampler::DotProduct(&_matrix[channel * _stride], source + frame * _stride, _stride);
+        }
+    }
+
+    return frames;
+}
+
+void AudioDownmix::Int16ToFloat(const int16_t* input, float* output, size_t count)
+{
+    constexpr float scale{1.0f / 32768.0f};
+    size_t index{0};
+
+#if defined(DOWNMIX_USE_SSE2)
+    const __m128 scaleVector = _mm_set1_ps(scale);
+    for (; index + 8 <= count; index += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index));
+        // Unpacking a value with itself and shifting right sign-extends it to 32 bits.
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(output + index, _mm_mul_ps(_mm_cvtepi32_ps(low), scaleVector));
+        _mm_storeu_ps(output + index + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scaleVector));
+    }
+#elif defined(DOWNMIX_USE_NEON)
+    for (; index + 8 <= count; index += 8)
+    {
+        int16x8_t samples = vld1q_s16(input + index);
+        vst1q_f32(output + index, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+        vst1q_f32(output + index + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        output[index] = static_cast<float>(input[index]) * scale;
+    }
+}
+
+void AudioDownmix::Int32ToFloat(const int32_t* input, float* output, size_t count)
+{
+    constexpr float scale{1.0f / 2147483648.0f};
+    size_t index{0};
+
+#if defined(DOWNMIX_USE_SSE2)
+    const __m128 scaleVector = _mm_set1_ps(scale);
+    for (; index + 4 <= count; index += 4)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index));
+        _mm_storeu_ps(output + index, _mm_mul_ps(_mm_cvtepi32_ps(samples), scaleVector));
+    }
+#elif defined(DOWNMIX_USE_NEON)
+    for (; index + 4 <= count; index += 4)
+    {
+        vst1q_f32(output + index, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(input + index)), scale));
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        output[index] = static_cast<float>(input[index]) * scale;
+    }
+}
+
+std::vector<float> AudioDownmix::DefaultMatrix(unsigned int channels, float lfeLevel)
+{
+    // Left and right gains of each channel role.
+    struct Gains {
+        float _left;
+        float _right;
+    };
+
+    constexpr float minus3dB{0.7071f};
+    const Gains frontLeft{1.0f, 0.0f};
+    const Gains frontRight{0.0f, 1.0f};
+    const Gains center{minus3dB, minus3dB};
+    const Gains lfe{lfeLevel, lfeLevel};
+    const Gains surroundLeft{minus3dB, 0.0f};
+    const Gains surroundRight{0.0f, minus3dB};
+    const Gains backCenter{0.5f, 0.5f};
+
+    // SDL's channel layouts for each channel count.
+    std::vector<Gains> layout;
+    switch (channels)
+    {
+        case 2:
+            layout = {frontLeft, frontRight};
+            break;
+        case 3:
+            layout = {frontLeft, frontRight, lfe};
+            break;
+        case 4:
+            layout = {frontLeft, frontRight, surroundLeft, surroundRight};
+            break;
+        case 5:
+            layout = {frontLeft, frontRight, lfe, surroundLeft, surroundRight};
+            break;
+        case 6:
+            layout = {frontLeft, frontRight, center, lfe, surroundLeft, surroundRight};
+            break;
+        case 7:
+            layout = {frontLeft, frontRight, center, lfe, backCenter, surroundLeft, surroundRight};
+            break;
+        default:
+            layout = {frontLeft, frontRight, center, lfe, surroundLeft, surroundRight, surroundLeft, surroundRight};
+            break;
+    }
+
+    std::vector<float> matrix(2 * channels, 0.0f);
+    for (unsigned int channel = 0; channel < channels && channel < layout.size(); channel++)
+    {
+        matrix[channel] = layout[channel]._left;
+        matrix[channels + channel] = layout[channel]._right;
+    }
+
+    return matrix;
+}
+
+bool AudioDownmix::ParseMatrix(const std::string& value, unsigned int channels, std::vector<float>& matrix)
+{
+    Poco::StringTokenizer rows(value, ";", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    if (rows.count() != 2)
+    {
+        return false;
+    }
+
+    matrix.clear();
+    for (const auto& row : rows)
+    {
+        Poco::StringTokenizer coefficients(row, ",", Poco::StringTokenizer::TOK_TRIM);
+        if (coefficients.count() != channels)
+        {
+            return false;
+        }
+
+        for (const auto& coefficient : coefficients)
+        {
+            double parsedCoefficient{0.0};
+            if (!Poco::NumberParser::tryParseFloat(coefficient, parsedCoefficient))
+            {
+                return false;
+            }
+            matrix.push_back(static_cast<float>(parsedCoefficient));
+        }
+    }
+
+    return true;
+}
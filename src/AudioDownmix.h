@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Converts captured audio in a device's native sample format and channel layout to mono or stereo float.
+ *
+ * projectM only accepts mono or stereo float samples. Devices delivering 16 or 32 bit integers are converted to float,
+ * and devices with more than two channels, e.g. surround monitor sources, are downmixed to stereo with a matrix. The
+ * default matrices follow SDL's channel layouts and mix center and surround channels at -3 dB, and the LFE channel at
+ * the configured level. Custom matrices can be configured per channel count.
+ *
+ * Conversion and mixing are vectorized with SSE2 or NEON if available.
+ */
+class AudioDownmix
+{
+public:
+    /**
+     * @brief Supported native sample formats, all in native byte order.
+     */
+    enum class SampleFormat
+    {
+        Float32, //!< 32 bit float.
+        Int16, //!< 16 bit signed integer.
+        Int32 //!< 32 bit signed integer.
+    };
+
+    static constexpr unsigned int MaxChannels{8}; //!< Largest supported channel count, 7.1 surround.
+
+    AudioDownmix() = default;
+
+    /**
+     * @brief Sets up the conversion for a device format.
+     * @param config View of the "audio.downmix" configuration subkey.
+     * @param format The device's sample format.
+     * @param channels The device's channel count, between 1 and MaxChannels.
+     * @param outputChannels Channel count of the converted audio, one or two. If 0, mono devices stay mono and all
+     *                       others are downmixed to stereo.
+     */
+    void Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, SampleFormat format, unsigned int channels,
+                   unsigned int outputChannels = 0);
+
+    /**
+     * @brief Returns the number of channels in the converted audio.
+     * @return The requested output channels, or 1 for mono devices and 2 for all others.
+     */
+    unsigned int OutputChannels() const;
+
+    /**
+     * @brief Returns the size of one sample frame in the device format.
+     * @return The frame size in bytes.
+     */
+    size_t FrameSize() const;
+
+    /**
+     * @brief Returns whether the device format can be passed to projectM as is.
+     * @return True if the device delivers mono or stereo float samples and the matrix doesn't change them.
+     */
+    bool Passthrough() const;
+
+    /**
+     * @brief Converts a block of captured audio.
+     * @param input Sample frames in the device format.
+     * @param frames Number of sample frames.
+     * @param output Receives the interleaved float samples with OutputChannels() channels.
+     * @return The number of sample frames, always equal to frames.
+     */
+    size_t Process(const uint8_t* input, size_t frames, std::vector<float>& output);
+
+    /**
+     * @brief Converts 16 bit integer samples to float in the range -1 to 1.
+     * @param input The integer samples.
+     * @param output Receives the float samples.
+     * @param count Number of samples.
+     */
+    static void Int16ToFloat(const int16_t* input, float* output, size_t count);
+
+    /**
+     * @brief Converts 32 bit integer samples to float in the range -1 to 1.
+     * @param input The integer samples.
+     * @param output Receives the float samples.
+     * @param count Number of samples.
+     */
+    static void Int32ToFloat(const int32_t* input, float* output, size_t count);
+
+protected:
+    /**
+     * @brief Returns the default downmix matrix for a channel count.
+     * @param channels The input channel count.
+     * @param lfeLevel Gain applied to the LFE channel.
+     * @return The left row followed by the right row, each with one coefficient per input channel.
+     */
+    static std::vector<float> DefaultMatrix(unsigned int channels, float lfeLevel);
+
+    /**
+     * @brief Parses a matrix from the configuration, e.g. "1,0,0.7;0,1,0.7".
+     * @param value The configured matrix, with rows separated by semicolons and coefficients by commas.
+     * @param channels The expected number of coefficients per row.
+     * @param matrix Receives the two rows.
+     * @return True if the value contained two rows with the expected number of coefficients.
+     */
+    static bool ParseMatrix(const std::string& value, unsigned int channels, std::vector<float>& matrix);
+
+    SampleFormat _format{SampleFormat::Float32}; //!< The device's sample format.
+    unsigned int _channels{2}; //!< The device's channel count.
+    unsigned int _outputChannels{2}; //!< Channels in the converted audio.
+    size_t _stride{4}; //!< Distance between frames in the padded buffer and matrix rows, a multiple of four.
+    bool _identity{true}; //!< True if the matrix passes the channels through unchanged.
+
+    std::vector<float> _matrix; //!< Downmix coefficients, one padded row per output channel.
+    std::vector<float> _converted; //!< Input converted to float.
+    std::vector<float> _padded; //!< Converted input with each frame padded to the stride.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioDownmix")}; //!< The class logger.
+};
@@ -0,0 +1,75 @@
+#include "AudioFile.h"
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Exception.h>
+
+#include <algorithm>
+#include <cstring>
+
+constexpr int AudioFile::SampleRate;
+constexpr int AudioFile::Channels;
+
+AudioFile::AudioFile(const std::string& fileName)
+{
+    SDL_AudioSpec fileSpec{};
+    Uint8* fileBuffer{nullptr};
+    Uint32 fileLength{0};
+
+    if (!SDL_LoadWAV(fileName.c_str(), &fileSpec, &fileBuffer, &fileLength))
+    {
+        throw Poco::Exception("Could not load audio file \"" + fileName + "\": " + std::string(SDL_GetError()));
+    }
+
+    SDL_AudioCVT converter{};
+    if (SDL_BuildAudioCVT(&converter, fileSpec.format, fileSpec.channels, fileSpec.freq,
+                          AUDIO_F32SYS, Channels, SampleRate) < 0)
+    {
+        SDL_FreeWAV(fileBuffer);
+        throw Poco::Exception("Cannot convert audio file \"" + fileName + "\": " + std::string(SDL_GetError()));
+    }
+
+    std::vector<Uint8> convertedData(static_cast<size_t>(fileLength) * std::max(1, converter.len_mult));
+    std::memcpy(convertedData.data(), fileBuffer, fileLength);
+    SDL_FreeWAV(fileBuffer);
+
+    converter.buf = convertedData.data();
+    converter.len = static_cast<int>(fileLength);
+    if (converter.needed && SDL_ConvertAudio(&converter) < 0)
+    {
+        throw Poco::Exception("Cannot convert audio file \"" + fileName + "\": " + std::string(SDL_GetError()));
+    }
+
+    auto convertedLength = converter.needed ? converter.len_cvt : converter.len;
+    _samples.resize(static_cast<size_t>(convertedLength) / sizeof(float));
+    std::memcpy(_samples.data(), convertedData.data(), _samples.size() * sizeof(float));
+
+    if (_samples.size() < Channels)
+    {
+        throw Poco::Exception("Audio file \"" + fileName + "\" contains no samples.");
+    }
+
+    poco_debug_f3(_logger, R"(Loaded audio file "%s" (%?d Hz, %?d channels).)", fileName, fileSpec.freq, fileSpec.channels);
+}
+
+size_t AudioFile::FrameCount() const
+{
+    return _samples.size() / Channels;
+}
+
+void AudioFile::AddToProjectM(projectm_handle projectMHandle, size_t& position, size_t frames) const
+{
+    auto frameCount = FrameCount();
+    auto maxFrames = static_cast<size_t>(projectm_pcm_get_max_samples());
+
+    while (frames > 0)
+    {
+        position %= frameCount;
+
+        auto chunkFrames = std::min({frames, frameCount - position, maxFrames});
+        projectm_pcm_add_float(projectMHandle, &_samples[position * Channels], static_cast<unsigned int>(chunkFrames), PROJECTM_STEREO);
+
+        position += chunkFrames;
+        frames -= chunkFrames;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <projectM-4/projectM.h>
+
+#include <Poco/Logger.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Audio data loaded from a WAV file, for use in offline rendering modes.
+ *
+ * The file is decoded and converted to interleaved 32-bit float stereo at 44.1 kHz using SDL's WAV loader
+ * and audio converter, which is what projectM's spectrum analyzer expects.
+ */
+class AudioFile
+{
+public:
+    static constexpr int SampleRate{44100}; //!< Sample rate of the converted audio data.
+    static constexpr int Channels{2}; //!< Number of interleaved channels in the converted audio data.
+
+    /**
+     * @brief Loads and converts the given WAV file.
+     * @throws Poco::Exception if the file can't be loaded or converted.
+     * @param fileName The WAV file to load.
+     */
+    explicit AudioFile(const std::string& fileName);
+
+    /**
+     * @brief Returns the number of stereo sample frames.
+     * @return The length of the audio data in sample frames.
+     */
+    size_t FrameCount() const;
+
+    /**
+     * @brief Passes audio data to projectM, starting at the given position.
+     *
+     * Wraps around to the start of the file if the end is reached.
+     *
+     * @param projectMHandle The projectM instance to add the audio data to.
+     * @param position[in,out] The sample frame position to start at. Is advanced by the number of frames added.
+     * @param frames The number of sample frames to add.
+     */
+    void AddToProjectM(projectm_handle projectMHandle, size_t& position, size_t frames) const;
+
+protected:
+    std::vector<float> _samples; //!< Interleaved stereo samples.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioFile")}; //!< The class logger.
+};
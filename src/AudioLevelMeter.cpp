@@ -0,0 +1,109 @@
+#include "AudioLevelMeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define METER_USE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define METER_USE_NEON 1
+#endif
+
+void AudioLevelMeter::Process(const float* samples, size_t count)
+{
+    if (samples == nullptr || count == 0)
+    {
+        return;
+    }
+
+    float sumOfSquares{0.0f};
+    float peak{0.0f};
+    Measure(samples, count, sumOfSquares, peak);
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _sumOfSquares += sumOfSquares;
+    _peak = std::max(_peak, peak);
+    _samples += count;
+}
+
+AudioLevelMeter::Level AudioLevelMeter::Read()
+{
+    Level level;
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    if (_samples > 0)
+    {
+        level._rms = static_cast<float>(std::sqrt(_sumOfSquares / static_cast<double>(_samples)));
+        level._peak = _peak;
+        level._samples = _samples;
+    }
+
+    _sumOfSquares = 0.0;
+    _peak = 0.0f;
+    _samples = 0;
+
+    return level;
+}
+
+void AudioLevelMeter::Measure(const float* samples, size_t count, float& sumOfSquares, float& peak)
+{
+    size_t index{0};
+    float sum{0.0f};
+    float maximum{0.0f};
+
+#if defined(METER_USE_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    __m128 sumVector = _mm_setzero_ps();
+    __m128 peakVector = _mm_setzero_ps();
+    for (; index + 4 <= count; index += 4)
+    {
+        __m128 values = _mm_loadu_ps(samples + index);
+        sumVector = _mm_add_ps(sumVector, _mm_mul_ps(values, values));
+        peakVector = _mm_max_ps(peakVector, _mm_max_ps(values, _mm_sub_ps(zero, values)));
+    }
+
+    alignas(16) float sums[4];
+    alignas(16) float peaks[4];
+    _mm_store_ps(sums, sumVector);
+    _mm_store_ps(peaks, peakVector);
+    sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    maximum = std::max(std::max(peaks[0], peaks[1]), std::max(peaks[2], peaks[3]));
+#elif defined(METER_USE_NEON)
+    float32x4_t sumVector = vdupq_n_f32(0.0f);
+    float32x4_t peakVector = vdupq_n_f32(0.0f);
+    for (; index + 4 <= count; index += 4)
+    {
+        float32x4_t values = vld1q_f32(samples + index);
+        sumVector = vmlaq_f32(sumVector, values, values);
+        peakVector = vmaxq_f32(peakVector, vabsq_f32(values));
+    }
+
+    float32x2_t sumPair = vadd_f32(vget_low_f32(sumVector), vget_high_f32(sumVector));
+    float32x2_t peakPair = vmax_f32(vget_low_f32(peakVector), vget_high_f32(peakVector));
+    sum = vget_lane_f32(vpadd_f32(sumPair, sumPair), 0);
+    maximum = vget_lane_f32(vpmax_f32(peakPair, peakPair), 0);
+#endif
+
+    for (; index < count; index++)
+    {
+        sum += samples[index] * samples[index];
+        maximum = std::max(maximum, std::abs(samples[index]));
+    }
+
+    sumOfSquares = sum;
+    peak = maximum;
+}
+
+float AudioLevelMeter::ToDecibels(float level)
+{
+    constexpr float floor{-120.0f};
+
+    if (level <= 0.0f)
+    {
+        return floor;
+    }
+
+    return std::max(floor, 20.0f * std::log10(level));
+}
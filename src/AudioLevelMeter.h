@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Poco/Mutex.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Measures the RMS and peak level of the captured audio.
+ *
+ * The capture implementation passes every block it hands to projectM through Process(), which may happen on the
+ * capture thread. The render loop reads the level of all blocks since its previous call with Read(). Both levels are
+ * calculated in a single vectorized pass with SSE or NEON if available, so metering costs next to nothing compared to
+ * the rest of the capture pipeline.
+ */
+class AudioLevelMeter
+{
+public:
+    /**
+     * @brief Level of a block of samples, relative to full scale.
+     */
+    struct Level {
+        float _rms{0.0f}; //!< Root mean square of all samples, 0 to 1.
+        float _peak{0.0f}; //!< Largest absolute sample value, 0 to 1.
+        uint64_t _samples{0}; //!< Number of samples the level was measured over. 0 if no audio was captured.
+    };
+
+    /**
+     * @brief Adds a block of captured audio to the measurement.
+     * @param samples The interleaved float samples.
+     * @param count Number of samples, i.e. frames times channels.
+     */
+    void Process(const float* samples, size_t count);
+
+    /**
+     * @brief Returns the level of all samples processed since the previous call and restarts the measurement.
+     * @return The level. All values are zero if nothing was processed.
+     */
+    Level Read();
+
+    /**
+     * @brief Calculates the sum of squares and the largest absolute value of a block of samples.
+     * @param samples The samples.
+     * @param count Number of samples.
+     * @param[out] sumOfSquares Receives the sum of all squared samples.
+     * @param[out] peak Receives the largest absolute sample value.
+     */
+    static void Measure(const float* samples, size_t count, float& sumOfSquares, float& peak);
+
+    /**
+     * @brief Converts a linear level to decibels relative to full scale.
+     * @param level The linear level.
+     * @return The level in dBFS, limited to -120 dB for silence.
+     */
+    static float ToDecibels(float level);
+
+protected:
+    Poco::FastMutex _mutex; //!< Protects the accumulated values, as the capture thread may add to them.
+    double _sumOfSquares{0.0}; //!< Sum of all squared samples since the last Read().
+    float _peak{0.0f}; //!< Largest absolute sample value since the last Read().
+    uint64_t _samples{0}; //!< Number of samples since the last Read().
+};
@@ -0,0 +1,220 @@
+#include "AudioMixer.h"
+
+#include "Metrics.h"
+#include "RealtimeThreads.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MIXER_USE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIXER_USE_NEON 1
+#endif
+
+AudioMixer::~AudioMixer()
+{
+    CloseSources();
+}
+
+void AudioMixer::Configure(unsigned int sampleRate, unsigned int channels, unsigned int periodFrames)
+{
+    if (sampleRate == _sampleRate && channels == _channels && periodFrames == _periodFrames)
+    {
+        return;
+    }
+
+    // SDL converts to the format on opening the device, so the sources have to be opened again.
+    std::vector<std::pair<AudioDeviceRegistry::Device, float>> reopenedSources;
+    for (const auto& source : _sources)
+    {
+        reopenedSources.emplace_back(source->_device, source->_gain);
+    }
+
+    CloseSources();
+
+    _sampleRate = sampleRate;
+    _channels = channels;
+    _periodFrames = periodFrames;
+
+    for (const auto& source : reopenedSources)
+    {
+        AddSource(source.first, source.second);
+    }
+}
+
+void AudioMixer::SetPrimaryGain(float gain)
+{
+    _primaryGain = gain;
+}
+
+bool AudioMixer::AddSource(const AudioDeviceRegistry::Device& device, float gain)
+{
+    std::unique_ptr<Source> source(new Source);
+    source->_device = device;
+    source->_gain = gain;
+
+    // SDL converts the sources to the mixed format, so they can be summed directly.
+    SDL_AudioSpec requestedSpecs{};
+    SDL_AudioSpec actualSpecs{};
+    requestedSpecs.freq = static_cast<int>(_sampleRate);
+    requestedSpecs.format = AUDIO_F32SYS;
+    requestedSpecs.channels = static_cast<Uint8>(_channels);
+    requestedSpecs.samples = static_cast<Uint16>(_periodFrames);
+    requestedSpecs.callback = &AudioMixer::AudioInputCallback;
+    requestedSpecs.userdata = source.get();
+
+    // NULL for the default device, which lets SDL select it.
+    auto deviceName = device._id != 0 ? device._name.c_str() : nullptr;
+
+    // Keep up to one second of audio, the ring must be allocated before the callback runs.
+    source->_ring.Reset(static_cast<size_t>(_sampleRate) * _channels * sizeof(float));
+
+    source->_deviceID = SDL_OpenAudioDevice(deviceName, true, &requestedSpecs, &actualSpecs, 0);
+    if (source->_deviceID == 0)
+    {
+        poco_error_f3(_logger, R"(Failed to open additional audio device "%s" (ID %?d): %s)",
+                      device._name, device._id, std::string(SDL_GetError()));
+        return false;
+    }
+
+    source->_periodFrames = actualSpecs.samples;
+
+    SDL_PauseAudioDevice(source->_deviceID, false);
+
+    poco_information_f3(_logger, R"(Mixing additional audio device "%s" (ID %?d) with gain %.2f.)",
+                        device._name, device._id, static_cast<double>(gain));
+
+    _sources.push_back(std::move(source));
+
+    return true;
+}
+
+void AudioMixer::CloseSources()
+{
+    for (auto& source : _sources)
+    {
+        SDL_PauseAudioDevice(source->_deviceID, true);
+        SDL_CloseAudioDevice(source->_deviceID);
+    }
+
+    _sources.clear();
+}
+
+bool AudioMixer::Active() const
+{
+    return !_sources.empty() || _primaryGain != 1.0f;
+}
+
+const float* AudioMixer::Mix(const float* samples, size_t frames)
+{
+    TRACE_ZONE("MixAudio", "audio");
+
+    auto count = frames * _channels;
+    _mixBuffer.resize(count);
+    Scale(samples, _primaryGain, _mixBuffer.data(), count);
+
+    auto frameSize = _channels * sizeof(float);
+    for (auto& source : _sources)
+    {
+        auto availableFrames = source->_ring.Available() / frameSize;
+
+        if (!source->_primed)
+        {
+            if (availableFrames < source->_periodFrames)
+            {
+                continue;
+            }
+            source->_primed = true;
+        }
+
+        // Drop audio the source delivered faster than the primary device, so its latency stays bounded.
+        auto maxFrames = frames + 2 * source->_periodFrames;
+        if (availableFrames > maxFrames)
+        {
+            Metrics::Instance().AudioOverrun();
+            source->_ring.Skip((availableFrames - maxFrames) * frameSize);
+            availableFrames = maxFrames;
+        }
+
+        auto mixFrames = std::min(availableFrames, frames);
+        _sourceBuffer.resize(mixFrames * _channels);
+        source->_ring.Read(reinterpret_cast<uint8_t*>(_sourceBuffer.data()), mixFrames * frameSize);
+        MixAdd(_sourceBuffer.data(), source->_gain, _mixBuffer.data(), mixFrames * _channels);
+
+        // Ran dry, buffer another period before mixing the source again.
+        if (mixFrames < frames)
+        {
+            source->_primed = false;
+        }
+    }
+
+    return _mixBuffer.data();
+}
+
+void AudioMixer::Scale(const float* input, float gain, float* output, size_t count)
+{
+    size_t index{0};
+
+#if defined(MIXER_USE_SSE)
+    const __m128 gainVector = _mm_set1_ps(gain);
+    for (; index + 4 <= count; index += 4)
+    {
+        _mm_storeu_ps(output + index, _mm_mul_ps(_mm_loadu_ps(input + index), gainVector));
+    }
+#elif defined(MIXER_USE_NEON)
+    for (; index + 4 <= count; index += 4)
+    {
+        vst1q_f32(output + index, vmulq_n_f32(vld1q_f32(input + index), gain));
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        output[index] = input[index] * gain;
+    }
+}
+
+void AudioMixer::MixAdd(const float* input, float gain, float* output, size_t count)
+{
+    size_t index{0};
+
+#if defined(MIXER_USE_SSE)
+    const __m128 gainVector = _mm_set1_ps(gain);
+    for (; index + 4 <= count; index += 4)
+    {
+        __m128 mixed = _mm_add_ps(_mm_loadu_ps(output + index), _mm_mul_ps(_mm_loadu_ps(input + index), gainVector));
+        _mm_storeu_ps(output + index, mixed);
+    }
+#elif defined(MIXER_USE_NEON)
+    for (; index + 4 <= count; index += 4)
+    {
+        vst1q_f32(output + index, vmlaq_n_f32(vld1q_f32(output + index), vld1q_f32(input + index), gain));
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        output[index] += input[index] * gain;
+    }
+}
+
+void AudioMixer::AudioInputCallback(void* userData, unsigned char* stream, int len)
+{
+    TRACE_ZONE("MixerSourceCallback", "audio");
+
+    RealtimeThreads::Instance().TuneCurrentThread(RealtimeThreads::Role::Audio);
+
+    poco_assert_dbg(userData);
+    auto source = reinterpret_cast<Source*>(userData);
+
+    auto written = source->_ring.Write(stream, static_cast<size_t>(len));
+    if (written < static_cast<size_t>(len))
+    {
+        // The render thread isn't mixing this source, e.g. because the primary device stopped delivering.
+        Metrics::Instance().AudioOverrun();
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "AudioDeviceRegistry.h"
+#include "AudioRingBuffer.h"
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Logger.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Captures additional audio devices and mixes them into the primary device's audio.
+ *
+ * Each additional source is opened by SDL in the format of the mixed audio, and its callback writes into a lock-free
+ * ring, so it never waits for the render thread. The primary device's audio drives the timing: each call to Mix()
+ * takes as many frames from every source as the primary delivered.
+ *
+ * Sources with a different buffer cadence are aligned with a small jitter buffer. A source is only mixed once it has
+ * buffered one of its device periods, and is primed again after running dry. Audio queued beyond two periods plus
+ * one block is discarded, so clock drift between the devices never leads to unbounded buffering or latency.
+ *
+ * Gains are applied and the sources summed with SSE or NEON if available.
+ */
+class AudioMixer
+{
+public:
+    AudioMixer() = default;
+
+    ~AudioMixer();
+
+    /**
+     * @brief Sets the format of the mixed audio. Sources are reopened if the format changed.
+     * @param sampleRate Sample rate of the primary device's audio after resampling, in Hz.
+     * @param channels Channel count of the primary device's audio after downmixing, one or two.
+     * @param periodFrames Requested device buffer size of the sources in sample frames.
+     */
+    void Configure(unsigned int sampleRate, unsigned int channels, unsigned int periodFrames);
+
+    /**
+     * @brief Sets the gain applied to the primary device's audio.
+     * @param gain The linear gain.
+     */
+    void SetPrimaryGain(float gain);
+
+    /**
+     * @brief Opens an additional capture device and starts capturing.
+     *
+     * The device is opened by name, so it's found again when the sources are reopened after SDL's device indices
+     * changed.
+     *
+     * @param device The device's registry entry.
+     * @param gain The linear gain applied to this source.
+     * @return True if the device was opened.
+     */
+    bool AddSource(const AudioDeviceRegistry::Device& device, float gain);
+
+    /**
+     * @brief Stops capturing and closes all additional sources.
+     */
+    void CloseSources();
+
+    /**
+     * @brief Returns whether Mix() changes the primary audio.
+     * @return True if sources were added or the primary gain isn't 1.
+     */
+    bool Active() const;
+
+    /**
+     * @brief Mixes the additional sources into a block of the primary device's audio.
+     * @param samples The primary device's interleaved samples.
+     * @param frames Number of sample frames.
+     * @return The mixed samples, valid until the next call.
+     */
+    const float* Mix(const float* samples, size_t frames);
+
+    /**
+     * @brief Multiplies samples with a gain.
+     * @param input The input samples.
+     * @param gain The linear gain.
+     * @param output Receives the scaled samples. May be the same as input.
+     * @param count Number of samples.
+     */
+    static void Scale(const float* input, float gain, float* output, size_t count);
+
+    /**
+     * @brief Adds samples multiplied with a gain to an output.
+     * @param input The input samples.
+     * @param gain The linear gain.
+     * @param output The samples to add to.
+     * @param count Number of samples.
+     */
+    static void MixAdd(const float* input, float gain, float* output, size_t count);
+
+protected:
+    /**
+     * @brief An additional capture device.
+     */
+    struct Source
+    {
+        AudioDeviceRegistry::Device _device; //!< The device's registry entry.
+        SDL_AudioDeviceID _deviceID{0}; //!< SDL device ID of the opened device.
+        float _gain{1.0f}; //!< Linear gain of this source.
+        AudioRingBuffer _ring; //!< Audio captured by the callback and not mixed yet.
+        size_t _periodFrames{0}; //!< The device's buffer size, the amount buffered before the source is mixed.
+        bool _primed{false}; //!< True if enough audio was buffered and the source is being mixed.
+    };
+
+    /**
+     * @brief SDL audio capture callback of the additional sources.
+     * @param userData The source.
+     * @param stream The captured samples.
+     * @param len Size of the captured samples in bytes.
+     */
+    static void AudioInputCallback(void* userData, unsigned char* stream, int len);
+
+    unsigned int _sampleRate{44100}; //!< Sample rate of the mixed audio.
+    unsigned int _channels{2}; //!< Channel count of the mixed audio.
+    unsigned int _periodFrames{735}; //!< Requested device buffer size of the sources.
+    float _primaryGain{1.0f}; //!< Gain applied to the primary device's audio.
+
+    std::vector<std::unique_ptr<Source>> _sources; //!< The additional capture devices.
+    std::vector<float> _mixBuffer; //!< The mixed audio of the current block.
+    std::vector<float> _sourceBuffer; //!< Audio of one source read from its ring.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioMixer")}; //!< The class logger.
+};
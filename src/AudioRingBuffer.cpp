@@ -0,0 +1,77 @@
+#include "AudioRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+void AudioRingBuffer::Reset(size_t capacity)
+{
+    size_t size{1};
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    _bufferLock.Unlock();
+    _buffer.assign(size, 0);
+    _bufferLock.Lock(_buffer.data(), _buffer.size());
+    _mask = size - 1;
+    _writeIndex.store(0, std::memory_order_relaxed);
+    _readIndex.store(0, std::memory_order_relaxed);
+}
+
+size_t AudioRingBuffer::Write(const uint8_t* data, size_t size)
+{
+    auto writeIndex = _writeIndex.load(std::memory_order_relaxed);
+    auto readIndex = _readIndex.load(std::memory_order_acquire);
+
+    size = std::min(size, _buffer.size() - (writeIndex - readIndex));
+
+    // Copy in up to two parts, if the data wraps around the end of the buffer.
+    auto offset = writeIndex & _mask;
+    auto firstPart = std::min(size, _buffer.size() - offset);
+    std::memcpy(_buffer.data() + offset, data, firstPart);
+    std::memcpy(_buffer.data(), data + firstPart, size - firstPart);
+
+    _writeIndex.store(writeIndex + size, std::memory_order_release);
+
+    return size;
+}
+
+size_t AudioRingBuffer::Read(uint8_t* data, size_t size)
+{
+    auto readIndex = _readIndex.load(std::memory_order_relaxed);
+    auto writeIndex = _writeIndex.load(std::memory_order_acquire);
+
+    size = std::min(size, writeIndex - readIndex);
+
+    auto offset = readIndex & _mask;
+    auto firstPart = std::min(size, _buffer.size() - offset);
+    std::memcpy(data, _buffer.data() + offset, firstPart);
+    std::memcpy(data + firstPart, _buffer.data(), size - firstPart);
+
+    _readIndex.store(readIndex + size, std::memory_order_release);
+
+    return size;
+}
+
+size_t AudioRingBuffer::Skip(size_t size)
+{
+    auto readIndex = _readIndex.load(std::memory_order_relaxed);
+    auto writeIndex = _writeIndex.load(std::memory_order_acquire);
+
+    size = std::min(size, writeIndex - readIndex);
+
+    _readIndex.store(readIndex + size, std::memory_order_release);
+
+    return size;
+}
+
+size_t AudioRingBuffer::Available() const
+{
+    return _writeIndex.load(std::memory_order_acquire) - _readIndex.load(std::memory_order_relaxed);
+}
+
+size_t AudioRingBuffer::Free() const
+{
+    return _buffer.size() - (_writeIndex.load(std::memory_order_relaxed) - _readIndex.load(std::memory_order_acquire));
+}
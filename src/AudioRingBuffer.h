@@ -0,0 +1,70 @@
+#pragma once
+
+#include "RealtimeThreads.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Lock-free single-producer, single-consumer byte ring buffer.
+ *
+ * Lets an audio callback hand its data to the render thread without taking a lock. One thread may only call
+ * Write() and Free(), the other only Read(), Skip() and Available(). The capacity is rounded up to a power of two, so the
+ * indices can wrap freely. The storage is locked in memory if realtime.lockMemory is enabled, so the
+ * callback writing into it never page-faults.
+ */
+class AudioRingBuffer
+{
+public:
+    AudioRingBuffer() = default;
+
+    /**
+     * @brief Allocates the buffer and discards all data. Must not be called while either side is in use.
+     * @param capacity Minimum capacity in bytes.
+     */
+    void Reset(size_t capacity);
+
+    /**
+     * @brief Appends data. If the buffer is full, only the part that fits is written.
+     * @param data The data to write.
+     * @param size Size of the data in bytes.
+     * @return The number of bytes written.
+     */
+    size_t Write(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Removes the oldest data from the buffer.
+     * @param data Receives the data.
+     * @param size Maximum number of bytes to read.
+     * @return The number of bytes read.
+     */
+    size_t Read(uint8_t* data, size_t size);
+
+    /**
+     * @brief Discards the oldest data.
+     * @param size Maximum number of bytes to discard.
+     * @return The number of bytes discarded.
+     */
+    size_t Skip(size_t size);
+
+    /**
+     * @brief Returns the number of bytes available for reading.
+     * @return The readable size in bytes.
+     */
+    size_t Available() const;
+
+    /**
+     * @brief Returns the number of bytes which can be written without overflowing, e.g. to only write whole frames.
+     * @return The writable size in bytes.
+     */
+    size_t Free() const;
+
+protected:
+    std::vector<uint8_t> _buffer; //!< The ring storage, with a power of two size.
+    LockedBuffer _bufferLock; //!< Keeps _buffer locked in memory.
+    size_t _mask{0}; //!< Buffer size minus one, maps the indices to buffer offsets.
+    std::atomic<size_t> _writeIndex{0}; //!< Total bytes written. Only changed by the producer.
+    std::atomic<size_t> _readIndex{0}; //!< Total bytes read. Only changed by the consumer.
+};
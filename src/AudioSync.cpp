@@ -0,0 +1,161 @@
+#include "AudioSync.h"
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr double AudioSync::CorrectionGain;
+constexpr double AudioSync::ResyncThreshold;
+
+void AudioSync::Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    _enabled = config->getBool("enabled", true);
+    _lookaheadTime = std::max(0.0, config->getDouble("lookaheadMs", 25.0)) / 1000.0;
+    _maxCorrection = std::min(0.1, std::max(0.0, config->getDouble("maxCorrection", 0.005)));
+}
+
+void AudioSync::SetEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool AudioSync::Enabled() const
+{
+    return _enabled;
+}
+
+void AudioSync::Reset(unsigned int sampleRate, unsigned int channels, unsigned int chunkFrames)
+{
+    _sampleRate = std::max(1U, sampleRate);
+    _channels = std::max(1U, channels);
+    _chunkTime = static_cast<double>(chunkFrames) / _sampleRate;
+
+    // Chunks never arrive exactly on time, so keep a quarter chunk more than one chunk as a margin.
+    _lookahead = std::max(_lookaheadTime, _chunkTime * 1.25) * _sampleRate;
+    if (_enabled && _lookahead > _lookaheadTime * _sampleRate)
+    {
+        poco_debug_f1(_logger, "Raised the audio lookahead to %.1f ms, as the device delivers larger chunks.",
+                      _lookahead * 1000.0 / _sampleRate);
+    }
+
+    // Up to one second of audio, as resynchronizing keeps the buffer much smaller.
+    _buffer.clear();
+    _buffer.reserve(static_cast<size_t>(_sampleRate) * _channels);
+    _readPosition = 0.0;
+    _outputRemainder = 0.0;
+    _error = 0.0;
+    _captured = false;
+    _started = false;
+}
+
+void AudioSync::Append(const float* samples, size_t frames, const Poco::Clock& captureTime)
+{
+    if (frames == 0)
+    {
+        return;
+    }
+
+    _buffer.insert(_buffer.end(), samples, samples + frames * _channels);
+    _captureTime = captureTime;
+    _captured = true;
+}
+
+unsigned int AudioSync::Read(std::vector<float>& output)
+{
+    output.clear();
+
+    if (!_captured)
+    {
+        return 0;
+    }
+
+    Poco::Clock now;
+    auto bufferedFrames = static_cast<double>(_buffer.size() / _channels);
+
+    // The device keeps capturing after delivering a chunk, but never delivers later than one chunk.
+    auto sinceCapture = std::min(static_cast<double>(now - _captureTime) / 1000000.0, _chunkTime);
+    auto capturePosition = bufferedFrames + sinceCapture * _sampleRate;
+
+    if (!_started)
+    {
+        if (capturePosition < _lookahead)
+        {
+            return 0;
+        }
+
+        Resynchronize(capturePosition);
+        _lastRead = now;
+        _started = true;
+        return 0;
+    }
+
+    auto elapsed = static_cast<double>(now - _lastRead) / 1000000.0;
+    _lastRead = now;
+
+    auto deviation = (capturePosition - _readPosition - _lookahead) / _sampleRate;
+    if (std::abs(deviation) > std::max(ResyncThreshold, _lookaheadTime * 2.0))
+    {
+        poco_debug_f1(_logger, "Audio drifted %.1f ms from the lookahead, resynchronizing.", deviation * 1000.0);
+        if (deviation > 0.0)
+        {
+            Metrics::Instance().AudioOverrun();
+        }
+        Resynchronize(capturePosition);
+        bufferedFrames = static_cast<double>(_buffer.size() / _channels);
+        deviation = 0.0;
+    }
+
+    _error = _error * 0.9 + deviation * 0.1;
+    auto ratio = 1.0 + std::min(_maxCorrection, std::max(-_maxCorrection, _error * CorrectionGain));
+
+    auto exactFrames = elapsed * _sampleRate + _outputRemainder;
+    auto outputFrames = static_cast<size_t>(exactFrames);
+    _outputRemainder = exactFrames - static_cast<double>(outputFrames);
+
+    // Interpolation needs the sample frame following each read position.
+    auto readableFrames = bufferedFrames - 1.0 - _readPosition;
+    auto availableFrames = readableFrames > 0.0 ? static_cast<size_t>(readableFrames / ratio) : 0;
+    if (outputFrames > availableFrames)
+    {
+        outputFrames = availableFrames;
+        _outputRemainder = 0.0;
+    }
+
+    output.resize(outputFrames * _channels);
+    for (size_t frame = 0; frame < outputFrames; frame++)
+    {
+        auto position = _readPosition + static_cast<double>(frame) * ratio;
+        auto index = static_cast<size_t>(position);
+        auto fraction = static_cast<float>(position - static_cast<double>(index));
+
+        const float* current = &_buffer[index * _channels];
+        const float* next = current + _channels;
+        float* target = &output[frame * _channels];
+        for (unsigned int channel = 0; channel < _channels; channel++)
+        {
+            target[channel] = current[channel] + (next[channel] - current[channel]) * fraction;
+        }
+    }
+
+    _readPosition += static_cast<double>(outputFrames) * ratio;
+
+    auto consumedFrames = static_cast<size_t>(_readPosition);
+    _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(consumedFrames * _channels));
+    _readPosition -= static_cast<double>(consumedFrames);
+
+    return static_cast<unsigned int>(outputFrames);
+}
+
+void AudioSync::Resynchronize(double capturePosition)
+{
+    auto bufferedFrames = _buffer.size() / _channels;
+    auto targetPosition = std::max(0.0, capturePosition - _lookahead);
+    auto droppedFrames = std::min(static_cast<size_t>(targetPosition), bufferedFrames);
+
+    _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(droppedFrames * _channels));
+    _readPosition = std::min(targetPosition - static_cast<double>(droppedFrames),
+                             static_cast<double>(_buffer.size() / _channels));
+    _outputRemainder = 0.0;
+    _error = 0.0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Paces captured audio to the render loop, keeping a constant audio-to-visual latency.
+ *
+ * Capture devices deliver audio in chunks at their own sample clock, while frames are paced by the FPS limiter or
+ * vertical sync. Passing whatever arrived since the last frame gives some frames too many samples and others too few,
+ * and the latency wanders with the chunk timing.
+ *
+ * Instead, each frame receives the audio captured in the wall-clock time since the previous frame, ending a fixed
+ * lookahead before the current capture position. The capture position is extrapolated from the timestamp of the
+ * last delivered chunk, so it advances smoothly between chunks. Clock drift between the capture device and the
+ * system clock would slowly grow or drain the buffered audio, so the input is resampled with a ratio slightly off
+ * 1.0, proportional to the deviation from the lookahead. Large deviations, e.g. after a stall, are corrected by
+ * resynchronizing instead.
+ *
+ * Not thread-safe. All methods must be called on the render thread.
+ */
+class AudioSync
+{
+public:
+    AudioSync() = default;
+
+    /**
+     * @brief Reads the synchronization settings.
+     * @param config View of the "audio.sync" configuration subkey.
+     */
+    void Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Enables or disables synchronization.
+     * @param enabled If false, Enabled() returns false and callers pass audio through unchanged.
+     */
+    void SetEnabled(bool enabled);
+
+    /**
+     * @brief Returns whether synchronization is enabled.
+     * @return True if audio should be passed through Append() and Read().
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Discards all buffered audio and sets the format of the following data.
+     * @param sampleRate The capture sample rate in Hz.
+     * @param channels Number of interleaved channels.
+     * @param chunkFrames Number of sample frames the device delivers at once. The lookahead is at least this long.
+     */
+    void Reset(unsigned int sampleRate, unsigned int channels, unsigned int chunkFrames);
+
+    /**
+     * @brief Adds captured audio.
+     * @param samples Interleaved samples.
+     * @param frames Number of sample frames.
+     * @param captureTime Time at which the last of the samples was captured.
+     */
+    void Append(const float* samples, size_t frames, const Poco::Clock& captureTime);
+
+    /**
+     * @brief Returns the audio belonging to the current frame.
+     * @param output Receives the interleaved samples. Resized to the returned number of sample frames.
+     * @return The number of sample frames in the output. Zero if not enough audio has been captured yet.
+     */
+    unsigned int Read(std::vector<float>& output);
+
+protected:
+    /**
+     * @brief Drops or keeps buffered audio so exactly the lookahead is buffered at the extrapolated capture position.
+     * @param capturePosition The extrapolated capture position in sample frames, relative to the buffer start.
+     */
+    void Resynchronize(double capturePosition);
+
+    static constexpr double CorrectionGain{0.1}; //!< Ratio correction per second of deviation from the lookahead.
+    static constexpr double ResyncThreshold{0.1}; //!< Smallest deviation in seconds causing a resync.
+
+    bool _enabled{false}; //!< True if audio is synchronized.
+    double _lookaheadTime{0.0}; //!< Configured lookahead in seconds.
+    double _maxCorrection{0.0}; //!< Largest allowed deviation of the resampling ratio from 1.0.
+
+    unsigned int _sampleRate{0}; //!< Sample rate of the buffered audio.
+    unsigned int _channels{0}; //!< Number of interleaved channels.
+    double _chunkTime{0.0}; //!< Duration of a delivered chunk in seconds.
+    double _lookahead{0.0}; //!< Effective lookahead in sample frames.
+
+    std::vector<float> _buffer; //!< Captured samples not yet passed on.
+    double _readPosition{0.0}; //!< Fractional read position in sample frames, relative to the buffer start.
+    double _outputRemainder{0.0}; //!< Fraction of an output sample frame carried over to the next frame.
+    double _error{0.0}; //!< Smoothed deviation from the lookahead in seconds.
+
+    bool _captured{false}; //!< True once audio has been appended since the last reset.
+    bool _started{false}; //!< True once the lookahead was filled and audio is being read.
+    Poco::Clock _captureTime; //!< Capture time of the last buffered sample.
+    Poco::Clock _lastRead; //!< Time of the previous Read() call.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioSync")}; //!< The class logger.
+};
@@ -0,0 +1,431 @@
+#include "FlightRecorder.h"
+
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/LocalDateTime.h>
+#include <Poco/Path.h>
+
+#include <Poco/JSON/Array.h>
+#include <Poco/JSON/Object.h>
+
+#include <algorithm>
+
+namespace {
+const char* PhaseNames[]{
+    "PollEvents",
+    "CheckViewportSize",
+    "FillBuffer",
+    "UpdatePreviewWall",
+    "RenderFrame",
+    "DrawPreviewWall",
+    "DrawHud",
+    "Swap",
+    "LimitFPS"};
+} // namespace
+
+constexpr size_t FlightRecorder::PhaseCount;
+constexpr size_t FlightRecorder::QueryCount;
+constexpr uint32_t FlightRecorder::UnknownTime;
+
+static_assert(sizeof(PhaseNames) / sizeof(PhaseNames[0]) == static_cast<size_t>(FlightRecorder::Phase::Count),
+              "Each flight recorder phase needs a name.");
+
+FlightRecorder::~FlightRecorder()
+{
+    if (!_writerThread.isRunning())
+    {
+        return;
+    }
+
+    {
+        Poco::FastMutex::ScopedLock lock(_dumpMutex);
+        _stopWriter = true;
+    }
+    _dumpEvent.set();
+    _writerThread.join();
+}
+
+void FlightRecorder::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, int targetFPS)
+{
+    if (_enabled || !config->getBool("enabled", true))
+    {
+        return;
+    }
+
+    _targetFPS = targetFPS;
+    auto fps = static_cast<uint64_t>(targetFPS > 0 ? targetFPS : 60);
+
+    _outputPath = config->getString("outputPath",
+                                    Poco::Path::configHome() + "projectM" + Poco::Path::separator() + "flightRecorder");
+    _threshold = static_cast<uint32_t>(std::max(1.0, config->getDouble("thresholdMs", 50.0)) * 1000.0);
+    _framesBefore = static_cast<uint64_t>(std::max(0.0, config->getDouble("secondsBefore", 10.0)) * fps);
+    _framesAfter = static_cast<uint64_t>(std::max(0.0, config->getDouble("secondsAfter", 2.0)) * fps);
+    _maxDumps = config->getInt("maxDumps", 10);
+    _gpuTiming = config->getBool("measureGpuTime", true);
+
+    // Loading the first preset and filling caches regularly takes longer than any threshold.
+    _warmupFrames = fps * 2;
+
+    // All memory is allocated here, recording a frame only overwrites the oldest record.
+    _records.assign(_framesBefore + _framesAfter + 1, FrameRecord());
+    _frame = 0;
+    _startTime.update();
+
+    if (!_writerThread.isRunning())
+    {
+        _stopWriter = false;
+        _writerThread.start(*this);
+    }
+
+    _enabled = true;
+
+    poco_information_f3(_logger, "Flight recorder keeps the last %?u frames. Frames over %.1f ms are written to \"%s\".",
+                        _records.size(), static_cast<double>(_threshold) / 1000.0, _outputPath);
+}
+
+void FlightRecorder::BeginFrame()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    if (_gpuTiming && !_gpuInitialized)
+    {
+        _gpuTiming = _gl.LoadTimerQueries();
+        if (_gpuTiming)
+        {
+            _gl.GenQueries(QueryCount, _queries);
+            _gpuInitialized = true;
+        }
+    }
+
+    _frame++;
+    _frameStart.update();
+    _phaseStart = _frameStart;
+
+    auto& record = _records[_frame % _records.size()];
+    record = FrameRecord();
+    record._frame = _frame;
+    record._startTime = _frameStart - _startTime;
+}
+
+void FlightRecorder::EndPhase(Phase phase)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    Poco::Clock now;
+    _records[_frame % _records.size()]._phaseTimes[static_cast<size_t>(phase)] = static_cast<uint32_t>(now - _phaseStart);
+    _phaseStart = now;
+}
+
+void FlightRecorder::BeginGpuTiming()
+{
+    if (!_enabled || !_gpuTiming)
+    {
+        return;
+    }
+
+    CollectGpuTimes();
+
+    // Never wait for the GPU. If it's that far behind, this frame isn't measured.
+    if (_queryPending[_nextQuery])
+    {
+        return;
+    }
+
+    _gl.BeginQuery(GL_TIME_ELAPSED, _queries[_nextQuery]);
+    _queryFrames[_nextQuery] = _frame;
+    _queryActive = true;
+}
+
+void FlightRecorder::EndGpuTiming()
+{
+    if (!_queryActive)
+    {
+        return;
+    }
+
+    _gl.EndQuery(GL_TIME_ELAPSED);
+    _queryPending[_nextQuery] = true;
+    _nextQuery = (_nextQuery + 1) % QueryCount;
+    _queryActive = false;
+}
+
+void FlightRecorder::SetFrameState(unsigned int audioFrames, uint32_t presetIndex, int width, int height)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    auto& record = _records[_frame % _records.size()];
+    record._audioFrames = audioFrames;
+    record._presetIndex = presetIndex;
+    record._width = static_cast<uint16_t>(std::min(std::max(width, 0), static_cast<int>(UINT16_MAX)));
+    record._height = static_cast<uint16_t>(std::min(std::max(height, 0), static_cast<int>(UINT16_MAX)));
+}
+
+void FlightRecorder::EndFrame()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    auto& record = _records[_frame % _records.size()];
+    record._frameTime = static_cast<uint32_t>(_frameStart.elapsed());
+
+    if (!_dumpPending && record._frameTime > _threshold && _frame > _warmupFrames && _dumpCount < _maxDumps)
+    {
+        poco_warning_f2(_logger, "Frame %?u took %.1f ms, writing flight recorder dump.",
+                        _frame, static_cast<double>(record._frameTime) / 1000.0);
+
+        _dumpPending = true;
+        _spikeFrame = _frame;
+    }
+
+    if (_dumpPending && _frame >= _spikeFrame + _framesAfter)
+    {
+        QueueDump();
+    }
+}
+
+bool FlightRecorder::LastFrame(FrameSummary& summary) const
+{
+    if (!_enabled || _frame < 2)
+    {
+        return false;
+    }
+
+    const auto& record = _records[(_frame - 1) % _records.size()];
+    summary._frameTime = record._frameTime;
+    summary._cpuTime = record._frameTime - std::min(record._frameTime, record._phaseTimes[static_cast<size_t>(Phase::LimitFPS)]);
+    summary._renderTime = record._phaseTimes[static_cast<size_t>(Phase::RenderFrame)];
+    summary._eventTime = record._phaseTimes[static_cast<size_t>(Phase::PollEvents)];
+    summary._gpuTimeValid = _lastGpuTime != UnknownTime;
+    summary._gpuTime = summary._gpuTimeValid ? _lastGpuTime : 0;
+
+    return true;
+}
+
+void FlightRecorder::PresetSwitched(const std::string& presetName)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _presetSwitches.push_back({_frame, presetName});
+
+    // Keep the last switch before the oldest record, so the active preset is known for all recorded frames.
+    while (_presetSwitches.size() > 1 && _presetSwitches[1]._frame + _records.size() <= _frame)
+    {
+        _presetSwitches.pop_front();
+    }
+}
+
+void FlightRecorder::Stop()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    if (_dumpPending)
+    {
+        QueueDump();
+    }
+
+    if (_gpuInitialized)
+    {
+        _gl.DeleteQueries(QueryCount, _queries);
+        std::fill(std::begin(_queryPending), std::end(_queryPending), false);
+        _gpuInitialized = false;
+    }
+
+    _enabled = false;
+}
+
+void FlightRecorder::run()
+{
+    for (;;)
+    {
+        _dumpEvent.wait();
+
+        for (;;)
+        {
+            Dump dump;
+            {
+                Poco::FastMutex::ScopedLock lock(_dumpMutex);
+                if (_dumps.empty())
+                {
+                    break;
+                }
+                dump = std::move(_dumps.front());
+                _dumps.pop_front();
+            }
+
+            WriteDump(dump);
+        }
+
+        Poco::FastMutex::ScopedLock lock(_dumpMutex);
+        if (_stopWriter && _dumps.empty())
+        {
+            return;
+        }
+    }
+}
+
+FlightRecorder::FrameRecord* FlightRecorder::Record(uint64_t frame)
+{
+    if (frame > _frame || _frame - frame >= _records.size())
+    {
+        return nullptr;
+    }
+
+    return &_records[frame % _records.size()];
+}
+
+void FlightRecorder::CollectGpuTimes()
+{
+    for (size_t query = 0; query < QueryCount; query++)
+    {
+        if (!_queryPending[query])
+        {
+            continue;
+        }
+
+        GLuint64 available{0};
+        _gl.GetQueryObjectui64v(_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            continue;
+        }
+
+        GLuint64 nanoseconds{0};
+        _gl.GetQueryObjectui64v(_queries[query], GL_QUERY_RESULT, &nanoseconds);
+        _queryPending[query] = false;
+
+        auto* record = Record(_queryFrames[query]);
+        if (record)
+        {
+            record->_gpuTime = static_cast<uint32_t>(std::min<GLuint64>(nanoseconds / 1000, UnknownTime - 1));
+        }
+        _lastGpuTime = static_cast<uint32_t>(std::min<GLuint64>(nanoseconds / 1000, UnknownTime - 1));
+    }
+}
+
+void FlightRecorder::QueueDump()
+{
+    uint64_t oldestFrame = _frame >= _records.size() ? _frame - _records.size() + 1 : 1;
+    uint64_t firstFrame = std::max(oldestFrame, _spikeFrame > _framesBefore ? _spikeFrame - _framesBefore : 1);
+
+    Dump dump;
+    dump._spikeFrame = _spikeFrame;
+    dump._frames.reserve(_frame - firstFrame + 1);
+    for (auto frame = firstFrame; frame <= _frame; frame++)
+    {
+        dump._frames.push_back(_records[frame % _records.size()]);
+    }
+
+    for (size_t index = 0; index < _presetSwitches.size(); index++)
+    {
+        // Also include the switch to the preset active in the first frame.
+        bool activeAtStart = index + 1 < _presetSwitches.size() && _presetSwitches[index + 1]._frame > firstFrame;
+        if (_presetSwitches[index]._frame >= firstFrame || activeAtStart || index + 1 == _presetSwitches.size())
+        {
+            dump._presetSwitches.push_back(_presetSwitches[index]);
+        }
+    }
+
+    {
+        Poco::FastMutex::ScopedLock lock(_dumpMutex);
+        _dumps.push_back(std::move(dump));
+    }
+    _dumpEvent.set();
+
+    _dumpPending = false;
+    _dumpCount++;
+
+    if (_dumpCount == _maxDumps)
+    {
+        poco_warning_f1(_logger, "Reached the maximum of %?d flight recorder dumps, no more will be written.", _maxDumps);
+    }
+}
+
+void FlightRecorder::WriteDump(const Dump& dump) const
+{
+    Poco::JSON::Object report;
+    report.set("spikeFrame", dump._spikeFrame);
+    report.set("thresholdUs", _threshold);
+    report.set("targetFPS", _targetFPS);
+
+    Poco::JSON::Array::Ptr phases = new Poco::JSON::Array;
+    for (auto phaseName : PhaseNames)
+    {
+        phases->add(std::string(phaseName));
+    }
+    report.set("phases", phases);
+
+    Poco::JSON::Array::Ptr frames = new Poco::JSON::Array;
+    for (const auto& record : dump._frames)
+    {
+        Poco::JSON::Object::Ptr frame = new Poco::JSON::Object;
+        frame->set("frame", record._frame);
+        frame->set("startUs", record._startTime);
+        frame->set("frameTimeUs", record._frameTime);
+        if (record._gpuTime != UnknownTime)
+        {
+            frame->set("gpuTimeUs", record._gpuTime);
+        }
+        frame->set("audioFrames", record._audioFrames);
+        frame->set("presetIndex", record._presetIndex);
+        frame->set("width", record._width);
+        frame->set("height", record._height);
+
+        Poco::JSON::Array::Ptr phaseTimes = new Poco::JSON::Array;
+        for (auto phaseTime : record._phaseTimes)
+        {
+            phaseTimes->add(phaseTime);
+        }
+        frame->set("phaseTimesUs", phaseTimes);
+
+        frames->add(frame);
+    }
+    report.set("frames", frames);
+
+    Poco::JSON::Array::Ptr presetSwitches = new Poco::JSON::Array;
+    for (const auto& presetSwitch : dump._presetSwitches)
+    {
+        Poco::JSON::Object::Ptr entry = new Poco::JSON::Object;
+        entry->set("frame", presetSwitch._frame);
+        entry->set("preset", presetSwitch._presetName);
+        presetSwitches->add(entry);
+    }
+    report.set("presetSwitches", presetSwitches);
+
+    Poco::Path dumpFile(_outputPath);
+    dumpFile.makeDirectory();
+    dumpFile.setFileName(Poco::format("flight-%s-frame%?u.json",
+                                      Poco::DateTimeFormatter::format(Poco::LocalDateTime(), "%Y%m%d-%H%M%S"),
+                                      dump._spikeFrame));
+
+    try
+    {
+        Poco::File(_outputPath).createDirectories();
+
+        Poco::FileOutputStream output(dumpFile.toString());
+        report.stringify(output, 1);
+
+        poco_information_f1(_logger, R"(Wrote flight recorder dump "%s".)", dumpFile.toString());
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not write flight recorder dump "%s": %s)", dumpFile.toString(), ex.displayText());
+    }
+}
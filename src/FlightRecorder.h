@@ -0,0 +1,238 @@
+#pragma once
+
+#include "OpenGLFunctions.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Event.h>
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Keeps the telemetry of the most recent frames in memory and writes it to a file when a frame spikes.
+ *
+ * Every frame adds a fixed-size record with the time spent in each render loop phase, the GPU time, the number of
+ * audio samples passed to projectM, the active preset and the viewport size to a ring buffer allocated upfront.
+ * If a frame takes longer than the configured threshold, the frames before and after it are written as JSON
+ * into the output directory by a background thread, so the render loop isn't blocked by the file system.
+ *
+ * Configured via the "flightRecorder" configuration subkey.
+ */
+class FlightRecorder : public Poco::Runnable
+{
+public:
+    /**
+     * @brief Timed phases of a render loop frame, in the order they are executed.
+     */
+    enum class Phase
+    {
+        PollEvents,
+        CheckViewportSize,
+        FillBuffer,
+        UpdatePreviewWall,
+        RenderFrame,
+        DrawPreviewWall,
+        DrawHud,
+        Swap,
+        LimitFPS,
+        Count //!< Number of phases, not a phase.
+    };
+
+    /**
+     * @brief Timings of a completed frame, in microseconds.
+     */
+    struct FrameSummary {
+        uint32_t _frameTime{0}; //!< Total frame time, including frame limiting.
+        uint32_t _cpuTime{0}; //!< Time spent in all phases except frame limiting.
+        uint32_t _renderTime{0}; //!< Time spent in projectM's frame rendering.
+        uint32_t _eventTime{0}; //!< Time spent handling events, which blocks e.g. while the window is dragged.
+        uint32_t _gpuTime{0}; //!< Most recently measured GPU time, which lags a few frames behind.
+        bool _gpuTimeValid{false}; //!< True if a GPU time was measured at all.
+    };
+
+    FlightRecorder() = default;
+
+    /**
+     * @brief Destructor. Waits until all queued dumps are written.
+     */
+    ~FlightRecorder() override;
+
+    /**
+     * @brief Allocates the frame ring buffer and starts recording.
+     *
+     * Until this is called, all other methods do nothing. Does nothing if "enabled" is false in the configuration.
+     *
+     * @param config View of the "flightRecorder" configuration subkey.
+     * @param targetFPS The render loop's target FPS, used to size the ring buffer. 0 for unlimited.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, int targetFPS);
+
+    /**
+     * @brief Starts a new frame record.
+     *
+     * If GPU times are measured, the OpenGL context must be current on the first call.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Marks the end of a phase. Its duration is the time since the end of the previous phase.
+     * @param phase The phase that just ended.
+     */
+    void EndPhase(Phase phase);
+
+    /**
+     * @brief Starts timing GPU work. Can only be used once per frame.
+     */
+    void BeginGpuTiming();
+
+    /**
+     * @brief Stops timing GPU work.
+     */
+    void EndGpuTiming();
+
+    /**
+     * @brief Adds the frame's state to the current record.
+     * @param audioFrames Number of audio sample frames passed to projectM in this frame.
+     * @param presetIndex The current playlist position.
+     * @param width Viewport width.
+     * @param height Viewport height.
+     */
+    void SetFrameState(unsigned int audioFrames, uint32_t presetIndex, int width, int height);
+
+    /**
+     * @brief Finishes the current frame record, checks for a spike and schedules a dump if needed.
+     */
+    void EndFrame();
+
+    /**
+     * @brief Returns the timings of the previous frame, e.g. to display them.
+     * @param summary[out] The frame timings.
+     * @return True if the recorder is running and a frame was completed, false if no data is available.
+     */
+    bool LastFrame(FrameSummary& summary) const;
+
+    /**
+     * @brief Remembers a preset switch, so dumps contain the preset names.
+     * @param presetName The name or file of the new preset.
+     */
+    void PresetSwitched(const std::string& presetName);
+
+    /**
+     * @brief Stops recording, writes a pending dump and releases the GPU resources.
+     *
+     * The OpenGL context must be current.
+     */
+    void Stop();
+
+    /**
+     * @brief Writer thread entry point.
+     */
+    void run() override;
+
+protected:
+    static constexpr size_t PhaseCount{static_cast<size_t>(Phase::Count)}; //!< Number of phases.
+    static constexpr size_t QueryCount{4}; //!< Number of GPU timer queries in flight.
+    static constexpr uint32_t UnknownTime{UINT32_MAX}; //!< Marks a GPU time that isn't available.
+
+    /**
+     * @brief Telemetry of a single frame. Times are in microseconds.
+     */
+    struct FrameRecord {
+        uint64_t _frame{0}; //!< Frame number.
+        int64_t _startTime{0}; //!< Frame start time, relative to the recorder's creation.
+        uint32_t _frameTime{0}; //!< Total frame time, including frame limiting.
+        uint32_t _gpuTime{UnknownTime}; //!< GPU time of the frame, if measured.
+        uint32_t _phaseTimes[PhaseCount]{}; //!< Time spent in each phase.
+        uint32_t _audioFrames{0}; //!< Audio sample frames passed to projectM.
+        uint32_t _presetIndex{0}; //!< Playlist position of the active preset.
+        uint16_t _width{0}; //!< Viewport width.
+        uint16_t _height{0}; //!< Viewport height.
+    };
+
+    /**
+     * @brief A preset switch, kept separately as the names have a variable size.
+     */
+    struct PresetSwitch {
+        uint64_t _frame{0}; //!< Frame in which the preset was switched.
+        std::string _presetName; //!< The new preset.
+    };
+
+    /**
+     * @brief A dump waiting to be written by the writer thread.
+     */
+    struct Dump {
+        uint64_t _spikeFrame{0}; //!< Frame which triggered the dump.
+        std::vector<FrameRecord> _frames; //!< Frames around the spike, oldest first.
+        std::vector<PresetSwitch> _presetSwitches; //!< Preset switches within the dumped frames.
+    };
+
+    /**
+     * @brief Returns the record of the given frame if it's still in the ring buffer.
+     * @param frame The frame number.
+     * @return A pointer to the record, or nullptr if it was overwritten already.
+     */
+    FrameRecord* Record(uint64_t frame);
+
+    /**
+     * @brief Reads available GPU timer query results into their frame records, without waiting.
+     */
+    void CollectGpuTimes();
+
+    /**
+     * @brief Copies the frames around the pending spike and queues them for writing.
+     */
+    void QueueDump();
+
+    /**
+     * @brief Writes a dump to a new file in the output directory.
+     * @param dump The dump to write.
+     */
+    void WriteDump(const Dump& dump) const;
+
+    bool _enabled{false}; //!< True while recording.
+    std::string _outputPath; //!< Directory the dumps are written to.
+    uint32_t _threshold{0}; //!< Frame time in microseconds above which a frame is a spike.
+    uint64_t _framesBefore{0}; //!< Number of frames written before the spike.
+    uint64_t _framesAfter{0}; //!< Number of frames written after the spike.
+    uint64_t _warmupFrames{0}; //!< Spikes are ignored in the first frames, as startup always stalls.
+    int _maxDumps{0}; //!< Maximum number of dumps per session.
+    int _targetFPS{0}; //!< Render loop target FPS.
+
+    std::vector<FrameRecord> _records; //!< Ring buffer of frame records.
+    uint64_t _frame{0}; //!< Number of the current frame.
+    Poco::Clock _startTime; //!< Time the recorder was created.
+    Poco::Clock _frameStart; //!< Start time of the current frame.
+    Poco::Clock _phaseStart; //!< End time of the previous phase.
+
+    std::deque<PresetSwitch> _presetSwitches; //!< Recent preset switches, trimmed to the ring buffer's frames.
+
+    bool _gpuTiming{false}; //!< True if GPU times are measured.
+    bool _gpuInitialized{false}; //!< True after the timer queries were created.
+    OpenGLFunctions _gl; //!< OpenGL timer query functions.
+    GLuint _queries[QueryCount]{}; //!< Timer query objects, used round-robin.
+    uint64_t _queryFrames[QueryCount]{}; //!< Frame number measured by each query.
+    bool _queryPending[QueryCount]{}; //!< True if the query's result wasn't read yet.
+    size_t _nextQuery{0}; //!< Next query object to use.
+    bool _queryActive{false}; //!< True if a query was started in the current frame.
+    uint32_t _lastGpuTime{UnknownTime}; //!< Most recently collected GPU time.
+
+    bool _dumpPending{false}; //!< True if a spike was detected and the frames after it are being recorded.
+    uint64_t _spikeFrame{0}; //!< Frame of the pending spike.
+    int _dumpCount{0}; //!< Number of dumps queued so far.
+
+    Poco::FastMutex _dumpMutex; //!< Protects _dumps.
+    std::deque<Dump> _dumps; //!< Dumps waiting to be written.
+    Poco::Event _dumpEvent; //!< Wakes the writer thread.
+    bool _stopWriter{false}; //!< Tells the writer thread to exit. Protected by _dumpMutex.
+    Poco::Thread _writerThread{"Flight recorder"}; //!< Writes the dumps.
+
+    Poco::Logger& _logger{Poco::Logger::get("FlightRecorder")}; //!< The class logger.
+};
@@ -0,0 +1,191 @@
+#include "FrameStatistics.h"
+
+#include <algorithm>
+
+constexpr size_t FrameStatistics::QueryCount;
+
+FrameStatistics::~FrameStatistics()
+{
+    // GPU resources can only be freed with a current context, which is the caller's job via Stop().
+    poco_assert_dbg(!_gpuTiming);
+}
+
+void FrameStatistics::Start(bool measureGpuTime)
+{
+    _cpuTimes.clear();
+    _gpuTimes.clear();
+    _intervals.clear();
+    _frameStarted = false;
+    _nextQuery = 0;
+
+    _gpuTiming = measureGpuTime && _gl.LoadTimerQueries();
+    if (_gpuTiming)
+    {
+        _gl.GenQueries(QueryCount, _queries);
+        std::fill(std::begin(_queryPending), std::end(_queryPending), false);
+    }
+}
+
+void FrameStatistics::BeginFrame()
+{
+    Poco::Clock now;
+    if (_frameStarted)
+    {
+        _intervals.push_back(static_cast<uint64_t>(now - _frameStart));
+    }
+
+    _frameStart = now;
+    _frameStarted = true;
+}
+
+void FrameStatistics::BeginGpuTiming()
+{
+    if (!_gpuTiming)
+    {
+        return;
+    }
+
+    if (_queryPending[_nextQuery])
+    {
+        CollectGpuTime(_nextQuery);
+    }
+
+    _gl.BeginQuery(GL_TIME_ELAPSED, _queries[_nextQuery]);
+}
+
+void FrameStatistics::EndGpuTiming()
+{
+    if (!_gpuTiming)
+    {
+        return;
+    }
+
+    _gl.EndQuery(GL_TIME_ELAPSED);
+    _queryPending[_nextQuery] = true;
+    _nextQuery = (_nextQuery + 1) % QueryCount;
+}
+
+void FrameStatistics::EndFrame()
+{
+    _cpuTimes.push_back(static_cast<uint64_t>(_frameStart.elapsed()));
+}
+
+void FrameStatistics::Stop()
+{
+    if (!_gpuTiming)
+    {
+        return;
+    }
+
+    // Oldest query first, to keep the frame order.
+    for (size_t offset = 0; offset < QueryCount; offset++)
+    {
+        auto query = (_nextQuery + offset) % QueryCount;
+        if (_queryPending[query])
+        {
+            CollectGpuTime(query);
+        }
+    }
+
+    _gl.DeleteQueries(QueryCount, _queries);
+    _gpuTiming = false;
+}
+
+size_t FrameStatistics::FrameCount() const
+{
+    return _cpuTimes.size();
+}
+
+void FrameStatistics::Log(Poco::Logger& logger, const std::string& title) const
+{
+    Summary cpu;
+    if (!Summarize(_cpuTimes, cpu))
+    {
+        poco_information_f1(logger, "%s: no frames.", title);
+        return;
+    }
+
+    poco_information(logger, Poco::format("%s: %?d frames. CPU time: median %.2f ms, 99th percentile %.2f ms, slowest %.2f ms in frame %?d.",
+                                          title, _cpuTimes.size(),
+                                          static_cast<double>(cpu._p50) / 1000.0, static_cast<double>(cpu._p99) / 1000.0,
+                                          static_cast<double>(cpu._max) / 1000.0, cpu._maxIndex));
+
+    Summary gpu;
+    if (Summarize(_gpuTimes, gpu))
+    {
+        poco_information(logger, Poco::format("%s: GPU time: median %.2f ms, 99th percentile %.2f ms, slowest %.2f ms in frame %?d.",
+                                              title,
+                                              static_cast<double>(gpu._p50) / 1000.0, static_cast<double>(gpu._p99) / 1000.0,
+                                              static_cast<double>(gpu._max) / 1000.0, gpu._maxIndex));
+    }
+
+    Summary interval;
+    if (Summarize(_intervals, interval))
+    {
+        poco_information(logger, Poco::format("%s: Frame interval: median %.2f ms, 99th percentile %.2f ms, longest %.2f ms before frame %?d.",
+                                              title,
+                                              static_cast<double>(interval._p50) / 1000.0, static_cast<double>(interval._p99) / 1000.0,
+                                              static_cast<double>(interval._max) / 1000.0, interval._maxIndex + 1));
+    }
+}
+
+Poco::JSON::Object::Ptr FrameStatistics::ToJSON() const
+{
+    Poco::JSON::Object::Ptr result(new Poco::JSON::Object);
+    result->set("frames", _cpuTimes.size());
+
+    auto addSummary = [&result](const std::string& name, const std::vector<uint64_t>& values) {
+        Summary summary;
+        if (!Summarize(values, summary))
+        {
+            return;
+        }
+
+        Poco::JSON::Object::Ptr object(new Poco::JSON::Object);
+        object->set("p50", summary._p50);
+        object->set("p99", summary._p99);
+        object->set("max", summary._max);
+        object->set("mean", summary._mean);
+        object->set("maxFrame", summary._maxIndex);
+        result->set(name, object);
+    };
+
+    addSummary("cpu", _cpuTimes);
+    addSummary("gpu", _gpuTimes);
+    addSummary("interval", _intervals);
+
+    return result;
+}
+
+bool FrameStatistics::Summarize(std::vector<uint64_t> values, Summary& summary)
+{
+    if (values.empty())
+    {
+        return false;
+    }
+
+    auto maxElement = std::max_element(values.begin(), values.end());
+    summary._max = *maxElement;
+    summary._maxIndex = static_cast<size_t>(std::distance(values.begin(), maxElement));
+
+    uint64_t sum{0};
+    for (auto value : values)
+    {
+        sum += value;
+    }
+    summary._mean = sum / values.size();
+
+    std::sort(values.begin(), values.end());
+    summary._p50 = values.at((values.size() - 1) / 2);
+    summary._p99 = values.at((values.size() - 1) * 99 / 100);
+
+    return true;
+}
+
+void FrameStatistics::CollectGpuTime(size_t query)
+{
+    GLuint64 nanoseconds{0};
+    _gl.GetQueryObjectui64v(_queries[query], GL_QUERY_RESULT, &nanoseconds);
+    _gpuTimes.push_back(static_cast<uint64_t>(nanoseconds / 1000));
+    _queryPending[query] = false;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "OpenGLFunctions.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/JSON/Object.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Collects per-frame CPU and GPU times and frame intervals for performance measurements.
+ *
+ * CPU time is the wall-clock time between BeginFrame() and EndFrame(), the interval is the time between two
+ * consecutive BeginFrame() calls, including any frame limiting delay. GPU time is measured with OpenGL timer
+ * queries around the GPU work. Query results are read a few frames later, so measuring doesn't stall the
+ * pipeline. All times are kept in microseconds.
+ */
+class FrameStatistics
+{
+public:
+    /**
+     * @brief Percentiles and extremes of a single metric, in microseconds.
+     */
+    struct Summary {
+        uint64_t _p50{0}; //!< Median.
+        uint64_t _p99{0}; //!< 99th percentile.
+        uint64_t _max{0}; //!< Maximum.
+        uint64_t _mean{0}; //!< Arithmetic mean.
+        size_t _maxIndex{0}; //!< Index of the frame with the maximum value.
+    };
+
+    ~FrameStatistics();
+
+    /**
+     * @brief Starts a new measurement, discarding previous results.
+     *
+     * If GPU times are requested, the OpenGL context must be current.
+     *
+     * @param measureGpuTime If true, GPU times are measured if timer queries are supported.
+     */
+    void Start(bool measureGpuTime);
+
+    /**
+     * @brief Marks the beginning of a frame.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Starts timing GPU work. Can only be used once per frame.
+     */
+    void BeginGpuTiming();
+
+    /**
+     * @brief Stops timing GPU work.
+     */
+    void EndGpuTiming();
+
+    /**
+     * @brief Marks the end of a frame's work.
+     */
+    void EndFrame();
+
+    /**
+     * @brief Collects all outstanding GPU times and releases the GPU resources.
+     *
+     * The OpenGL context must be current.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the number of measured frames.
+     * @return The number of frames between Start() and Stop().
+     */
+    size_t FrameCount() const;
+
+    /**
+     * @brief Logs a summary of all metrics.
+     * @param logger The logger to use.
+     * @param title Describes what was measured, used as the start of the log message.
+     */
+    void Log(Poco::Logger& logger, const std::string& title) const;
+
+    /**
+     * @brief Returns all summaries as a JSON object.
+     *
+     * Contains "frames" and a summary object with "p50", "p99", "max", "mean" and "maxFrame" for each of "cpu",
+     * "gpu" and "interval". Metrics without any samples are omitted.
+     *
+     * @return The JSON object.
+     */
+    Poco::JSON::Object::Ptr ToJSON() const;
+
+protected:
+    static constexpr size_t QueryCount{4}; //!< Number of timer queries in flight.
+
+    /**
+     * @brief Calculates the summary of a metric.
+     * @param values The measured values.
+     * @param summary[out] Receives the summary.
+     * @return True if there were any values, false otherwise.
+     */
+    static bool Summarize(std::vector<uint64_t> values, Summary& summary);
+
+    /**
+     * @brief Reads the result of a pending timer query.
+     * @param query Index of the query.
+     */
+    void CollectGpuTime(size_t query);
+
+    OpenGLFunctions _gl; //!< OpenGL timer query functions.
+    bool _gpuTiming{false}; //!< True if GPU times are measured.
+    GLuint _queries[QueryCount]{}; //!< Timer query objects, used round-robin.
+    bool _queryPending[QueryCount]{}; //!< True if the query's result wasn't read yet.
+    size_t _nextQuery{0}; //!< Next query object to use.
+
+    bool _frameStarted{false}; //!< True after the first BeginFrame() call.
+    Poco::Clock _frameStart; //!< Start time of the current frame.
+
+    std::vector<uint64_t> _cpuTimes; //!< CPU time of each frame.
+    std::vector<uint64_t> _gpuTimes; //!< GPU time of each frame.
+    std::vector<uint64_t> _intervals; //!< Time between the starts of consecutive frames.
+};
@@ -0,0 +1,206 @@
+#include "Metrics.h"
+
+#include <Poco/Clock.h>
+#include <Poco/NumberFormatter.h>
+
+#if defined(_WIN32)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <fstream>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Formats a microsecond value as seconds, the Prometheus base unit for durations.
+ * @param valueUs The value in microseconds.
+ * @return The value in seconds.
+ */
+std::string Seconds(int64_t valueUs)
+{
+    return Poco::NumberFormatter::format(static_cast<double>(valueUs) / 1000000.0, 6);
+}
+
+void AppendHeader(const char* name, const char* help, const char* type, std::string& out)
+{
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+void AppendValue(const char* name, const char* help, const char* type, const std::string& value, std::string& out)
+{
+    AppendHeader(name, help, type, out);
+    out.append(name).append(" ").append(value).append("\n");
+}
+
+} // namespace
+
+const int64_t Metrics::Histogram::Bounds[Metrics::Histogram::BucketCount]{
+    1000, 2000, 4000, 8000, 12000, 16667, 20000, 33333, 50000, 100000, 250000, 1000000};
+
+void Metrics::Histogram::Observe(int64_t valueUs)
+{
+    int bucket = 0;
+    while (bucket < BucketCount && valueUs > Bounds[bucket])
+    {
+        bucket++;
+    }
+
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _sumUs.fetch_add(valueUs, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Histogram::Format(const char* name, const char* help, std::string& out) const
+{
+    AppendHeader(name, help, "histogram", out);
+
+    uint64_t cumulative{0};
+    for (int bucket = 0; bucket < BucketCount; bucket++)
+    {
+        cumulative += _buckets[bucket].load(std::memory_order_relaxed);
+        out.append(name).append("_bucket{le=\"").append(Seconds(Bounds[bucket])).append("\"} ");
+        out.append(std::to_string(cumulative)).append("\n");
+    }
+    cumulative += _buckets[BucketCount].load(std::memory_order_relaxed);
+    out.append(name).append("_bucket{le=\"+Inf\"} ").append(std::to_string(cumulative)).append("\n");
+
+    out.append(name).append("_sum ").append(Seconds(_sumUs.load(std::memory_order_relaxed))).append("\n");
+    out.append(name).append("_count ").append(std::to_string(_count.load(std::memory_order_relaxed))).append("\n");
+}
+
+Metrics& Metrics::Instance()
+{
+    static Metrics instance;
+    return instance;
+}
+
+void Metrics::FrameFinished(int64_t frameTimeUs, int targetFps)
+{
+    _frameTime.Observe(frameTimeUs);
+    _frames.fetch_add(1, std::memory_order_relaxed);
+
+    if (targetFps > 0 && frameTimeUs * targetFps > 1500000)
+    {
+        _missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    _fpsWindowUs += frameTimeUs;
+    _fpsWindowFrames++;
+    if (_fpsWindowUs >= 1000000)
+    {
+        _fpsMilli.store(static_cast<uint32_t>(_fpsWindowFrames * 1000000000LL / _fpsWindowUs), std::memory_order_relaxed);
+        _fpsWindowUs = 0;
+        _fpsWindowFrames = 0;
+    }
+}
+
+void Metrics::SetResolution(int width, int height)
+{
+    _width.store(width, std::memory_order_relaxed);
+    _height.store(height, std::memory_order_relaxed);
+}
+
+void Metrics::SetMeshSize(size_t width, size_t height)
+{
+    _meshWidth.store(static_cast<uint32_t>(width), std::memory_order_relaxed);
+    _meshHeight.store(static_cast<uint32_t>(height), std::memory_order_relaxed);
+}
+
+void Metrics::AudioOverrun()
+{
+    _audioOverruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::AudioUnderrun()
+{
+    _audioUnderruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::PresetSwitched(int64_t latencyUs)
+{
+    _presetSwitchLatency.Observe(latencyUs);
+}
+
+std::string Metrics::PrometheusText() const
+{
+    std::string out;
+    out.reserve(4096);
+
+    AppendValue("projectm_fps", "Frames rendered per second, measured over the last second.", "gauge",
+                Poco::NumberFormatter::format(_fpsMilli.load(std::memory_order_relaxed) / 1000.0, 3), out);
+    AppendValue("projectm_frames_total", "Number of frames rendered by the main render loop.", "counter",
+                std::to_string(_frames.load(std::memory_order_relaxed)), out);
+    _frameTime.Format("projectm_frame_time_seconds", "Frame time of the main render loop, including FPS limiting.", out);
+    AppendValue("projectm_missed_deadlines_total", "Frames taking longer than 1.5 times the target frame interval.", "counter",
+                std::to_string(_missedDeadlines.load(std::memory_order_relaxed)), out);
+
+    AppendValue("projectm_audio_overruns_total", "Times captured audio was dropped because the renderer fell behind.", "counter",
+                std::to_string(_audioOverruns.load(std::memory_order_relaxed)), out);
+    AppendValue("projectm_audio_underruns_total", "Frames which received no new audio data from an open capture device.", "counter",
+                std::to_string(_audioUnderruns.load(std::memory_order_relaxed)), out);
+
+    _presetSwitchLatency.Format("projectm_preset_switch_latency_seconds", "Duration of explicitly requested preset switches.", out);
+
+    AppendValue("projectm_render_width_pixels", "Current rendering width.", "gauge",
+                std::to_string(_width.load(std::memory_order_relaxed)), out);
+    AppendValue("projectm_render_height_pixels", "Current rendering height.", "gauge",
+                std::to_string(_height.load(std::memory_order_relaxed)), out);
+    AppendValue("projectm_mesh_width", "Number of per-pixel mesh columns.", "gauge",
+                std::to_string(_meshWidth.load(std::memory_order_relaxed)), out);
+    AppendValue("projectm_mesh_height", "Number of per-pixel mesh rows.", "gauge",
+                std::to_string(_meshHeight.load(std::memory_order_relaxed)), out);
+
+    auto rss = ResidentSetSize();
+    if (rss >= 0)
+    {
+        AppendValue("process_resident_memory_bytes", "Resident memory size in bytes.", "gauge", std::to_string(rss), out);
+    }
+
+    return out;
+}
+
+int64_t Metrics::ResidentSetSize()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<int64_t>(counters.WorkingSetSize);
+    }
+    return -1;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    {
+        return static_cast<int64_t>(info.resident_size);
+    }
+    return -1;
+#else
+    // Second field is the number of resident pages.
+    std::ifstream statm("/proc/self/statm");
+    int64_t size{0};
+    int64_t resident{0};
+    if (statm >> size >> resident)
+    {
+        return resident * static_cast<int64_t>(sysconf(_SC_PAGESIZE));
+    }
+    return -1;
+#endif
+}
+
+PresetSwitchTimer::PresetSwitchTimer()
+    : _start(Poco::Clock().microseconds())
+{
+}
+
+PresetSwitchTimer::~PresetSwitchTimer()
+{
+    Metrics::Instance().PresetSwitched(Poco::Clock().microseconds() - _start);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Collects runtime metrics and formats them in the Prometheus text exposition format.
+ *
+ * All recording functions only use relaxed atomic operations, so they can be called from the render loop and
+ * the audio callback without ever blocking. The values are read when the metrics endpoint is scraped, so a
+ * scrape may see a histogram update only partially applied, which is acceptable for monitoring.
+ */
+class Metrics
+{
+public:
+    /**
+     * @brief Cumulative histogram with fixed bucket bounds.
+     */
+    class Histogram
+    {
+    public:
+        static constexpr int BucketCount{12}; //!< Number of buckets, not counting the +Inf bucket.
+
+        /**
+         * @brief Adds a single observation.
+         * @param valueUs The observed value in microseconds.
+         */
+        void Observe(int64_t valueUs);
+
+        /**
+         * @brief Appends the histogram in Prometheus text format.
+         * @param name Metric name, without suffixes.
+         * @param help Help text.
+         * @param out String to append to.
+         */
+        void Format(const char* name, const char* help, std::string& out) const;
+
+        static const int64_t Bounds[BucketCount]; //!< Upper bucket bounds in microseconds.
+
+    protected:
+        std::atomic<uint64_t> _buckets[BucketCount + 1]{}; //!< Non-cumulative bucket counts, the last one is +Inf.
+        std::atomic<uint64_t> _count{0}; //!< Number of observations.
+        std::atomic<int64_t> _sumUs{0}; //!< Sum of all observations in microseconds.
+    };
+
+    /**
+     * @brief Returns the global metrics instance.
+     * @return The metrics.
+     */
+    static Metrics& Instance();
+
+    /**
+     * @brief Records a finished frame of the main render loop.
+     *
+     * Also updates the FPS gauge once per second. Must only be called from the main render loop.
+     *
+     * @param frameTimeUs Time the frame took, including the FPS limiter wait, in microseconds.
+     * @param targetFps The target FPS, or 0 if unlimited.
+     */
+    void FrameFinished(int64_t frameTimeUs, int targetFps);
+
+    /**
+     * @brief Sets the current rendering resolution.
+     * @param width Width in pixels.
+     * @param height Height in pixels.
+     */
+    void SetResolution(int width, int height);
+
+    /**
+     * @brief Sets the current per-pixel mesh size.
+     * @param width Number of mesh columns.
+     * @param height Number of mesh rows.
+     */
+    void SetMeshSize(size_t width, size_t height);
+
+    /**
+     * @brief Counts audio samples which were dropped because the renderer didn't consume them in time.
+     */
+    void AudioOverrun();
+
+    /**
+     * @brief Counts a frame which got no new audio data from an open capture device.
+     */
+    void AudioUnderrun();
+
+    /**
+     * @brief Records the time an explicitly requested preset switch took.
+     * @param latencyUs Switch duration in microseconds.
+     */
+    void PresetSwitched(int64_t latencyUs);
+
+    /**
+     * @brief Formats all metrics in the Prometheus text exposition format, version 0.0.4.
+     * @return The metrics text.
+     */
+    std::string PrometheusText() const;
+
+protected:
+    Metrics() = default;
+
+    /**
+     * @brief Returns the resident set size of the process.
+     * @return The RSS in bytes, or -1 if not supported on this platform.
+     */
+    static int64_t ResidentSetSize();
+
+    Histogram _frameTime; //!< Frame times of the main render loop.
+    Histogram _presetSwitchLatency; //!< Durations of explicit preset switches.
+
+    std::atomic<uint64_t> _frames{0}; //!< Number of rendered frames.
+    std::atomic<uint64_t> _missedDeadlines{0}; //!< Frames taking more than 1.5 times the target frame interval.
+    std::atomic<uint64_t> _audioOverruns{0}; //!< Number of times captured audio was dropped.
+    std::atomic<uint64_t> _audioUnderruns{0}; //!< Number of frames without new audio data.
+    std::atomic<uint32_t> _fpsMilli{0}; //!< Measured FPS over the last second, times 1000.
+    std::atomic<int> _width{0}; //!< Rendering width in pixels.
+    std::atomic<int> _height{0}; //!< Rendering height in pixels.
+    std::atomic<uint32_t> _meshWidth{0}; //!< Per-pixel mesh columns.
+    std::atomic<uint32_t> _meshHeight{0}; //!< Per-pixel mesh rows.
+
+    int64_t _fpsWindowUs{0}; //!< Time accumulated in the current FPS window. Render loop only.
+    uint32_t _fpsWindowFrames{0}; //!< Frames rendered in the current FPS window. Render loop only.
+};
+
+/**
+ * @brief Records the lifetime of this object as a preset switch latency metric.
+ */
+class PresetSwitchTimer
+{
+public:
+    PresetSwitchTimer();
+
+    ~PresetSwitchTimer();
+
+    PresetSwitchTimer(const PresetSwitchTimer&) = delete;
+    PresetSwitchTimer& operator=(const PresetSwitchTimer&) = delete;
+
+private:
+    int64_t _start; //!< Start time in microseconds.
+};
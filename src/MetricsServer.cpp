@@ -0,0 +1,134 @@
+#include "MetricsServer.h"
+
+#include "Metrics.h"
+#include "Tracer.h"
+
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+
+#include <Poco/Util/Application.h>
+
+namespace {
+
+class MetricsRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override
+    {
+        if (request.getURI() != "/metrics")
+        {
+            response.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+            response.setContentType("text/plain");
+            response.send() << "Not found. Metrics are served at /metrics.\n";
+            return;
+        }
+
+        auto text = Metrics::Instance().PrometheusText();
+        response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+        response.setContentType("text/plain; version=0.0.4; charset=utf-8");
+        response.setContentLength(static_cast<long long>(text.size()));
+        response.send() << text;
+    }
+};
+
+class MetricsRequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+    Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&) override
+    {
+        return new MetricsRequestHandler;
+    }
+};
+
+} // namespace
+
+const char* MetricsServer::name() const
+{
+    return "Metrics Server";
+}
+
+void MetricsServer::initialize(Poco::Util::Application& app)
+{
+    TRACE_ZONE("MetricsServer::initialize", "init");
+
+    auto config = app.config().createView("metrics");
+    if (!config->getBool("enabled", false))
+    {
+        return;
+    }
+
+    auto listen = config->getString("listen", "127.0.0.1:9464");
+
+    try
+    {
+        Poco::Net::SocketAddress address;
+        if (listen.compare(0, 5, "unix:") == 0)
+        {
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+            auto socketPath = listen.substr(5);
+
+            // A socket file left behind by a crashed instance would make binding fail.
+            if (!_socketFile.Prepare(socketPath))
+            {
+                poco_error_f1(_logger, R"(Could not start metrics endpoint on "%s".)", listen);
+                return;
+            }
+
+            address = Poco::Net::SocketAddress(Poco::Net::AddressFamily::UNIX_LOCAL, socketPath);
+#else
+            poco_error_f1(_logger, R"(Could not start metrics endpoint on "%s": Unix domain sockets are not supported on this platform.)",
+                          listen);
+            return;
+#endif
+        }
+        else
+        {
+            address = Poco::Net::SocketAddress(listen);
+        }
+
+        Poco::Net::ServerSocket socket(address);
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+        if (listen.compare(0, 5, "unix:") == 0)
+        {
+            _socketFile.Claim();
+        }
+#endif
+
+        Poco::Net::HTTPServerParams::Ptr params = new Poco::Net::HTTPServerParams;
+        params->setMaxThreads(2);
+        params->setMaxQueued(16);
+        params->setKeepAlive(false);
+
+        _server.reset(new Poco::Net::HTTPServer(new MetricsRequestHandlerFactory, socket, params));
+        _server->start();
+
+        poco_information_f1(_logger, "Serving metrics on %s/metrics.", listen);
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not start metrics endpoint on "%s": %s)", listen, ex.displayText());
+        _server.reset();
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+        _socketFile.Remove();
+#endif
+    }
+}
+
+void MetricsServer::uninitialize()
+{
+    if (_server)
+    {
+        _server->stopAll(true);
+        _server.reset();
+    }
+
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+    // Only removes the socket file this server bound, not one another instance created at the same path.
+    _socketFile.Remove();
+#endif
+}
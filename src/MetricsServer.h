@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <Poco/Net/HTTPServer.h>
+
+#include <Poco/Util/Subsystem.h>
+
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+#include "UnixSocketFile.h"
+#endif
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief Serves the collected Metrics on a local HTTP endpoint in the Prometheus text format.
+ *
+ * Disabled by default. If "metrics.enabled" is set, "/metrics" is served on the address given in
+ * "metrics.listen", either "host:port" or "unix:<path>" for a Unix domain socket. Requests are handled on
+ * the HTTP server's own threads, which only read the metric atomics.
+ */
+class MetricsServer : public Poco::Util::Subsystem
+{
+public:
+    const char* name() const override;
+
+    void initialize(Poco::Util::Application& app) override;
+
+    void uninitialize() override;
+
+protected:
+    std::unique_ptr<Poco::Net::HTTPServer> _server; //!< The HTTP server, if enabled.
+
+    Poco::Logger& _logger{Poco::Logger::get("MetricsServer")}; //!< The class logger.
+
+#if defined(POCO_HAS_UNIX_SOCKET) && !defined(_WIN32)
+    UnixSocketFile _socketFile{_logger}; //!< The Unix domain socket file, removed on shutdown if this server created it.
+#endif
+};
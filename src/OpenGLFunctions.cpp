@@ -0,0 +1,77 @@
+#include "OpenGLFunctions.h"
+
+#include <SDL2/SDL.h>
+
+namespace {
+
+template<typename FunctionPointer>
+bool LoadFunction(FunctionPointer& function, const char* name)
+{
+    function = reinterpret_cast<FunctionPointer>(SDL_GL_GetProcAddress(name));
+    return function != nullptr;
+}
+
+} // namespace
+
+bool OpenGLFunctions::Load()
+{
+    bool success{true};
+
+    success &= LoadFunction(GenFramebuffers, "glGenFramebuffers");
+    success &= LoadFunction(DeleteFramebuffers, "glDeleteFramebuffers");
+    success &= LoadFunction(BindFramebuffer, "glBindFramebuffer");
+    success &= LoadFunction(FramebufferTexture2D, "glFramebufferTexture2D");
+    success &= LoadFunction(CheckFramebufferStatus, "glCheckFramebufferStatus");
+    success &= LoadFunction(BlitFramebuffer, "glBlitFramebuffer");
+
+    return success;
+}
+
+bool OpenGLFunctions::LoadTimerQueries()
+{
+    bool success{true};
+
+    success &= LoadFunction(GenQueries, "glGenQueries");
+    success &= LoadFunction(DeleteQueries, "glDeleteQueries");
+    success &= LoadFunction(BeginQuery, "glBeginQuery");
+    success &= LoadFunction(EndQuery, "glEndQuery");
+    success &= LoadFunction(GetQueryObjectui64v, "glGetQueryObjectui64v");
+
+    return success;
+}
+
+bool OpenGLFunctions::LoadDrawFunctions()
+{
+    bool success{true};
+
+    success &= LoadFunction(GenBuffers, "glGenBuffers");
+    success &= LoadFunction(DeleteBuffers, "glDeleteBuffers");
+    success &= LoadFunction(BindBuffer, "glBindBuffer");
+    success &= LoadFunction(BufferData, "glBufferData");
+    success &= LoadFunction(MapBufferRange, "glMapBufferRange");
+    success &= LoadFunction(UnmapBuffer, "glUnmapBuffer");
+    success &= LoadFunction(GenVertexArrays, "glGenVertexArrays");
+    success &= LoadFunction(DeleteVertexArrays, "glDeleteVertexArrays");
+    success &= LoadFunction(BindVertexArray, "glBindVertexArray");
+    success &= LoadFunction(EnableVertexAttribArray, "glEnableVertexAttribArray");
+    success &= LoadFunction(VertexAttribPointer, "glVertexAttribPointer");
+    success &= LoadFunction(CreateShader, "glCreateShader");
+    success &= LoadFunction(DeleteShader, "glDeleteShader");
+    success &= LoadFunction(ShaderSource, "glShaderSource");
+    success &= LoadFunction(CompileShader, "glCompileShader");
+    success &= LoadFunction(GetShaderiv, "glGetShaderiv");
+    success &= LoadFunction(GetShaderInfoLog, "glGetShaderInfoLog");
+    success &= LoadFunction(CreateProgram, "glCreateProgram");
+    success &= LoadFunction(DeleteProgram, "glDeleteProgram");
+    success &= LoadFunction(AttachShader, "glAttachShader");
+    success &= LoadFunction(LinkProgram, "glLinkProgram");
+    success &= LoadFunction(GetProgramiv, "glGetProgramiv");
+    success &= LoadFunction(GetProgramInfoLog, "glGetProgramInfoLog");
+    success &= LoadFunction(UseProgram, "glUseProgram");
+    success &= LoadFunction(GetUniformLocation, "glGetUniformLocation");
+    success &= LoadFunction(Uniform1i, "glUniform1i");
+    success &= LoadFunction(Uniform2f, "glUniform2f");
+    success &= LoadFunction(ActiveTexture, "glActiveTexture");
+
+    return success;
+}
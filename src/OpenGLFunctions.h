@@ -0,0 +1,73 @@
+#pragma once
+
+#include <SDL2/SDL_opengl.h>
+
+/**
+ * @brief OpenGL 3.x entry points used by the frontend's own rendering code.
+ *
+ * Not all platform GL libraries export functions beyond OpenGL 1.1, so these are always loaded
+ * via SDL_GL_GetProcAddress(). An OpenGL context must be current when calling Load().
+ */
+class OpenGLFunctions
+{
+public:
+    /**
+     * @brief Loads all function pointers from the current OpenGL context.
+     * @return True if all functions could be loaded, false if at least one is not available.
+     */
+    bool Load();
+
+    /**
+     * @brief Loads the timer query functions, which are optional and not available in OpenGL ES.
+     * @return True if all timer query functions could be loaded.
+     */
+    bool LoadTimerQueries();
+
+    /**
+     * @brief Loads the shader, buffer and vertex array functions used to draw geometry.
+     * @return True if all functions could be loaded.
+     */
+    bool LoadDrawFunctions();
+
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers{nullptr};
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers{nullptr};
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer{nullptr};
+    PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D{nullptr};
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus{nullptr};
+    PFNGLBLITFRAMEBUFFERPROC BlitFramebuffer{nullptr};
+
+    PFNGLGENQUERIESPROC GenQueries{nullptr};
+    PFNGLDELETEQUERIESPROC DeleteQueries{nullptr};
+    PFNGLBEGINQUERYPROC BeginQuery{nullptr};
+    PFNGLENDQUERYPROC EndQuery{nullptr};
+    PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v{nullptr};
+
+    PFNGLGENBUFFERSPROC GenBuffers{nullptr};
+    PFNGLDELETEBUFFERSPROC DeleteBuffers{nullptr};
+    PFNGLBINDBUFFERPROC BindBuffer{nullptr};
+    PFNGLBUFFERDATAPROC BufferData{nullptr};
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange{nullptr};
+    PFNGLUNMAPBUFFERPROC UnmapBuffer{nullptr};
+    PFNGLGENVERTEXARRAYSPROC GenVertexArrays{nullptr};
+    PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays{nullptr};
+    PFNGLBINDVERTEXARRAYPROC BindVertexArray{nullptr};
+    PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray{nullptr};
+    PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer{nullptr};
+    PFNGLCREATESHADERPROC CreateShader{nullptr};
+    PFNGLDELETESHADERPROC DeleteShader{nullptr};
+    PFNGLSHADERSOURCEPROC ShaderSource{nullptr};
+    PFNGLCOMPILESHADERPROC CompileShader{nullptr};
+    PFNGLGETSHADERIVPROC GetShaderiv{nullptr};
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog{nullptr};
+    PFNGLCREATEPROGRAMPROC CreateProgram{nullptr};
+    PFNGLDELETEPROGRAMPROC DeleteProgram{nullptr};
+    PFNGLATTACHSHADERPROC AttachShader{nullptr};
+    PFNGLLINKPROGRAMPROC LinkProgram{nullptr};
+    PFNGLGETPROGRAMIVPROC GetProgramiv{nullptr};
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog{nullptr};
+    PFNGLUSEPROGRAMPROC UseProgram{nullptr};
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation{nullptr};
+    PFNGLUNIFORM1IPROC Uniform1i{nullptr};
+    PFNGLUNIFORM2FPROC Uniform2f{nullptr};
+    PFNGLACTIVETEXTUREPROC ActiveTexture{nullptr};
+};
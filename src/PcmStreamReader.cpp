@@ -0,0 +1,291 @@
+#include "PcmStreamReader.h"
+
+#include "Metrics.h"
+#include "RealtimeThreads.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+PcmStreamReader::~PcmStreamReader()
+{
+    Close();
+}
+
+bool PcmStreamReader::Open(const std::string& source, size_t frameSize, size_t capacity)
+{
+    Close();
+
+    _source = source;
+    _frameSize = std::max<size_t>(1, frameSize);
+    _socketPath = source.compare(0, 5, "unix:") == 0 ? source.substr(5) : std::string();
+
+    _ring.Reset(capacity);
+    _readBuffer.assign(std::max<size_t>(capacity / 4, _frameSize * 2), 0);
+    _partialSize = 0;
+
+    if (!OpenSource())
+    {
+        return false;
+    }
+
+    _stop = false;
+    _thread.start(*this);
+
+    return true;
+}
+
+void PcmStreamReader::Close()
+{
+    if (_thread.isRunning())
+    {
+        _stop = true;
+        _thread.join();
+    }
+
+    CloseSource(true);
+}
+
+void PcmStreamReader::Read(std::vector<uint8_t>& buffer, size_t maxSize)
+{
+    auto available = _ring.Available() / _frameSize * _frameSize;
+    maxSize = maxSize / _frameSize * _frameSize;
+
+    if (available > maxSize)
+    {
+        // The renderer is lagging behind, drop the oldest frames.
+        Metrics::Instance().AudioOverrun();
+        _ring.Skip(available - maxSize);
+        available = maxSize;
+    }
+
+    buffer.resize(available);
+    buffer.resize(_ring.Read(buffer.data(), available));
+}
+
+void PcmStreamReader::run()
+{
+    RealtimeThreads::Instance().TuneCurrentThread(RealtimeThreads::Role::Audio);
+
+    while (!_stop)
+    {
+        if (_fd < 0)
+        {
+            // Standard input can't be reopened.
+            if (_source == "-")
+            {
+                return;
+            }
+
+            if (_listenFd >= 0)
+            {
+                AcceptProducer();
+                continue;
+            }
+
+            // Reopening a FIFO only fails if it was removed, retry a bit later then.
+            if (!OpenSource())
+            {
+                poll(nullptr, 0, 10 * PollTimeout);
+                continue;
+            }
+        }
+
+        pollfd pollFd{_fd, POLLIN, 0};
+        auto result = poll(&pollFd, 1, PollTimeout);
+        if (result < 0 && errno != EINTR)
+        {
+            poco_error_f2(_logger, R"(Polling the PCM stream "%s" failed: %s)", _source, std::string(std::strerror(errno)));
+            return;
+        }
+
+        // A hangup can still come with data, which is read before the end of the stream is detected.
+        if (result > 0 && (pollFd.revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !ReadAvailable())
+        {
+            if (_source == "-")
+            {
+                poco_information(_logger, "Reached the end of the PCM stream on standard input.");
+            }
+            else
+            {
+                poco_information_f1(_logger, R"(The producer of the PCM stream "%s" disconnected, waiting for the next one.)", _source);
+            }
+
+            CloseSource(false);
+            _partialSize = 0;
+        }
+    }
+}
+
+bool PcmStreamReader::OpenSource()
+{
+    if (_source == "-")
+    {
+        // Standard input is shared with the parent shell, so its flags are restored when closing.
+        _fd = STDIN_FILENO;
+        _stdinFlags = fcntl(_fd, F_GETFL);
+    }
+    else if (!_socketPath.empty())
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (_socketPath.size() >= sizeof(address.sun_path))
+        {
+            poco_error_f1(_logger, R"(The PCM stream socket path "%s" is too long.)", _socketPath);
+            return false;
+        }
+        std::strncpy(address.sun_path, _socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        // Remove a stale socket file left behind by a previous run, but never a live socket or anything else.
+        if (!_socketFile.Prepare(_socketPath))
+        {
+            return false;
+        }
+
+        _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_listenFd < 0)
+        {
+            poco_error_f1(_logger, "Could not create the PCM stream socket: %s", std::string(std::strerror(errno)));
+            return false;
+        }
+
+        if (bind(_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            poco_error_f2(_logger, R"(Could not bind the PCM stream socket "%s": %s)", _socketPath,
+                          std::string(std::strerror(errno)));
+            CloseSource(true);
+            return false;
+        }
+        _socketFile.Claim();
+
+        if (listen(_listenFd, 1) != 0)
+        {
+            poco_error_f2(_logger, R"(Could not listen on the PCM stream socket "%s": %s)", _socketPath,
+                          std::string(std::strerror(errno)));
+            CloseSource(true);
+            return false;
+        }
+
+        fcntl(_listenFd, F_SETFL, fcntl(_listenFd, F_GETFL) | O_NONBLOCK);
+        poco_information_f1(_logger, R"(Waiting for a PCM stream producer on socket "%s".)", _socketPath);
+        return true;
+    }
+    else
+    {
+        // Non-blocking, so opening a FIFO doesn't wait for a writer.
+        _fd = open(_source.c_str(), O_RDONLY | O_NONBLOCK);
+        if (_fd < 0)
+        {
+            poco_error_f2(_logger, R"(Could not open the PCM stream "%s": %s)", _source, std::string(std::strerror(errno)));
+            return false;
+        }
+    }
+
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    poco_information_f1(_logger, R"(Reading PCM stream from "%s".)", _source);
+
+    return true;
+}
+
+bool PcmStreamReader::AcceptProducer()
+{
+    pollfd pollFd{_listenFd, POLLIN, 0};
+    if (poll(&pollFd, 1, PollTimeout) <= 0)
+    {
+        return false;
+    }
+
+    _fd = accept(_listenFd, nullptr, nullptr);
+    if (_fd < 0)
+    {
+        return false;
+    }
+
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    poco_information_f1(_logger, R"(A PCM stream producer connected to socket "%s".)", _socketPath);
+
+    return true;
+}
+
+bool PcmStreamReader::ReadAvailable()
+{
+    TRACE_ZONE("ReadPcmStream", "audio");
+
+    for (;;)
+    {
+        auto bytesRead = read(_fd, _readBuffer.data() + _partialSize, _readBuffer.size() - _partialSize);
+
+        if (bytesRead == 0)
+        {
+            return false;
+        }
+
+        if (bytesRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return true;
+            }
+
+            poco_error_f2(_logger, R"(Reading the PCM stream "%s" failed: %s)", _source, std::string(std::strerror(errno)));
+            return false;
+        }
+
+        // Only whole frames go into the ring. If it's full, the newest frames are dropped, as the render thread
+        // drops the oldest ones itself once it catches up.
+        auto size = _partialSize + static_cast<size_t>(bytesRead);
+        auto wholeFrames = size / _frameSize * _frameSize;
+        auto writable = std::min(wholeFrames, _ring.Free() / _frameSize * _frameSize);
+        _ring.Write(_readBuffer.data(), writable);
+        if (writable < wholeFrames)
+        {
+            Metrics::Instance().AudioOverrun();
+        }
+
+        // Keep the incomplete frame for the next read.
+        _partialSize = size - wholeFrames;
+        std::memmove(_readBuffer.data(), _readBuffer.data() + wholeFrames, _partialSize);
+    }
+}
+
+void PcmStreamReader::CloseSource(bool closeListener)
+{
+    if (_fd == STDIN_FILENO)
+    {
+        if (_stdinFlags >= 0)
+        {
+            fcntl(_fd, F_SETFL, _stdinFlags);
+            _stdinFlags = -1;
+        }
+    }
+    else if (_fd >= 0)
+    {
+        close(_fd);
+    }
+    _fd = -1;
+
+    if (!closeListener)
+    {
+        return;
+    }
+
+    if (_listenFd >= 0)
+    {
+        close(_listenFd);
+        _listenFd = -1;
+    }
+
+    // Only removes the socket file this reader created, and only if it wasn't replaced meanwhile.
+    _socketFile.Remove();
+}
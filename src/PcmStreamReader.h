@@ -0,0 +1,115 @@
+#pragma once
+
+#include "AudioRingBuffer.h"
+#include "UnixSocketFile.h"
+
+#include <Poco/Logger.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reads raw interleaved PCM from standard input, a FIFO or a Unix domain socket.
+ *
+ * Lets decoders and playback engines feed the visualizer directly, without the latency and resampling of a loopback
+ * sound device. A background thread waits for data with poll() and reads it non-blocking into the same kind of
+ * lock-free ring the mixer uses for capture devices. Partial reads are kept until the rest of the frame arrives, so
+ * only whole frames enter the ring and the render thread never sees a misaligned stream.
+ *
+ * If the producer stalls, the render thread simply gets fewer samples. If it goes away, the reader waits for the
+ * next one: a FIFO is reopened, and a socket accepts the next connection. Standard input can't be reopened, so
+ * reading stops at its end.
+ *
+ * Only one producer is read at a time. Sources are given as "-" for standard input, "unix:<path>" for a socket the
+ * reader listens on, or the path of a FIFO. A stale socket file at the path is replaced, but if any other kind of
+ * file exists there, the reader refuses to start.
+ */
+class PcmStreamReader : public Poco::Runnable
+{
+public:
+    PcmStreamReader() = default;
+
+    /**
+     * @brief Destructor. Stops reading.
+     */
+    ~PcmStreamReader() override;
+
+    /**
+     * @brief Opens the source and starts reading in the background.
+     * @param source "-" for standard input, "unix:<path>" for a Unix domain socket or the path of a FIFO.
+     * @param frameSize Size of a sample frame in bytes.
+     * @param capacity Ring buffer size in bytes.
+     * @return True if the source could be opened. Waiting for a producer to connect doesn't count as failure.
+     */
+    bool Open(const std::string& source, size_t frameSize, size_t capacity);
+
+    /**
+     * @brief Stops reading and closes the source.
+     */
+    void Close();
+
+    /**
+     * @brief Takes the newest whole frames from the ring. Called by the render thread.
+     *
+     * If more data is available than requested, e.g. because rendering stalled, the oldest data is discarded.
+     *
+     * @param buffer Receives the data.
+     * @param maxSize Largest size to read in bytes.
+     */
+    void Read(std::vector<uint8_t>& buffer, size_t maxSize);
+
+    /**
+     * @brief Reader thread entry point.
+     */
+    void run() override;
+
+protected:
+    /**
+     * @brief Opens standard input, the FIFO or the listening socket.
+     * @return True if the source was opened.
+     */
+    bool OpenSource();
+
+    /**
+     * @brief Waits for and accepts the next producer on the listening socket.
+     * @return True if a producer connected.
+     */
+    bool AcceptProducer();
+
+    /**
+     * @brief Reads all data currently available from the producer into the ring.
+     * @return False if the producer closed the stream or a read error occurred.
+     */
+    bool ReadAvailable();
+
+    /**
+     * @brief Closes the producer's file descriptor, and the listening socket if requested.
+     * @param closeListener If true, the listening socket is closed and its file removed as well.
+     */
+    void CloseSource(bool closeListener);
+
+    static constexpr int PollTimeout{100}; //!< Time in milliseconds after which the thread checks the stop flag.
+
+    std::string _source; //!< The configured source.
+    std::string _socketPath; //!< File system path of the socket, empty if not reading from a socket.
+    size_t _frameSize{0}; //!< Size of a sample frame in bytes.
+
+    int _fd{-1}; //!< File descriptor of the producer's stream.
+    int _listenFd{-1}; //!< Listening socket, -1 if not reading from a socket.
+    UnixSocketFile _socketFile{Poco::Logger::get("PcmStreamReader")}; //!< The socket's file system entry, removed when closing if this reader created it.
+    int _stdinFlags{-1}; //!< Original file status flags of standard input, restored when closing.
+
+    AudioRingBuffer _ring; //!< Whole frames waiting to be read by the render thread.
+    std::vector<uint8_t> _readBuffer; //!< Data read from the producer, starting with the incomplete frame of the last read.
+    size_t _partialSize{0}; //!< Bytes of the incomplete frame at the start of _readBuffer.
+
+    std::atomic<bool> _stop{false}; //!< Tells the reader thread to exit.
+    Poco::Thread _thread{"PCM stream reader"}; //!< Reads from the source.
+
+    Poco::Logger& _logger{Poco::Logger::get("PcmStreamReader")}; //!< The class logger.
+};
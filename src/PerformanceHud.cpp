@@ -0,0 +1,627 @@
+#include "PerformanceHud.h"
+
+#include <Poco/Path.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+/**
+ * 8x8 pixel glyphs of the printable ASCII characters 0x20 to 0x7E, one byte per row, top row first.
+ * The least significant bit is the leftmost pixel. Based on the public domain font8x8 by Daniel Hepper.
+ * The last entry (0x7F) is a solid block, used to draw rectangles from the same atlas.
+ */
+const uint8_t Font8x8[96][8]{
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // '!'
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // '#'
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // '$'
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // '%'
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // '&'
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '''
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // '('
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // ')'
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // '*'
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ','
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // '.'
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // '/'
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // '0'
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // '1'
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // '2'
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // '3'
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // '4'
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // '5'
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // '6'
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // '7'
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // '8'
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ';'
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // '<'
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // '='
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // '>'
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // '?'
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // '@'
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // 'A'
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // 'B'
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // 'C'
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // 'D'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // 'E'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // 'F'
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // 'G'
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // 'H'
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'I'
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // 'J'
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // 'K'
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // 'L'
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // 'M'
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // 'N'
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // 'O'
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // 'P'
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // 'Q'
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // 'R'
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // 'S'
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'T'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // 'U'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // 'V'
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // 'W'
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // 'X'
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // 'Y'
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // 'Z'
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // '['
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // '\'
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ']'
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // '_'
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // 'a'
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // 'b'
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // 'c'
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // 'd'
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // 'e'
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // 'f'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // 'g'
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // 'h'
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'i'
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // 'j'
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // 'k'
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'l'
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // 'm'
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // 'n'
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // 'o'
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // 'p'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // 'q'
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // 'r'
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // 's'
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // 't'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // 'u'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // 'v'
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // 'w'
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // 'x'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // 'y'
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // 'z'
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // '{'
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // '|'
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // '}'
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '~'
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, // Solid block
+};
+
+constexpr int GlyphSize{8}; //!< Glyph width and height in atlas pixels.
+constexpr int AtlasColumns{16}; //!< Glyphs per atlas row.
+constexpr int AtlasRows{6}; //!< Glyph rows in the atlas.
+constexpr int AtlasWidth{AtlasColumns * GlyphSize}; //!< Atlas texture width.
+constexpr int AtlasHeight{AtlasRows * GlyphSize}; //!< Atlas texture height.
+constexpr int SolidGlyph{95}; //!< Index of the solid block glyph.
+
+constexpr int64_t TextUpdateInterval{250000}; //!< Microseconds between text updates.
+constexpr int GpuTimeLag{4}; //!< Frames after a preset switch until GPU times belong to the new preset.
+
+#if USE_GLES
+#define HUD_SHADER_HEADER "#version 300 es\nprecision mediump float;\n"
+#else
+#define HUD_SHADER_HEADER "#version 330 core\n"
+#endif
+
+const char* VertexShaderSource = HUD_SHADER_HEADER R"(
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+
+uniform vec2 viewportSize;
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    gl_Position = vec4(position.x / viewportSize.x * 2.0 - 1.0, 1.0 - position.y / viewportSize.y * 2.0, 0.0, 1.0);
+    fragTexCoord = texCoord;
+    fragColor = color;
+}
+)";
+
+const char* FragmentShaderSource = HUD_SHADER_HEADER R"(
+uniform sampler2D atlas;
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+out vec4 outColor;
+
+void main()
+{
+    outColor = vec4(fragColor.rgb, fragColor.a * texture(atlas, fragTexCoord).r);
+}
+)";
+
+} // namespace
+
+constexpr int PerformanceHud::GraphFrames;
+constexpr int PerformanceHud::GraphHeight;
+constexpr int PerformanceHud::TextLines;
+constexpr int PerformanceHud::LineLength;
+
+PerformanceHud::PerformanceHud()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    _visible = config.getBool("hud.visible", false);
+    _scale = std::min(std::max(config.getInt("hud.scale", 2), 1), 8);
+
+    auto targetFps = config.getInt("projectM.fps", 60);
+    _targetFrameTime = targetFps > 0 ? 1000.0 / targetFps : 0.0;
+
+    _vertices.reserve(static_cast<size_t>(6 * (2 + GraphFrames + TextLines * LineLength)));
+}
+
+PerformanceHud::~PerformanceHud()
+{
+    DestroyResources();
+}
+
+bool PerformanceHud::Visible() const
+{
+    return _visible;
+}
+
+void PerformanceHud::Toggle()
+{
+    _visible = !_visible;
+
+    if (_visible)
+    {
+        // Statistics aren't updated while hidden, so start over.
+        std::fill(std::begin(_frameTimes), std::end(_frameTimes), 0.0f);
+        _nextFrameTime = 0;
+        _windowFrames = 0;
+        _windowFrameTime = 0.0;
+        _windowCpuTime = 0.0;
+        _presetFrames = 0;
+        _presetRenderTime = 0.0;
+        _presetGpuTime = 0.0;
+        _presetGpuFrames = 0;
+        _lastFrame.update();
+        _windowStart.update();
+        FormatText();
+    }
+}
+
+void PerformanceHud::PresetSwitched(const std::string& presetName)
+{
+    _presetName = Poco::Path(presetName).getBaseName();
+    _presetFrames = 0;
+    _presetRenderTime = 0.0;
+    _presetGpuTime = 0.0;
+    _presetGpuFrames = 0;
+}
+
+void PerformanceHud::Draw(int width, int height, unsigned int audioFrames, const FlightRecorder::FrameSummary* lastFrame)
+{
+    if (!_visible || width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    if (!_resourcesCreated)
+    {
+        if (_resourcesFailed || !CreateResources())
+        {
+            DestroyResources();
+            _resourcesFailed = true;
+            _visible = false;
+            return;
+        }
+    }
+
+    UpdateStatistics(audioFrames, lastFrame);
+
+    const float scale = static_cast<float>(_scale);
+    const float padding = 4.0f * scale;
+    const float lineHeight = 10.0f * scale;
+    const float panelLeft = padding;
+    const float panelTop = padding;
+    const float contentWidth = static_cast<float>(std::max(LineLength * GlyphSize, GraphFrames)) * scale;
+    const float graphHeight = static_cast<float>(GraphHeight) * scale;
+    const float graphTop = panelTop + padding + TextLines * lineHeight + padding;
+    const float graphBottom = graphTop + graphHeight;
+
+    const Color background{0, 0, 0, 170};
+    const Color text{230, 230, 230, 255};
+    const Color targetLine{255, 255, 255, 90};
+    const Color good{80, 220, 80, 255};
+    const Color late{240, 200, 40, 255};
+    const Color missed{240, 60, 50, 255};
+
+    _vertices.clear();
+
+    AddRectangle(panelLeft, panelTop, panelLeft + contentWidth + 2.0f * padding, graphBottom + padding, background);
+
+    for (int line = 0; line < TextLines; line++)
+    {
+        AddText(panelLeft + padding, panelTop + padding + static_cast<float>(line) * lineHeight, _lines[line], text);
+    }
+
+    // Frame time graph, scaled so the target frame time is at half height. Oldest frame on the left.
+    double graphMaximum = _targetFrameTime > 0.0 ? 2.0 * _targetFrameTime : 33.3;
+    if (_targetFrameTime > 0.0)
+    {
+        float targetY = graphBottom - graphHeight * 0.5f;
+        AddRectangle(panelLeft + padding, targetY - scale * 0.5f, panelLeft + padding + contentWidth, targetY + scale * 0.5f, targetLine);
+    }
+
+    for (int bar = 0; bar < GraphFrames; bar++)
+    {
+        float frameTime = _frameTimes[(_nextFrameTime + bar) % GraphFrames];
+        if (frameTime <= 0.0f)
+        {
+            continue;
+        }
+
+        Color color = good;
+        if (_targetFrameTime > 0.0 && frameTime > _targetFrameTime * 1.5)
+        {
+            color = missed;
+        }
+        else if (_targetFrameTime > 0.0 && frameTime > _targetFrameTime * 1.1)
+        {
+            color = late;
+        }
+
+        float barHeight = graphHeight * static_cast<float>(std::min(1.0, frameTime / graphMaximum));
+        float left = panelLeft + padding + static_cast<float>(bar) * scale;
+        AddRectangle(left, graphBottom - barHeight, left + scale, graphBottom, color);
+    }
+
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    _gl.UseProgram(_program);
+    _gl.Uniform2f(_viewportSizeLocation, static_cast<GLfloat>(width), static_cast<GLfloat>(height));
+    _gl.ActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    _gl.BindVertexArray(_vertexArray);
+    _gl.BindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+
+    // Orphan the previous frame's storage, so the driver never has to wait for the GPU to finish reading it.
+    auto size = static_cast<GLsizeiptr>(_vertices.size() * sizeof(Vertex));
+    _gl.BufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertexCapacity * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+    void* mappedVertices = _gl.MapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mappedVertices)
+    {
+        std::memcpy(mappedVertices, _vertices.data(), static_cast<size_t>(size));
+        if (_gl.UnmapBuffer(GL_ARRAY_BUFFER))
+        {
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
+        }
+    }
+
+    _gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    _gl.BindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    _gl.UseProgram(0);
+    glDisable(GL_BLEND);
+}
+
+bool PerformanceHud::CreateResources()
+{
+    if (!_gl.LoadDrawFunctions())
+    {
+        poco_error(_logger, "Could not load the required OpenGL functions, the performance HUD is not available.");
+        return false;
+    }
+
+    // Shaders
+    auto compileShader = [this](GLenum type, const char* source) -> GLuint {
+        GLuint shader = _gl.CreateShader(type);
+        _gl.ShaderSource(shader, 1, &source, nullptr);
+        _gl.CompileShader(shader);
+
+        GLint status{GL_FALSE};
+        _gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            GLchar log[1024]{};
+            _gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            poco_error_f1(_logger, "Could not compile HUD shader: %s", std::string(log));
+            _gl.DeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    };
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, VertexShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, FragmentShaderSource);
+    if (!vertexShader || !fragmentShader)
+    {
+        if (vertexShader)
+        {
+            _gl.DeleteShader(vertexShader);
+        }
+        if (fragmentShader)
+        {
+            _gl.DeleteShader(fragmentShader);
+        }
+        return false;
+    }
+
+    _program = _gl.CreateProgram();
+    _gl.AttachShader(_program, vertexShader);
+    _gl.AttachShader(_program, fragmentShader);
+    _gl.LinkProgram(_program);
+    _gl.DeleteShader(vertexShader);
+    _gl.DeleteShader(fragmentShader);
+
+    GLint linkStatus{GL_FALSE};
+    _gl.GetProgramiv(_program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        GLchar log[1024]{};
+        _gl.GetProgramInfoLog(_program, sizeof(log), nullptr, log);
+        poco_error_f1(_logger, "Could not link HUD shader program: %s", std::string(log));
+        return false;
+    }
+
+    _viewportSizeLocation = _gl.GetUniformLocation(_program, "viewportSize");
+    _gl.UseProgram(_program);
+    _gl.Uniform1i(_gl.GetUniformLocation(_program, "atlas"), 0);
+    _gl.UseProgram(0);
+
+    // Glyph atlas
+    std::vector<uint8_t> atlas(static_cast<size_t>(AtlasWidth * AtlasHeight), 0);
+    for (int glyph = 0; glyph < AtlasColumns * AtlasRows; glyph++)
+    {
+        int glyphLeft = (glyph % AtlasColumns) * GlyphSize;
+        int glyphTop = (glyph / AtlasColumns) * GlyphSize;
+        for (int row = 0; row < GlyphSize; row++)
+        {
+            for (int column = 0; column < GlyphSize; column++)
+            {
+                if (Font8x8[glyph][row] & (1 << column))
+                {
+                    atlas[static_cast<size_t>((glyphTop + row) * AtlasWidth + glyphLeft + column)] = 255;
+                }
+            }
+        }
+    }
+
+    glGenTextures(1, &_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, AtlasWidth, AtlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Vertex buffer and layout
+    _vertexCapacity = _vertices.capacity();
+
+    _gl.GenVertexArrays(1, &_vertexArray);
+    _gl.GenBuffers(1, &_vertexBuffer);
+    _gl.BindVertexArray(_vertexArray);
+    _gl.BindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    _gl.BufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertexCapacity * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+
+    _gl.EnableVertexAttribArray(0);
+    _gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _x)));
+    _gl.EnableVertexAttribArray(1);
+    _gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _u)));
+    _gl.EnableVertexAttribArray(2);
+    _gl.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _color)));
+
+    _gl.BindVertexArray(0);
+    _gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    _resourcesCreated = true;
+
+    return true;
+}
+
+void PerformanceHud::DestroyResources()
+{
+    if (_vertexBuffer)
+    {
+        _gl.DeleteBuffers(1, &_vertexBuffer);
+        _vertexBuffer = 0;
+    }
+
+    if (_vertexArray)
+    {
+        _gl.DeleteVertexArrays(1, &_vertexArray);
+        _vertexArray = 0;
+    }
+
+    if (_atlasTexture)
+    {
+        glDeleteTextures(1, &_atlasTexture);
+        _atlasTexture = 0;
+    }
+
+    if (_program)
+    {
+        _gl.DeleteProgram(_program);
+        _program = 0;
+    }
+
+    _resourcesCreated = false;
+}
+
+void PerformanceHud::UpdateStatistics(unsigned int audioFrames, const FlightRecorder::FrameSummary* lastFrame)
+{
+    auto frameTime = static_cast<double>(_lastFrame.elapsed()) / 1000.0;
+    _lastFrame.update();
+
+    _frameTimes[_nextFrameTime] = static_cast<float>(frameTime);
+    _nextFrameTime = (_nextFrameTime + 1) % GraphFrames;
+
+    _windowFrames++;
+    _windowFrameTime += frameTime;
+    _audioFrames = audioFrames;
+
+    _cpuTimeValid = lastFrame != nullptr;
+    if (lastFrame)
+    {
+        _windowCpuTime += static_cast<double>(lastFrame->_cpuTime) / 1000.0;
+        _gpuTime = lastFrame->_gpuTimeValid ? static_cast<double>(lastFrame->_gpuTime) / 1000.0 : -1.0;
+
+        _presetFrames++;
+        _presetRenderTime += static_cast<double>(lastFrame->_renderTime) / 1000.0;
+        if (lastFrame->_gpuTimeValid && _presetFrames > GpuTimeLag)
+        {
+            _presetGpuFrames++;
+            _presetGpuTime += _gpuTime;
+        }
+    }
+    else
+    {
+        _gpuTime = -1.0;
+    }
+
+    if (_windowStart.elapsed() >= TextUpdateInterval)
+    {
+        FormatText();
+        _windowStart.update();
+        _windowFrames = 0;
+        _windowFrameTime = 0.0;
+        _windowCpuTime = 0.0;
+    }
+}
+
+void PerformanceHud::FormatText()
+{
+    char line[64];
+
+    double averageFrameTime = _windowFrames > 0 ? _windowFrameTime / _windowFrames : 0.0;
+    double fps = averageFrameTime > 0.0 ? 1000.0 / averageFrameTime : 0.0;
+    std::snprintf(line, sizeof(line), "FPS %5.1f  Frame %5.2f ms", fps, averageFrameTime);
+    _lines[0] = line;
+
+    if (_cpuTimeValid && _windowFrames > 0)
+    {
+        if (_gpuTime >= 0.0)
+        {
+            std::snprintf(line, sizeof(line), "CPU %5.2f ms  GPU %5.2f ms", _windowCpuTime / _windowFrames, _gpuTime);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "CPU %5.2f ms  GPU n/a", _windowCpuTime / _windowFrames);
+        }
+    }
+    else
+    {
+        std::snprintf(line, sizeof(line), "CPU n/a  GPU n/a");
+    }
+    _lines[1] = line;
+
+    std::snprintf(line, sizeof(line), "Audio buffer %u frames", _audioFrames);
+    _lines[2] = line;
+
+    _lines[3] = _presetName.empty() ? std::string("No preset") : _presetName.substr(0, LineLength);
+
+    if (_presetFrames > 0)
+    {
+        if (_presetGpuFrames > 0)
+        {
+            std::snprintf(line, sizeof(line), "Preset CPU %5.2f GPU %5.2f ms",
+                          _presetRenderTime / _presetFrames, _presetGpuTime / _presetGpuFrames);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "Preset CPU %5.2f ms", _presetRenderTime / _presetFrames);
+        }
+    }
+    else
+    {
+        std::snprintf(line, sizeof(line), "Preset cost n/a");
+    }
+    _lines[4] = line;
+}
+
+void PerformanceHud::AddRectangle(float left, float top, float right, float bottom, Color color)
+{
+    float u = (static_cast<float>((SolidGlyph % AtlasColumns) * GlyphSize) + GlyphSize * 0.5f) / AtlasWidth;
+    float v = (static_cast<float>((SolidGlyph / AtlasColumns) * GlyphSize) + GlyphSize * 0.5f) / AtlasHeight;
+    AddQuad(left, top, right, bottom, u, v, u, v, color);
+}
+
+void PerformanceHud::AddText(float left, float top, const std::string& text, Color color)
+{
+    const float glyphSize = static_cast<float>(GlyphSize * _scale);
+    auto length = std::min(text.size(), static_cast<size_t>(LineLength));
+
+    for (size_t index = 0; index < length; index++)
+    {
+        auto character = static_cast<unsigned char>(text[index]);
+        if (character == ' ')
+        {
+            continue;
+        }
+        if (character < 0x20 || character > 0x7E)
+        {
+            character = '?';
+        }
+
+        int glyph = character - 0x20;
+        float u0 = static_cast<float>((glyph % AtlasColumns) * GlyphSize) / AtlasWidth;
+        float v0 = static_cast<float>((glyph / AtlasColumns) * GlyphSize) / AtlasHeight;
+        float u1 = u0 + static_cast<float>(GlyphSize) / AtlasWidth;
+        float v1 = v0 + static_cast<float>(GlyphSize) / AtlasHeight;
+
+        float x = left + static_cast<float>(index) * glyphSize;
+        AddQuad(x, top, x + glyphSize, top + glyphSize, u0, v0, u1, v1, color);
+    }
+}
+
+void PerformanceHud::AddQuad(float left, float top, float right, float bottom, float u0, float v0, float u1, float v1, Color color)
+{
+    if (_vertices.size() + 6 > _vertices.capacity())
+    {
+        return;
+    }
+
+    Vertex topLeft{left, top, u0, v0, color};
+    Vertex topRight{right, top, u1, v0, color};
+    Vertex bottomLeft{left, bottom, u0, v1, color};
+    Vertex bottomRight{right, bottom, u1, v1, color};
+
+    _vertices.push_back(topLeft);
+    _vertices.push_back(bottomLeft);
+    _vertices.push_back(topRight);
+    _vertices.push_back(topRight);
+    _vertices.push_back(bottomLeft);
+    _vertices.push_back(bottomRight);
+}
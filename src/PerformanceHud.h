@@ -0,0 +1,166 @@
+#pragma once
+
+#include "FlightRecorder.h"
+#include "OpenGLFunctions.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief On-screen overlay showing frame timings, audio input and the cost of the current preset.
+ *
+ * Shows a frame time graph of the most recent frames, FPS, CPU and GPU time, the number of audio frames
+ * received in the last frame, and the current preset with its average render cost since it was loaded.
+ *
+ * All text and graph geometry is drawn with a single draw call. Glyphs come from a built-in 8x8 pixel font,
+ * which is uploaded into a small atlas texture once. Rectangles use a solid atlas cell, so they can be batched
+ * with the text. Vertices are written into an orphaned stream buffer each frame, so the GPU never stalls on it.
+ * The text is only reformatted a few times per second.
+ *
+ * Configured via the "hud" configuration subkey.
+ */
+class PerformanceHud
+{
+public:
+    PerformanceHud();
+
+    /**
+     * @brief Destructor. Must be called on the rendering thread.
+     */
+    ~PerformanceHud();
+
+    /**
+     * @brief Returns whether the overlay is currently shown.
+     * @return True if the overlay is drawn.
+     */
+    bool Visible() const;
+
+    /**
+     * @brief Shows or hides the overlay.
+     */
+    void Toggle();
+
+    /**
+     * @brief Remembers the new preset and restarts measuring its cost.
+     * @param presetName The name or file of the new preset.
+     */
+    void PresetSwitched(const std::string& presetName);
+
+    /**
+     * @brief Draws the overlay on top of the current output, if visible.
+     * @param width The drawable width.
+     * @param height The drawable height.
+     * @param audioFrames Number of audio sample frames passed to projectM in this frame.
+     * @param lastFrame Timings of the previous frame, or nullptr if not available.
+     */
+    void Draw(int width, int height, unsigned int audioFrames, const FlightRecorder::FrameSummary* lastFrame);
+
+protected:
+    static constexpr int GraphFrames{240}; //!< Number of frames shown in the frame time graph.
+    static constexpr int GraphHeight{60}; //!< Graph height in unscaled pixels.
+    static constexpr int TextLines{5}; //!< Number of text lines.
+    static constexpr int LineLength{30}; //!< Maximum characters per text line.
+
+    /**
+     * @brief An 8-bit RGBA color.
+     */
+    struct Color {
+        uint8_t _r{0}; //!< Red.
+        uint8_t _g{0}; //!< Green.
+        uint8_t _b{0}; //!< Blue.
+        uint8_t _a{0}; //!< Alpha.
+    };
+
+    /**
+     * @brief A single HUD vertex in window pixel coordinates.
+     */
+    struct Vertex {
+        float _x{0.0f}; //!< Horizontal position in pixels, from the left.
+        float _y{0.0f}; //!< Vertical position in pixels, from the top.
+        float _u{0.0f}; //!< Atlas texture coordinate.
+        float _v{0.0f}; //!< Atlas texture coordinate.
+        Color _color; //!< Vertex color.
+    };
+
+    /**
+     * @brief Creates the shader program, atlas texture and vertex buffer.
+     * @return True if all resources were created successfully.
+     */
+    bool CreateResources();
+
+    /**
+     * @brief Destroys all OpenGL resources.
+     */
+    void DestroyResources();
+
+    /**
+     * @brief Updates the frame time history and the averages shown as text.
+     * @param audioFrames Number of audio sample frames passed to projectM in this frame.
+     * @param lastFrame Timings of the previous frame, or nullptr if not available.
+     */
+    void UpdateStatistics(unsigned int audioFrames, const FlightRecorder::FrameSummary* lastFrame);
+
+    /**
+     * @brief Formats the text lines from the current averages.
+     */
+    void FormatText();
+
+    /**
+     * @brief Appends a solid rectangle to the vertex batch.
+     */
+    void AddRectangle(float left, float top, float right, float bottom, Color color);
+
+    /**
+     * @brief Appends a line of text to the vertex batch.
+     */
+    void AddText(float left, float top, const std::string& text, Color color);
+
+    /**
+     * @brief Appends a textured quad to the vertex batch.
+     */
+    void AddQuad(float left, float top, float right, float bottom, float u0, float v0, float u1, float v1, Color color);
+
+    bool _visible{false}; //!< True if the overlay is shown.
+    int _scale{2}; //!< Integer pixel scale of the overlay.
+    double _targetFrameTime{0.0}; //!< Target frame time in milliseconds, 0 if unlimited.
+
+    OpenGLFunctions _gl; //!< OpenGL 3 entry points.
+    GLuint _program{0}; //!< Shader program.
+    GLint _viewportSizeLocation{-1}; //!< Location of the viewport size uniform.
+    GLuint _atlasTexture{0}; //!< Glyph atlas texture.
+    GLuint _vertexArray{0}; //!< Vertex array object describing the vertex layout.
+    GLuint _vertexBuffer{0}; //!< Stream vertex buffer, orphaned every frame.
+    size_t _vertexCapacity{0}; //!< Maximum number of vertices in the buffer.
+    bool _resourcesCreated{false}; //!< True if the GL resources exist.
+    bool _resourcesFailed{false}; //!< True if creating the GL resources failed, so it isn't retried every frame.
+
+    std::vector<Vertex> _vertices; //!< Vertex batch of the current frame.
+
+    Poco::Clock _lastFrame; //!< Time the previous frame was drawn.
+    float _frameTimes[GraphFrames]{}; //!< Ring buffer of recent frame times in milliseconds.
+    int _nextFrameTime{0}; //!< Next frame time ring buffer index.
+
+    Poco::Clock _windowStart; //!< Start of the current text update interval.
+    int _windowFrames{0}; //!< Frames drawn in the current interval.
+    double _windowFrameTime{0.0}; //!< Sum of frame times in the current interval, in milliseconds.
+    double _windowCpuTime{0.0}; //!< Sum of CPU times in the current interval, in milliseconds.
+    double _gpuTime{-1.0}; //!< Latest GPU time in milliseconds, -1 if not available.
+    bool _cpuTimeValid{false}; //!< True if CPU times are available.
+    unsigned int _audioFrames{0}; //!< Audio frames received in the last frame.
+
+    std::string _presetName; //!< Name of the current preset.
+    int _presetFrames{0}; //!< Frames rendered with the current preset.
+    double _presetRenderTime{0.0}; //!< Sum of projectM render times with the current preset, in milliseconds.
+    double _presetGpuTime{0.0}; //!< Sum of GPU times with the current preset, in milliseconds.
+    int _presetGpuFrames{0}; //!< Frames with a GPU time since the current preset was loaded.
+
+    std::string _lines[TextLines]; //!< Formatted text lines.
+
+    Poco::Logger& _logger{Poco::Logger::get("PerformanceHud")}; //!< The class logger.
+};
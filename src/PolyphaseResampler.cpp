@@ -0,0 +1,224 @@
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RESAMPLER_USE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLER_USE_NEON 1
+#endif
+
+constexpr unsigned int PolyphaseResampler::MaxPhases;
+
+namespace {
+
+constexpr double Pi{3.14159265358979323846};
+
+/**
+ * @brief Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+ * @param x The function argument.
+ * @return I0(x).
+ */
+double BesselI0(double x)
+{
+    double sum{1.0};
+    double term{1.0};
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+unsigned int GreatestCommonDivisor(unsigned int a, unsigned int b)
+{
+    while (b != 0)
+    {
+        auto remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+} // namespace
+
+void PolyphaseResampler::Configure(unsigned int inputRate, unsigned int outputRate, unsigned int channels, unsigned int taps)
+{
+    _channels = std::max(1U, channels);
+    _coefficients.clear();
+    _history.clear();
+    _phases = 0;
+    _step = 0;
+
+    if (inputRate == 0 || outputRate == 0 || inputRate == outputRate)
+    {
+        return;
+    }
+
+    auto divisor = GreatestCommonDivisor(inputRate, outputRate);
+    _phases = outputRate / divisor;
+    _step = inputRate / divisor;
+
+    if (_phases > MaxPhases)
+    {
+        // Find the closest ratio with a usable number of phases.
+        double ratio = static_cast<double>(inputRate) / outputRate;
+        double bestError{1.0};
+        for (unsigned int phases = 1; phases <= MaxPhases; phases++)
+        {
+            auto step = static_cast<unsigned int>(std::lround(phases * ratio));
+            double error = std::abs(static_cast<double>(step) / phases - ratio) / ratio;
+            if (step > 0 && error < bestError)
+            {
+                bestError = error;
+                _phases = phases;
+                _step = step;
+            }
+        }
+    }
+
+    _taps = std::max<size_t>(4, (static_cast<size_t>(taps) + 3) / 4 * 4);
+
+    // Prototype low-pass filter at the upsampled rate. The cutoff leaves room for the transition band below the
+    // lower Nyquist frequency, and the gain makes up for the zeros inserted by upsampling.
+    auto length = _taps * _phases;
+    double cutoff = 0.45 * std::min(1.0, static_cast<double>(_phases) / _step) / _phases;
+    double center = static_cast<double>(length - 1) / 2.0;
+    constexpr double beta{8.0};
+    double windowNormalization = BesselI0(beta);
+
+    _coefficients.resize(length);
+    for (unsigned int phase = 0; phase < _phases; phase++)
+    {
+        for (size_t tap = 0; tap < _taps; tap++)
+        {
+            auto index = phase + tap * _phases;
+            double offset = static_cast<double>(index) - center;
+            double sinc = offset == 0.0 ? 1.0 : std::sin(2.0 * Pi * cutoff * offset) / (2.0 * Pi * cutoff * offset);
+            double position = 2.0 * static_cast<double>(index) / static_cast<double>(length - 1) - 1.0;
+            double window = BesselI0(beta * std::sqrt(std::max(0.0, 1.0 - position * position))) / windowNormalization;
+
+            // Phases are stored reversed, so the dot product runs over the input in ascending order.
+            _coefficients[phase * _taps + (_taps - 1 - tap)] =
+                static_cast<float>(2.0 * cutoff * sinc * window * _phases);
+        }
+    }
+
+    // Start with silence, so the first output sample already has a full filter history.
+    _history.assign(_channels, std::vector<float>(_taps - 1, 0.0f));
+    _inputIndex = _taps - 1;
+    _phase = 0;
+}
+
+bool PolyphaseResampler::Active() const
+{
+    return _phases > 0;
+}
+
+size_t PolyphaseResampler::Process(const float* input, size_t frames, std::vector<float>& output)
+{
+    output.clear();
+
+    if (!Active())
+    {
+        return 0;
+    }
+
+    for (unsigned int channel = 0; channel < _channels; channel++)
+    {
+        auto& history = _history[channel];
+        auto offset = history.size();
+        history.resize(offset + frames);
+        for (size_t frame = 0; frame < frames; frame++)
+        {
+            history[offset + frame] = input[frame * _channels + channel];
+        }
+    }
+
+    auto available = _history[0].size();
+    if (_inputIndex >= available)
+    {
+        return 0;
+    }
+
+    // Upper bound of the output frames, used to size the output buffer once.
+    auto maxFrames = ((available - _inputIndex) * _phases) / _step + 1;
+    output.resize(maxFrames * _channels);
+
+    size_t outputFrames{0};
+    while (_inputIndex < available && outputFrames < maxFrames)
+    {
+        const float* coefficients = &_coefficients[static_cast<size_t>(_phase) * _taps];
+        auto first = _inputIndex + 1 - _taps;
+        for (unsigned int channel = 0; channel < _channels; channel++)
+        {
+            output[outputFrames * _channels + channel] = DotProduct(coefficients, &_history[channel][first], _taps);
+        }
+        outputFrames++;
+
+        _phase += _step;
+        _inputIndex += _phase / _phases;
+        _phase %= _phases;
+    }
+
+    output.resize(outputFrames * _channels);
+
+    // Keep only the history needed by the next output sample.
+    auto consumed = std::min(_inputIndex + 1 - _taps, available);
+    for (auto& history : _history)
+    {
+        history.erase(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(consumed));
+    }
+    _inputIndex -= consumed;
+
+    return outputFrames;
+}
+
+float PolyphaseResampler::DotProduct(const float* left, const float* right, size_t count)
+{
+#if defined(RESAMPLER_USE_SSE)
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t index{0};
+    for (; index + 8 <= count; index += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(left + index), _mm_loadu_ps(right + index)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(left + index + 4), _mm_loadu_ps(right + index + 4)));
+    }
+    for (; index < count; index += 4)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(left + index), _mm_loadu_ps(right + index)));
+    }
+    sum0 = _mm_add_ps(sum0, sum1);
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum0);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(RESAMPLER_USE_NEON)
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (size_t index = 0; index < count; index += 4)
+    {
+        sum = vmlaq_f32(sum, vld1q_f32(left + index), vld1q_f32(right + index));
+    }
+    float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#else
+    float sum[4]{};
+    for (size_t index = 0; index < count; index += 4)
+    {
+        sum[0] += left[index] * right[index];
+        sum[1] += left[index + 1] * right[index + 1];
+        sum[2] += left[index + 2] * right[index + 2];
+        sum[3] += left[index + 3] * right[index + 3];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Converts interleaved float audio between two fixed sample rates with a polyphase FIR filter.
+ *
+ * The conversion ratio is reduced to a fraction of two integers, upsampling by the numerator and decimating by the
+ * denominator. Only the filter phase needed for each output sample is evaluated, so the cost per output sample is
+ * the number of taps per phase, independent of the ratio. The prototype filter is a Kaiser-windowed sinc with its
+ * cutoff just below the lower of the two Nyquist frequencies, so downsampling doesn't alias.
+ *
+ * Ratios with an impractically large numerator are approximated by the closest fraction with a usable number of
+ * phases, which changes the output rate by a few parts per million at most.
+ *
+ * The filter taps are evaluated with SSE or NEON if available. Not thread-safe.
+ */
+class PolyphaseResampler
+{
+public:
+    PolyphaseResampler() = default;
+
+    /**
+     * @brief Sets up the filter for a conversion and discards all buffered input.
+     * @param inputRate The input sample rate in Hz.
+     * @param outputRate The output sample rate in Hz.
+     * @param channels The number of interleaved channels.
+     * @param taps Filter taps per phase. Rounded up to a multiple of four. More taps give a steeper filter.
+     */
+    void Configure(unsigned int inputRate, unsigned int outputRate, unsigned int channels, unsigned int taps);
+
+    /**
+     * @brief Returns whether a conversion is set up.
+     * @return True if the input and output rates differ.
+     */
+    bool Active() const;
+
+    /**
+     * @brief Converts a block of input samples.
+     *
+     * Input samples are kept until enough following samples arrived to evaluate the filter, so the output lags
+     * the input by half the filter length.
+     *
+     * @param input Interleaved input samples.
+     * @param frames Number of input sample frames.
+     * @param output Receives the interleaved output samples. Resized to the returned number of sample frames.
+     * @return The number of output sample frames.
+     */
+    size_t Process(const float* input, size_t frames, std::vector<float>& output);
+
+    /**
+     * @brief Calculates the dot product of two float arrays.
+     * @param left The first array.
+     * @param right The second array.
+     * @param count Number of elements. Must be a multiple of four.
+     * @return The sum of the element-wise products.
+     */
+    static float DotProduct(const float* left, const float* right, size_t count);
+
+protected:
+    static constexpr unsigned int MaxPhases{1024}; //!< Largest number of filter phases before the ratio is approximated.
+
+    unsigned int _channels{0}; //!< Number of interleaved channels.
+    unsigned int _phases{0}; //!< Number of filter phases, the upsampling factor.
+    unsigned int _step{0}; //!< Decimation factor, the phase increment per output sample.
+    size_t _taps{0}; //!< Filter taps per phase.
+
+    std::vector<float> _coefficients; //!< Coefficients of all phases, each in reverse order for the dot product.
+    std::vector<std::vector<float>> _history; //!< Buffered input samples per channel.
+
+    size_t _inputIndex{0}; //!< Index of the newest input sample used by the next output sample.
+    unsigned int _phase{0}; //!< Filter phase of the next output sample.
+};
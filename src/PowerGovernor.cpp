@@ -0,0 +1,332 @@
+#include "PowerGovernor.h"
+
+#include <Poco/DirectoryIterator.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberParser.h>
+#include <Poco/String.h>
+#include <Poco/StringTokenizer.h>
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+
+PowerGovernor::~PowerGovernor()
+{
+    Stop();
+}
+
+void PowerGovernor::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    if (!config->getBool("enabled", false))
+    {
+        return;
+    }
+
+    _tiers.assign(1, Tier());
+
+    auto tiersConfig = config->createView("tiers");
+    Poco::Util::AbstractConfiguration::Keys tierNames;
+    tiersConfig->keys(tierNames);
+
+    for (const auto& tierName : tierNames)
+    {
+        Tier tier;
+        tier._name = tierName;
+        tier._priority = tiersConfig->getInt(tierName + ".priority", 1);
+        tier._onBattery = tiersConfig->getBool(tierName + ".onBattery", false);
+        tier._batteryBelow = tiersConfig->getInt(tierName + ".batteryBelow", 0);
+        tier._temperatureAbove = tiersConfig->getDouble(tierName + ".temperatureAbove", 0.0);
+        tier._throttled = tiersConfig->getBool(tierName + ".throttled", false);
+        tier._fps = std::max(0, tiersConfig->getInt(tierName + ".fps", 0));
+        tier._resolutionScale = std::min(1.0, std::max(0.25, tiersConfig->getDouble(tierName + ".resolutionScale", 1.0)));
+        tier._meshScale = std::min(1.0, std::max(0.1, tiersConfig->getDouble(tierName + ".meshScale", 1.0)));
+
+        if (tiersConfig->has(tierName + ".frequencyBelow"))
+        {
+            poco_warning_f1(_logger, R"(Governor tier "%s": the "frequencyBelow" trigger is no longer supported, use "throttled" instead.)",
+                            tierName);
+        }
+
+        if (!tier._onBattery && tier._batteryBelow <= 0 && tier._temperatureAbove <= 0.0 && !tier._throttled)
+        {
+            poco_warning_f1(_logger, R"(Governor tier "%s" has no triggers and is ignored.)", tierName);
+            continue;
+        }
+
+        _tiers.push_back(tier);
+    }
+
+    if (_tiers.size() == 1)
+    {
+        poco_warning(_logger, "Power governor enabled, but no tiers are defined in the governor.tiers subkeys.");
+        return;
+    }
+
+    // Stable, so tiers with equal priority keep their configuration order.
+    std::stable_sort(_tiers.begin() + 1, _tiers.end(), [](const Tier& left, const Tier& right) {
+        return left._priority < right._priority;
+    });
+
+    Poco::StringTokenizer thermalZones(config->getString("thermalZones", ""), ";",
+                                       Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    _thermalZones.assign(thermalZones.begin(), thermalZones.end());
+
+    _pollInterval = static_cast<long>(std::max(1.0, config->getDouble("pollSeconds", 5.0)) * 1000.0);
+    _recoveryTime = static_cast<Poco::Clock::ClockDiff>(std::max(0.0, config->getDouble("recoverySeconds", 60.0)) *
+                                                        static_cast<double>(Poco::Clock::resolution()));
+    _temperatureHysteresis = std::max(0.0, config->getDouble("temperatureHysteresis", 5.0));
+
+    _activeTier = 0;
+    _lastThrottleCount = -1;
+    _lowerPending = false;
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _tierChanged = false;
+        _stop = false;
+    }
+
+    poco_information_f2(_logger, "Power governor watching %?d tiers, polling every %ld ms.", _tiers.size() - 1, _pollInterval);
+
+    _thread.start(*this);
+}
+
+void PowerGovernor::Stop()
+{
+    if (!_thread.isRunning())
+    {
+        return;
+    }
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _stop = true;
+    }
+    _wakeUp.set();
+    _thread.join();
+}
+
+bool PowerGovernor::TierChanged(Tier& tier)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!_tierChanged)
+    {
+        return false;
+    }
+
+    tier = _changedTier;
+    _tierChanged = false;
+    return true;
+}
+
+PowerGovernor::Readings PowerGovernor::ReadSensors(const std::vector<std::string>& thermalZones)
+{
+    Readings readings;
+
+    int percent{-1};
+    auto powerState = SDL_GetPowerInfo(nullptr, &percent);
+    readings._onBattery = powerState == SDL_POWERSTATE_ON_BATTERY;
+    readings._batteryPercent = percent;
+
+    readings._temperature = ReadTemperature(thermalZones);
+    readings._throttleCount = ReadThrottleCount();
+
+    return readings;
+}
+
+void PowerGovernor::run()
+{
+    for (;;)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+            if (_stop)
+            {
+                return;
+            }
+        }
+
+        auto readings = ReadSensors(_thermalZones);
+
+        // The first poll only sets the baseline, throttling before the start doesn't count.
+        readings._throttled = _lastThrottleCount >= 0 && readings._throttleCount > _lastThrottleCount;
+        _lastThrottleCount = readings._throttleCount;
+
+        poco_trace_f4(_logger, "Battery: %s, %d%%, temperature: %.1f °C, thermal throttle events: %?d",
+                      std::string(readings._onBattery ? "discharging" : "not discharging"), readings._batteryPercent,
+                      readings._temperature, readings._throttleCount);
+
+        SelectTier(readings);
+
+        _wakeUp.tryWait(_pollInterval);
+    }
+}
+
+bool PowerGovernor::Triggered(const Tier& tier, const Readings& readings, bool active) const
+{
+    if (tier._onBattery && readings._onBattery)
+    {
+        return true;
+    }
+
+    if (tier._batteryBelow > 0 && readings._onBattery && readings._batteryPercent >= 0 &&
+        readings._batteryPercent < tier._batteryBelow)
+    {
+        return true;
+    }
+
+    if (tier._temperatureAbove > 0.0 && readings._temperature >= 0.0)
+    {
+        auto threshold = active ? tier._temperatureAbove - _temperatureHysteresis : tier._temperatureAbove;
+        if (readings._temperature > threshold)
+        {
+            return true;
+        }
+    }
+
+    if (tier._throttled && readings._throttled)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+void PowerGovernor::SelectTier(const Readings& readings)
+{
+    size_t selectedTier{0};
+    for (size_t index = _tiers.size() - 1; index > 0; index--)
+    {
+        if (Triggered(_tiers[index], readings, index == _activeTier))
+        {
+            selectedTier = index;
+            break;
+        }
+    }
+
+    if (selectedTier < _activeTier)
+    {
+        // Only step down once the triggers stayed off for the recovery time.
+        if (!_lowerPending)
+        {
+            _lowerPending = true;
+            _lowerSince.update();
+            return;
+        }
+
+        if (!_lowerSince.isElapsed(_recoveryTime))
+        {
+            return;
+        }
+    }
+
+    _lowerPending = false;
+
+    if (selectedTier == _activeTier)
+    {
+        return;
+    }
+
+    const auto& tier = _tiers[selectedTier];
+    poco_information_f4(_logger, R"(Switching to governor tier "%s": %d FPS limit, %.2f resolution scale, %.2f mesh scale.)",
+                        tier._name, tier._fps, tier._resolutionScale, tier._meshScale);
+
+    _activeTier = selectedTier;
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _changedTier = tier;
+    _tierChanged = true;
+}
+
+double PowerGovernor::ReadTemperature(const std::vector<std::string>& thermalZones)
+{
+    const std::string thermalPath{"/sys/class/thermal"};
+    double temperature{-1.0};
+
+    Poco::File thermalDirectory(thermalPath);
+    if (!thermalDirectory.exists())
+    {
+        return temperature;
+    }
+
+    try
+    {
+        for (Poco::DirectoryIterator zone(thermalDirectory); zone != Poco::DirectoryIterator(); ++zone)
+        {
+            if (zone.name().compare(0, 12, "thermal_zone") != 0)
+            {
+                continue;
+            }
+
+            std::string type;
+            if (!thermalZones.empty() &&
+                (!ReadSysfsValue(zone.path().toString() + "/type", type) ||
+                 std::find(thermalZones.begin(), thermalZones.end(), type) == thermalZones.end()))
+            {
+                continue;
+            }
+
+            std::string value;
+            int milliDegrees{0};
+            if (ReadSysfsValue(zone.path().toString() + "/temp", value) && Poco::NumberParser::tryParse(value, milliDegrees))
+            {
+                temperature = std::max(temperature, static_cast<double>(milliDegrees) / 1000.0);
+            }
+        }
+    }
+    catch (Poco::Exception& ex)
+    {
+        // Zones can disappear while iterating, e.g. when a USB device is unplugged.
+        poco_debug_f1(Poco::Logger::get("PowerGovernor"), "Could not read thermal zones: %s", ex.displayText());
+    }
+
+    return temperature;
+}
+
+int64_t PowerGovernor::ReadThrottleCount()
+{
+    int64_t throttleCount{-1};
+
+    for (int cpu = 0;; cpu++)
+    {
+        auto cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        if (!Poco::File(cpuPath).exists())
+        {
+            break;
+        }
+
+        // Package counters are the same for all cores of a package, which doesn't matter for detecting an increase.
+        for (const auto* counter : {"core_throttle_count", "package_throttle_count"})
+        {
+            std::string value;
+            Poco::UInt64 count{0};
+            if (ReadSysfsValue(cpuPath + "/thermal_throttle/" + counter, value) &&
+                Poco::NumberParser::tryParseUnsigned64(value, count))
+            {
+                throttleCount = std::max<int64_t>(throttleCount, 0) + static_cast<int64_t>(count);
+            }
+        }
+    }
+
+    return throttleCount;
+}
+
+bool PowerGovernor::ReadSysfsValue(const std::string& path, std::string& value)
+{
+    try
+    {
+        Poco::FileInputStream stream(path);
+        if (!std::getline(stream, value))
+        {
+            return false;
+        }
+    }
+    catch (Poco::Exception&)
+    {
+        return false;
+    }
+
+    Poco::trimInPlace(value);
+    return !value.empty();
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <Poco/Clock.h>
+#include <Poco/Event.h>
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lowers frame rate, resolution and mesh size when running on battery or getting hot.
+ *
+ * A background thread polls the battery state via SDL_GetPowerInfo(), and on Linux the thermal zone temperatures
+ * and the CPUs' thermal throttle counters from sysfs, every few seconds. Policy tiers are defined in the "governor.tiers.<name>"
+ * configuration subkeys. Each tier has triggers, e.g. running on battery or a temperature above a threshold, and a
+ * policy with a frame rate limit and scale factors for the internal resolution and the mesh size. Of all tiers with
+ * a firing trigger, the one with the highest priority is applied by the render loop.
+ *
+ * Stepping up to a more restrictive tier happens with the next poll, so the frontend degrades before the hardware
+ * throttles. Stepping back down only happens after the triggers stayed off for the recovery time, and temperature
+ * triggers of the active tier only release once the temperature fell below the threshold minus the hysteresis. This
+ * keeps the quality from oscillating around a threshold.
+ *
+ * Configured via the "governor" configuration subkey.
+ */
+class PowerGovernor : public Poco::Runnable
+{
+public:
+    /**
+     * @brief A policy tier. The default tier without triggers applies the configured settings.
+     */
+    struct Tier {
+        std::string _name{"default"}; //!< The tier name, used in log messages.
+        int _priority{0}; //!< If multiple tiers are triggered, the one with the highest priority is applied.
+
+        bool _onBattery{false}; //!< Triggers while running on battery.
+        int _batteryBelow{0}; //!< Triggers while running on battery with less than this charge in percent. 0 to disable.
+        double _temperatureAbove{0.0}; //!< Triggers above this temperature in °C. 0 to disable.
+        bool _throttled{false}; //!< Triggers if the CPU was thermally throttled since the previous poll.
+
+        int _fps{0}; //!< Frame rate limit, or 0 to use the configured rate.
+        double _resolutionScale{1.0}; //!< Factor applied to the internal rendering resolution.
+        double _meshScale{1.0}; //!< Factor applied to the configured mesh size.
+    };
+
+    /**
+     * @brief Power and thermal state from one poll. Values which can't be read are negative.
+     */
+    struct Readings {
+        bool _onBattery{false}; //!< True if the system runs on battery.
+        int _batteryPercent{-1}; //!< Remaining battery charge in percent.
+        double _temperature{-1.0}; //!< Highest temperature of the watched thermal zones in °C.
+        int64_t _throttleCount{-1}; //!< Sum of the CPUs' thermal throttle event counters since boot.
+        bool _throttled{false}; //!< True if the throttle count increased since the previous poll.
+    };
+
+    PowerGovernor() = default;
+
+    /**
+     * @brief Destructor. Stops the polling thread.
+     */
+    ~PowerGovernor() override;
+
+    /**
+     * @brief Loads the policy tiers and starts polling.
+     *
+     * Does nothing if "enabled" is false in the configuration or no tiers are defined.
+     *
+     * @param config View of the "governor" configuration subkey.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Stops polling.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the tier to apply if it changed since the last call.
+     * @param tier Receives the new tier.
+     * @return True if a different tier became active.
+     */
+    bool TierChanged(Tier& tier);
+
+    /**
+     * @brief Polls the power and thermal state.
+     * @param thermalZones Types of the thermal zones to read, or empty to read all zones.
+     * @return The current readings.
+     */
+    static Readings ReadSensors(const std::vector<std::string>& thermalZones);
+
+    /**
+     * @brief Polling thread entry point.
+     */
+    void run() override;
+
+protected:
+    /**
+     * @brief Checks whether any trigger of a tier fires.
+     * @param tier The tier to check.
+     * @param readings The current readings.
+     * @param active True if the tier is currently active, which applies the temperature hysteresis.
+     * @return True if the tier is triggered.
+     */
+    bool Triggered(const Tier& tier, const Readings& readings, bool active) const;
+
+    /**
+     * @brief Selects the tier for the current readings and switches to it, respecting the recovery time.
+     * @param readings The current readings.
+     */
+    void SelectTier(const Readings& readings);
+
+    /**
+     * @brief Reads the highest temperature of all matching thermal zones.
+     * @param thermalZones Types of the thermal zones to read, or empty to read all zones.
+     * @return The temperature in °C, or -1 if no zone could be read.
+     */
+    static double ReadTemperature(const std::vector<std::string>& thermalZones);
+
+    /**
+     * @brief Reads the number of thermal throttle events of all CPUs since boot.
+     *
+     * The counters only increase when the hardware actually throttles for thermal reasons, unlike the current
+     * frequency, which also drops when the CPU idles, e.g. because the governor already reduced the load.
+     * Only available on x86 CPUs with thermal throttle reporting.
+     *
+     * @return The sum of all core and package throttle counters, or -1 if no counter could be read.
+     */
+    static int64_t ReadThrottleCount();
+
+    /**
+     * @brief Reads the first line of a sysfs file.
+     * @param path The file path.
+     * @param value Receives the trimmed line.
+     * @return True if the file could be read.
+     */
+    static bool ReadSysfsValue(const std::string& path, std::string& value);
+
+    std::vector<Tier> _tiers; //!< Policy tiers, sorted by ascending priority. The first one is the default tier.
+    std::vector<std::string> _thermalZones; //!< Types of the thermal zones to read. Empty to read all.
+    long _pollInterval{5000}; //!< Time between polls in milliseconds.
+    Poco::Clock::ClockDiff _recoveryTime{0}; //!< Time the triggers must stay off before stepping down.
+    double _temperatureHysteresis{5.0}; //!< Temperature drop in °C required to release a temperature trigger.
+
+    size_t _activeTier{0}; //!< Index of the active tier. Only used by the polling thread.
+    int64_t _lastThrottleCount{-1}; //!< Throttle count of the previous poll. Only used by the polling thread.
+    Poco::Clock _lowerSince; //!< Time since a less restrictive tier than the active one would be selected.
+    bool _lowerPending{false}; //!< True while waiting for the recovery time to step down.
+
+    Poco::FastMutex _mutex; //!< Protects _changedTier, _tierChanged and _stop.
+    Tier _changedTier; //!< The newly activated tier, waiting to be picked up by the render loop.
+    bool _tierChanged{false}; //!< True if _changedTier wasn't picked up yet.
+    bool _stop{false}; //!< Tells the polling thread to exit.
+    Poco::Event _wakeUp; //!< Wakes the polling thread when stopping.
+    Poco::Thread _thread{"Power governor"}; //!< Polls the sensors.
+
+    Poco::Logger& _logger{Poco::Logger::get("PowerGovernor")}; //!< The class logger.
+};
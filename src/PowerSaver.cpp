@@ -0,0 +1,93 @@
+#include "PowerSaver.h"
+
+#include <algorithm>
+#include <string>
+
+void PowerSaver::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    _enabled = config->getBool("enabled", false);
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _thresholdDb = static_cast<float>(config->getDouble("thresholdDb", -60.0));
+    _silenceTime = static_cast<Poco::Clock::ClockDiff>(std::max(1.0, config->getDouble("silenceSeconds", 30.0)) *
+                                                       static_cast<double>(Poco::Clock::resolution()));
+    _idleFps = std::max(1, config->getInt("idleFps", 10));
+    _freezeFrame = config->getBool("freezeFrame", false);
+
+    _idle = false;
+    _lastSound.update();
+
+    poco_information_f4(_logger, "Power saving enabled: idling at %d FPS%s after %.0f seconds below %.0f dBFS.",
+                        _idleFps, std::string(_freezeFrame ? " with a frozen frame" : ""),
+                        static_cast<double>(_silenceTime) / static_cast<double>(Poco::Clock::resolution()),
+                        static_cast<double>(_thresholdDb));
+}
+
+bool PowerSaver::Update(const AudioLevelMeter::Level& level)
+{
+    if (!_enabled)
+    {
+        return false;
+    }
+
+    bool silent = level._samples == 0 || AudioLevelMeter::ToDecibels(level._rms) < _thresholdDb;
+
+    if (!silent)
+    {
+        _lastSound.update();
+        if (_idle)
+        {
+            _idle = false;
+            poco_information_f1(_logger, "Sound returned at %.1f dBFS, resuming full frame rate.",
+                                static_cast<double>(AudioLevelMeter::ToDecibels(level._rms)));
+            return true;
+        }
+        return false;
+    }
+
+    if (!_idle && _lastSound.isElapsed(_silenceTime))
+    {
+        _idle = true;
+        poco_information_f1(_logger, "Audio is silent, idling at %d FPS.", _idleFps);
+        return true;
+    }
+
+    return false;
+}
+
+bool PowerSaver::Wake()
+{
+    _lastSound.update();
+
+    if (!_idle)
+    {
+        return false;
+    }
+
+    _idle = false;
+    poco_debug(_logger, "Woken up by user input.");
+    return true;
+}
+
+bool PowerSaver::Enabled() const
+{
+    return _enabled;
+}
+
+bool PowerSaver::Idle() const
+{
+    return _idle;
+}
+
+bool PowerSaver::RenderIdleFrames() const
+{
+    return !_freezeFrame;
+}
+
+int PowerSaver::IdleFPS() const
+{
+    return _idleFps;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AudioLevelMeter.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+/**
+ * @brief Lowers the frame rate while the captured audio is silent.
+ *
+ * Each frame, the render loop passes the level of the audio captured for it. Once the RMS level stayed below the
+ * threshold for the configured time, the saver goes idle: the render loop lowers the FPS limiter target to the idle
+ * rate and, if "freezeFrame" is set, stops rendering and swapping altogether, so the last frame stays on screen.
+ * Audio and events are still polled at the idle rate. The first idle frame with sound is rendered, and the full rate
+ * is restored right away, so the visuals pick up again within one idle frame interval. User input also wakes the
+ * saver and restarts the silence timer.
+ *
+ * Configured via the "powerSave" configuration subkey.
+ */
+class PowerSaver
+{
+public:
+    PowerSaver() = default;
+
+    /**
+     * @brief Starts watching the audio level.
+     *
+     * Until this is called, the saver never goes idle. Does nothing if "enabled" is false in the configuration.
+     *
+     * @param config View of the "powerSave" configuration subkey.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Checks the level of the audio captured for the current frame.
+     * @param level The level of the captured audio. Frames without any audio count as silent.
+     * @return True if the saver went idle or woke up with this frame.
+     */
+    bool Update(const AudioLevelMeter::Level& level);
+
+    /**
+     * @brief Leaves the idle state and restarts the silence timer, e.g. on user input.
+     * @return True if the saver was idle.
+     */
+    bool Wake();
+
+    /**
+     * @brief Returns whether the saver watches the audio level.
+     * @return True if power saving was enabled in the configuration.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Returns whether the saver is idle.
+     * @return True if the audio has been silent for longer than the configured time.
+     */
+    bool Idle() const;
+
+    /**
+     * @brief Returns whether idle frames should be rendered.
+     * @return False if the last frame is frozen while idle.
+     */
+    bool RenderIdleFrames() const;
+
+    /**
+     * @brief Returns the frame rate used while idle.
+     * @return The idle FPS limiter target.
+     */
+    int IdleFPS() const;
+
+protected:
+    bool _enabled{false}; //!< True while watching the audio level.
+    float _thresholdDb{-60.0f}; //!< RMS level in dBFS below which the audio is considered silent.
+    Poco::Clock::ClockDiff _silenceTime{30 * Poco::Clock::resolution()}; //!< Silence duration before going idle.
+    int _idleFps{10}; //!< FPS limiter target while idle.
+    bool _freezeFrame{false}; //!< If true, nothing is rendered while idle.
+
+    bool _idle{false}; //!< True while idle.
+    Poco::Clock _lastSound; //!< Time the audio was last above the threshold, or the saver was woken up.
+
+    Poco::Logger& _logger{Poco::Logger::get("PowerSaver")}; //!< The class logger.
+};
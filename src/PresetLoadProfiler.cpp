@@ -0,0 +1,295 @@
+#include "PresetLoadProfiler.h"
+
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/Format.h>
+#include <Poco/Path.h>
+
+#include <Poco/JSON/Array.h>
+#include <Poco/JSON/Object.h>
+#include <Poco/JSON/Parser.h>
+
+#include <algorithm>
+#include <vector>
+
+constexpr int PresetLoadProfiler::BucketCount;
+
+const double PresetLoadProfiler::BucketBounds[PresetLoadProfiler::BucketCount]{
+    5.0, 10.0, 25.0, 50.0, 100.0, 250.0, 500.0, 1000.0, 2500.0, 5000.0};
+
+double PresetLoadProfiler::PresetStatistics::Percentile(double percentile) const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+
+    auto rank = static_cast<uint64_t>(std::max(1.0, percentile * static_cast<double>(_count) + 0.5));
+    uint64_t cumulative{0};
+    for (int bucket = 0; bucket < BucketCount; bucket++)
+    {
+        cumulative += _buckets[bucket];
+        if (cumulative >= rank)
+        {
+            return std::min(BucketBounds[bucket], _maxTime);
+        }
+    }
+
+    return _maxTime;
+}
+
+void PresetLoadProfiler::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    if (!config->getBool("enabled", true))
+    {
+        return;
+    }
+
+    _file = StatisticsFile(config);
+    _slowLoadThreshold = config->getDouble("slowLoadMs", 250.0);
+
+    Load();
+
+    _requestTime.update();
+    _pendingPreset.clear();
+    _enabled = true;
+}
+
+void PresetLoadProfiler::BeginFrame()
+{
+    if (_enabled)
+    {
+        _requestTime.update();
+    }
+}
+
+void PresetLoadProfiler::BeginRendering()
+{
+    if (_enabled)
+    {
+        _requestTime.update();
+    }
+}
+
+void PresetLoadProfiler::PresetSwitched(const std::string& presetFile)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    // If multiple switches happen in one frame, only the last preset is actually shown.
+    _pendingPreset = presetFile;
+    _switchRequestTime = _requestTime;
+}
+
+void PresetLoadProfiler::EndFrame()
+{
+    if (!_enabled || _pendingPreset.empty())
+    {
+        return;
+    }
+
+    auto loadTime = static_cast<double>(_switchRequestTime.elapsed()) / 1000.0;
+
+    auto& statistics = _statistics[_pendingPreset];
+    statistics._count++;
+    statistics._totalTime += loadTime;
+    statistics._maxTime = std::max(statistics._maxTime, loadTime);
+
+    int bucket = 0;
+    while (bucket < BucketCount && loadTime > BucketBounds[bucket])
+    {
+        bucket++;
+    }
+    statistics._buckets[bucket]++;
+
+    if (loadTime > _slowLoadThreshold)
+    {
+        poco_information(_logger, Poco::format(R"(Slow preset load: "%s" took %.1f ms.)", _pendingPreset, loadTime));
+    }
+
+    _pendingPreset.clear();
+    _changed = true;
+}
+
+double PresetLoadProfiler::ExpectedLoadTime(const std::string& presetFile) const
+{
+    if (!_enabled)
+    {
+        return -1.0;
+    }
+
+    auto statistics = _statistics.find(presetFile);
+    if (statistics == _statistics.end() || statistics->second._count == 0)
+    {
+        return -1.0;
+    }
+
+    return statistics->second.Percentile(0.95);
+}
+
+void PresetLoadProfiler::Stop()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _enabled = false;
+
+    if (!_changed)
+    {
+        return;
+    }
+
+    try
+    {
+        Save();
+        _changed = false;
+        poco_debug_f2(_logger, R"(Saved load times of %?d presets to "%s".)", _statistics.size(), _file);
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not save preset load times to "%s": %s)", _file, ex.displayText());
+    }
+}
+
+bool PresetLoadProfiler::Report(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, size_t count, std::ostream& output)
+{
+    _file = StatisticsFile(config);
+    Load();
+
+    if (_statistics.empty())
+    {
+        output << "No preset load times recorded in \"" << _file << "\"." << std::endl;
+        return false;
+    }
+
+    using Entry = std::pair<const std::string*, const PresetStatistics*>;
+    std::vector<Entry> presets;
+    presets.reserve(_statistics.size());
+    for (const auto& preset : _statistics)
+    {
+        presets.emplace_back(&preset.first, &preset.second);
+    }
+
+    std::sort(presets.begin(), presets.end(), [](const Entry& left, const Entry& right) {
+        auto leftP95 = left.second->Percentile(0.95);
+        auto rightP95 = right.second->Percentile(0.95);
+        if (leftP95 != rightP95)
+        {
+            return leftP95 > rightP95;
+        }
+        return left.second->_maxTime > right.second->_maxTime;
+    });
+
+    output << Poco::format("Slowest preset loads of %?d presets, by 95th percentile:", _statistics.size()) << std::endl;
+    output << "  Loads   Mean ms    P95 ms    Max ms  Preset" << std::endl;
+
+    for (size_t index = 0; index < std::min(count, presets.size()); index++)
+    {
+        const auto& statistics = *presets[index].second;
+        output << Poco::format("%7?d %9.1f %9.1f %9.1f  %s",
+                               statistics._count,
+                               statistics._totalTime / static_cast<double>(statistics._count),
+                               statistics.Percentile(0.95),
+                               statistics._maxTime,
+                               *presets[index].first)
+               << std::endl;
+    }
+
+    return true;
+}
+
+std::string PresetLoadProfiler::StatisticsFile(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    return config->getString("file",
+                             Poco::Path::configHome() + "projectM" + Poco::Path::separator() + "presetLoadTimes.json");
+}
+
+void PresetLoadProfiler::Load()
+{
+    _statistics.clear();
+
+    if (!Poco::File(_file).exists())
+    {
+        return;
+    }
+
+    try
+    {
+        Poco::FileInputStream input(_file);
+        Poco::JSON::Parser parser;
+        auto store = parser.parse(input).extract<Poco::JSON::Object::Ptr>();
+
+        auto presets = store->getArray("presets");
+        for (size_t entryIndex = 0; presets && entryIndex < presets->size(); entryIndex++)
+        {
+            auto entry = presets->getObject(static_cast<unsigned int>(entryIndex));
+
+            PresetStatistics statistics;
+            statistics._count = entry->optValue<uint64_t>("count", 0);
+            statistics._totalTime = entry->optValue<double>("totalMs", 0.0);
+            statistics._maxTime = entry->optValue<double>("maxMs", 0.0);
+
+            auto buckets = entry->getArray("buckets");
+            for (size_t bucket = 0; buckets && bucket < std::min(buckets->size(), static_cast<size_t>(BucketCount + 1)); bucket++)
+            {
+                statistics._buckets[bucket] = buckets->getElement<uint64_t>(static_cast<unsigned int>(bucket));
+            }
+
+            _statistics[entry->getValue<std::string>("preset")] = statistics;
+        }
+
+        poco_debug_f1(_logger, "Loaded load times of %?d presets.", _statistics.size());
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_warning_f2(_logger, R"(Could not read preset load times from "%s", starting from scratch: %s)", _file, ex.displayText());
+        _statistics.clear();
+    }
+}
+
+void PresetLoadProfiler::Save() const
+{
+    Poco::JSON::Object store;
+
+    Poco::JSON::Array::Ptr bounds(new Poco::JSON::Array);
+    for (auto bound : BucketBounds)
+    {
+        bounds->add(bound);
+    }
+    store.set("bucketBoundsMs", bounds);
+
+    Poco::JSON::Array::Ptr presets(new Poco::JSON::Array);
+    for (const auto& preset : _statistics)
+    {
+        Poco::JSON::Object::Ptr entry(new Poco::JSON::Object);
+        entry->set("preset", preset.first);
+        entry->set("count", preset.second._count);
+        entry->set("totalMs", preset.second._totalTime);
+        entry->set("maxMs", preset.second._maxTime);
+
+        Poco::JSON::Array::Ptr buckets(new Poco::JSON::Array);
+        for (auto bucketCount : preset.second._buckets)
+        {
+            buckets->add(bucketCount);
+        }
+        entry->set("buckets", buckets);
+
+        presets->add(entry);
+    }
+    store.set("presets", presets);
+
+    Poco::Path storePath(_file);
+    Poco::File(storePath.parent()).createDirectories();
+
+    // Write to a temporary file first, so an interrupted run never leaves a truncated file behind.
+    Poco::Path temporaryPath(_file + ".tmp");
+    {
+        Poco::FileOutputStream output(temporaryPath.toString());
+        store.stringify(output, 1);
+    }
+    Poco::File(temporaryPath).renameTo(storePath.toString());
+}
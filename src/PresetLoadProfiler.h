@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Measures how long each preset takes to load and keeps per-preset load time histograms on disk.
+ *
+ * The load time of a preset is measured from the switch request to the end of the first completed frame showing
+ * it, so it includes reading and parsing the preset file as well as compiling its shaders on first use. As the
+ * playlist doesn't report when a switch was requested, the request time is the start of the render loop phase
+ * in which the switch happened: the frame start for switches caused by input events, or the start of projectM's
+ * frame rendering for automatic switches.
+ *
+ * The histograms are loaded from and saved to a JSON file, so they accumulate over sessions. Use Report() to list
+ * the presets causing the worst hitches.
+ *
+ * Configured via the "presetLoadProfiler" configuration subkey.
+ */
+class PresetLoadProfiler
+{
+public:
+    static constexpr int BucketCount{10}; //!< Number of histogram buckets, not counting the overflow bucket.
+
+    static const double BucketBounds[BucketCount]; //!< Upper bucket bounds in milliseconds.
+
+    /**
+     * @brief Load time statistics of a single preset.
+     */
+    struct PresetStatistics {
+        uint64_t _count{0}; //!< Number of measured loads.
+        double _totalTime{0.0}; //!< Sum of all load times in milliseconds.
+        double _maxTime{0.0}; //!< Slowest load in milliseconds.
+        uint64_t _buckets[BucketCount + 1]{}; //!< Load time histogram, the last bucket counts all slower loads.
+
+        /**
+         * @brief Estimates a percentile from the histogram.
+         * @param percentile The percentile, between 0 and 1.
+         * @return The upper bound of the bucket containing the percentile, or the maximum for the overflow bucket.
+         */
+        double Percentile(double percentile) const;
+    };
+
+    PresetLoadProfiler() = default;
+
+    /**
+     * @brief Loads the existing statistics and starts measuring.
+     *
+     * Until this is called, all other methods do nothing. Does nothing if "enabled" is false in the configuration.
+     *
+     * @param config View of the "presetLoadProfiler" configuration subkey.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Marks the start of a frame. Switches requested by input events are measured from here.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Marks the start of projectM's frame rendering. Automatic switches are measured from here.
+     */
+    void BeginRendering();
+
+    /**
+     * @brief Remembers a preset switch. Its load time is recorded at the end of the frame.
+     * @param presetFile The file of the new preset.
+     */
+    void PresetSwitched(const std::string& presetFile);
+
+    /**
+     * @brief Marks the end of a frame and records the load time of a preset switched in this frame.
+     */
+    void EndFrame();
+
+    /**
+     * @brief Returns the expected load time of a preset from its measured loads.
+     * @param presetFile The preset file.
+     * @return The 95th percentile load time in milliseconds, or -1 if the preset was never measured or the
+     *         profiler isn't running.
+     */
+    double ExpectedLoadTime(const std::string& presetFile) const;
+
+    /**
+     * @brief Stops measuring and saves the statistics.
+     */
+    void Stop();
+
+    /**
+     * @brief Writes a table of the presets with the slowest loads, by 95th percentile load time.
+     * @param config View of the "presetLoadProfiler" configuration subkey.
+     * @param count Maximum number of presets to list.
+     * @param output The stream to write the report to.
+     * @return True if statistics were found, false if there's nothing to report.
+     */
+    bool Report(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, size_t count, std::ostream& output);
+
+protected:
+    /**
+     * @brief Returns the statistics file path from the configuration.
+     * @param config View of the "presetLoadProfiler" configuration subkey.
+     * @return The statistics file path.
+     */
+    static std::string StatisticsFile(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Loads the statistics file, if it exists.
+     */
+    void Load();
+
+    /**
+     * @brief Writes all statistics to the statistics file.
+     */
+    void Save() const;
+
+    bool _enabled{false}; //!< True while measuring.
+    std::string _file; //!< The statistics file.
+    double _slowLoadThreshold{0.0}; //!< Load time in milliseconds above which a load is logged.
+
+    std::map<std::string, PresetStatistics> _statistics; //!< Load time statistics by preset file.
+    bool _changed{false}; //!< True if there are unsaved measurements.
+
+    Poco::Clock _requestTime; //!< Start of the current phase, used as the request time of the next switch.
+    Poco::Clock _switchRequestTime; //!< Request time of the pending switch.
+    std::string _pendingPreset; //!< Preset switched in the current frame, empty if none.
+
+    Poco::Logger& _logger{Poco::Logger::get("PresetLoadProfiler")}; //!< The class logger.
+};
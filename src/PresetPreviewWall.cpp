@@ -0,0 +1,458 @@
+#include "PresetPreviewWall.h"
+
+#include "Metrics.h"
+#include "Tracer.h"
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+
+PresetPreviewWall::PresetPreviewWall(AudioCapture& audioCapture, projectm_playlist_handle playlist,
+                                     const PresetLoadProfiler& loadProfiler)
+    : _audioCapture(audioCapture)
+    , _playlist(playlist)
+    , _loadProfiler(loadProfiler)
+    , _config(Poco::Util::Application::instance().config().createView("browse"))
+{
+    _columns = std::max(1, _config->getInt("columns", 4));
+    _rows = std::max(1, _config->getInt("rows", 3));
+    _thumbnailWidth = std::max(16, _config->getInt("thumbnailWidth", 256));
+    _thumbnailHeight = std::max(16, _config->getInt("thumbnailHeight", 144));
+    _frameBudget = std::max(0.1, _config->getDouble("frameBudget", 4.0));
+    _averagePreviewTime = _frameBudget / 2.0;
+    _averageLoadTime = _frameBudget / 2.0;
+    _slowLoadInterval = std::max(1, _config->getInt("slowLoadInterval", 30));
+    _framesSinceSlowLoad = _slowLoadInterval;
+}
+
+PresetPreviewWall::~PresetPreviewWall()
+{
+    Leave();
+    DestroyResources();
+}
+
+bool PresetPreviewWall::Active() const
+{
+    return _active;
+}
+
+void PresetPreviewWall::Enter()
+{
+    if (_active)
+    {
+        return;
+    }
+
+    if (!_resourcesCreated && !CreateResources())
+    {
+        DestroyResources();
+        return;
+    }
+
+    for (const auto& preview : _previews)
+    {
+        _audioCapture.AddReceiver(preview._projectM);
+    }
+
+    auto previewCount = static_cast<uint32_t>(_previews.size());
+    auto position = projectm_playlist_get_position(_playlist);
+    _selection = position % previewCount;
+    ShowPage(position / previewCount);
+
+    _active = true;
+
+    poco_debug_f2(_logger, "Entered browse mode with %?dx%?d previews.", _columns, _rows);
+}
+
+void PresetPreviewWall::Leave()
+{
+    if (!_active)
+    {
+        return;
+    }
+
+    for (const auto& preview : _previews)
+    {
+        _audioCapture.RemoveReceiver(preview._projectM);
+    }
+
+    _active = false;
+
+    poco_debug(_logger, "Left browse mode.");
+}
+
+void PresetPreviewWall::Update()
+{
+    if (!_active)
+    {
+        return;
+    }
+
+    const auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    const auto frameStartTime = SDL_GetPerformanceCounter();
+    bool workDone{false};
+
+    _framesSinceSlowLoad = std::min(_framesSinceSlowLoad + 1, _slowLoadInterval);
+
+    // Hard budget: a load is only started if its expected cost fits into the remaining time of this frame.
+    for (size_t slot = 0; slot < _previews.size(); slot++)
+    {
+        auto& preview = _previews[slot];
+        if (!preview._needsLoad)
+        {
+            continue;
+        }
+
+        auto stepStartTime = SDL_GetPerformanceCounter();
+        double elapsedTime = static_cast<double>(stepStartTime - frameStartTime) * 1000.0 / frequency;
+        double expectedTime = ExpectedLoadTime(preview);
+
+        // A load longer than the whole budget never fits, so it may take a frame of its own every few frames.
+        bool slowLoad = expectedTime > _frameBudget;
+        if (slowLoad ? workDone || _framesSinceSlowLoad < _slowLoadInterval : elapsedTime + expectedTime > _frameBudget)
+        {
+            continue;
+        }
+        workDone = true;
+
+        LoadPreview(slot);
+
+        double loadTime = static_cast<double>(SDL_GetPerformanceCounter() - stepStartTime) * 1000.0 / frequency;
+        _averageLoadTime = _averageLoadTime * 0.9 + loadTime * 0.1;
+        if (slowLoad || loadTime > _frameBudget)
+        {
+            _framesSinceSlowLoad = 0;
+        }
+    }
+
+    for (size_t step = 0; step < _previews.size(); step++)
+    {
+        auto& preview = _previews[_nextPreview];
+        if (preview._empty || preview._needsLoad)
+        {
+            _nextPreview = (_nextPreview + 1) % _previews.size();
+            continue;
+        }
+
+        // Defer the render if it isn't expected to fit into the remaining time of this frame.
+        auto stepStartTime = SDL_GetPerformanceCounter();
+        double elapsedTime = static_cast<double>(stepStartTime - frameStartTime) * 1000.0 / frequency;
+        if (workDone && elapsedTime + _averagePreviewTime > _frameBudget)
+        {
+            break;
+        }
+        workDone = true;
+
+        RenderPreview(_nextPreview);
+        _nextPreview = (_nextPreview + 1) % _previews.size();
+
+        double previewTime = static_cast<double>(SDL_GetPerformanceCounter() - stepStartTime) * 1000.0 / frequency;
+        _averagePreviewTime = _averagePreviewTime * 0.9 + previewTime * 0.1;
+    }
+}
+
+void PresetPreviewWall::Draw(int width, int height)
+{
+    if (!_active)
+    {
+        return;
+    }
+
+    int atlasWidth = _columns * _thumbnailWidth;
+    int atlasHeight = _rows * _thumbnailHeight;
+
+    _gl.BindFramebuffer(GL_READ_FRAMEBUFFER, _atlasFramebuffer);
+    _gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    _gl.BlitFramebuffer(0, 0, atlasWidth, atlasHeight,
+                        0, 0, width, height,
+                        GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Selection marker: a frame around the selected tile, drawn with scissored clears.
+    int tileX;
+    int tileY;
+    TileOffset(_selection, tileX, tileY);
+
+    int left = tileX * width / atlasWidth;
+    int bottom = tileY * height / atlasHeight;
+    int right = (tileX + _thumbnailWidth) * width / atlasWidth;
+    int top = (tileY + _thumbnailHeight) * height / atlasHeight;
+    int border = std::max(2, width / 400);
+
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glScissor(left, bottom, right - left, border);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(left, top - border, right - left, border);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(left, bottom, border, top - bottom);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(right - border, bottom, border, top - bottom);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+bool PresetPreviewWall::KeyEvent(const SDL_KeyboardEvent& event)
+{
+    if (!_active)
+    {
+        return false;
+    }
+
+    auto previewCount = _previews.size();
+    auto playlistSize = projectm_playlist_size(_playlist);
+    auto pageCount = std::max<uint32_t>(1, (playlistSize + previewCount - 1) / previewCount);
+
+    switch (event.keysym.sym)
+    {
+        case SDLK_LEFT:
+            _selection = (_selection + previewCount - 1) % previewCount;
+            return true;
+
+        case SDLK_RIGHT:
+            _selection = (_selection + 1) % previewCount;
+            return true;
+
+        case SDLK_UP:
+            _selection = (_selection + previewCount - _columns) % previewCount;
+            return true;
+
+        case SDLK_DOWN:
+            _selection = (_selection + _columns) % previewCount;
+            return true;
+
+        case SDLK_PAGEUP:
+            ShowPage((_page + pageCount - 1) % pageCount);
+            return true;
+
+        case SDLK_PAGEDOWN:
+            ShowPage((_page + 1) % pageCount);
+            return true;
+
+        case SDLK_RETURN:
+            if (!_previews[_selection]._empty)
+            {
+                TRACE_ZONE("PresetSwitch", "preset");
+                PresetSwitchTimer presetSwitchTimer;
+                projectm_playlist_set_position(_playlist, _previews[_selection]._playlistIndex, true);
+            }
+            Leave();
+            return true;
+
+        case SDLK_ESCAPE:
+            Leave();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool PresetPreviewWall::CreateResources()
+{
+    if (!_gl.Load())
+    {
+        poco_error(_logger, "Could not load the required OpenGL functions, browse mode is not available.");
+        return false;
+    }
+
+    int atlasWidth = _columns * _thumbnailWidth;
+    int atlasHeight = _rows * _thumbnailHeight;
+
+    glGenTextures(1, &_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _gl.GenFramebuffers(1, &_atlasFramebuffer);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, _atlasFramebuffer);
+    _gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _atlasTexture, 0);
+    auto status = _gl.CheckFramebufferStatus(GL_FRAMEBUFFER);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        poco_error_f1(_logger, "Preview atlas framebuffer is incomplete (status 0x%?x).", status);
+        return false;
+    }
+
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+    glGenTextures(1, &_scratchTexture);
+    glBindTexture(GL_TEXTURE_2D, _scratchTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _thumbnailWidth, _thumbnailHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _gl.GenFramebuffers(1, &_scratchFramebuffer);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, _scratchFramebuffer);
+    _gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _scratchTexture, 0);
+    status = _gl.CheckFramebufferStatus(GL_FRAMEBUFFER);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        poco_error_f1(_logger, "Preview scratch framebuffer is incomplete (status 0x%?x).", status);
+        return false;
+    }
+#endif
+
+    auto& appConfig = Poco::Util::Application::instance().config();
+    auto texturePath = appConfig.getString("projectM.texturePath", "");
+
+    _previews.resize(static_cast<size_t>(_columns * _rows));
+    for (auto& preview : _previews)
+    {
+        preview._projectM = projectm_create();
+        if (!preview._projectM)
+        {
+            poco_error(_logger, "Could not create projectM instance for preset preview.");
+            return false;
+        }
+
+        projectm_set_window_size(preview._projectM, _thumbnailWidth, _thumbnailHeight);
+        projectm_set_mesh_size(preview._projectM, _config->getInt("meshX", 48), _config->getInt("meshY", 32));
+        projectm_set_fps(preview._projectM, appConfig.getInt("projectM.fps", 60));
+        projectm_set_preset_locked(preview._projectM, true);
+        projectm_set_hard_cut_enabled(preview._projectM, false);
+
+        if (!texturePath.empty())
+        {
+            const char* texturePathList[1]{&texturePath[0]};
+            projectm_set_texture_search_paths(preview._projectM, texturePathList, 1);
+        }
+    }
+
+    _resourcesCreated = true;
+
+    return true;
+}
+
+void PresetPreviewWall::DestroyResources()
+{
+    for (auto& preview : _previews)
+    {
+        if (preview._projectM)
+        {
+            projectm_destroy(preview._projectM);
+        }
+    }
+    _previews.clear();
+
+    if (_atlasFramebuffer)
+    {
+        _gl.DeleteFramebuffers(1, &_atlasFramebuffer);
+        _atlasFramebuffer = 0;
+    }
+
+    if (_atlasTexture)
+    {
+        glDeleteTextures(1, &_atlasTexture);
+        _atlasTexture = 0;
+    }
+
+    if (_scratchFramebuffer)
+    {
+        _gl.DeleteFramebuffers(1, &_scratchFramebuffer);
+        _scratchFramebuffer = 0;
+    }
+
+    if (_scratchTexture)
+    {
+        glDeleteTextures(1, &_scratchTexture);
+        _scratchTexture = 0;
+    }
+
+    _resourcesCreated = false;
+}
+
+void PresetPreviewWall::ShowPage(uint32_t page)
+{
+    _page = page;
+
+    auto playlistSize = projectm_playlist_size(_playlist);
+    auto firstIndex = static_cast<uint32_t>(page * _previews.size());
+
+    // Clear the atlas, so tiles without a rendered preview are black.
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, _atlasFramebuffer);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (size_t slot = 0; slot < _previews.size(); slot++)
+    {
+        auto& preview = _previews[slot];
+        preview._playlistIndex = firstIndex + static_cast<uint32_t>(slot);
+        preview._empty = preview._playlistIndex >= playlistSize;
+        preview._needsLoad = !preview._empty;
+        preview._presetFile.clear();
+
+        // Known upfront, so the expected load time can be looked up before loading.
+        auto presetFile = preview._empty ? nullptr : projectm_playlist_item(_playlist, preview._playlistIndex);
+        if (presetFile)
+        {
+            preview._presetFile = presetFile;
+            projectm_playlist_free_string(presetFile);
+        }
+    }
+
+    _nextPreview = 0;
+
+    poco_debug_f2(_logger, "Showing preview page %?d, starting at playlist index %?d.", page, firstIndex);
+}
+
+double PresetPreviewWall::ExpectedLoadTime(const Preview& preview) const
+{
+    auto measuredTime = _loadProfiler.ExpectedLoadTime(preview._presetFile);
+    return measuredTime >= 0.0 ? measuredTime : _averageLoadTime;
+}
+
+void PresetPreviewWall::LoadPreview(size_t slot)
+{
+    auto& preview = _previews[slot];
+
+    if (!preview._presetFile.empty())
+    {
+        TRACE_ZONE("LoadPreviewPreset", "preset");
+        projectm_load_preset_file(preview._projectM, preview._presetFile.c_str(), false);
+    }
+    preview._needsLoad = false;
+}
+
+void PresetPreviewWall::RenderPreview(size_t slot)
+{
+    auto& preview = _previews[slot];
+
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+    GLuint sourceFramebuffer = _scratchFramebuffer;
+    projectm_opengl_render_frame_fbo(preview._projectM, _scratchFramebuffer);
+#else
+    // projectM 4.0 always renders into the default framebuffer.
+    GLuint sourceFramebuffer = 0;
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    projectm_opengl_render_frame(preview._projectM);
+#endif
+
+    // Copy the rendered preview into its atlas tile.
+    int tileX;
+    int tileY;
+    TileOffset(slot, tileX, tileY);
+
+    _gl.BindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer);
+    _gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, _atlasFramebuffer);
+    _gl.BlitFramebuffer(0, 0, _thumbnailWidth, _thumbnailHeight,
+                        tileX, tileY, tileX + _thumbnailWidth, tileY + _thumbnailHeight,
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PresetPreviewWall::TileOffset(size_t slot, int& x, int& y) const
+{
+    auto column = static_cast<int>(slot) % _columns;
+    auto row = static_cast<int>(slot) / _columns;
+
+    x = column * _thumbnailWidth;
+    y = (_rows - 1 - row) * _thumbnailHeight;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "AudioCapture.h"
+#include "OpenGLFunctions.h"
+#include "PresetLoadProfiler.h"
+
+#include <projectM-4/playlist.h>
+#include <projectM-4/projectM.h>
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Preset browser showing a grid of live, low-resolution preset previews.
+ *
+ * Previews are rendered by a pool of small projectM instances, one per grid cell, which all receive the
+ * live audio data. Each preview is copied into a tile of a single atlas texture, which is then drawn on
+ * top of the main output in one blit. When paging through the playlist, the pool instances are recycled
+ * by loading the new presets into them.
+ *
+ * Preview work is limited by a hard per-frame time budget. Preset loads come first, then previews are rendered
+ * round-robin. Before each step, the time already spent in the frame plus the step's expected cost is checked
+ * against the budget, and the remaining work is deferred to the next frame once it's spent. The expected cost of
+ * a load is the preset's load time measured by the preset load profiler, or the average preview load time for
+ * presets it hasn't measured. Loads expected to take longer than the whole budget never fit, so they are spread
+ * out instead: at most one every few frames, and only at the start of a frame. Only the first render of a frame
+ * is always taken, so the wall keeps animating even if rendering a single preview exceeds the budget.
+ *
+ * With projectM 4.1 or later, previews are rendered into an offscreen framebuffer. Older versions always
+ * render into the default framebuffer, which is then used as scratch space.
+ */
+class PresetPreviewWall
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param audioCapture The audio capture instance feeding the preview instances.
+     * @param playlist The main playlist to browse.
+     * @param loadProfiler The load profiler providing the measured preset load times.
+     */
+    PresetPreviewWall(AudioCapture& audioCapture, projectm_playlist_handle playlist, const PresetLoadProfiler& loadProfiler);
+
+    /**
+     * @brief Destructor. Must be called on the rendering thread.
+     */
+    ~PresetPreviewWall();
+
+    /**
+     * @brief Returns whether browse mode is currently active.
+     * @return True if the preview wall is shown, false if not.
+     */
+    bool Active() const;
+
+    /**
+     * @brief Enters browse mode, showing the page containing the current playlist position.
+     */
+    void Enter();
+
+    /**
+     * @brief Leaves browse mode.
+     */
+    void Leave();
+
+    /**
+     * @brief Loads and renders as many previews as the frame budget allows.
+     *
+     * With projectM 4.0, the default framebuffer is used as scratch space, so it must be called before the
+     * main output is rendered.
+     */
+    void Update();
+
+    /**
+     * @brief Draws the preview atlas and selection marker on top of the main output.
+     * @param width The drawable width.
+     * @param height The drawable height.
+     */
+    void Draw(int width, int height);
+
+    /**
+     * @brief Handles key presses while browse mode is active.
+     * @param event The key event.
+     * @return True if the key was consumed by the browser, false if it should be handled normally.
+     */
+    bool KeyEvent(const SDL_KeyboardEvent& event);
+
+protected:
+    /**
+     * @brief A single grid cell with its projectM instance.
+     */
+    struct Preview {
+        projectm_handle _projectM{nullptr}; //!< The pooled projectM instance rendering this preview.
+        uint32_t _playlistIndex{0}; //!< Playlist index of the displayed preset.
+        std::string _presetFile; //!< File of the displayed preset.
+        bool _needsLoad{false}; //!< True if the preset has to be loaded before the next update.
+        bool _empty{true}; //!< True if there's no preset to show in this cell.
+    };
+
+    /**
+     * @brief Creates the atlas texture, framebuffer and projectM instance pool.
+     * @return True if all resources were created successfully.
+     */
+    bool CreateResources();
+
+    /**
+     * @brief Destroys all OpenGL resources and pooled projectM instances.
+     */
+    void DestroyResources();
+
+    /**
+     * @brief Assigns the presets of the given page to the pooled instances.
+     * @param page The page number, starting at 0.
+     */
+    void ShowPage(uint32_t page);
+
+    /**
+     * @brief Returns the time a preview's preset is expected to take to load.
+     * @param preview The preview.
+     * @return The expected load time in milliseconds.
+     */
+    double ExpectedLoadTime(const Preview& preview) const;
+
+    /**
+     * @brief Loads the preset of a single preview.
+     * @param slot The grid cell index.
+     */
+    void LoadPreview(size_t slot);
+
+    /**
+     * @brief Renders a single preview and copies it into its atlas tile.
+     * @param slot The grid cell index.
+     */
+    void RenderPreview(size_t slot);
+
+    /**
+     * @brief Returns the atlas offset of a grid cell. Cell 0 is top left.
+     * @param slot The grid cell index.
+     * @param x[out] Left atlas coordinate.
+     * @param y[out] Bottom atlas coordinate.
+     */
+    void TileOffset(size_t slot, int& x, int& y) const;
+
+    AudioCapture& _audioCapture; //!< Audio capture instance, feeds the previews.
+    projectm_playlist_handle _playlist{nullptr}; //!< The main playlist.
+    const PresetLoadProfiler& _loadProfiler; //!< Provides the measured preset load times.
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "browse" configuration subkey.
+
+    OpenGLFunctions _gl; //!< OpenGL 3 entry points.
+    GLuint _atlasTexture{0}; //!< Texture containing all preview tiles.
+    GLuint _atlasFramebuffer{0}; //!< Framebuffer with the atlas texture attached.
+    GLuint _scratchTexture{0}; //!< Texture a single preview is rendered into.
+    GLuint _scratchFramebuffer{0}; //!< Framebuffer with the scratch texture attached.
+
+    int _columns{4}; //!< Number of preview columns.
+    int _rows{3}; //!< Number of preview rows.
+    int _thumbnailWidth{256}; //!< Width of a single preview in pixels.
+    int _thumbnailHeight{144}; //!< Height of a single preview in pixels.
+    double _frameBudget{4.0}; //!< Hard limit for the time spent on previews per frame in milliseconds.
+
+    std::vector<Preview> _previews; //!< The preview instance pool, one per grid cell.
+    size_t _nextPreview{0}; //!< Round-robin position of the next preview to update.
+    double _averagePreviewTime{0.0}; //!< Moving average of the time needed to render a single preview.
+    double _averageLoadTime{0.0}; //!< Moving average of the time needed to load a preview's preset.
+    int _slowLoadInterval{30}; //!< Minimum number of frames between two loads exceeding the whole budget.
+    int _framesSinceSlowLoad{0}; //!< Frames since the last load exceeding the whole budget.
+
+    uint32_t _page{0}; //!< Currently displayed page.
+    size_t _selection{0}; //!< Currently selected grid cell.
+
+    bool _active{false}; //!< True while browse mode is active.
+    bool _resourcesCreated{false}; //!< True if the pool and GL resources exist.
+
+    Poco::Logger& _logger{Poco::Logger::get("PresetPreviewWall")}; //!< The class logger.
+};
@@ -0,0 +1,247 @@
+#include "PresetWatchdog.h"
+
+#include <Poco/DateTimeFormat.h>
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/Format.h>
+#include <Poco/LocalDateTime.h>
+#include <Poco/Path.h>
+#include <Poco/String.h>
+
+#include <algorithm>
+
+void PresetWatchdog::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, projectm_playlist_handle playlist)
+{
+    if (!config->getBool("enabled", true))
+    {
+        return;
+    }
+
+    _playlist = playlist;
+    _skipListFile = SkipListFile(config);
+    _skipList = LoadSkipList(config);
+
+    _frameTimeThreshold = static_cast<int64_t>(std::max(1.0, config->getDouble("frameTimeMs", 200.0)) * 1000.0);
+    _hangThreshold = static_cast<int64_t>(std::max(1.0, config->getDouble("hangMs", 1000.0)) * 1000.0);
+    _sustainedFrames = std::max(1, config->getInt("sustainedFrames", 5));
+    _graceFrames = std::max(0, config->getInt("graceFrames", 3));
+    _maxSkips = std::max(0, config->getInt("maxSkipsPerSession", 10));
+
+    _activePreset.clear();
+    _firstHangTime = 0;
+    _skipPending = false;
+    RestartGracePeriod();
+    _skipCount = 0;
+    _enabled = true;
+
+    poco_debug_f2(_logger, R"(Preset watchdog started, %?d presets in skip list "%s".)", _skipList.size(), _skipListFile);
+}
+
+void PresetWatchdog::PresetSwitched(const std::string& presetFile)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _activePreset = presetFile;
+    _firstHangTime = 0;
+    _skipPending = false;
+    RestartGracePeriod();
+}
+
+void PresetWatchdog::FrameFinished(const FlightRecorder::FrameSummary* lastFrame, bool visible)
+{
+    if (!_enabled || !lastFrame || _activePreset.empty() || _skipPending)
+    {
+        return;
+    }
+
+    // Drivers throttle or skip rendering for invisible windows, and a stalled event loop distorts the following
+    // frames, so neither says anything about the preset.
+    if (!visible || static_cast<int64_t>(lastFrame->_eventTime) > _frameTimeThreshold)
+    {
+        RestartGracePeriod();
+        return;
+    }
+
+    _framesSinceSwitch++;
+
+    // Loading the preset and compiling its shaders is measured by the preset load profiler instead.
+    if (_framesSinceSwitch <= _graceFrames)
+    {
+        return;
+    }
+
+    int64_t frameTimeUs = lastFrame->_renderTime;
+    if (lastFrame->_gpuTimeValid)
+    {
+        frameTimeUs = std::max(frameTimeUs, static_cast<int64_t>(lastFrame->_gpuTime));
+    }
+
+    if (frameTimeUs <= _frameTimeThreshold)
+    {
+        _consecutiveOverruns = 0;
+        _worstFrameTime = 0;
+        return;
+    }
+
+    _consecutiveOverruns++;
+    _worstFrameTime = std::max(_worstFrameTime, frameTimeUs);
+
+    if (frameTimeUs > _hangThreshold)
+    {
+        // A single hang may be the driver or system, only a second one is blamed on the preset.
+        if (_firstHangTime == 0)
+        {
+            _firstHangTime = frameTimeUs;
+            poco_debug_f2(_logger, R"(Preset "%s" took %.0f ms for a frame, skipping it if this happens again.)",
+                          _activePreset, static_cast<double>(frameTimeUs) / 1000.0);
+            return;
+        }
+
+        _skipReason = Poco::format("two frames took %.0f ms and %.0f ms",
+                                   static_cast<double>(_firstHangTime) / 1000.0,
+                                   static_cast<double>(frameTimeUs) / 1000.0);
+        _skipPending = true;
+        return;
+    }
+
+    if (_consecutiveOverruns >= _sustainedFrames)
+    {
+        _skipReason = Poco::format("%?d consecutive frames over %.0f ms, longest %.0f ms",
+                                   _consecutiveOverruns,
+                                   static_cast<double>(_frameTimeThreshold) / 1000.0,
+                                   static_cast<double>(_worstFrameTime) / 1000.0);
+        _skipPending = true;
+    }
+}
+
+void PresetWatchdog::Update()
+{
+    if (!_enabled || !_skipPending)
+    {
+        return;
+    }
+
+    _skipPending = false;
+
+    if (_skipCount >= _maxSkips)
+    {
+        poco_warning(_logger, Poco::format(R"(Not skipping preset "%s" (%s): already skipped %?d presets in this session, )"
+                                           "the machine may be too slow for the current settings.",
+                                           _activePreset, _skipReason, _skipCount));
+        _consecutiveOverruns = 0;
+        _worstFrameTime = 0;
+        return;
+    }
+
+    SkipPreset();
+}
+
+std::vector<std::string> PresetWatchdog::LoadSkipList(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    std::vector<std::string> skipList;
+
+    auto skipListFile = SkipListFile(config);
+    if (!Poco::File(skipListFile).exists())
+    {
+        return skipList;
+    }
+
+    try
+    {
+        Poco::FileInputStream input(skipListFile);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            Poco::trimInPlace(line);
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            if (std::find(skipList.begin(), skipList.end(), line) == skipList.end())
+            {
+                skipList.push_back(line);
+            }
+        }
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(Poco::Logger::get("PresetWatchdog"), R"(Could not read preset skip list "%s": %s)",
+                      skipListFile, ex.displayText());
+    }
+
+    return skipList;
+}
+
+void PresetWatchdog::SetPlaylistFilter(projectm_playlist_handle playlist, const std::vector<std::string>& skipList)
+{
+    // Exclusion filters are glob patterns, which match the literal path as long as it contains no wildcards.
+    std::vector<std::string> filters;
+    filters.reserve(skipList.size());
+    for (const auto& presetFile : skipList)
+    {
+        filters.push_back("-" + presetFile);
+    }
+
+    std::vector<const char*> filterList;
+    filterList.reserve(filters.size());
+    for (const auto& filter : filters)
+    {
+        filterList.push_back(filter.c_str());
+    }
+
+    projectm_playlist_set_filter(playlist, filterList.data(), filterList.size());
+}
+
+void PresetWatchdog::RestartGracePeriod()
+{
+    _framesSinceSwitch = 0;
+    _consecutiveOverruns = 0;
+    _worstFrameTime = 0;
+}
+
+std::string PresetWatchdog::SkipListFile(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    return config->getString("skipListFile",
+                             Poco::Path::configHome() + "projectM" + Poco::Path::separator() + "presetSkipList.txt");
+}
+
+void PresetWatchdog::SkipPreset()
+{
+    poco_warning(_logger, Poco::format(R"(Skipping preset "%s" and adding it to the skip list: %s.)", _activePreset, _skipReason));
+
+    _skipCount++;
+
+    if (std::find(_skipList.begin(), _skipList.end(), _activePreset) == _skipList.end())
+    {
+        _skipList.push_back(_activePreset);
+
+        // Written immediately, as a preset this slow may well hang the driver completely next time.
+        try
+        {
+            Poco::File(Poco::Path(_skipListFile).parent()).createDirectories();
+
+            Poco::FileOutputStream output(_skipListFile, std::ios::out | std::ios::app);
+            output << "# " << Poco::DateTimeFormatter::format(Poco::LocalDateTime(), Poco::DateTimeFormat::SORTABLE_FORMAT)
+                   << ": " << _skipReason << std::endl;
+            output << _activePreset << std::endl;
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(_logger, R"(Could not write preset skip list "%s": %s)", _skipListFile, ex.displayText());
+        }
+    }
+
+    std::string skippedPreset = _activePreset;
+
+    projectm_playlist_play_next(_playlist, true);
+
+    SetPlaylistFilter(_playlist, _skipList);
+    auto removed = projectm_playlist_apply_filter(_playlist);
+
+    poco_information_f2(_logger, R"(Removed %?u playlist item(s) of preset "%s".)", removed, skippedPreset);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "FlightRecorder.h"
+
+#include <projectM-4/playlist.h>
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Skips presets which cause pathological frame times and adds them to a persisted skip list.
+ *
+ * Only the preset's own cost is watched: the CPU time of projectM's frame rendering or the measured GPU time,
+ * whichever is higher, as taken from the flight recorder. Nothing is watched if the flight recorder is disabled.
+ * Time spent waiting for events or the frame limiter, or while the process wasn't scheduled, doesn't count.
+ *
+ * A preset is skipped if a number of consecutive frames exceed the frame time threshold, or if two frames of the
+ * same preset exceed the hang threshold, so a single hiccup of the driver or system never skips a preset. The first
+ * frames after a switch are ignored, as loading a preset and compiling its shaders always takes a while. The same
+ * grace period starts again after the window was hidden or minimized, and after event handling stalled, e.g. while
+ * the window was dragged, as the driver may need a few frames to catch up. Skipped presets are appended to the skip list file together with
+ * the reason, and removed from the playlist via an exclusion filter. ProjectMWrapper applies the same filter
+ * on startup, so skipped presets aren't loaded again in later runs.
+ *
+ * To avoid emptying the playlist on a machine which is simply too slow, only a limited number of presets
+ * is skipped per session.
+ *
+ * Configured via the "presetWatchdog" configuration subkey.
+ */
+class PresetWatchdog
+{
+public:
+    PresetWatchdog() = default;
+
+    /**
+     * @brief Loads the skip list and starts watching frame times.
+     *
+     * Until this is called, all other methods do nothing. Does nothing if "enabled" is false in the configuration.
+     *
+     * @param config View of the "presetWatchdog" configuration subkey.
+     * @param playlist The playlist to skip presets in.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config, projectm_playlist_handle playlist);
+
+    /**
+     * @brief Starts watching a newly loaded preset.
+     * @param presetFile The file of the new preset.
+     */
+    void PresetSwitched(const std::string& presetFile);
+
+    /**
+     * @brief Checks the preset's cost in a finished frame against the thresholds.
+     * @param lastFrame The timings of the finished frame, or nullptr if the flight recorder has no data.
+     * @param visible False if the window is hidden or minimized.
+     */
+    void FrameFinished(const FlightRecorder::FrameSummary* lastFrame, bool visible);
+
+    /**
+     * @brief Skips the active preset if the previous frames overran the thresholds.
+     *
+     * Called at the start of a frame, so the switch is handled like one caused by user input.
+     */
+    void Update();
+
+    /**
+     * @brief Reads the skip list file.
+     * @param config View of the "presetWatchdog" configuration subkey.
+     * @return The preset files in the skip list. Empty if the file doesn't exist.
+     */
+    static std::vector<std::string> LoadSkipList(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Sets a playlist filter excluding all presets in the skip list.
+     *
+     * The filter is applied to presets added afterwards. Call projectm_playlist_apply_filter() to remove
+     * presets already in the playlist.
+     *
+     * @param playlist The playlist to filter.
+     * @param skipList Preset files to exclude.
+     */
+    static void SetPlaylistFilter(projectm_playlist_handle playlist, const std::vector<std::string>& skipList);
+
+protected:
+    /**
+     * @brief Returns the skip list file path from the configuration.
+     * @param config View of the "presetWatchdog" configuration subkey.
+     * @return The skip list file path.
+     */
+    static std::string SkipListFile(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Clears the overrun counters and ignores the next frames like after a preset switch.
+     */
+    void RestartGracePeriod();
+
+    /**
+     * @brief Appends the active preset to the skip list file and the playlist filter, then skips to the next one.
+     */
+    void SkipPreset();
+
+    bool _enabled{false}; //!< True while watching.
+    projectm_playlist_handle _playlist{nullptr}; //!< The playlist to skip presets in.
+    std::string _skipListFile; //!< The skip list file.
+    std::vector<std::string> _skipList; //!< All skipped presets, including those of previous runs.
+
+    int64_t _frameTimeThreshold{0}; //!< Frame time in microseconds above which a frame counts as an overrun.
+    int64_t _hangThreshold{0}; //!< Frame time in microseconds above which a frame counts as a hang. Two hangs trigger a skip.
+    int _sustainedFrames{0}; //!< Number of consecutive overruns triggering a skip.
+    int _graceFrames{0}; //!< Frames after a switch which are ignored.
+    int _maxSkips{0}; //!< Maximum number of presets skipped per session.
+
+    std::string _activePreset; //!< File of the active preset, empty if unknown.
+    int _framesSinceSwitch{0}; //!< Frames rendered with the active preset.
+    int _consecutiveOverruns{0}; //!< Current number of consecutive overruns.
+    int64_t _worstFrameTime{0}; //!< Longest frame time of the current overrun streak.
+    int64_t _firstHangTime{0}; //!< Time of the active preset's first hang, 0 if it didn't hang yet.
+    bool _skipPending{false}; //!< True if the active preset should be skipped at the next Update().
+    std::string _skipReason; //!< Why the active preset is skipped, for the log and skip list.
+    int _skipCount{0}; //!< Number of presets skipped in this session.
+
+    Poco::Logger& _logger{Poco::Logger::get("PresetWatchdog")}; //!< The class logger.
+};
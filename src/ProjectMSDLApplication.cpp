@@ -5,9 +5,18 @@
 #include "ProjectMSDLApplication.h"
 
 #include "AudioCapture.h"
+#include "MetricsServer.h"
+#include "PresetLoadProfiler.h"
 #include "ProjectMWrapper.h"
+#include "RealtimeThreads.h"
+#include "RenderFarm.h"
+#include "RenderFarmWorker.h"
 #include "RenderLoop.h"
 #include "SDLRenderingWindow.h"
+#include "ThumbnailGenerator.h"
+#include "ThumbnailWorker.h"
+#include "Tracer.h"
+#include "ZoneManager.h"
 
 #include <Poco/Environment.h>
 #include <Poco/File.h>
@@ -23,6 +32,8 @@ ProjectMSDLApplication::ProjectMSDLApplication()
     addSubsystem(new SDLRenderingWindow);
     addSubsystem(new ProjectMWrapper);
     addSubsystem(new AudioCapture);
+    addSubsystem(new ZoneManager);
+    addSubsystem(new MetricsServer);
 }
 
 const char* ProjectMSDLApplication::name() const
@@ -34,23 +45,51 @@ void ProjectMSDLApplication::initialize(Poco::Util::Application& self)
 {
     config().add(_commandLineOverrides, PRIO_APPLICATION);
 
-    loadConfiguration(PRIO_DEFAULT);
+    // Started first, so loading the configuration and initializing the subsystems is traced as well.
+    auto traceFile = config().getString("tracing.file", "");
+    if (!traceFile.empty())
+    {
+        try
+        {
+            Tracer::Instance().Start(traceFile);
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(logger(), R"(Could not create trace file "%s": %s)", traceFile, ex.displayText());
+        }
+    }
 
-    // Try to load user's custom configuration file on top.
-    Poco::Path userConfigurationFile =
-        Poco::Path::configHome() + "projectM" + Poco::Path::separator() + "projectMSDL.properties";
-    if (Poco::File(userConfigurationFile).exists())
     {
-        loadConfiguration(userConfigurationFile.toString(), PRIO_DEFAULT - 10);
+        TRACE_ZONE("LoadConfiguration", "init");
+
+        loadConfiguration(PRIO_DEFAULT);
+
+        // Try to load user's custom configuration file on top.
+        Poco::Path userConfigurationFile =
+            Poco::Path::configHome() + "projectM" + Poco::Path::separator() + "projectMSDL.properties";
+        if (Poco::File(userConfigurationFile).exists())
+        {
+            loadConfiguration(userConfigurationFile.toString(), PRIO_DEFAULT - 10);
+        }
     }
 
+    // Configured before the subsystems start their threads.
+    RealtimeThreads::Instance().Configure(config().createView("realtime"));
+
+    TRACE_ZONE("InitializeSubsystems", "init");
 
     Application::initialize(self);
 }
 
 void ProjectMSDLApplication::uninitialize()
 {
-    Application::uninitialize();
+    {
+        TRACE_ZONE("UninitializeSubsystems", "init");
+
+        Application::uninitialize();
+    }
+
+    Tracer::Instance().Stop();
 }
 
 void ProjectMSDLApplication::defineOptions(Poco::Util::OptionSet& options)
@@ -160,12 +199,118 @@ void ProjectMSDLApplication::defineOptions(Poco::Util::OptionSet& options)
                              false, "<number>", true)
                           .binding("projectM.beatSensitivity", _commandLineOverrides));
 
+    options.addOption(Option("record", "",
+                             "Records audio, input events, viewport sizes and preset switches of this session into the given file for later replay.",
+                             false, "<file>", true)
+                          .binding("session.recordFile", _commandLineOverrides));
+
+    options.addOption(Option("replay", "",
+                             "Replays a recorded session frame by frame on a hidden window, then exits and reports frame time statistics.",
+                             false, "<file>", true)
+                          .binding("session.replayFile", _commandLineOverrides)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::ReplaySession)));
+
+    options.addOption(Option("replayReport", "", "Writes the frame time statistics of a replay as JSON into the given file.",
+                             false, "<file>", true)
+                          .binding("session.replayReport", _commandLineOverrides));
+
+    options.addOption(Option("replayRealtime", "", "If true, replays at the configured FPS instead of as fast as possible.",
+                             false, "<0/1>", true)
+                          .binding("session.replayRealtime", _commandLineOverrides));
+
+    options.addOption(Option("trace", "", "Records timing zones of the render loop, audio capture and initialization into the given "
+                                          "Chrome trace event JSON file, which can be loaded into Perfetto or chrome://tracing.",
+                             false, "<file>", true)
+                          .binding("tracing.file", _commandLineOverrides));
+
+    options.addOption(Option("presetLoadReport", "",
+                             "Lists the given number of presets with the slowest recorded load times and exits.",
+                             false, "<count>", true)
+                          .binding("presetLoadProfiler.reportCount", _commandLineOverrides)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::PresetLoadReport)));
+
+    options.addOption(Option("thumbnails", "",
+                             "Renders a thumbnail image of each preset into the given directory and exits. "
+                             "Already rendered thumbnails are skipped, so an interrupted run can be resumed.",
+                             false, "<path>", true)
+                          .binding("thumbnails.outputPath", _commandLineOverrides)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::GenerateThumbnails)));
+
+    options.addOption(Option("thumbnailAudio", "", "WAV file used as audio input when rendering thumbnails.",
+                             false, "<file>", true)
+                          .binding("thumbnails.audioFile", _commandLineOverrides));
+
+    options.addOption(Option("thumbnailWorkers", "", "Number of worker processes rendering thumbnails. Default is the number of CPU cores.",
+                             false, "<number>", true)
+                          .binding("thumbnails.workers", _commandLineOverrides));
+
+    // Internal option, used to launch the thumbnail worker processes.
+    options.addOption(Option("thumbnailWorker", "", "")
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::ThumbnailWorkerMode)));
+
+    options.addOption(Option("renderJobs", "",
+                             "Renders all jobs in the given JSON job manifest offline using local worker processes and exits.",
+                             false, "<file>", true)
+                          .binding("renderFarm.manifest", _commandLineOverrides)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::RenderJobs)));
+
+    options.addOption(Option("renderWorkers", "", "Number of render worker processes. Default is one per \"renderFarm.llvmpipeThreads\" CPU cores.",
+                             false, "<number>", true)
+                          .binding("renderFarm.workers", _commandLineOverrides));
+
+    // Internal options, used to launch the render farm worker processes.
+    options.addOption(Option("renderWorker", "", "")
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::RenderWorkerMode)));
+
+    options.addOption(Option("renderCpus", "", "", false, "<list>", true)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::RenderCpus)));
 }
 
 int ProjectMSDLApplication::main(POCO_UNUSED const std::vector<std::string>& args)
 {
-    RenderLoop renderLoop;
-    renderLoop.Run();
+    switch (_runMode)
+    {
+        case RunMode::Thumbnails: {
+            ThumbnailGenerator generator;
+            return generator.Run();
+        }
+
+        case RunMode::ThumbnailWorker: {
+            ThumbnailWorker worker;
+            return worker.Run();
+        }
+
+        case RunMode::RenderFarm: {
+            RenderFarm renderFarm;
+            return renderFarm.Run();
+        }
+
+        case RunMode::RenderWorker: {
+            RenderFarmWorker worker;
+            return worker.Run();
+        }
+
+        case RunMode::PresetLoadReport: {
+            PresetLoadProfiler profiler;
+            auto profilerConfig = config().createView("presetLoadProfiler");
+            profiler.Report(profilerConfig, profilerConfig->getUInt("reportCount", 20), std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        case RunMode::Interactive:
+        default: {
+            RenderLoop renderLoop;
+            renderLoop.Run();
+            break;
+        }
+    }
 
     return EXIT_SUCCESS;
 }
@@ -208,3 +353,65 @@ void ProjectMSDLApplication::ListAudioDevices(POCO_UNUSED const std::string& nam
 {
     _commandLineOverrides->setBool("audio.listDevices", true);
 }
+
+void ProjectMSDLApplication::GenerateThumbnails(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _runMode = RunMode::Thumbnails;
+    SetHeadlessOverrides();
+}
+
+void ProjectMSDLApplication::ThumbnailWorkerMode(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _runMode = RunMode::ThumbnailWorker;
+    SetHeadlessOverrides();
+
+    // Workers load presets one by one, scanning the preset directory would only slow down startup.
+    _commandLineOverrides->setString("projectM.presetPath", "");
+}
+
+void ProjectMSDLApplication::RenderJobs(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _runMode = RunMode::RenderFarm;
+    SetHeadlessOverrides();
+
+    // The coordinator itself doesn't render anything.
+    _commandLineOverrides->setString("projectM.presetPath", "");
+}
+
+void ProjectMSDLApplication::RenderWorkerMode(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _runMode = RunMode::RenderWorker;
+    SetHeadlessOverrides();
+
+    // Presets are loaded as listed in the job.
+    _commandLineOverrides->setString("projectM.presetPath", "");
+}
+
+void ProjectMSDLApplication::RenderCpus(POCO_UNUSED const std::string& name, const std::string& value)
+{
+    // Options are processed before the subsystems are initialized, so all threads created later inherit this.
+    RenderFarmWorker::PinToCpus(value);
+}
+
+void ProjectMSDLApplication::ReplaySession(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    SetHeadlessOverrides();
+}
+
+void ProjectMSDLApplication::PresetLoadReport(POCO_UNUSED const std::string& name, POCO_UNUSED const std::string& value)
+{
+    _runMode = RunMode::PresetLoadReport;
+    SetHeadlessOverrides();
+
+    // Only the statistics file is read.
+    _commandLineOverrides->setString("projectM.presetPath", "");
+}
+
+void ProjectMSDLApplication::SetHeadlessOverrides()
+{
+    _commandLineOverrides->setBool("window.hidden", true);
+    _commandLineOverrides->setBool("window.fullscreen", false);
+    _commandLineOverrides->setBool("window.waitForVerticalSync", false);
+    _commandLineOverrides->setBool("audio.enabled", false);
+    _commandLineOverrides->setBool("projectM.enableSplash", false);
+}
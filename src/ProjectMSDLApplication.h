@@ -28,6 +28,75 @@ protected:
 
     void ListAudioDevices(const std::string& name, const std::string& value);
 
+    /**
+     * @brief Switches to thumbnail generation mode.
+     * @param name Unused.
+     * @param value The output directory.
+     */
+    void GenerateThumbnails(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Runs as a thumbnail worker process, spawned by the thumbnail generator.
+     * @param name Unused.
+     * @param value Unused.
+     */
+    void ThumbnailWorkerMode(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Switches to render farm mode.
+     * @param name Unused.
+     * @param value The job manifest file.
+     */
+    void RenderJobs(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Runs as a render farm worker process, spawned by the render farm.
+     * @param name Unused.
+     * @param value Unused.
+     */
+    void RenderWorkerMode(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Pins the process to the given CPUs. Called before any subsystem is initialized.
+     * @param name Unused.
+     * @param value The CPU list.
+     */
+    void RenderCpus(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Replays a recorded session on a hidden window.
+     * @param name Unused.
+     * @param value The session recording file.
+     */
+    void ReplaySession(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Prints the presets with the slowest recorded load times and exits.
+     * @param name Unused.
+     * @param value Number of presets to list.
+     */
+    void PresetLoadReport(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Sets the overrides needed to run without a visible window and audio capture.
+     */
+    void SetHeadlessOverrides();
+
+    /**
+     * @brief What the application does after initialization.
+     */
+    enum class RunMode
+    {
+        Interactive, //!< Displays the visualizer window.
+        Thumbnails, //!< Generates preset thumbnails using worker processes.
+        ThumbnailWorker, //!< Renders thumbnails as instructed via stdin.
+        RenderFarm, //!< Renders all jobs of a job manifest using worker processes.
+        RenderWorker, //!< Renders a single job received via stdin.
+        PresetLoadReport //!< Prints the slowest preset loads.
+    };
+
+    RunMode _runMode{RunMode::Interactive}; //!< The selected run mode.
+
     Poco::AutoPtr<Poco::Util::MapConfiguration> _commandLineOverrides{
         new Poco::Util::MapConfiguration() }; //!< Map configuration with overrides set by command line arguments.
 };
@@ -1,6 +1,9 @@
 #include "ProjectMWrapper.h"
 
+#include "Metrics.h"
+#include "PresetWatchdog.h"
 #include "SDLRenderingWindow.h"
+#include "Tracer.h"
 
 #include <Poco/Util/Application.h>
 
@@ -13,7 +16,7 @@ const char* ProjectMWrapper::name() const
 
 void ProjectMWrapper::initialize(Poco::Util::Application& app)
 {
-    _config = app.config().createView("projectM");
+    TRACE_ZONE("ProjectMWrapper::initialize", "init");
 
     if (!_projectM)
     {
@@ -24,6 +27,20 @@ void ProjectMWrapper::initialize(Poco::Util::Application& app)
 
         sdlWindow.GetDrawableSize(canvasWidth, canvasHeight);
 
+        initialize(app.config().createView("projectM"), canvasWidth, canvasHeight);
+    }
+}
+
+void ProjectMWrapper::initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config,
+                                 int canvasWidth, int canvasHeight,
+                                 const std::vector<std::string>& presetIndex)
+{
+    _config = config;
+
+    if (!_projectM)
+    {
+        auto& app = Poco::Util::Application::instance();
+
         auto presetPath = _config->getString("presetPath", app.config().getString("application.dir", ""));
         auto texturePath = _config->getString("texturePath", app.config().getString("", ""));
 
@@ -52,8 +69,31 @@ void ProjectMWrapper::initialize(Poco::Util::Application& app)
         _playlist = projectm_playlist_create(_projectM);
 
         projectm_playlist_set_shuffle(_playlist, _config->getBool("shuffleEnabled", true));
-        if (!presetPath.empty())
+
+        // Presets skipped by the watchdog in previous runs are filtered out when adding presets.
+        auto skipList = PresetWatchdog::LoadSkipList(app.config().createView("presetWatchdog"));
+        if (!skipList.empty())
+        {
+            PresetWatchdog::SetPlaylistFilter(_playlist, skipList);
+            poco_debug_f1(_logger, "Excluding %?d presets in the watchdog skip list.", skipList.size());
+        }
+
+        if (!presetIndex.empty())
         {
+            // Already scanned and sorted by another instance, no need to hit the disk again.
+            std::vector<const char*> presetFiles;
+            presetFiles.reserve(presetIndex.size());
+            for (const auto& presetFile : presetIndex)
+            {
+                presetFiles.push_back(presetFile.c_str());
+            }
+
+            projectm_playlist_add_presets(_playlist, presetFiles.data(), static_cast<uint32_t>(presetFiles.size()), false);
+        }
+        else if (!presetPath.empty())
+        {
+            TRACE_ZONE("ScanPresets", "playlist");
+
             projectm_playlist_add_path(_playlist, presetPath.c_str(), true, false);
             projectm_playlist_sort(_playlist, 0, projectm_playlist_size(_playlist), SORT_PREDICATE_FILENAME_ONLY, SORT_ORDER_ASCENDING);
         }
@@ -103,6 +143,9 @@ void ProjectMWrapper::DisplayInitialPreset()
 {
     if (!_config->getBool("enableSplash", true))
     {
+        TRACE_ZONE("PresetSwitch", "preset");
+        PresetSwitchTimer presetSwitchTimer;
+
         if (_config->getBool("shuffleEnabled", true))
         {
             projectm_playlist_play_next(_playlist, true);
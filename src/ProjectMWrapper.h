@@ -9,6 +9,8 @@
 #include <Poco/Util/Subsystem.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 class ProjectMWrapper : public Poco::Util::Subsystem
 {
@@ -42,6 +44,21 @@ public:
 
     void initialize(Poco::Util::Application& app) override;
 
+    /**
+     * @brief Creates the projectM and playlist instances using the given configuration.
+     *
+     * Must be called on the thread the rendering window's OpenGL context is current on.
+     *
+     * @param config View of the "projectM" configuration subkey to use.
+     * @param canvasWidth Initial rendering canvas width.
+     * @param canvasHeight Initial rendering canvas height.
+     * @param presetIndex If not empty, the playlist is filled from this list of preset files instead of
+     *                    scanning the preset path again.
+     */
+    void initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config,
+                    int canvasWidth, int canvasHeight,
+                    const std::vector<std::string>& presetIndex = {});
+
     void uninitialize() override;
 
 
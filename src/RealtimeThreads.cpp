@@ -0,0 +1,282 @@
+#include "RealtimeThreads.h"
+
+#include <Poco/NumberParser.h>
+#include <Poco/String.h>
+#include <Poco/StringTokenizer.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace {
+
+/**
+ * @brief Returns the description of the last error for the startup report.
+ * @param error The error number.
+ * @return The error description.
+ */
+std::string ErrorText(int error)
+{
+    return std::string(std::strerror(error));
+}
+
+} // namespace
+
+RealtimeThreads& RealtimeThreads::Instance()
+{
+    static RealtimeThreads instance;
+    return instance;
+}
+
+void RealtimeThreads::Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    _audio = LoadSettings(config->createView("audio"));
+    _render = LoadSettings(config->createView("render"));
+    _lockMemory = config->getBool("lockMemory", false);
+    _lockReported = false;
+}
+
+void RealtimeThreads::TuneCurrentThread(Role role)
+{
+    static thread_local bool tuned{false};
+    if (tuned)
+    {
+        return;
+    }
+    tuned = true;
+
+    const auto& settings = role == Role::Audio ? _audio : _render;
+    if (settings._cpus.empty() && settings._policy == "default" && settings._nice == 0)
+    {
+        return;
+    }
+
+    std::string report;
+    if (!settings._cpus.empty())
+    {
+        report = ApplyAffinity(settings._cpus);
+    }
+
+    if (settings._policy != "default" || settings._nice != 0)
+    {
+        report += (report.empty() ? "" : "; ") + ApplyScheduling(settings);
+    }
+
+    poco_information_f2(_logger, "%s thread: %s.", std::string(role == Role::Audio ? "Audio" : "Render"), report);
+}
+
+bool RealtimeThreads::LockMemory(const void* data, size_t size)
+{
+    if (!_lockMemory || data == nullptr || size == 0)
+    {
+        return false;
+    }
+
+#if defined(_WIN32)
+    bool locked = VirtualLock(const_cast<void*>(data), size) != 0;
+    auto error = locked ? std::string() : std::string("error ") + std::to_string(GetLastError());
+#else
+    bool locked = mlock(data, size) == 0;
+    auto error = locked ? std::string() : ErrorText(errno);
+#endif
+
+    // Only the first outcome is reported, all audio buffers are usually locked the same way.
+    if (!_lockReported.exchange(true))
+    {
+        if (locked)
+        {
+            poco_information(_logger, "Audio buffers are locked in memory.");
+        }
+        else
+        {
+            poco_warning_f1(_logger, "Could not lock audio buffers in memory (%s). Raise the locked memory limit, "
+                                     "e.g. with \"ulimit -l\", to use realtime.lockMemory.", error);
+        }
+    }
+
+    poco_debug_f2(_logger, "%s %?d bytes of audio buffer.", std::string(locked ? "Locked" : "Failed to lock"), size);
+
+    return locked;
+}
+
+void RealtimeThreads::UnlockMemory(const void* data, size_t size)
+{
+#if defined(_WIN32)
+    VirtualUnlock(const_cast<void*>(data), size);
+#else
+    munlock(data, size);
+#endif
+}
+
+RealtimeThreads::Settings RealtimeThreads::LoadSettings(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config) const
+{
+    Settings settings;
+
+    Poco::StringTokenizer cpus(config->getString("cpus", ""), ",",
+                               Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    for (const auto& cpu : cpus)
+    {
+        int cpuIndex{0};
+        if (Poco::NumberParser::tryParse(cpu, cpuIndex) && cpuIndex >= 0)
+        {
+            settings._cpus.push_back(cpuIndex);
+        }
+        else
+        {
+            poco_warning_f1(_logger, R"(Ignoring invalid CPU index "%s".)", cpu);
+        }
+    }
+
+    settings._policy = Poco::toLower(config->getString("policy", "default"));
+    if (settings._policy != "default" && settings._policy != "fifo" && settings._policy != "rr")
+    {
+        poco_warning_f1(_logger, R"(Unknown scheduling policy "%s", using the default policy.)", settings._policy);
+        settings._policy = "default";
+    }
+
+    settings._priority = config->getInt("priority", 50);
+    settings._nice = std::min(19, std::max(-20, config->getInt("nice", 0)));
+
+    return settings;
+}
+
+std::string RealtimeThreads::ApplyAffinity(const std::vector<int>& cpus)
+{
+    std::string cpuList;
+    for (auto cpu : cpus)
+    {
+        cpuList += (cpuList.empty() ? "" : ",") + std::to_string(cpu);
+    }
+
+#if defined(_WIN32)
+    DWORD_PTR mask{0};
+    for (auto cpu : cpus)
+    {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+        {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+    {
+        return "pinning to CPUs " + cpuList + " failed (error " + std::to_string(GetLastError()) + ")";
+    }
+    return "pinned to CPUs " + cpuList;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    auto result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0)
+    {
+        return "pinning to CPUs " + cpuList + " failed (" + ErrorText(result) + ")";
+    }
+    return "pinned to CPUs " + cpuList;
+#else
+    return "pinning to CPUs " + cpuList + " is not supported on this platform";
+#endif
+}
+
+std::string RealtimeThreads::ApplyScheduling(const Settings& settings)
+{
+    if (settings._policy == "default")
+    {
+        return ApplyNice(settings._nice);
+    }
+
+#if defined(_WIN32)
+    // Windows has no real-time policies for single threads, the highest priority comes closest.
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+    {
+        return "time critical priority instead of " + settings._policy + " scheduling";
+    }
+    return "raising the priority failed (error " + std::to_string(GetLastError()) + ")";
+#else
+    int policy = settings._policy == "fifo" ? SCHED_FIFO : SCHED_RR;
+    auto policyName = settings._policy == "fifo" ? std::string("SCHED_FIFO") : std::string("SCHED_RR");
+
+    sched_param parameters{};
+    parameters.sched_priority = std::min(sched_get_priority_max(policy), std::max(sched_get_priority_min(policy), settings._priority));
+
+    auto result = pthread_setschedparam(pthread_self(), policy, &parameters);
+    if (result == 0)
+    {
+        return policyName + " priority " + std::to_string(parameters.sched_priority);
+    }
+
+    auto failure = policyName + " priority " + std::to_string(parameters.sched_priority) + " failed (" + ErrorText(result) + ")";
+    if (settings._nice == 0)
+    {
+        return failure + ", keeping the default scheduling";
+    }
+
+    return failure + ", falling back to " + ApplyNice(settings._nice);
+#endif
+}
+
+std::string RealtimeThreads::ApplyNice(int nice)
+{
+    if (nice == 0)
+    {
+        return "default scheduling";
+    }
+
+#if defined(__linux__)
+    // On Linux, the nice value is a per-thread attribute when set for the thread ID.
+    auto threadId = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, threadId, nice) != 0)
+    {
+        return "nice " + std::to_string(nice) + " failed (" + ErrorText(errno) + ")";
+    }
+    return "nice " + std::to_string(nice);
+#else
+    return "nice " + std::to_string(nice) + " is not supported for single threads on this platform";
+#endif
+}
+
+LockedBuffer::~LockedBuffer()
+{
+    Unlock();
+}
+
+void LockedBuffer::Lock(const void* data, size_t size)
+{
+    Unlock();
+
+    if (RealtimeThreads::Instance().LockMemory(data, size))
+    {
+        _data = data;
+        _size = size;
+    }
+}
+
+void LockedBuffer::Unlock()
+{
+    if (_data)
+    {
+        RealtimeThreads::UnlockMemory(_data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+}
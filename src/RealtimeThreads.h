@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Applies CPU affinity and real-time scheduling to the audio and render threads, and locks audio buffers.
+ *
+ * Under system load, threads with default scheduling get preempted, and the audio callback may miss its deadline
+ * or page-fault on a buffer which was swapped out. Each thread calls TuneCurrentThread() when it starts, or on its
+ * first callback for threads created by SDL or the OS. The settings are applied once per thread:
+ *
+ * - The thread is pinned to the configured CPUs.
+ * - SCHED_FIFO or SCHED_RR is requested with the configured priority. If that's not permitted, e.g. without
+ *   CAP_SYS_NICE or an RLIMIT_RTPRIO limit, the thread's nice value is lowered instead, if configured.
+ *
+ * Each thread logs which of its settings actually took effect. Buffers written by audio callbacks are locked in
+ * memory via LockedBuffer, so the callbacks never page-fault.
+ *
+ * Configured via the "realtime" configuration subkey.
+ */
+class RealtimeThreads
+{
+public:
+    /**
+     * @brief The thread roles which can be tuned.
+     */
+    enum class Role
+    {
+        Audio, //!< Threads delivering captured audio: SDL's audio callback, the PCM stream reader and WASAPI's capture thread.
+        Render //!< The main render loop thread.
+    };
+
+    /**
+     * @brief Returns the global instance.
+     * @return The real-time thread settings.
+     */
+    static RealtimeThreads& Instance();
+
+    /**
+     * @brief Loads the settings. Must be called before any thread is tuned.
+     * @param config View of the "realtime" configuration subkey.
+     */
+    void Configure(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
+    /**
+     * @brief Applies the settings of a role to the calling thread, if not done before.
+     *
+     * Cheap enough to be called at the start of every audio callback.
+     *
+     * @param role The role of the calling thread.
+     */
+    void TuneCurrentThread(Role role);
+
+    /**
+     * @brief Locks a memory range, so it's never paged out. Does nothing if memory locking is disabled.
+     * @param data Start of the range.
+     * @param size Size of the range in bytes.
+     * @return True if the range was locked.
+     */
+    bool LockMemory(const void* data, size_t size);
+
+    /**
+     * @brief Unlocks a memory range previously locked with LockMemory().
+     * @param data Start of the range.
+     * @param size Size of the range in bytes.
+     */
+    static void UnlockMemory(const void* data, size_t size);
+
+protected:
+    /**
+     * @brief Settings of one thread role.
+     */
+    struct Settings {
+        std::vector<int> _cpus; //!< CPUs to pin the thread to. Empty to keep the default affinity.
+        std::string _policy{"default"}; //!< Scheduling policy: "default", "fifo" or "rr".
+        int _priority{0}; //!< Real-time priority for the "fifo" and "rr" policies.
+        int _nice{0}; //!< Nice value used if real-time scheduling isn't permitted, or with the default policy.
+    };
+
+    RealtimeThreads() = default;
+
+    /**
+     * @brief Reads the settings of one role.
+     * @param config View of the role's configuration subkey.
+     * @return The settings.
+     */
+    Settings LoadSettings(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config) const;
+
+    /**
+     * @brief Pins the calling thread to the configured CPUs.
+     * @param cpus The CPUs.
+     * @return A description of the outcome for the startup report.
+     */
+    static std::string ApplyAffinity(const std::vector<int>& cpus);
+
+    /**
+     * @brief Sets the scheduling policy and priority of the calling thread, falling back to the nice value.
+     * @param settings The role's settings.
+     * @return A description of the outcome for the startup report.
+     */
+    static std::string ApplyScheduling(const Settings& settings);
+
+    /**
+     * @brief Sets the nice value of the calling thread.
+     * @param nice The nice value.
+     * @return A description of the outcome for the startup report.
+     */
+    static std::string ApplyNice(int nice);
+
+    Settings _audio; //!< Settings of the audio threads.
+    Settings _render; //!< Settings of the render thread.
+    bool _lockMemory{false}; //!< If true, buffers written by audio callbacks are locked in memory.
+    std::atomic<bool> _lockReported{false}; //!< True after the first memory lock outcome was logged.
+
+    Poco::Logger& _logger{Poco::Logger::get("RealtimeThreads")}; //!< The class logger.
+};
+
+/**
+ * @brief Keeps a buffer locked in memory while it's alive, if memory locking is enabled.
+ *
+ * Declare it after the buffer it locks, so it's unlocked before the buffer is freed.
+ */
+class LockedBuffer
+{
+public:
+    LockedBuffer() = default;
+
+    LockedBuffer(const LockedBuffer&) = delete;
+
+    LockedBuffer& operator=(const LockedBuffer&) = delete;
+
+    ~LockedBuffer();
+
+    /**
+     * @brief Locks a memory range, unlocking the previously locked one.
+     * @param data Start of the range.
+     * @param size Size of the range in bytes.
+     */
+    void Lock(const void* data, size_t size);
+
+    /**
+     * @brief Unlocks the locked range, if any. Must be called before the buffer is reallocated.
+     */
+    void Unlock();
+
+protected:
+    const void* _data{nullptr}; //!< Start of the locked range, nullptr if nothing is locked.
+    size_t _size{0}; //!< Size of the locked range.
+};
@@ -0,0 +1,358 @@
+#include "RenderFarm.h"
+
+#include "AudioFile.h"
+
+#include <Poco/Environment.h>
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Path.h>
+#include <Poco/Thread.h>
+
+#include <Poco/JSON/Array.h>
+#include <Poco/JSON/Parser.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <sstream>
+
+RenderFarm::RenderFarm()
+    : _config(Poco::Util::Application::instance().config().createView("renderFarm"))
+{
+    _retries = std::max(0, _config->getInt("retries", 2));
+}
+
+int RenderFarm::Run()
+{
+    try
+    {
+        LoadManifest();
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Could not load render job manifest: %s", ex.displayText());
+        return Poco::Util::Application::EXIT_DATAERR;
+    }
+
+    if (_jobs.empty())
+    {
+        poco_warning(_logger, "No render jobs to run.");
+        return _failedJobs == 0 ? Poco::Util::Application::EXIT_OK : Poco::Util::Application::EXIT_DATAERR;
+    }
+
+    // Split the CPUs into slots, each running one worker using "llvmpipeThreads" render threads.
+    int cpuCount = std::max(1, static_cast<int>(Poco::Environment::processorCount()));
+    int threadsPerSlot = std::min(cpuCount, std::max(1, _config->getInt("llvmpipeThreads", 1)));
+    int slotCount = std::max(1, _config->getInt("workers", cpuCount / threadsPerSlot));
+    slotCount = std::min(slotCount, static_cast<int>(_jobs.size()));
+    bool pinCpus = _config->getBool("pinCpus", true);
+
+    poco_information_f4(_logger, "Rendering %?d jobs with %?d frames using %?d workers with %?d threads each.",
+                        _jobs.size(), _totalFrames, slotCount, threadsPerSlot);
+
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::unique_ptr<Poco::Thread>> threads;
+
+    _stopwatch.start();
+
+    for (int slotIndex = 0; slotIndex < slotCount; slotIndex++)
+    {
+        std::string cpuList;
+        if (pinCpus)
+        {
+            int firstCpu = (slotIndex * threadsPerSlot) % cpuCount;
+            int lastCpu = std::min(cpuCount - 1, firstCpu + threadsPerSlot - 1);
+            cpuList = std::to_string(firstCpu) + "-" + std::to_string(lastCpu);
+        }
+
+        slots.emplace_back(new Slot(*this, slotIndex, cpuList));
+        threads.emplace_back(new Poco::Thread("Render slot " + std::to_string(slotIndex)));
+        threads.back()->start(*slots.back());
+    }
+
+    auto reportInterval = std::max(1, _config->getInt("reportInterval", 10)) * 1000;
+    for (auto& thread : threads)
+    {
+        while (!thread->tryJoin(reportInterval))
+        {
+            ReportProgress();
+        }
+    }
+
+    _stopwatch.stop();
+
+    double seconds = static_cast<double>(_stopwatch.elapsed()) / 1000000.0;
+    poco_information(_logger, Poco::format("Finished %?d of %?d jobs (%?d failed), %?d frames in %.1f seconds, aggregate %.1f FPS.",
+                                           _finishedJobs, _totalJobs, _failedJobs, _renderedFrames, seconds,
+                                           static_cast<double>(_renderedFrames) / std::max(seconds, 0.001)));
+
+    return _failedJobs == 0 ? Poco::Util::Application::EXIT_OK : Poco::Util::Application::EXIT_SOFTWARE;
+}
+
+void RenderFarm::LoadManifest()
+{
+    Poco::Path manifestPath(_config->getString("manifest"));
+    manifestPath.makeAbsolute();
+
+    Poco::FileInputStream input(manifestPath.toString());
+    Poco::JSON::Parser parser;
+    auto manifest = parser.parse(input).extract<Poco::JSON::Object::Ptr>();
+
+    auto defaults = manifest->getObject("defaults");
+    if (!defaults)
+    {
+        defaults = new Poco::JSON::Object;
+    }
+
+    auto jobArray = manifest->getArray("jobs");
+    if (!jobArray)
+    {
+        throw Poco::DataFormatException("Manifest has no \"jobs\" array");
+    }
+
+    // Relative file names are resolved against the manifest's directory.
+    Poco::Path manifestDir(manifestPath.parent());
+    auto resolvePath = [&manifestDir](const std::string& fileName) {
+        return Poco::Path(manifestDir).resolve(Poco::Path(fileName)).toString();
+    };
+
+    for (size_t jobIndex = 0; jobIndex < jobArray->size(); jobIndex++)
+    {
+        auto definition = jobArray->getObject(static_cast<unsigned int>(jobIndex));
+        if (!definition)
+        {
+            throw Poco::DataFormatException("Job " + std::to_string(jobIndex) + " is not an object");
+        }
+
+        auto value = [&definition, &defaults](const std::string& key, const Poco::Dynamic::Var& fallback) {
+            return definition->has(key) ? definition->get(key) : defaults->has(key) ? defaults->get(key) : fallback;
+        };
+
+        Job job;
+        job._name = value("name", "job " + std::to_string(jobIndex)).toString();
+        job._width = std::max(16, value("width", _config->getInt("width", 1280)).convert<int>());
+        job._height = std::max(16, value("height", _config->getInt("height", 720)).convert<int>());
+
+        int fps = std::max(1, value("fps", _config->getInt("fps", 60)).convert<int>());
+
+        Poco::JSON::Array::Ptr presets(new Poco::JSON::Array);
+        auto presetArray = definition->has("presets") ? definition->getArray("presets") : defaults->getArray("presets");
+        for (size_t presetIndex = 0; presetArray && presetIndex < presetArray->size(); presetIndex++)
+        {
+            presets->add(resolvePath(presetArray->getElement<std::string>(static_cast<unsigned int>(presetIndex))));
+        }
+
+        job._definition = new Poco::JSON::Object;
+        job._definition->set("audio", resolvePath(value("audio", "").toString()));
+        job._definition->set("presets", presets);
+        job._definition->set("width", job._width);
+        job._definition->set("height", job._height);
+        job._definition->set("fps", fps);
+        job._definition->set("presetDuration", value("presetDuration", _config->getDouble("presetDuration", 30.0)).convert<double>());
+
+        auto output = value("output", "").toString();
+        if (!output.empty())
+        {
+            job._definition->set("output", resolvePath(output));
+        }
+
+        // Also validates the audio file, so broken jobs don't occupy a worker.
+        try
+        {
+            AudioFile audioFile(job._definition->getValue<std::string>("audio"));
+            job._frames = static_cast<int>(audioFile.FrameCount() * fps / AudioFile::SampleRate);
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(_logger, R"(Skipping job "%s": %s)", job._name, ex.displayText());
+            _totalJobs++;
+            _failedJobs++;
+            continue;
+        }
+
+        _totalJobs++;
+        _totalFrames += job._frames;
+        _jobs.push_back(job);
+    }
+
+    // Longest jobs first, so no slot ends up rendering a long job while all others are idle.
+    std::stable_sort(_jobs.begin(), _jobs.end(), [](const Job& left, const Job& right) {
+        return static_cast<int64_t>(left._frames) * left._width * left._height
+               > static_cast<int64_t>(right._frames) * right._width * right._height;
+    });
+}
+
+RenderFarm::Slot::Slot(RenderFarm& farm, int index, std::string cpuList)
+    : _farm(farm)
+    , _index(index)
+    , _cpuList(std::move(cpuList))
+{
+}
+
+void RenderFarm::Slot::run()
+{
+    Job job;
+    while (_farm.NextJob(job))
+    {
+        Poco::Stopwatch stopwatch;
+        stopwatch.start();
+
+        std::string error;
+        bool success = RunJob(job, error);
+
+        _farm.JobFinished(job, success, static_cast<double>(stopwatch.elapsed()) / 1000000.0, error);
+    }
+}
+
+bool RenderFarm::Slot::RunJob(const Job& job, std::string& error)
+{
+    auto& app = Poco::Util::Application::instance();
+
+    // Window size determines the render resolution, so it's passed on the command line.
+    std::vector<std::string> args{
+        "--renderWorker",
+        "--width", std::to_string(job._width),
+        "--height", std::to_string(job._height)};
+
+    if (!_cpuList.empty())
+    {
+        args.emplace_back("--renderCpus");
+        args.emplace_back(_cpuList);
+    }
+
+    Poco::Process::Env environment{
+        {"LP_NUM_THREADS", _farm._config->getString("llvmpipeThreads", "1")}};
+
+    WorkerProcess worker("Render worker " + std::to_string(_index), app.commandPath(), args, environment);
+
+    int renderedFrames{0};
+
+    try
+    {
+        worker.Start();
+    }
+    catch (Poco::Exception& ex)
+    {
+        error = "Could not start worker: " + ex.displayText();
+        return false;
+    }
+
+    std::ostringstream definition;
+    job._definition->stringify(definition);
+
+    bool success{false};
+    std::string line;
+    if (!worker.SendLine(definition.str()))
+    {
+        error = "Could not send job to worker";
+    }
+    else
+    {
+        error = "Worker process terminated";
+        while (worker.ReadLine(line))
+        {
+            if (line.compare(0, 9, "PROGRESS ") == 0)
+            {
+                int frames = Poco::NumberParser::parse(line.substr(9, line.find(' ', 9) - 9));
+                _farm.AddRenderedFrames(frames - renderedFrames);
+                renderedFrames = frames;
+            }
+            else if (line.compare(0, 5, "DONE ") == 0)
+            {
+                std::istringstream result(line.substr(5));
+                int frames{0};
+                double seconds{0.0};
+                result >> frames >> seconds;
+
+                _farm.AddRenderedFrames(frames - renderedFrames);
+                renderedFrames = frames;
+
+                poco_information(_farm._logger, Poco::format(R"(Job "%s" rendered %?d frames at %?dx%?d in %.1f seconds, %.1f FPS.)",
+                                                             job._name, frames, job._width, job._height, seconds,
+                                                             static_cast<double>(frames) / std::max(seconds, 0.001)));
+                success = true;
+                break;
+            }
+            else if (line.compare(0, 5, "FAIL ") == 0)
+            {
+                error = line.substr(5);
+                break;
+            }
+        }
+    }
+
+    if (success)
+    {
+        worker.Stop();
+    }
+    else
+    {
+        worker.Kill();
+        _farm.AddRenderedFrames(-renderedFrames);
+    }
+
+    return success;
+}
+
+bool RenderFarm::NextJob(Job& job)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_jobs.empty())
+    {
+        return false;
+    }
+
+    job = _jobs.front();
+    _jobs.pop_front();
+
+    return true;
+}
+
+void RenderFarm::JobFinished(Job job, bool success, double seconds, const std::string& error)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (success)
+    {
+        _finishedJobs++;
+        return;
+    }
+
+    job._attempt++;
+    if (job._attempt <= _retries)
+    {
+        poco_warning(_logger, Poco::format(R"(Job "%s" failed after %.1f seconds, retrying (%?d/%?d): %s)",
+                                           job._name, seconds, job._attempt, _retries, error));
+        _jobs.push_back(job);
+        return;
+    }
+
+    poco_error_f2(_logger, R"(Job "%s" failed, giving up: %s)", job._name, error);
+    _failedJobs++;
+}
+
+void RenderFarm::AddRenderedFrames(int frames)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    _renderedFrames += frames;
+}
+
+void RenderFarm::ReportProgress()
+{
+    size_t finishedJobs;
+    int64_t renderedFrames;
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        finishedJobs = _finishedJobs;
+        renderedFrames = _renderedFrames;
+    }
+
+    double seconds = static_cast<double>(_stopwatch.elapsed()) / 1000000.0;
+    double framesPerSecond = static_cast<double>(renderedFrames) / std::max(seconds, 0.001);
+
+    poco_information(_logger, Poco::format("Progress: %?d/%?d jobs, %?d/%?d frames, aggregate %.1f FPS.",
+                                           finishedJobs, _totalJobs, renderedFrames, _totalFrames, framesPerSecond));
+}
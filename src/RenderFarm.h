@@ -0,0 +1,135 @@
+#pragma once
+
+#include "WorkerProcess.h"
+
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Stopwatch.h>
+
+#include <Poco/JSON/Object.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Offline render farm, renders all jobs of a job manifest using local worker processes.
+ *
+ * The manifest is a JSON file with a "jobs" array. Each job renders one audio file with a list of presets:
+ *
+ *     {
+ *         "defaults": { "width": 1920, "height": 1080, "fps": 60, "presetDuration": 15 },
+ *         "jobs": [
+ *             { "name": "intro", "audio": "intro.wav", "presets": ["a.milk", "b.milk"], "output": "intro.rgba" }
+ *         ]
+ *     }
+ *
+ * Any job property not given is taken from "defaults", then from the "renderFarm" configuration. The output
+ * is optional and receives raw RGBA frames.
+ *
+ * Every job is rendered by a separate RenderFarmWorker process. The available CPUs are split into worker
+ * slots of "llvmpipeThreads" cores each, and every worker is pinned to its slot's cores. Jobs are started
+ * longest first, so the slots finish at about the same time. Failed jobs are retried a few times.
+ */
+class RenderFarm
+{
+public:
+    RenderFarm();
+
+    /**
+     * @brief Renders all jobs in the manifest.
+     * @return The application exit code.
+     */
+    int Run();
+
+protected:
+    /**
+     * @brief A single render job.
+     */
+    struct Job {
+        std::string _name; //!< Job name, used in log messages.
+        Poco::JSON::Object::Ptr _definition; //!< Job definition with all defaults resolved, sent to the worker.
+        int _width{0}; //!< Output width in pixels.
+        int _height{0}; //!< Output height in pixels.
+        int _frames{0}; //!< Number of frames to render.
+        int _attempt{0}; //!< Number of previous attempts.
+    };
+
+    /**
+     * @brief A worker slot, running one job after another on a fixed set of CPUs.
+     */
+    class Slot : public Poco::Runnable
+    {
+    public:
+        Slot(RenderFarm& farm, int index, std::string cpuList);
+
+        void run() override;
+
+    protected:
+        /**
+         * @brief Runs a single job in a new worker process.
+         * @param job The job to render.
+         * @param error[out] Receives an error message if the job failed.
+         * @return True if the job was rendered successfully.
+         */
+        bool RunJob(const Job& job, std::string& error);
+
+        RenderFarm& _farm; //!< The farm owning the job queue.
+        int _index{0}; //!< Slot index.
+        std::string _cpuList; //!< CPUs assigned to this slot.
+    };
+
+    /**
+     * @brief Loads the job manifest and fills the job queue.
+     * @throws Poco::Exception if the manifest is invalid.
+     */
+    void LoadManifest();
+
+    /**
+     * @brief Takes the next job from the queue.
+     * @param job[out] Receives the job.
+     * @return True if a job was returned, false if the queue is empty.
+     */
+    bool NextJob(Job& job);
+
+    /**
+     * @brief Records a finished job, or queues it again if it failed and has retries left.
+     * @param job The job.
+     * @param success True if the job was rendered successfully.
+     * @param seconds Wall-clock time needed to render the job.
+     * @param error Error message if the job failed.
+     */
+    void JobFinished(Job job, bool success, double seconds, const std::string& error);
+
+    /**
+     * @brief Adds rendered frames to the progress counters.
+     * @param frames Number of frames rendered since the last call for the same job. Negative to remove the
+     *               frames of a failed attempt again.
+     */
+    void AddRenderedFrames(int frames);
+
+    /**
+     * @brief Logs the number of finished jobs and the aggregate frame rate.
+     */
+    void ReportProgress();
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "renderFarm" configuration subkey.
+
+    int _retries{2}; //!< Number of times a failed job is retried.
+
+    Poco::FastMutex _mutex; //!< Protects the job queue and counters.
+    std::deque<Job> _jobs; //!< Jobs waiting to be rendered.
+    size_t _totalJobs{0}; //!< Number of jobs in the manifest.
+    size_t _finishedJobs{0}; //!< Number of successfully rendered jobs.
+    size_t _failedJobs{0}; //!< Number of jobs which failed after all retries.
+    uint64_t _totalFrames{0}; //!< Number of frames of all jobs.
+    int64_t _renderedFrames{0}; //!< Number of frames of all successful and running jobs rendered so far.
+
+    Poco::Stopwatch _stopwatch; //!< Measures total run time for the aggregate frame rate.
+
+    Poco::Logger& _logger{Poco::Logger::get("RenderFarm")}; //!< The class logger.
+};
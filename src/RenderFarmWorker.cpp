@@ -0,0 +1,209 @@
+#include "RenderFarmWorker.h"
+
+#include "AudioFile.h"
+
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Stopwatch.h>
+#include <Poco/StringTokenizer.h>
+
+#include <Poco/JSON/Array.h>
+#include <Poco/JSON/Parser.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL_opengl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+RenderFarmWorker::RenderFarmWorker()
+    : _projectMWrapper(Poco::Util::Application::instance().getSubsystem<ProjectMWrapper>())
+{
+}
+
+int RenderFarmWorker::Run()
+{
+    std::string jobLine;
+    if (!std::getline(std::cin, jobLine))
+    {
+        poco_error(_logger, "No render job received.");
+        return Poco::Util::Application::EXIT_NOINPUT;
+    }
+
+    auto projectMHandle = _projectMWrapper.ProjectM();
+    projectm_set_preset_switch_failed_event_callback(projectMHandle, &RenderFarmWorker::PresetSwitchFailedEvent, this);
+
+    int exitCode = Poco::Util::Application::EXIT_OK;
+
+    try
+    {
+        Poco::JSON::Parser parser;
+        auto job = parser.parse(jobLine).extract<Poco::JSON::Object::Ptr>();
+
+        Poco::Stopwatch stopwatch;
+        stopwatch.start();
+
+        int frames = RenderJob(*job);
+
+        std::cout << "DONE " << frames << " " << static_cast<double>(stopwatch.elapsed()) / 1000000.0 << std::endl;
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Render job failed: %s", ex.displayText());
+        std::cout << "FAIL " << ex.displayText() << std::endl;
+        exitCode = Poco::Util::Application::EXIT_SOFTWARE;
+    }
+
+    projectm_set_preset_switch_failed_event_callback(projectMHandle, nullptr, nullptr);
+
+    return exitCode;
+}
+
+int RenderFarmWorker::RenderJob(const Poco::JSON::Object& job)
+{
+    auto projectMHandle = _projectMWrapper.ProjectM();
+
+    AudioFile audioFile(job.getValue<std::string>("audio"));
+
+    int width = job.getValue<int>("width");
+    int height = job.getValue<int>("height");
+    int fps = std::max(1, job.getValue<int>("fps"));
+    double presetDuration = std::max(0.1, job.getValue<double>("presetDuration"));
+
+    std::vector<std::string> presets;
+    auto presetArray = job.getArray("presets");
+    for (size_t index = 0; presetArray && index < presetArray->size(); index++)
+    {
+        presets.push_back(presetArray->getElement<std::string>(static_cast<unsigned int>(index)));
+    }
+
+    std::unique_ptr<Poco::FileOutputStream> output;
+    auto outputFile = job.optValue<std::string>("output", "");
+    if (!outputFile.empty())
+    {
+        output.reset(new Poco::FileOutputStream(outputFile, std::ios::out | std::ios::binary | std::ios::trunc));
+    }
+
+    // Presets are switched by the job schedule only.
+    projectm_set_window_size(projectMHandle, width, height);
+    projectm_set_preset_locked(projectMHandle, true);
+    projectm_set_hard_cut_enabled(projectMHandle, false);
+
+    auto frameCount = static_cast<int>(audioFile.FrameCount() * fps / AudioFile::SampleRate);
+    int framesPerPreset = std::max(1, static_cast<int>(presetDuration * fps));
+
+    size_t rowLength = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> pixels(rowLength * height);
+    std::vector<uint8_t> row(rowLength);
+
+    size_t audioPosition{0};
+    int currentPreset{-1};
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        if (!presets.empty())
+        {
+            int preset = (frame / framesPerPreset) % static_cast<int>(presets.size());
+            if (preset != currentPreset)
+            {
+                projectm_load_preset_file(projectMHandle, presets.at(preset).c_str(), currentPreset >= 0);
+                currentPreset = preset;
+            }
+        }
+
+        // Distribute the samples evenly if the sample rate isn't a multiple of the frame rate.
+        size_t nextAudioPosition = static_cast<size_t>(frame + 1) * AudioFile::SampleRate / fps;
+        audioFile.AddToProjectM(projectMHandle, audioPosition, nextAudioPosition - audioPosition);
+
+        glClearColor(0.0, 0.0, 0.0, 0.0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        projectm_opengl_render_frame(projectMHandle);
+
+        if (output)
+        {
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+            // OpenGL returns the bottom row first, video frames are stored top row first.
+            for (int y = 0; y < height / 2; y++)
+            {
+                auto top = pixels.data() + y * rowLength;
+                auto bottom = pixels.data() + (height - 1 - y) * rowLength;
+                std::memcpy(row.data(), top, rowLength);
+                std::memcpy(top, bottom, rowLength);
+                std::memcpy(bottom, row.data(), rowLength);
+            }
+
+            output->write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+            if (!output->good())
+            {
+                throw Poco::WriteFileException(outputFile);
+            }
+        }
+
+        if ((frame + 1) % fps == 0)
+        {
+            std::cout << "PROGRESS " << frame + 1 << " " << frameCount << std::endl;
+        }
+    }
+
+    if (output)
+    {
+        output->close();
+    }
+
+    return frameCount;
+}
+
+void RenderFarmWorker::PinToCpus(const std::string& cpuList)
+{
+    auto& logger = Poco::Logger::get("RenderFarmWorker");
+
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    try
+    {
+        Poco::StringTokenizer items(cpuList, ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+        for (const auto& item : items)
+        {
+            auto dash = item.find('-');
+            int first = Poco::NumberParser::parse(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : Poco::NumberParser::parse(item.substr(dash + 1));
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+    }
+    catch (Poco::SyntaxException& ex)
+    {
+        poco_warning_f2(logger, R"(Invalid CPU list "%s": %s)", cpuList, ex.displayText());
+        return;
+    }
+
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0)
+    {
+        poco_warning_f2(logger, R"(Could not pin process to CPUs "%s": %s)", cpuList, std::string(std::strerror(errno)));
+    }
+#else
+    poco_debug_f1(logger, R"(CPU pinning is not supported on this platform, ignoring CPU list "%s".)", cpuList);
+#endif
+}
+
+void RenderFarmWorker::PresetSwitchFailedEvent(const char* presetFilename, const char* message, void* context)
+{
+    auto that = reinterpret_cast<RenderFarmWorker*>(context);
+    poco_warning_f2(that->_logger, R"(Could not load preset "%s", keeping the previous one: %s)",
+                    std::string(presetFilename ? presetFilename : ""), std::string(message ? message : "Unknown error"));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ProjectMWrapper.h"
+
+#include <Poco/Logger.h>
+
+#include <Poco/JSON/Object.h>
+
+#include <string>
+
+/**
+ * @brief Headless worker process for the render farm, renders a single job.
+ *
+ * The job is read as a single line of JSON from standard input, see RenderFarm for the format. The audio file
+ * is rendered at the job's frame rate from start to end, switching presets in the given order every
+ * "presetDuration" seconds. If an output file is given, frames are appended to it as raw, top-down RGBA data.
+ *
+ * While rendering, "PROGRESS <frame> <total>" lines are written to standard output. The job ends with either
+ * "DONE <frames> <seconds>" or "FAIL <message>".
+ *
+ * The worker renders into the application's hidden window, which is created with the job resolution by the
+ * render farm. The preset and transition times are not tied to the rendered frames, as projectM animates
+ * presets using wall-clock time.
+ */
+class RenderFarmWorker
+{
+public:
+    RenderFarmWorker();
+
+    /**
+     * @brief Reads and renders the job.
+     * @return The application exit code.
+     */
+    int Run();
+
+    /**
+     * @brief Restricts the calling process to the given CPUs.
+     *
+     * Must be called before the OpenGL context is created, so llvmpipe's render threads inherit the affinity.
+     * Only supported on Linux, ignored on other platforms.
+     *
+     * @param cpuList A CPU list like "0-3" or "0,2,4-6".
+     */
+    static void PinToCpus(const std::string& cpuList);
+
+protected:
+    /**
+     * @brief Renders the job.
+     * @param job The parsed job object.
+     * @return The number of rendered frames.
+     * @throws Poco::Exception on errors.
+     */
+    int RenderJob(const Poco::JSON::Object& job);
+
+    /**
+     * @brief Callback for failed preset loads, logs the error.
+     * @param presetFilename The preset which failed to load.
+     * @param message The error message.
+     * @param context Pointer to the worker instance.
+     */
+    static void PresetSwitchFailedEvent(const char* presetFilename, const char* message, void* context);
+
+    ProjectMWrapper& _projectMWrapper; //!< The application's projectM wrapper.
+
+    Poco::Logger& _logger{Poco::Logger::get("RenderFarmWorker")}; //!< The class logger.
+};
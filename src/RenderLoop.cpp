@@ -1,75 +1,468 @@
 #include "RenderLoop.h"
 
-#include "FPSLimiter.h"
+#include "Metrics.h"
+#include "RealtimeThreads.h"
+#include "Tracer.h"
+#include "ZoneManager.h"
+
+#include <Poco/Clock.h>
+#include <Poco/FileStream.h>
 
 #include <Poco/Util/Application.h>
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
+
 RenderLoop::RenderLoop()
     : _audioCapture(Poco::Util::Application::instance().getSubsystem<AudioCapture>())
     , _projectMWrapper(Poco::Util::Application::instance().getSubsystem<ProjectMWrapper>())
     , _sdlRenderingWindow(Poco::Util::Application::instance().getSubsystem<SDLRenderingWindow>())
+    , _zoneManager(&Poco::Util::Application::instance().getSubsystem<ZoneManager>())
+    , _projectMHandle(_projectMWrapper.ProjectM())
+    , _playlistHandle(_projectMWrapper.Playlist())
+    , _previewWall(_audioCapture, _playlistHandle, _loadProfiler)
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    auto replayFile = config.getString("session.replayFile", "");
+    auto recordFile = config.getString("session.recordFile", "");
+
+    if (!replayFile.empty())
+    {
+        _sessionReplay.reset(new SessionReplay(replayFile));
+    }
+    else if (!recordFile.empty())
+    {
+        _sessionRecorder.reset(new SessionRecorder(recordFile));
+    }
+}
+
+RenderLoop::RenderLoop(AudioCapture& audioCapture, ProjectMWrapper& projectMWrapper, SDLRenderingWindow& sdlRenderingWindow)
+    : _audioCapture(audioCapture)
+    , _projectMWrapper(projectMWrapper)
+    , _sdlRenderingWindow(sdlRenderingWindow)
     , _projectMHandle(_projectMWrapper.ProjectM())
     , _playlistHandle(_projectMWrapper.Playlist())
+    , _externalEvents(true)
+    , _previewWall(_audioCapture, _playlistHandle, _loadProfiler)
 {
 }
 
 void RenderLoop::Run()
 {
     FPSLimiter limiter;
-    limiter.TargetFPS(_projectMWrapper.TargetFPS());
 
-    projectm_playlist_set_preset_switched_event_callback(_playlistHandle, &RenderLoop::PresetSwitchedEvent, static_cast<void*>(this));
+    if (_sessionReplay)
+    {
+        // Render as fast as possible by default, so the replay measures the actual frame cost.
+        bool realtime = Poco::Util::Application::instance().config().getBool("session.replayRealtime", false);
+        limiter.TargetFPS(realtime ? _projectMWrapper.TargetFPS() : 0);
+
+        // Presets are only switched as recorded. The disconnected playlist still follows navigation events,
+        // but doesn't load presets anymore, and automatic switches requested by projectM are ignored.
+        projectm_playlist_connect(_playlistHandle, nullptr);
+
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+        if (!_sessionReplay->HasFrameTimes())
+        {
+            poco_warning(_logger, "The session was recorded without frame times, the replay is only approximate.");
+        }
+#else
+        poco_warning(_logger, "projectM 4.0 animates presets on its own clock, the replay is only approximate.");
+#endif
+
+        _replayStatistics.Start(true);
+    }
+    else
+    {
+        limiter.TargetFPS(_projectMWrapper.TargetFPS());
+
+        projectm_playlist_set_preset_switched_event_callback(_playlistHandle, &RenderLoop::PresetSwitchedEvent, static_cast<void*>(this));
+
+        if (_sessionRecorder)
+        {
+            _audioCapture.SetSampleCallback([this](const float* samples, unsigned int frames, unsigned int channels) {
+                _sessionRecorder->RecordAudio(samples, frames, channels);
+            });
+            _sessionClock.update();
+        }
+
+        if (!_externalEvents)
+        {
+            _flightRecorder.Start(Poco::Util::Application::instance().config().createView("flightRecorder"),
+                                  _projectMWrapper.TargetFPS());
+            _loadProfiler.Start(Poco::Util::Application::instance().config().createView("presetLoadProfiler"));
+            _presetWatchdog.Start(Poco::Util::Application::instance().config().createView("presetWatchdog"), _playlistHandle);
+
+            // Recorded sessions must replay frame by frame, so they always run at the full rate and quality,
+            // and with the configured transition durations, which adapted ones aren't recorded.
+            if (!_sessionRecorder)
+            {
+                _transitionBudget.Start(Poco::Util::Application::instance().config().createView("transitionBudget"),
+                                        _projectMHandle, _playlistHandle, _projectMWrapper.TargetFPS());
+                _powerSaver.Start(Poco::Util::Application::instance().config().createView("powerSave"));
+                _governor.Start(Poco::Util::Application::instance().config().createView("governor"));
+            }
+        }
+
+        _projectMWrapper.DisplayInitialPreset();
+    }
 
-    _projectMWrapper.DisplayInitialPreset();
+    // Only the main loop reports frame metrics and is watched, zones would otherwise mix their frame times into it.
+    bool mainLoop = !_externalEvents && !_sessionReplay;
+    int targetFps = _projectMWrapper.TargetFPS();
+    if (mainLoop)
+    {
+        RealtimeThreads::Instance().TuneCurrentThread(RealtimeThreads::Role::Render);
+
+        size_t meshWidth{0};
+        size_t meshHeight{0};
+        projectm_get_mesh_size(_projectMHandle, &meshWidth, &meshHeight);
+        Metrics::Instance().SetMeshSize(meshWidth, meshHeight);
+        _configuredMeshWidth = meshWidth;
+        _configuredMeshHeight = meshHeight;
+    }
+    Poco::Clock frameStart;
 
     while (!_wantsToQuit)
     {
+        TRACE_ZONE("Frame", "frame");
+
         limiter.StartFrame();
-        PollEvents();
-        CheckViewportSize();
-        _audioCapture.FillBuffer();
-        _projectMWrapper.RenderFrame();
-        _sdlRenderingWindow.Swap();
-        limiter.EndFrame();
+
+        PowerGovernor::Tier governorTier;
+        if (_governor.TierChanged(governorTier))
+        {
+            ApplyGovernorTier(governorTier, limiter);
+            targetFps = FullFrameRate();
+        }
+
+        if (_powerSaver.Idle())
+        {
+            IdleFrame(limiter);
+
+            if (mainLoop)
+            {
+                Poco::Clock frameEnd;
+                Metrics::Instance().FrameFinished(frameEnd - frameStart, _powerSaver.Idle() ? _powerSaver.IdleFPS() : targetFps);
+                frameStart = frameEnd;
+            }
+            continue;
+        }
+
+        _flightRecorder.BeginFrame();
+        _loadProfiler.BeginFrame();
+        _presetWatchdog.Update();
+
+        unsigned int audioFrames{0};
+
+        if (_sessionReplay)
+        {
+            _replayStatistics.BeginFrame();
+            {
+                TRACE_ZONE("ReplayFrame", "frame");
+                if (!ReplayFrame())
+                {
+                    break;
+                }
+            }
+            _replayStatistics.BeginGpuTiming();
+        }
+        else
+        {
+            {
+                TRACE_ZONE("PollEvents", "frame");
+                PollEvents();
+                _flightRecorder.EndPhase(FlightRecorder::Phase::PollEvents);
+            }
+            {
+                TRACE_ZONE("CheckViewportSize", "frame");
+                CheckViewportSize();
+                _flightRecorder.EndPhase(FlightRecorder::Phase::CheckViewportSize);
+            }
+            {
+                TRACE_ZONE("FillBuffer", "audio");
+                audioFrames = _audioCapture.FillBuffer();
+                _flightRecorder.EndPhase(FlightRecorder::Phase::FillBuffer);
+            }
+            if (_sessionRecorder)
+            {
+                // projectM takes its time from the recording clock, so the replay can reproduce it exactly.
+                double frameTime = static_cast<double>(_sessionClock.elapsed()) / 1000000.0;
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+                projectm_set_frame_time(_projectMHandle, frameTime);
+#endif
+                _sessionRecorder->RecordFrameTime(frameTime);
+            }
+            if (_powerSaver.Enabled() && _powerSaver.Update(_audioCapture.AudioLevel()))
+            {
+                // This frame is still rendered at the full rate, the next one is an idle frame.
+                limiter.TargetFPS(_powerSaver.IdleFPS());
+            }
+            _flightRecorder.BeginGpuTiming();
+        }
+
+        {
+            TRACE_ZONE("UpdatePreviewWall", "frame");
+            _previewWall.Update();
+            _flightRecorder.EndPhase(FlightRecorder::Phase::UpdatePreviewWall);
+        }
+        {
+            TRACE_ZONE("RenderFrame", "frame");
+            _loadProfiler.BeginRendering();
+            _projectMWrapper.RenderFrame();
+            if (!_resolutionScaler.Upscale(_renderWidth, _renderHeight))
+            {
+                UpdateProjectMWindowSize();
+            }
+            _flightRecorder.EndPhase(FlightRecorder::Phase::RenderFrame);
+        }
+        {
+            TRACE_ZONE("DrawPreviewWall", "frame");
+            _previewWall.Draw(_renderWidth, _renderHeight);
+            _flightRecorder.EndPhase(FlightRecorder::Phase::DrawPreviewWall);
+        }
+
+        if (_sessionReplay)
+        {
+            _replayStatistics.EndGpuTiming();
+        }
+        _flightRecorder.EndGpuTiming();
+
+        {
+            // Not part of the GPU timing, so the HUD doesn't show its own cost.
+            TRACE_ZONE("DrawHud", "frame");
+            FlightRecorder::FrameSummary lastFrame;
+            _hud.Draw(_renderWidth, _renderHeight, audioFrames,
+                      _flightRecorder.LastFrame(lastFrame) ? &lastFrame : nullptr);
+            _flightRecorder.EndPhase(FlightRecorder::Phase::DrawHud);
+        }
+
+        {
+            TRACE_ZONE("Swap", "frame");
+            _sdlRenderingWindow.Swap();
+            _flightRecorder.EndPhase(FlightRecorder::Phase::Swap);
+        }
+        _loadProfiler.EndFrame();
+
+        if (_sessionReplay)
+        {
+            _replayStatistics.EndFrame();
+        }
+
+        {
+            TRACE_ZONE("LimitFPS", "frame");
+            limiter.EndFrame();
+            _flightRecorder.EndPhase(FlightRecorder::Phase::LimitFPS);
+        }
+
+        _flightRecorder.SetFrameState(audioFrames, projectm_playlist_get_position(_playlistHandle),
+                                      _renderWidth, _renderHeight);
+        _flightRecorder.EndFrame();
+
+        FlightRecorder::FrameSummary lastFrame;
+        bool lastFrameValid = _flightRecorder.LastFrame(lastFrame);
+        _transitionBudget.FrameFinished(lastFrameValid ? &lastFrame : nullptr);
+
+        if (mainLoop)
+        {
+            Poco::Clock frameEnd;
+            Metrics::Instance().FrameFinished(frameEnd - frameStart, targetFps);
+            _presetWatchdog.FrameFinished(lastFrameValid ? &lastFrame : nullptr, _sdlRenderingWindow.Visible());
+            frameStart = frameEnd;
+        }
+
+        if (_sessionRecorder)
+        {
+            _sessionRecorder->NextFrame();
+        }
+    }
+
+    _flightRecorder.Stop();
+    _loadProfiler.Stop();
+    _transitionBudget.Stop();
+    _governor.Stop();
+    _resolutionScaler.Release();
+
+    if (_sessionRecorder)
+    {
+        _audioCapture.SetSampleCallback({});
+        _sessionRecorder->Finish();
+    }
+
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+    if (_sessionRecorder || _sessionReplay)
+    {
+        // Hand the time base back to projectM.
+        projectm_set_frame_time(_projectMHandle, -1.0);
+    }
+#endif
+
+    if (_sessionReplay)
+    {
+        _replayStatistics.Stop();
+        ReportReplayStatistics();
+        projectm_playlist_connect(_playlistHandle, _projectMHandle);
     }
 
     projectm_playlist_set_preset_switched_event_callback(_playlistHandle, nullptr, nullptr);
 }
 
+void RenderLoop::UpdateProjectMWindowSize()
+{
+    int scaledWidth;
+    int scaledHeight;
+    _resolutionScaler.ScaledSize(_renderWidth, _renderHeight, scaledWidth, scaledHeight);
+    projectm_set_window_size(_projectMHandle, scaledWidth, scaledHeight);
+}
+
+void RenderLoop::ApplyGovernorTier(const PowerGovernor::Tier& tier, FPSLimiter& limiter)
+{
+    _governorFps = tier._fps;
+    if (!_powerSaver.Idle())
+    {
+        limiter.TargetFPS(FullFrameRate());
+    }
+
+    _resolutionScaler.SetScale(tier._resolutionScale);
+    UpdateProjectMWindowSize();
+
+    auto meshWidth = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_configuredMeshWidth) * tier._meshScale));
+    auto meshHeight = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_configuredMeshHeight) * tier._meshScale));
+    projectm_set_mesh_size(_projectMHandle, meshWidth, meshHeight);
+    Metrics::Instance().SetMeshSize(meshWidth, meshHeight);
+    _transitionBudget.SetMeshSize(meshWidth, meshHeight);
+}
+
+int RenderLoop::FullFrameRate()
+{
+    auto targetFps = _projectMWrapper.TargetFPS();
+    if (_governorFps > 0 && (targetFps == 0 || _governorFps < targetFps))
+    {
+        return _governorFps;
+    }
+
+    return targetFps;
+}
+
+void RenderLoop::IdleFrame(FPSLimiter& limiter)
+{
+    TRACE_ZONE("IdleFrame", "frame");
+
+    PollEvents();
+    CheckViewportSize();
+    auto audioFrames = _audioCapture.FillBuffer();
+
+    _powerSaver.Update(_audioCapture.AudioLevel());
+
+    if (!_powerSaver.Idle())
+    {
+        // Sound returned or the user woke the saver up, render this frame and continue at the full rate.
+        limiter.TargetFPS(FullFrameRate());
+    }
+    else if (!_powerSaver.RenderIdleFrames())
+    {
+        // Keep the last frame on screen without touching the GPU.
+        limiter.EndFrame();
+        return;
+    }
+
+    _previewWall.Update();
+    _projectMWrapper.RenderFrame();
+    if (!_resolutionScaler.Upscale(_renderWidth, _renderHeight))
+    {
+        UpdateProjectMWindowSize();
+    }
+    _previewWall.Draw(_renderWidth, _renderHeight);
+    _hud.Draw(_renderWidth, _renderHeight, audioFrames, nullptr);
+    _sdlRenderingWindow.Swap();
+
+    limiter.EndFrame();
+}
+
+void RenderLoop::PushEvent(const SDL_Event& event)
+{
+    Poco::FastMutex::ScopedLock lock(_eventMutex);
+    _pendingEvents.push_back(event);
+}
+
+void RenderLoop::Quit()
+{
+    _wantsToQuit = true;
+}
+
 void RenderLoop::PollEvents()
 {
+    if (_externalEvents)
+    {
+        std::deque<SDL_Event> events;
+        {
+            Poco::FastMutex::ScopedLock lock(_eventMutex);
+            events.swap(_pendingEvents);
+        }
+
+        for (const auto& event : events)
+        {
+            HandleEvent(event);
+        }
+
+        return;
+    }
+
     SDL_Event event;
 
     while (SDL_PollEvent(&event))
     {
-        switch (event.type)
+        if (_zoneManager && _zoneManager->DispatchEvent(event))
         {
-            case SDL_MOUSEWHEEL:
-                ScrollEvent(event.wheel);
-                break;
+            continue;
+        }
 
-            case SDL_KEYDOWN:
-                KeyEvent(event.key, true);
-                break;
+        if (_sessionRecorder)
+        {
+            _sessionRecorder->RecordEvent(event);
+        }
 
-            case SDL_KEYUP:
-                KeyEvent(event.key, false);
-                break;
+        HandleEvent(event);
+    }
+}
 
-            case SDL_MOUSEBUTTONDOWN:
-                MouseDownEvent(event.button);
-                break;
+void RenderLoop::HandleEvent(const SDL_Event& event)
+{
+    switch (event.type)
+    {
+        case SDL_MOUSEWHEEL:
+            _powerSaver.Wake();
+            ScrollEvent(event.wheel);
+            break;
 
-            case SDL_MOUSEBUTTONUP:
-                MouseUpEvent(event.button);
-                break;
+        case SDL_KEYDOWN:
+            _powerSaver.Wake();
+            KeyEvent(event.key, true);
+            break;
 
-            case SDL_QUIT:
-                _wantsToQuit = true;
-                break;
-        }
+        case SDL_KEYUP:
+            KeyEvent(event.key, false);
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+            _powerSaver.Wake();
+            MouseDownEvent(event.button);
+            break;
+
+        case SDL_MOUSEBUTTONUP:
+            MouseUpEvent(event.button);
+            break;
+
+        case SDL_AUDIODEVICEADDED:
+        case SDL_AUDIODEVICEREMOVED:
+            _audioCapture.AudioDeviceEvent(event.adevice);
+            break;
+
+        case SDL_QUIT:
+            _wantsToQuit = true;
+            break;
     }
 }
 
@@ -81,14 +474,91 @@ void RenderLoop::CheckViewportSize()
 
     if (renderWidth != _renderWidth || renderHeight != _renderHeight)
     {
-        projectm_set_window_size(_projectMHandle, renderWidth, renderHeight);
         _renderWidth = renderWidth;
         _renderHeight = renderHeight;
+        UpdateProjectMWindowSize();
+        _powerSaver.Wake();
+
+        if (!_externalEvents)
+        {
+            Metrics::Instance().SetResolution(renderWidth, renderHeight);
+        }
+
+        if (_sessionRecorder)
+        {
+            _sessionRecorder->RecordViewport(renderWidth, renderHeight);
+        }
 
         poco_debug_f2(_logger, "Resized rendering canvas to %?dx%?d.", renderWidth, renderHeight);
     }
 }
 
+bool RenderLoop::ReplayFrame()
+{
+    if (!_sessionReplay->NextFrame(_replayFrame))
+    {
+        return false;
+    }
+
+    // Same order as in a live frame. Preset switches come last, as automatic switches happen in RenderFrame().
+    for (const auto& event : _replayFrame._events)
+    {
+        HandleEvent(event);
+    }
+
+    if (_replayFrame._viewportChanged)
+    {
+        _sdlRenderingWindow.SetSize(_replayFrame._viewportWidth, _replayFrame._viewportHeight);
+        projectm_set_window_size(_projectMHandle, _replayFrame._viewportWidth, _replayFrame._viewportHeight);
+        _renderWidth = _replayFrame._viewportWidth;
+        _renderHeight = _replayFrame._viewportHeight;
+    }
+
+#if defined(PROJECTMSDL_PROJECTM_4_1)
+    if (_replayFrame._frameTime >= 0.0)
+    {
+        projectm_set_frame_time(_projectMHandle, _replayFrame._frameTime);
+    }
+#endif
+
+    for (const auto& chunk : _replayFrame._audio)
+    {
+        projectm_pcm_add_float(_projectMHandle, chunk._samples.data(),
+                               static_cast<unsigned int>(chunk._samples.size() / chunk._channels),
+                               static_cast<projectm_channels>(chunk._channels));
+    }
+
+    for (const auto& presetSwitch : _replayFrame._presetSwitches)
+    {
+        TRACE_ZONE("PresetSwitch", "preset");
+        PresetSwitchTimer presetSwitchTimer;
+        projectm_load_preset_file(_projectMHandle, presetSwitch._presetFile.c_str(), !presetSwitch._hardCut);
+    }
+
+    return true;
+}
+
+void RenderLoop::ReportReplayStatistics() const
+{
+    _replayStatistics.Log(_logger, "Session replay");
+
+    auto reportFile = Poco::Util::Application::instance().config().getString("session.replayReport", "");
+    if (reportFile.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        Poco::FileOutputStream output(reportFile);
+        _replayStatistics.ToJSON()->stringify(output, 4);
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not write replay report "%s": %s)", reportFile, ex.displayText());
+    }
+}
+
 void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
 {
     auto keyModifier{static_cast<SDL_Keymod>(event.keysym.mod)};
@@ -132,6 +602,11 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
         return;
     }
 
+    if (_previewWall.KeyEvent(event))
+    {
+        return;
+    }
+
     // Currently mapping all SDL keycodes manually to projectM, as the key handler API will be gone before the
     // 4.0 release, being replaced by API methods reflecting the action instead of requiring knowledge about
     // projectM's internal hotkey bindings.
@@ -143,6 +618,17 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
         }
         break;
 
+        case SDLK_b:
+            if (_previewWall.Active())
+            {
+                _previewWall.Leave();
+            }
+            else
+            {
+                _previewWall.Enter();
+            }
+            break;
+
 #ifdef _DEBUG
         case SDLK_d:
             // Write next rendered frame to file
@@ -157,6 +643,10 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
             }
             break;
 
+        case SDLK_h:
+            _hud.Toggle();
+            break;
+
         case SDLK_i:
             if (modifierPressed)
             {
@@ -172,15 +662,23 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
             }
             break;
 
-        case SDLK_n:
+        case SDLK_n: {
+            TRACE_ZONE("PresetSwitch", "preset");
+            PresetSwitchTimer presetSwitchTimer;
             projectm_playlist_play_next(_playlistHandle, true);
             break;
+        }
 
-        case SDLK_p:
+        case SDLK_p: {
+            TRACE_ZONE("PresetSwitch", "preset");
+            PresetSwitchTimer presetSwitchTimer;
             projectm_playlist_play_previous(_playlistHandle, true);
             break;
+        }
 
         case SDLK_r: {
+            TRACE_ZONE("PresetSwitch", "preset");
+            PresetSwitchTimer presetSwitchTimer;
             bool shuffleEnabled = projectm_playlist_get_shuffle(_playlistHandle);
             projectm_playlist_set_shuffle(_playlistHandle, true);
             projectm_playlist_play_next(_playlistHandle, true);
@@ -200,9 +698,12 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
         }
         break;
 
-        case SDLK_BACKSPACE:
+        case SDLK_BACKSPACE: {
+            TRACE_ZONE("PresetSwitch", "preset");
+            PresetSwitchTimer presetSwitchTimer;
             projectm_playlist_play_last(_playlistHandle, true);
             break;
+        }
 
         case SDLK_SPACE:
             projectm_set_preset_locked(_projectMHandle, !projectm_get_preset_locked(_projectMHandle));
@@ -223,6 +724,14 @@ void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
 
 void RenderLoop::ScrollEvent(const SDL_MouseWheelEvent& event)
 {
+    if (event.y == 0)
+    {
+        return;
+    }
+
+    TRACE_ZONE("PresetSwitch", "preset");
+    PresetSwitchTimer presetSwitchTimer;
+
     // Wheel up is positive
     if (event.y > 0)
     {
@@ -243,15 +752,14 @@ void RenderLoop::MouseDownEvent(const SDL_MouseButtonEvent& event)
             if (!_mouseDown && _keyStates._shiftPressed)
             {
                 // ToDo: Improve this to differentiate between single click (add waveform) and drag (move waveform).
-                int x;
-                int y;
+                // Use the event's position, not the current mouse state, so replayed sessions are identical.
+                int x{event.x};
+                int y{event.y};
                 int width;
                 int height;
 
                 _sdlRenderingWindow.GetDrawableSize(width, height);
 
-                SDL_GetMouseState(&x, &y);
-
                 // Scale those coordinates. libProjectM uses a scale of 0..1 instead of absolute pixel coordinates.
                 float scaledX = (static_cast<float>(x) / static_cast<float>(width));
                 float scaledY = (static_cast<float>(height - y) / static_cast<float>(height));
@@ -286,8 +794,27 @@ void RenderLoop::MouseUpEvent(const SDL_MouseButtonEvent& event)
 void RenderLoop::PresetSwitchedEvent(bool isHardCut, unsigned int index, void* context)
 {
     auto that = reinterpret_cast<RenderLoop*>(context);
+
+    // Automatic switches happen inside projectM's frame rendering, so only mark the point in time.
+    Tracer::Instance().Instant(isHardCut ? "PresetSwitchedHardCut" : "PresetSwitched", "preset");
+
     auto presetName = projectm_playlist_item(that->_playlistHandle, index);
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Displaying preset: %s\n", presetName);;
+
+    if (that->_sessionRecorder && presetName)
+    {
+        that->_sessionRecorder->RecordPresetSwitch(isHardCut, presetName);
+    }
+
+    if (presetName)
+    {
+        that->_flightRecorder.PresetSwitched(presetName);
+        that->_hud.PresetSwitched(presetName);
+        that->_loadProfiler.PresetSwitched(presetName);
+        that->_presetWatchdog.PresetSwitched(presetName);
+        that->_transitionBudget.PresetSwitched(presetName, isHardCut);
+    }
+
     projectm_playlist_free_string(presetName);
 
     that->UpdateWindowTitle();
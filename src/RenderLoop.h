@@ -1,18 +1,74 @@
 #pragma once
 
 #include "AudioCapture.h"
+#include "FPSLimiter.h"
+#include "FlightRecorder.h"
+#include "FrameStatistics.h"
+#include "PerformanceHud.h"
+#include "PowerGovernor.h"
+#include "PowerSaver.h"
+#include "PresetLoadProfiler.h"
+#include "PresetPreviewWall.h"
+#include "PresetWatchdog.h"
 #include "ProjectMWrapper.h"
+#include "ResolutionScaler.h"
 #include "SDLRenderingWindow.h"
+#include "SessionRecorder.h"
+#include "SessionReplay.h"
+#include "TransitionBudget.h"
 
+#include <Poco/Clock.h>
 #include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+class ZoneManager;
 
 class RenderLoop
 {
 public:
+    /**
+     * @brief Creates the main render loop, using the application's subsystems.
+     *
+     * SDL events are polled by this loop and forwarded to any render zones. If "session.recordFile" is set,
+     * the session is recorded. If "session.replayFile" is set, a recorded session is replayed instead of
+     * processing live input.
+     *
+     * @throws Poco::Exception if the session recording file can't be opened.
+     */
     RenderLoop();
 
+    /**
+     * @brief Creates a render loop for a render zone.
+     *
+     * This loop won't poll SDL events itself, as these are only delivered to the main thread. Instead,
+     * the events for this zone's window are passed in via PushEvent().
+     *
+     * @param audioCapture The zone's audio capture instance.
+     * @param projectMWrapper The zone's projectM instance.
+     * @param sdlRenderingWindow The zone's rendering window.
+     */
+    RenderLoop(AudioCapture& audioCapture, ProjectMWrapper& projectMWrapper, SDLRenderingWindow& sdlRenderingWindow);
+
     void Run();
 
+    /**
+     * @brief Queues an SDL event for processing in the next frame.
+     *
+     * Thread-safe. Only used for render zones.
+     *
+     * @param event The event to queue.
+     */
+    void PushEvent(const SDL_Event& event);
+
+    /**
+     * @brief Requests the loop to exit after the current frame. Thread-safe.
+     */
+    void Quit();
+
 protected:
     struct ModifierKeyStates {
         bool _shiftPressed{false}; //!< L/R shift keys
@@ -26,11 +82,60 @@ protected:
      */
     void PollEvents();
 
+    /**
+     * @brief Takes action on a single SDL event.
+     * @param event The event to handle.
+     */
+    void HandleEvent(const SDL_Event& event);
+
     /**
      * @brief Checks if the GL viewport size has changed and if so, reconfigured projectM accordingly.
      */
     void CheckViewportSize();
 
+    /**
+     * @brief Sets projectM's window size to the drawable size, scaled to the internal resolution.
+     */
+    void UpdateProjectMWindowSize();
+
+    /**
+     * @brief Applies a power governor tier's frame rate limit, internal resolution and mesh size.
+     * @param tier The tier to apply.
+     * @param limiter The render loop's FPS limiter.
+     */
+    void ApplyGovernorTier(const PowerGovernor::Tier& tier, FPSLimiter& limiter);
+
+    /**
+     * @brief Returns the frame rate used while the power saver isn't idle.
+     * @return The configured target FPS, limited by the active governor tier.
+     */
+    int FullFrameRate();
+
+    /**
+     * @brief Runs a frame while the power saver is idle.
+     *
+     * Polls events and audio like a regular frame, but skips all telemetry. Nothing is rendered if the last frame is
+     * frozen, unless sound returned or user input woke the power saver up, in which case the full frame rate is
+     * restored.
+     *
+     * @param limiter The render loop's FPS limiter.
+     */
+    void IdleFrame(FPSLimiter& limiter);
+
+    /**
+     * @brief Applies all recorded input of the next frame when replaying a session.
+     *
+     * Replaces PollEvents(), CheckViewportSize() and filling the audio buffer.
+     *
+     * @return True if a frame was replayed, false if the end of the recording was reached.
+     */
+    bool ReplayFrame();
+
+    /**
+     * @brief Logs the frame time statistics of a session replay and writes the report file, if requested.
+     */
+    void ReportReplayStatistics() const;
+
     /**
      * @brief Handles SDL key press events.
      * @param event The key event.
@@ -77,11 +182,16 @@ protected:
     AudioCapture& _audioCapture;
     ProjectMWrapper& _projectMWrapper;
     SDLRenderingWindow& _sdlRenderingWindow;
+    ZoneManager* _zoneManager{nullptr}; //!< Receives events for other zone windows. Only set in the main loop.
 
     projectm_handle _projectMHandle{nullptr};
     projectm_playlist_handle _playlistHandle{nullptr};
 
-    bool _wantsToQuit{false};
+    std::atomic<bool> _wantsToQuit{false};
+
+    bool _externalEvents{false}; //!< If true, events are passed in via PushEvent() instead of being polled.
+    Poco::FastMutex _eventMutex; //!< Protects _pendingEvents.
+    std::deque<SDL_Event> _pendingEvents; //!< Events pushed by the main thread, waiting to be handled.
 
     bool _mouseDown{false}; //!< Left mouse button is pressed
 
@@ -90,5 +200,24 @@ protected:
 
     ModifierKeyStates _keyStates; //!< Current "pressed" states of modifier keys
 
+    PresetPreviewWall _previewWall; //!< Preset browser, shown in browse mode.
+
+    std::unique_ptr<SessionRecorder> _sessionRecorder; //!< Records the session if requested. Main loop only.
+    std::unique_ptr<SessionReplay> _sessionReplay; //!< Replays a recorded session if requested. Main loop only.
+    SessionReplay::Frame _replayFrame; //!< Input of the currently replayed frame, reused to avoid allocations.
+    Poco::Clock _sessionClock; //!< Time base of the recorded frame times, started with the recording.
+    FrameStatistics _replayStatistics; //!< Frame times measured during a session replay.
+    PerformanceHud _hud; //!< Performance overlay, toggled with the H key.
+    FlightRecorder _flightRecorder; //!< Keeps recent frame telemetry and dumps it on frame spikes. Main loop only.
+    PresetLoadProfiler _loadProfiler; //!< Measures preset load times. Main loop only.
+    PresetWatchdog _presetWatchdog; //!< Skips presets with pathological frame times. Main loop only.
+    TransitionBudget _transitionBudget; //!< Adapts soft cuts to the frame budget. Main loop only.
+    PowerSaver _powerSaver; //!< Lowers the frame rate while the audio is silent. Main loop only.
+    PowerGovernor _governor; //!< Degrades quality on battery or when the system gets hot. Main loop only.
+    ResolutionScaler _resolutionScaler; //!< Renders projectM at the internal resolution set by the governor.
+    int _governorFps{0}; //!< Frame rate limit of the active governor tier, 0 for none.
+    size_t _configuredMeshWidth{0}; //!< Mesh width before the governor changed it.
+    size_t _configuredMeshHeight{0}; //!< Mesh height before the governor changed it.
+
     Poco::Logger& _logger{Poco::Logger::get("RenderLoop")}; //!< The class logger.
 };
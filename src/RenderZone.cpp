@@ -0,0 +1,100 @@
+#include "RenderZone.h"
+
+RenderZone::RenderZone(std::string name,
+                       Poco::AutoPtr<Poco::Util::AbstractConfiguration> config,
+                       const std::vector<std::string>& presetIndex)
+    : _name(std::move(name))
+    , _config(std::move(config))
+    , _presetIndex(presetIndex)
+    , _thread("Zone " + _name)
+{
+    _sdlRenderingWindow->initialize(_config->createView("window"));
+    _sdlRenderingWindow->SetTitle("projectM ➫ " + _name);
+
+    // Creating the context made it current on the main thread. Release it so the render thread can take over.
+    _sdlRenderingWindow->ReleaseCurrent();
+}
+
+RenderZone::~RenderZone()
+{
+    Stop();
+    _sdlRenderingWindow->uninitialize();
+}
+
+const std::string& RenderZone::Name() const
+{
+    return _name;
+}
+
+uint32_t RenderZone::WindowID() const
+{
+    return _sdlRenderingWindow->WindowID();
+}
+
+void RenderZone::Start()
+{
+    _thread.start(*this);
+}
+
+void RenderZone::Stop()
+{
+    {
+        Poco::FastMutex::ScopedLock lock(_renderLoopMutex);
+        _stopRequested = true;
+        if (_renderLoop)
+        {
+            _renderLoop->Quit();
+        }
+    }
+
+    if (_thread.isRunning())
+    {
+        _thread.join();
+    }
+}
+
+void RenderZone::PushEvent(const SDL_Event& event)
+{
+    Poco::FastMutex::ScopedLock lock(_renderLoopMutex);
+    if (_renderLoop)
+    {
+        _renderLoop->PushEvent(event);
+    }
+}
+
+void RenderZone::run()
+{
+    _sdlRenderingWindow->MakeCurrent();
+
+    int canvasWidth{0};
+    int canvasHeight{0};
+    _sdlRenderingWindow->GetDrawableSize(canvasWidth, canvasHeight);
+
+    _projectMWrapper->initialize(_config->createView("projectM"), canvasWidth, canvasHeight, _presetIndex);
+    _audioCapture->initialize(_config->createView("audio"), _projectMWrapper->ProjectM());
+
+    poco_information_f1(_logger, R"(Zone "%s" started rendering.)", _name);
+
+    {
+        Poco::FastMutex::ScopedLock lock(_renderLoopMutex);
+        _renderLoop.reset(new RenderLoop(*_audioCapture, *_projectMWrapper, *_sdlRenderingWindow));
+        if (_stopRequested)
+        {
+            _renderLoop->Quit();
+        }
+    }
+
+    _renderLoop->Run();
+
+    {
+        Poco::FastMutex::ScopedLock lock(_renderLoopMutex);
+        _renderLoop.reset();
+    }
+
+    _audioCapture->uninitialize();
+    _projectMWrapper->uninitialize();
+
+    _sdlRenderingWindow->ReleaseCurrent();
+
+    poco_information_f1(_logger, R"(Zone "%s" stopped rendering.)", _name);
+}
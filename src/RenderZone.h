@@ -0,0 +1,97 @@
+#pragma once
+
+#include "AudioCapture.h"
+#include "ProjectMWrapper.h"
+#include "RenderLoop.h"
+#include "SDLRenderingWindow.h"
+
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A render zone with its own window, projectM instance, playlist and audio capture device.
+ *
+ * Zones are defined in the "zones.<name>" configuration subkeys. Each zone renders on its own thread,
+ * using its own OpenGL context. The window itself is created on the main thread, as SDL requires this
+ * on some platforms and also delivers all events there.
+ */
+class RenderZone : public Poco::Runnable
+{
+public:
+    /**
+     * @brief Creates a zone and its rendering window.
+     *
+     * Must be called on the main thread. The OpenGL context of the new window is released afterwards.
+     *
+     * @param name The zone name, used for logging and the thread name.
+     * @param config The zone configuration. Settings not specified for the zone are inherited from the
+     *               global configuration.
+     * @param presetIndex The shared list of preset files, or an empty list to scan the zone's preset path.
+     */
+    RenderZone(std::string name,
+               Poco::AutoPtr<Poco::Util::AbstractConfiguration> config,
+               const std::vector<std::string>& presetIndex);
+
+    ~RenderZone() override;
+
+    /**
+     * @brief Returns the zone name.
+     * @return The name of this zone.
+     */
+    const std::string& Name() const;
+
+    /**
+     * @brief Returns the SDL window ID of the zone's rendering window.
+     * @return The SDL window ID.
+     */
+    uint32_t WindowID() const;
+
+    /**
+     * @brief Starts the zone's render thread.
+     */
+    void Start();
+
+    /**
+     * @brief Stops rendering and waits for the render thread to exit.
+     */
+    void Stop();
+
+    /**
+     * @brief Forwards an SDL event to the zone's render loop.
+     *
+     * Events arriving before the render loop has started are dropped.
+     *
+     * @param event The event to forward.
+     */
+    void PushEvent(const SDL_Event& event);
+
+    /**
+     * @brief Render thread entry point.
+     */
+    void run() override;
+
+protected:
+    std::string _name; //!< The zone name.
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< Zone configuration, layered over the global one.
+    const std::vector<std::string>& _presetIndex; //!< The shared preset index.
+
+    Poco::AutoPtr<SDLRenderingWindow> _sdlRenderingWindow{new SDLRenderingWindow}; //!< The zone's rendering window.
+    Poco::AutoPtr<ProjectMWrapper> _projectMWrapper{new ProjectMWrapper}; //!< The zone's projectM instance.
+    Poco::AutoPtr<AudioCapture> _audioCapture{new AudioCapture}; //!< The zone's audio capture device.
+
+    Poco::FastMutex _renderLoopMutex; //!< Protects _renderLoop while the thread starts up or shuts down.
+    std::unique_ptr<RenderLoop> _renderLoop; //!< The zone's render loop, only valid while the thread is running.
+    bool _stopRequested{false}; //!< Set by Stop(), in case the render loop wasn't created yet.
+
+    Poco::Thread _thread; //!< The zone's render thread.
+
+    Poco::Logger& _logger{Poco::Logger::get("RenderZone")}; //!< The class logger.
+};
@@ -0,0 +1,122 @@
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ResolutionScaler::SetScale(double scale)
+{
+    _scale = std::min(1.0, std::max(0.25, scale));
+}
+
+void ResolutionScaler::ScaledSize(int width, int height, int& scaledWidth, int& scaledHeight) const
+{
+    if (_scale >= 1.0 || _failed)
+    {
+        scaledWidth = width;
+        scaledHeight = height;
+        return;
+    }
+
+    scaledWidth = std::max(1, static_cast<int>(std::lround(width * _scale)));
+    scaledHeight = std::max(1, static_cast<int>(std::lround(height * _scale)));
+}
+
+bool ResolutionScaler::Upscale(int width, int height)
+{
+    int scaledWidth;
+    int scaledHeight;
+    ScaledSize(width, height, scaledWidth, scaledHeight);
+
+    if (scaledWidth == width && scaledHeight == height)
+    {
+        return true;
+    }
+
+    if (!CreateFramebuffer(scaledWidth, scaledHeight))
+    {
+        return false;
+    }
+
+    // Source and destination overlap in the default framebuffer, so the frame takes a detour.
+    _gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    _gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebuffer);
+    _gl.BlitFramebuffer(0, 0, scaledWidth, scaledHeight,
+                        0, 0, scaledWidth, scaledHeight,
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    _gl.BindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+    _gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    _gl.BlitFramebuffer(0, 0, scaledWidth, scaledHeight,
+                        0, 0, width, height,
+                        GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glViewport(0, 0, width, height);
+
+    return true;
+}
+
+void ResolutionScaler::Release()
+{
+    if (_framebuffer)
+    {
+        _gl.DeleteFramebuffers(1, &_framebuffer);
+        _framebuffer = 0;
+    }
+
+    if (_texture)
+    {
+        glDeleteTextures(1, &_texture);
+        _texture = 0;
+    }
+
+    _framebufferWidth = 0;
+    _framebufferHeight = 0;
+}
+
+bool ResolutionScaler::CreateFramebuffer(int width, int height)
+{
+    if (_framebuffer && width == _framebufferWidth && height == _framebufferHeight)
+    {
+        return true;
+    }
+
+    if (!_glLoaded)
+    {
+        if (!_gl.Load())
+        {
+            poco_error(_logger, "Could not load the required OpenGL functions, rendering at full resolution.");
+            _failed = true;
+            return false;
+        }
+        _glLoaded = true;
+    }
+
+    Release();
+
+    glGenTextures(1, &_texture);
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _gl.GenFramebuffers(1, &_framebuffer);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    _gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0);
+    auto status = _gl.CheckFramebufferStatus(GL_FRAMEBUFFER);
+    _gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        poco_error_f1(_logger, "Scaling framebuffer is incomplete (status 0x%?x), rendering at full resolution.", status);
+        Release();
+        _failed = true;
+        return false;
+    }
+
+    _framebufferWidth = width;
+    _framebufferHeight = height;
+
+    return true;
+}
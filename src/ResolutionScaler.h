@@ -0,0 +1,73 @@
+#pragma once
+
+#include "OpenGLFunctions.h"
+
+#include <Poco/Logger.h>
+
+/**
+ * @brief Renders projectM at a lower internal resolution and scales the result up to the window size.
+ *
+ * projectM's window size is set to the scaled size, so it only renders into the lower left part of the default
+ * framebuffer. Upscale() copies that part into an intermediate framebuffer and stretches it back over the whole
+ * window with linear filtering. The two blits cost far less than the pixels saved in the preset's shaders.
+ *
+ * Must be used on the render thread with the OpenGL context current.
+ */
+class ResolutionScaler
+{
+public:
+    ResolutionScaler() = default;
+
+    /**
+     * @brief Sets the scale factor of the internal resolution.
+     * @param scale The factor, between 0.25 and 1. A factor of 1 disables scaling.
+     */
+    void SetScale(double scale);
+
+    /**
+     * @brief Returns the internal resolution for a drawable size.
+     * @param width The drawable width.
+     * @param height The drawable height.
+     * @param[out] scaledWidth Receives the width projectM should render at.
+     * @param[out] scaledHeight Receives the height projectM should render at.
+     */
+    void ScaledSize(int width, int height, int& scaledWidth, int& scaledHeight) const;
+
+    /**
+     * @brief Stretches the frame projectM rendered at the internal resolution over the whole drawable.
+     *
+     * Does nothing if the scale is 1.
+     *
+     * @param width The drawable width.
+     * @param height The drawable height.
+     * @return False if the intermediate framebuffer couldn't be created. Scaling is then disabled, and projectM must be
+     *         set back to the full size.
+     */
+    bool Upscale(int width, int height);
+
+    /**
+     * @brief Deletes the intermediate framebuffer.
+     */
+    void Release();
+
+protected:
+    /**
+     * @brief Creates or resizes the intermediate framebuffer.
+     * @param width The internal width.
+     * @param height The internal height.
+     * @return True if the framebuffer is usable.
+     */
+    bool CreateFramebuffer(int width, int height);
+
+    double _scale{1.0}; //!< Internal resolution scale factor.
+    bool _failed{false}; //!< True if the framebuffer couldn't be created, disables upscaling.
+
+    OpenGLFunctions _gl; //!< OpenGL framebuffer functions.
+    bool _glLoaded{false}; //!< True after the OpenGL functions were loaded.
+    GLuint _framebuffer{0}; //!< Intermediate framebuffer holding the low resolution frame.
+    GLuint _texture{0}; //!< Color attachment of the intermediate framebuffer.
+    int _framebufferWidth{0}; //!< Width of the intermediate framebuffer.
+    int _framebufferHeight{0}; //!< Height of the intermediate framebuffer.
+
+    Poco::Logger& _logger{Poco::Logger::get("ResolutionScaler")}; //!< The class logger.
+};
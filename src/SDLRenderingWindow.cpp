@@ -1,5 +1,7 @@
 #include "SDLRenderingWindow.h"
 
+#include "Tracer.h"
+
 #include <Poco/Util/Application.h>
 
 #include <SDL2/SDL_opengl.h>
@@ -11,7 +13,14 @@ const char* SDLRenderingWindow::name() const
 
 void SDLRenderingWindow::initialize(Poco::Util::Application& app)
 {
-    _config = app.config().createView("window");
+    TRACE_ZONE("SDLRenderingWindow::initialize", "init");
+
+    initialize(app.config().createView("window"));
+}
+
+void SDLRenderingWindow::initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config)
+{
+    _config = config;
 
     if (!_renderingWindow)
     {
@@ -32,6 +41,11 @@ void SDLRenderingWindow::GetDrawableSize(int& width, int& height) const
     SDL_GL_GetDrawableSize(_renderingWindow, &width, &height);
 }
 
+void SDLRenderingWindow::SetSize(int width, int height) const
+{
+    SDL_SetWindowSize(_renderingWindow, width, height);
+}
+
 void SDLRenderingWindow::SetTitle(const std::string& title) const
 {
     SDL_SetWindowTitle(_renderingWindow, title.c_str());
@@ -42,6 +56,26 @@ void SDLRenderingWindow::Swap() const
     SDL_GL_SwapWindow(_renderingWindow);
 }
 
+uint32_t SDLRenderingWindow::WindowID() const
+{
+    return SDL_GetWindowID(_renderingWindow);
+}
+
+bool SDLRenderingWindow::Visible() const
+{
+    return (SDL_GetWindowFlags(_renderingWindow) & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED)) == 0;
+}
+
+void SDLRenderingWindow::MakeCurrent() const
+{
+    SDL_GL_MakeCurrent(_renderingWindow, _glContext);
+}
+
+void SDLRenderingWindow::ReleaseCurrent() const
+{
+    SDL_GL_MakeCurrent(_renderingWindow, nullptr);
+}
+
 void SDLRenderingWindow::ToggleFullscreen()
 {
     if (_fullscreen)
@@ -230,8 +264,12 @@ void SDLRenderingWindow::CreateSDLWindow()
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 #endif
 
+    // Hidden windows are used for offscreen rendering, e.g. by the thumbnail generator.
+    bool hidden = _config->getBool("hidden", false);
+
     _renderingWindow = SDL_CreateWindow("projectM", left, top, width, height,
-                                        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+                                        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
+                                        | (hidden ? SDL_WINDOW_HIDDEN : 0));
     if (!_renderingWindow)
     {
         auto errorMessage = "Could not create SDL rendering window. Error: " + std::string(SDL_GetError());
@@ -251,7 +289,7 @@ void SDLRenderingWindow::CreateSDLWindow()
     SDL_GL_MakeCurrent(_renderingWindow, _glContext);
     SDL_GL_SetSwapInterval(_config->getBool("waitForVerticalSync", true) ? 1 : 0);
 
-    if (_config->getBool("fullscreen", false))
+    if (!hidden && _config->getBool("fullscreen", false))
     {
         Fullscreen();
     }
@@ -16,6 +16,15 @@ public:
 
     void initialize(Poco::Util::Application& app) override;
 
+    /**
+     * @brief Creates the rendering window using the given configuration.
+     *
+     * Used by render zones, which do not read their settings from the global "window" key.
+     *
+     * @param config View of the "window" configuration subkey to use.
+     */
+    void initialize(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config);
+
     void uninitialize() override;
 
     /**
@@ -29,6 +38,16 @@ public:
      */
     void GetDrawableSize(int& width, int& height) const;
 
+    /**
+     * @brief Resizes the window.
+     *
+     * Used to restore recorded viewport sizes on replay. Only matches the drawable size if no DPI scaling is applied.
+     *
+     * @param width The new window width.
+     * @param height The new window height.
+     */
+    void SetSize(int width, int height) const;
+
     /**
      * @brief Sets the window title.
      * @param title The new window title.
@@ -40,6 +59,34 @@ public:
      */
     void Swap() const;
 
+    /**
+     * @brief Returns the SDL window ID.
+     *
+     * Used to find the window an SDL event was targeted at.
+     *
+     * @return The SDL ID of the rendering window.
+     */
+    uint32_t WindowID() const;
+
+    /**
+     * @brief Returns whether the window is shown, i.e. neither hidden nor minimized.
+     * @return True if the window is visible.
+     */
+    bool Visible() const;
+
+    /**
+     * @brief Makes the window's OpenGL context current on the calling thread.
+     */
+    void MakeCurrent() const;
+
+    /**
+     * @brief Releases the window's OpenGL context from the calling thread.
+     *
+     * A context can only be current on one thread at a time, so it must be released before
+     * another thread can make it current.
+     */
+    void ReleaseCurrent() const;
+
     /**
      * @brief Toggles the window's fullscreen mode.
      *
@@ -0,0 +1,159 @@
+#include "SessionRecorder.h"
+
+#include <Poco/Exception.h>
+
+constexpr char SessionRecorder::Magic[4];
+constexpr uint32_t SessionRecorder::Version;
+
+SessionRecorder::SessionRecorder(const std::string& fileName)
+    : _fileName(fileName)
+    , _stream(fileName, std::ios::out | std::ios::binary | std::ios::trunc)
+    , _writer(_stream, Poco::BinaryWriter::LITTLE_ENDIAN_BYTE_ORDER)
+{
+    _writer.writeRaw(Magic, sizeof(Magic));
+    _writer << Version;
+
+    if (!_writer.good())
+    {
+        throw Poco::CreateFileException(fileName);
+    }
+
+    poco_information_f1(_logger, R"(Recording session to "%s".)", fileName);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    try
+    {
+        Finish();
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Could not finish session recording: %s", ex.displayText());
+    }
+}
+
+void SessionRecorder::NextFrame()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _frame++;
+}
+
+void SessionRecorder::RecordAudio(const float* samples, unsigned int frames, unsigned int channels)
+{
+    if (frames == 0)
+    {
+        return;
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::Audio);
+    _writer << static_cast<uint8_t>(channels) << static_cast<uint32_t>(frames);
+    _writer.writeRaw(reinterpret_cast<const char*>(samples),
+                     static_cast<std::streamsize>(frames * channels * sizeof(float)));
+
+    _audioFrames += frames;
+}
+
+void SessionRecorder::RecordEvent(const SDL_Event& event)
+{
+    // These carry pointers to data which can't be restored on replay.
+    switch (event.type)
+    {
+        case SDL_SYSWMEVENT:
+        case SDL_DROPFILE:
+        case SDL_DROPTEXT:
+#if SDL_VERSION_ATLEAST(2, 0, 22)
+        case SDL_TEXTEDITING_EXT:
+#endif
+            return;
+
+        default:
+            if (event.type >= SDL_USEREVENT)
+            {
+                return;
+            }
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::Event);
+    _writer << static_cast<uint32_t>(sizeof(SDL_Event));
+    _writer.writeRaw(reinterpret_cast<const char*>(&event), sizeof(SDL_Event));
+
+    _events++;
+}
+
+void SessionRecorder::RecordViewport(int width, int height)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::Viewport);
+    _writer << static_cast<int32_t>(width) << static_cast<int32_t>(height);
+}
+
+void SessionRecorder::RecordPresetSwitch(bool hardCut, const std::string& presetFile)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::PresetSwitch);
+    _writer << hardCut << presetFile;
+}
+
+void SessionRecorder::RecordFrameTime(double seconds)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::FrameTime);
+    _writer << seconds;
+}
+
+void SessionRecorder::Finish()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_finished)
+    {
+        return;
+    }
+
+    WriteRecordHeader(RecordType::End);
+    _finished = true;
+
+    _writer.flush();
+    _stream.close();
+
+    poco_information_f4(_logger, R"(Finished session recording "%s": %?d frames, %?d events, %?d audio sample frames.)",
+                        _fileName, _frame, _events, _audioFrames);
+}
+
+void SessionRecorder::WriteRecordHeader(RecordType type)
+{
+    _writer << static_cast<uint8_t>(type) << _frame;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <Poco/BinaryWriter.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief Records everything that drives a rendering session into a binary file for later replay.
+ *
+ * The file starts with the magic "PMSR" and a format version, followed by a sequence of records. Each record
+ * starts with its type and the index of the frame it belongs to, followed by a type-specific payload:
+ *
+ * - Audio: channel count, sample frame count and the interleaved float samples passed to projectM.
+ * - Event: the raw SDL_Event structure handled by the render loop.
+ * - Viewport: the new drawable width and height.
+ * - PresetSwitch: hard cut flag and the preset file name.
+ * - FrameTime: seconds since the start of the recording used as projectM's frame time (version 2 and later).
+ * - End: no payload, the frame index is the total number of frames.
+ *
+ * With projectM 4.1 or later, projectM's animation time is driven by the recorded frame times, both while
+ * recording and on replay, so the replay renders exactly the same frames. projectM 4.0 always uses its own
+ * clock, which makes the replay of time-based animations only approximate.
+ *
+ * All values are stored in little endian byte order. Audio samples and events are stored as raw memory, so
+ * recordings can only be replayed on little endian machines by a build using the same SDL version.
+ */
+class SessionRecorder
+{
+public:
+    /**
+     * @brief Session recording record types.
+     */
+    enum class RecordType : uint8_t
+    {
+        Audio = 1, //!< Audio samples passed to projectM.
+        Event = 2, //!< SDL event handled by the render loop.
+        Viewport = 3, //!< Changed rendering viewport size.
+        PresetSwitch = 4, //!< Displayed preset has changed.
+        End = 5, //!< End of the recording.
+        FrameTime = 6 //!< Time of the frame passed to projectM.
+    };
+
+    static constexpr char Magic[4]{'P', 'M', 'S', 'R'}; //!< File magic.
+    static constexpr uint32_t Version{2}; //!< Current file format version. Version 1 had no frame times.
+
+    /**
+     * @brief Creates the recording file.
+     * @throws Poco::FileException if the file can't be created.
+     * @param fileName The recording file name.
+     */
+    explicit SessionRecorder(const std::string& fileName);
+
+    /**
+     * @brief Destructor. Finishes the recording.
+     */
+    ~SessionRecorder();
+
+    /**
+     * @brief Starts the next frame. All following records are attached to it.
+     */
+    void NextFrame();
+
+    /**
+     * @brief Records audio data passed to projectM. Thread-safe.
+     * @param samples Interleaved float samples.
+     * @param frames Number of sample frames.
+     * @param channels Number of channels.
+     */
+    void RecordAudio(const float* samples, unsigned int frames, unsigned int channels);
+
+    /**
+     * @brief Records an SDL event. Events containing pointers, e.g. drop events, are skipped.
+     * @param event The event to record.
+     */
+    void RecordEvent(const SDL_Event& event);
+
+    /**
+     * @brief Records a changed rendering viewport size.
+     * @param width The new drawable width.
+     * @param height The new drawable height.
+     */
+    void RecordViewport(int width, int height);
+
+    /**
+     * @brief Records a preset switch.
+     * @param hardCut True if the preset was switched without a transition.
+     * @param presetFile The new preset file.
+     */
+    void RecordPresetSwitch(bool hardCut, const std::string& presetFile);
+
+    /**
+     * @brief Records the time of the current frame.
+     * @param seconds Seconds since the start of the recording.
+     */
+    void RecordFrameTime(double seconds);
+
+    /**
+     * @brief Writes the end record and closes the file. Called automatically on destruction.
+     */
+    void Finish();
+
+protected:
+    /**
+     * @brief Writes the common record header. Must be called with the mutex locked.
+     * @param type The record type.
+     */
+    void WriteRecordHeader(RecordType type);
+
+    std::string _fileName; //!< The recording file name.
+    Poco::FileOutputStream _stream; //!< The recording file.
+    Poco::BinaryWriter _writer; //!< Writes the records into the file.
+
+    Poco::FastMutex _mutex; //!< Serializes writes, as audio may be recorded from another thread.
+    uint32_t _frame{0}; //!< Current frame index.
+    bool _finished{false}; //!< True once the end record was written.
+    uint64_t _audioFrames{0}; //!< Number of recorded audio sample frames, for the summary.
+    uint64_t _events{0}; //!< Number of recorded events, for the summary.
+
+    Poco::Logger& _logger{Poco::Logger::get("SessionRecorder")}; //!< The class logger.
+};
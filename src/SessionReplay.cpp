@@ -0,0 +1,148 @@
+#include "SessionReplay.h"
+
+#include <Poco/Exception.h>
+
+#include <cstring>
+
+SessionReplay::SessionReplay(const std::string& fileName)
+    : _stream(fileName, std::ios::in | std::ios::binary)
+    , _reader(_stream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER)
+{
+    char magic[sizeof(SessionRecorder::Magic)]{};
+    _reader.readRaw(magic, sizeof(magic));
+    _reader >> _version;
+
+    if (!_reader.good() || std::memcmp(magic, SessionRecorder::Magic, sizeof(magic)) != 0)
+    {
+        throw Poco::DataFormatException("Not a session recording", fileName);
+    }
+
+    if (_version < 1 || _version > SessionRecorder::Version)
+    {
+        throw Poco::DataFormatException(Poco::format("Unsupported session recording version %?d", _version), fileName);
+    }
+
+    ReadRecordHeader();
+
+    poco_information_f1(_logger, R"(Replaying session from "%s".)", fileName);
+}
+
+bool SessionReplay::NextFrame(Frame& frame)
+{
+    frame._events.clear();
+    frame._viewportChanged = false;
+    frame._audio.clear();
+    frame._presetSwitches.clear();
+    frame._frameTime = -1.0;
+
+    if (_started)
+    {
+        _currentFrame++;
+    }
+    _started = true;
+
+    while (!_finished && _nextFrame == _currentFrame)
+    {
+        switch (_nextType)
+        {
+            case SessionRecorder::RecordType::Audio: {
+                uint8_t channels{0};
+                uint32_t sampleFrames{0};
+                _reader >> channels >> sampleFrames;
+
+                AudioChunk chunk;
+                chunk._channels = channels;
+                chunk._samples.resize(static_cast<size_t>(sampleFrames) * channels);
+                _reader.readRaw(reinterpret_cast<char*>(chunk._samples.data()),
+                                static_cast<std::streamsize>(chunk._samples.size() * sizeof(float)));
+                frame._audio.push_back(std::move(chunk));
+                break;
+            }
+
+            case SessionRecorder::RecordType::Event: {
+                uint32_t eventSize{0};
+                _reader >> eventSize;
+                if (eventSize != sizeof(SDL_Event))
+                {
+                    throw Poco::DataFormatException("Session was recorded with an incompatible SDL version");
+                }
+
+                SDL_Event event;
+                _reader.readRaw(reinterpret_cast<char*>(&event), sizeof(SDL_Event));
+                frame._events.push_back(event);
+                break;
+            }
+
+            case SessionRecorder::RecordType::Viewport: {
+                int32_t width{0};
+                int32_t height{0};
+                _reader >> width >> height;
+
+                frame._viewportChanged = true;
+                frame._viewportWidth = width;
+                frame._viewportHeight = height;
+                break;
+            }
+
+            case SessionRecorder::RecordType::PresetSwitch: {
+                PresetSwitch presetSwitch;
+                _reader >> presetSwitch._hardCut >> presetSwitch._presetFile;
+                frame._presetSwitches.push_back(presetSwitch);
+                break;
+            }
+
+            case SessionRecorder::RecordType::FrameTime:
+                _reader >> frame._frameTime;
+                break;
+
+            case SessionRecorder::RecordType::End:
+                _finished = true;
+                _endFrame = _nextFrame;
+                break;
+
+            default:
+                throw Poco::DataFormatException(Poco::format("Unknown record type %?d in frame %?d",
+                                                             static_cast<int>(_nextType), _nextFrame));
+        }
+
+        if (!_reader.good())
+        {
+            throw Poco::DataFormatException(Poco::format("Session recording is truncated in frame %?d", _nextFrame));
+        }
+
+        if (!_finished)
+        {
+            ReadRecordHeader();
+        }
+    }
+
+    return _currentFrame < _endFrame;
+}
+
+uint32_t SessionReplay::CurrentFrame() const
+{
+    return _currentFrame;
+}
+
+bool SessionReplay::HasFrameTimes() const
+{
+    return _version >= 2;
+}
+
+void SessionReplay::ReadRecordHeader()
+{
+    uint8_t type{0};
+    _reader >> type >> _nextFrame;
+
+    if (!_reader.good())
+    {
+        // Recording wasn't finished properly, e.g. due to a crash. Replay everything up to here.
+        poco_warning(_logger, "Session recording has no end record, it might be incomplete.");
+        _nextType = SessionRecorder::RecordType::End;
+        _finished = true;
+        _endFrame = _started ? _currentFrame + 1 : 0;
+        return;
+    }
+
+    _nextType = static_cast<SessionRecorder::RecordType>(type);
+}
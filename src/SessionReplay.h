@@ -0,0 +1,93 @@
+#pragma once
+
+#include "SessionRecorder.h"
+
+#include <Poco/BinaryReader.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reads a session recording written by SessionRecorder frame by frame.
+ */
+class SessionReplay
+{
+public:
+    /**
+     * @brief Audio data passed to projectM within a frame.
+     */
+    struct AudioChunk {
+        unsigned int _channels{2}; //!< Number of channels.
+        std::vector<float> _samples; //!< Interleaved samples.
+    };
+
+    /**
+     * @brief A preset switch within a frame.
+     */
+    struct PresetSwitch {
+        bool _hardCut{false}; //!< True if the preset was switched without a transition.
+        std::string _presetFile; //!< The new preset file.
+    };
+
+    /**
+     * @brief All recorded input of a single frame, in recording order per type.
+     */
+    struct Frame {
+        std::vector<SDL_Event> _events; //!< Handled SDL events.
+        bool _viewportChanged{false}; //!< True if the viewport size was changed in this frame.
+        int _viewportWidth{0}; //!< New viewport width, if changed.
+        int _viewportHeight{0}; //!< New viewport height, if changed.
+        std::vector<AudioChunk> _audio; //!< Audio data passed to projectM.
+        std::vector<PresetSwitch> _presetSwitches; //!< Preset switches.
+        double _frameTime{-1.0}; //!< projectM frame time in seconds, negative if not recorded.
+    };
+
+    /**
+     * @brief Opens a recording file and checks the header.
+     * @throws Poco::Exception if the file can't be opened or is no valid session recording.
+     * @param fileName The recording file name.
+     */
+    explicit SessionReplay(const std::string& fileName);
+
+    /**
+     * @brief Reads all records of the next frame.
+     * @param frame[out] Receives the frame's records. Cleared before reading.
+     * @return True if a frame was read, false if the end of the recording was reached.
+     * @throws Poco::DataFormatException if the file is corrupted.
+     */
+    bool NextFrame(Frame& frame);
+
+    /**
+     * @brief Returns the index of the frame last returned by NextFrame().
+     * @return The current frame index.
+     */
+    uint32_t CurrentFrame() const;
+
+    /**
+     * @brief Returns whether the recording contains frame times.
+     * @return True if frame times were recorded, false for recordings of format version 1.
+     */
+    bool HasFrameTimes() const;
+
+protected:
+    /**
+     * @brief Reads the next record header into _nextType and _nextFrame.
+     */
+    void ReadRecordHeader();
+
+    Poco::FileInputStream _stream; //!< The recording file.
+    Poco::BinaryReader _reader; //!< Reads the records from the file.
+
+    SessionRecorder::RecordType _nextType{SessionRecorder::RecordType::End}; //!< Type of the next record.
+    uint32_t _nextFrame{0}; //!< Frame index of the next record.
+    uint32_t _currentFrame{0}; //!< Index of the frame last returned.
+    bool _started{false}; //!< True after the first frame was returned.
+    bool _finished{false}; //!< True once the end record was read.
+    uint32_t _endFrame{UINT32_MAX}; //!< Number of frames in the recording, known once the end is reached.
+    uint32_t _version{0}; //!< File format version of the recording.
+
+    Poco::Logger& _logger{Poco::Logger::get("SessionReplay")}; //!< The class logger.
+};
@@ -0,0 +1,345 @@
+#include "ThumbnailGenerator.h"
+
+#include "AudioFile.h"
+#include "ProjectMWrapper.h"
+
+#include <Poco/Environment.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/MD5Engine.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Path.h>
+#include <Poco/Thread.h>
+
+#include <Poco/JSON/Array.h>
+#include <Poco/JSON/Object.h>
+#include <Poco/JSON/Parser.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+
+ThumbnailGenerator::ThumbnailGenerator()
+    : _config(Poco::Util::Application::instance().config().createView("thumbnails"))
+{
+}
+
+int ThumbnailGenerator::Run()
+{
+    auto& app = Poco::Util::Application::instance();
+
+    _outputPath = _config->getString("outputPath");
+    _jobTimeout = static_cast<long>(std::max(1.0, _config->getDouble("jobTimeout", 60.0)) * 1000.0);
+
+    // Validate the audio file once, otherwise every single job would fail in the workers.
+    try
+    {
+        AudioFile audioFile(_config->getString("audioFile"));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Cannot generate thumbnails, a valid WAV file must be given via --thumbnailAudio: %s",
+                      ex.displayText());
+        return Poco::Util::Application::EXIT_NOINPUT;
+    }
+
+    Poco::File(_outputPath).createDirectories();
+
+    LoadIndex();
+
+    // The main playlist already contains the whole preset library.
+    auto playlist = app.getSubsystem<ProjectMWrapper>().Playlist();
+    auto presetCount = projectm_playlist_size(playlist);
+    auto presetFiles = projectm_playlist_items(playlist, 0, presetCount);
+
+    for (auto presetFile = presetFiles; presetFile && *presetFile; presetFile++)
+    {
+        if (_results.find(*presetFile) != _results.end())
+        {
+            continue;
+        }
+
+        _jobs.push_back({*presetFile, ImageFileName(*presetFile)});
+    }
+
+    projectm_playlist_free_string_array(presetFiles);
+
+    _totalJobs = _jobs.size();
+    if (_totalJobs == 0)
+    {
+        poco_information_f1(_logger, "All %?d thumbnails are up to date.", presetCount);
+        return Poco::Util::Application::EXIT_OK;
+    }
+
+    auto workerCount = std::max(1, _config->getInt("workers", static_cast<int>(Poco::Environment::processorCount())));
+    workerCount = std::min(workerCount, static_cast<int>(_totalJobs));
+
+    poco_information_f3(_logger, "Rendering %?d thumbnails (%?d already done) using %?d workers.",
+                        _totalJobs, presetCount - _totalJobs, workerCount);
+
+    // Each worker is single-threaded, so let llvmpipe use one thread per worker as well.
+    Poco::Process::Env environment{
+        {"LP_NUM_THREADS", _config->getString("llvmpipeThreads", "1")}};
+
+    std::vector<std::string> workerArgs{
+        "--thumbnailWorker",
+        "--thumbnailAudio", _config->getString("audioFile", "")};
+
+    std::vector<std::unique_ptr<WorkerRunner>> runners;
+    std::vector<std::unique_ptr<Poco::Thread>> threads;
+
+    _stopwatch.start();
+
+    for (int workerIndex = 0; workerIndex < workerCount; workerIndex++)
+    {
+        auto workerName = "Thumbnail worker " + std::to_string(workerIndex);
+        std::unique_ptr<WorkerProcess> worker(new WorkerProcess(workerName, app.commandPath(), workerArgs, environment));
+        runners.emplace_back(new WorkerRunner(*this, std::move(worker)));
+        threads.emplace_back(new Poco::Thread(workerName));
+        threads.back()->start(*runners.back());
+    }
+
+    auto reportInterval = std::max(1, _config->getInt("reportInterval", 10)) * 1000;
+    for (auto& thread : threads)
+    {
+        while (!thread->tryJoin(reportInterval))
+        {
+            ReportProgress();
+        }
+    }
+
+    _stopwatch.stop();
+
+    try
+    {
+        SaveIndex();
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Could not write the thumbnail index: %s", ex.displayText());
+        return Poco::Util::Application::EXIT_CANTCREAT;
+    }
+
+    double seconds = static_cast<double>(_stopwatch.elapsed()) / 1000000.0;
+    poco_information_f4(_logger, "Finished %?d thumbnails (%?d failed) in %.1f seconds, %.2f presets/s.",
+                        _finishedJobs, _failedJobs, seconds, static_cast<double>(_finishedJobs) / std::max(seconds, 0.001));
+
+    return _failedJobs == 0 ? Poco::Util::Application::EXIT_OK : Poco::Util::Application::EXIT_SOFTWARE;
+}
+
+ThumbnailGenerator::WorkerRunner::WorkerRunner(ThumbnailGenerator& generator, std::unique_ptr<WorkerProcess> worker)
+    : _generator(generator)
+    , _worker(std::move(worker))
+{
+}
+
+void ThumbnailGenerator::WorkerRunner::run()
+{
+    Job job;
+    while (_generator.NextJob(job))
+    {
+        Result result;
+
+        try
+        {
+            if (!_worker->Running())
+            {
+                _worker->Start();
+            }
+        }
+        catch (Poco::Exception& ex)
+        {
+            result._error = "Could not start worker: " + ex.displayText();
+            _generator.JobFinished(job, result);
+            continue;
+        }
+
+        std::string response;
+        if (!_worker->SendLine(Poco::Path(_generator._outputPath, job._imageFile).toString() + "\t" + job._presetFile)
+            || !_worker->ReadLine(response, _generator._jobTimeout))
+        {
+            // Worker crashed or hangs, most likely caused by this preset. A new one is started for the next job.
+            result._error = _worker->TimedOut()
+                                ? "Worker process timed out after " + std::to_string(_generator._jobTimeout / 1000) + " seconds"
+                                : "Worker process terminated";
+            _worker->Kill();
+        }
+        else if (response.compare(0, 3, "OK ") == 0)
+        {
+            result._imageFile = job._imageFile;
+            if (!Poco::NumberParser::tryParseFloat(response.substr(3), result._renderTime))
+            {
+                poco_warning_f2(_generator._logger, R"(Invalid render time in response "%s" from %s.)", response, _worker->Name());
+            }
+        }
+        else
+        {
+            result._error = response.compare(0, 5, "FAIL ") == 0 ? response.substr(5) : response;
+        }
+
+        _generator.JobFinished(job, result);
+    }
+
+    _worker->Stop();
+}
+
+bool ThumbnailGenerator::NextJob(Job& job)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_jobs.empty())
+    {
+        return false;
+    }
+
+    job = _jobs.front();
+    _jobs.pop_front();
+
+    return true;
+}
+
+void ThumbnailGenerator::JobFinished(const Job& job, const Result& result)
+{
+    bool saveIndex{false};
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        _results[job._presetFile] = result;
+        _finishedJobs++;
+        if (!result._error.empty())
+        {
+            _failedJobs++;
+            poco_warning_f2(_logger, R"(Thumbnail for "%s" failed: %s)", job._presetFile, result._error);
+        }
+
+        _unsavedResults++;
+        saveIndex = _unsavedResults >= 100;
+    }
+
+    if (saveIndex)
+    {
+        // A failed intermediate save is retried with the next batch and at the end of the run.
+        try
+        {
+            SaveIndex();
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_warning_f1(_logger, "Could not write the thumbnail index: %s", ex.displayText());
+        }
+    }
+}
+
+void ThumbnailGenerator::LoadIndex()
+{
+    Poco::File indexFile(Poco::Path(_outputPath, "index.json"));
+    if (!indexFile.exists())
+    {
+        return;
+    }
+
+    try
+    {
+        Poco::FileInputStream input(indexFile.path());
+        Poco::JSON::Parser parser;
+        auto index = parser.parse(input).extract<Poco::JSON::Object::Ptr>();
+
+        auto presets = index->getArray("presets");
+        for (size_t entryIndex = 0; presets && entryIndex < presets->size(); entryIndex++)
+        {
+            auto entry = presets->getObject(static_cast<unsigned int>(entryIndex));
+
+            Result result;
+            result._imageFile = entry->optValue<std::string>("image", "");
+            result._renderTime = entry->optValue<double>("renderTime", 0.0);
+            result._error = entry->optValue<std::string>("error", "");
+
+            // Retry failed presets only if requested, and re-render images which were deleted.
+            if ((!result._error.empty() && _config->getBool("retryFailed", false))
+                || (result._error.empty() && !Poco::File(Poco::Path(_outputPath, result._imageFile)).exists()))
+            {
+                continue;
+            }
+
+            _results[entry->getValue<std::string>("preset")] = result;
+        }
+
+        poco_information_f1(_logger, "Loaded %?d results from existing thumbnail index.", _results.size());
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_warning_f1(_logger, "Could not read existing thumbnail index, starting from scratch: %s", ex.displayText());
+        _results.clear();
+    }
+}
+
+void ThumbnailGenerator::SaveIndex()
+{
+    // Held for the whole save, so two runner threads never write the same temporary file.
+    Poco::FastMutex::ScopedLock saveLock(_saveMutex);
+
+    Poco::JSON::Object index;
+    Poco::JSON::Array::Ptr presets(new Poco::JSON::Array);
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        for (const auto& result : _results)
+        {
+            Poco::JSON::Object::Ptr entry(new Poco::JSON::Object);
+            entry->set("preset", result.first);
+            if (result.second._error.empty())
+            {
+                entry->set("image", result.second._imageFile);
+                entry->set("renderTime", result.second._renderTime);
+            }
+            else
+            {
+                entry->set("error", result.second._error);
+            }
+            presets->add(entry);
+        }
+
+        _unsavedResults = 0;
+    }
+
+    index.set("width", _config->getInt("width", 256));
+    index.set("height", _config->getInt("height", 144));
+    index.set("presets", presets);
+
+    // Write to a temporary file first, so an interrupted run never leaves a truncated index behind.
+    Poco::Path indexPath(_outputPath, "index.json");
+    Poco::Path temporaryPath(_outputPath, "index.json.tmp");
+    {
+        Poco::FileOutputStream output(temporaryPath.toString());
+        index.stringify(output, 1);
+    }
+    Poco::File(temporaryPath).renameTo(indexPath.toString());
+}
+
+std::string ThumbnailGenerator::ImageFileName(const std::string& presetFile)
+{
+    Poco::MD5Engine md5;
+    md5.update(presetFile);
+
+    return Poco::DigestEngine::digestToHex(md5.digest()) + ".bmp";
+}
+
+void ThumbnailGenerator::ReportProgress()
+{
+    size_t finishedJobs;
+    size_t failedJobs;
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        finishedJobs = _finishedJobs;
+        failedJobs = _failedJobs;
+    }
+
+    double seconds = static_cast<double>(_stopwatch.elapsed()) / 1000000.0;
+    double presetsPerSecond = static_cast<double>(finishedJobs) / std::max(seconds, 0.001);
+    double remainingSeconds = presetsPerSecond > 0.0 ? static_cast<double>(_totalJobs - finishedJobs) / presetsPerSecond : 0.0;
+
+    poco_information(_logger, Poco::format("Progress: %?d/%?d thumbnails (%?d failed), %.2f presets/s, about %.0f seconds remaining.",
+                                           finishedJobs, _totalJobs, failedJobs, presetsPerSecond, remainingSeconds));
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "WorkerProcess.h"
+
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Stopwatch.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Batch thumbnail generator, renders a preview image of every preset in the library.
+ *
+ * The generator distributes the presets of the main playlist over a number of headless worker processes
+ * (see ThumbnailWorker) via a shared job queue, so faster workers automatically take more jobs. Workers
+ * which crash, e.g. due to a driver issue with a specific preset, are restarted and the preset is marked
+ * as failed.
+ *
+ * All results are recorded in "index.json" inside the output directory, mapping each preset to its image
+ * file. The index is saved periodically, and presets already listed in it are skipped on the next run,
+ * so an interrupted run can simply be resumed.
+ */
+class ThumbnailGenerator
+{
+public:
+    ThumbnailGenerator();
+
+    /**
+     * @brief Generates all missing thumbnails.
+     * @return The application exit code.
+     */
+    int Run();
+
+protected:
+    /**
+     * @brief A single thumbnail job.
+     */
+    struct Job {
+        std::string _presetFile; //!< The preset to render.
+        std::string _imageFile; //!< The image file to write.
+    };
+
+    /**
+     * @brief Result of a job, stored in the index.
+     */
+    struct Result {
+        std::string _imageFile; //!< The image file, relative to the output directory. Empty if failed.
+        double _renderTime{0.0}; //!< Time needed to render the thumbnail in milliseconds.
+        std::string _error; //!< Error message if the job failed.
+    };
+
+    /**
+     * @brief Drives one worker process from its own thread.
+     */
+    class WorkerRunner : public Poco::Runnable
+    {
+    public:
+        WorkerRunner(ThumbnailGenerator& generator, std::unique_ptr<WorkerProcess> worker);
+
+        void run() override;
+
+    protected:
+        ThumbnailGenerator& _generator; //!< The generator owning the job queue.
+        std::unique_ptr<WorkerProcess> _worker; //!< The worker process.
+    };
+
+    /**
+     * @brief Takes the next job from the queue.
+     * @param job[out] Receives the job.
+     * @return True if a job was returned, false if the queue is empty.
+     */
+    bool NextJob(Job& job);
+
+    /**
+     * @brief Records the result of a job.
+     * @param job The finished job.
+     * @param result The job result.
+     */
+    void JobFinished(const Job& job, const Result& result);
+
+    /**
+     * @brief Loads the results of previous runs from the index file, if it exists.
+     */
+    void LoadIndex();
+
+    /**
+     * @brief Writes all results to the index file. Safe to call from several threads at once.
+     * @throws Poco::Exception if the index file could not be written.
+     */
+    void SaveIndex();
+
+    /**
+     * @brief Builds a stable, unique image file name for a preset.
+     * @param presetFile The preset file.
+     * @return The image file name, relative to the output directory.
+     */
+    static std::string ImageFileName(const std::string& presetFile);
+
+    /**
+     * @brief Logs the number of processed jobs and the current throughput.
+     */
+    void ReportProgress();
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "thumbnails" configuration subkey.
+
+    std::string _outputPath; //!< Directory receiving the images and the index.
+    long _jobTimeout{60000}; //!< Time in milliseconds a worker may take for a single job before it's killed.
+
+    Poco::FastMutex _mutex; //!< Protects the job queue, results and counters.
+    Poco::FastMutex _saveMutex; //!< Serializes writing and renaming the index file.
+    std::deque<Job> _jobs; //!< Jobs waiting to be processed.
+    std::map<std::string, Result> _results; //!< Results of this and previous runs, by preset file.
+    size_t _totalJobs{0}; //!< Number of jobs queued in this run.
+    size_t _finishedJobs{0}; //!< Number of jobs finished in this run.
+    size_t _failedJobs{0}; //!< Number of jobs failed in this run.
+    size_t _unsavedResults{0}; //!< Number of results not yet written to the index file.
+
+    Poco::Stopwatch _stopwatch; //!< Measures total run time for the throughput report.
+
+    Poco::Logger& _logger{Poco::Logger::get("ThumbnailGenerator")}; //!< The class logger.
+};
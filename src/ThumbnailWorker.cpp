@@ -0,0 +1,182 @@
+#include "ThumbnailWorker.h"
+
+#include <Poco/Stopwatch.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL_opengl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ThumbnailWorker::ThumbnailWorker()
+    : _config(Poco::Util::Application::instance().config().createView("thumbnails"))
+    , _projectMWrapper(Poco::Util::Application::instance().getSubsystem<ProjectMWrapper>())
+{
+    _width = std::max(16, _config->getInt("width", 256));
+    _height = std::max(16, _config->getInt("height", 144));
+    _fps = std::max(1, _config->getInt("fps", 30));
+    _duration = std::max(0.1, _config->getDouble("duration", 3.0));
+}
+
+int ThumbnailWorker::Run()
+{
+    try
+    {
+        _audioFile.reset(new AudioFile(_config->getString("audioFile")));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f1(_logger, "Cannot start thumbnail worker: %s", ex.displayText());
+        return Poco::Util::Application::EXIT_NOINPUT;
+    }
+
+    auto projectMHandle = _projectMWrapper.ProjectM();
+
+    projectm_set_window_size(projectMHandle, _width, _height);
+    projectm_set_preset_locked(projectMHandle, true);
+    projectm_set_hard_cut_enabled(projectMHandle, false);
+    projectm_set_preset_switch_failed_event_callback(projectMHandle, &ThumbnailWorker::PresetSwitchFailedEvent, this);
+
+    std::string job;
+    while (std::getline(std::cin, job))
+    {
+        auto separator = job.find('\t');
+        if (separator == std::string::npos)
+        {
+            std::cout << "FAIL Malformed job" << std::endl;
+            continue;
+        }
+
+        auto imageFile = job.substr(0, separator);
+        auto presetFile = job.substr(separator + 1);
+
+        Poco::Stopwatch stopwatch;
+        stopwatch.start();
+
+        std::string error;
+        if (RenderThumbnail(presetFile, imageFile, error))
+        {
+            std::cout << "OK " << static_cast<double>(stopwatch.elapsed()) / 1000.0 << std::endl;
+        }
+        else
+        {
+            poco_warning_f2(_logger, R"(Could not render thumbnail for preset "%s": %s)", presetFile, error);
+            std::cout << "FAIL " << error << std::endl;
+        }
+    }
+
+    projectm_set_preset_switch_failed_event_callback(projectMHandle, nullptr, nullptr);
+
+    return Poco::Util::Application::EXIT_OK;
+}
+
+bool ThumbnailWorker::RenderThumbnail(const std::string& presetFile, const std::string& imageFile, std::string& error)
+{
+    auto projectMHandle = _projectMWrapper.ProjectM();
+
+    _loadFailed = false;
+    projectm_load_preset_file(projectMHandle, presetFile.c_str(), false);
+    if (_loadFailed)
+    {
+        error = _loadError;
+        return false;
+    }
+
+    int frameCount = std::max(1, static_cast<int>(_duration * _fps));
+    size_t samplesPerFrame = AudioFile::SampleRate / _fps;
+
+    // Sample a few frames from the second half, where the preset has settled, and keep the most detailed one.
+    std::vector<int> candidateFrames{frameCount / 2, frameCount * 3 / 4, frameCount - 1};
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(_width) * _height * 4);
+    std::vector<uint8_t> bestPixels;
+    double bestDetail{-1.0};
+
+    // Every preset gets the same audio, so thumbnails are comparable and reproducible.
+    size_t audioPosition{0};
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        _audioFile->AddToProjectM(projectMHandle, audioPosition, samplesPerFrame);
+
+        glClearColor(0.0, 0.0, 0.0, 0.0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        projectm_opengl_render_frame(projectMHandle);
+
+        if (std::find(candidateFrames.begin(), candidateFrames.end(), frame) == candidateFrames.end())
+        {
+            continue;
+        }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        double detail = ImageDetail(pixels);
+        if (detail > bestDetail)
+        {
+            bestDetail = detail;
+            bestPixels = pixels;
+        }
+    }
+
+    if (!SaveImage(bestPixels, imageFile))
+    {
+        error = "Could not write image file: " + std::string(SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+double ThumbnailWorker::ImageDetail(const std::vector<uint8_t>& pixels)
+{
+    double sum{0.0};
+    double squareSum{0.0};
+    size_t pixelCount = pixels.size() / 4;
+
+    for (size_t pixel = 0; pixel < pixelCount; pixel++)
+    {
+        double luminance = 0.299 * pixels[pixel * 4] + 0.587 * pixels[pixel * 4 + 1] + 0.114 * pixels[pixel * 4 + 2];
+        sum += luminance;
+        squareSum += luminance * luminance;
+    }
+
+    double mean = sum / static_cast<double>(pixelCount);
+    return squareSum / static_cast<double>(pixelCount) - mean * mean;
+}
+
+bool ThumbnailWorker::SaveImage(std::vector<uint8_t>& pixels, const std::string& fileName) const
+{
+    // OpenGL returns the bottom row first, images are stored top row first.
+    size_t rowLength = static_cast<size_t>(_width) * 4;
+    std::vector<uint8_t> row(rowLength);
+    for (int y = 0; y < _height / 2; y++)
+    {
+        auto top = pixels.data() + y * rowLength;
+        auto bottom = pixels.data() + (_height - 1 - y) * rowLength;
+        std::memcpy(row.data(), top, rowLength);
+        std::memcpy(top, bottom, rowLength);
+        std::memcpy(bottom, row.data(), rowLength);
+    }
+
+    auto surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), _width, _height, 32,
+                                                      static_cast<int>(rowLength), SDL_PIXELFORMAT_RGBA32);
+    if (!surface)
+    {
+        return false;
+    }
+
+    bool success = SDL_SaveBMP(surface, fileName.c_str()) == 0;
+    SDL_FreeSurface(surface);
+
+    return success;
+}
+
+void ThumbnailWorker::PresetSwitchFailedEvent(POCO_UNUSED const char* presetFilename, const char* message, void* context)
+{
+    auto that = reinterpret_cast<ThumbnailWorker*>(context);
+    that->_loadFailed = true;
+    that->_loadError = message ? message : "Unknown error";
+}
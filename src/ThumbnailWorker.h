@@ -0,0 +1,85 @@
+#pragma once
+
+#include "AudioFile.h"
+#include "ProjectMWrapper.h"
+#include "SDLRenderingWindow.h"
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Headless worker process for the batch thumbnail generator.
+ *
+ * Reads jobs from standard input, one per line in the form "<image file><TAB><preset file>". For each job,
+ * the preset is rendered for a few seconds of the reference audio file, and the most detailed of a few
+ * sampled frames is stored as a BMP image. A result line is written to standard output for each job,
+ * either "OK <milliseconds>" or "FAIL <message>". The worker exits when standard input is closed.
+ *
+ * Uses the application's hidden rendering window and projectM instance. Note that projectM animates presets
+ * using wall-clock time, so on slow renderers fewer frames are rendered within the same preset time.
+ */
+class ThumbnailWorker
+{
+public:
+    ThumbnailWorker();
+
+    /**
+     * @brief Processes jobs until standard input is closed.
+     * @return The application exit code.
+     */
+    int Run();
+
+protected:
+    /**
+     * @brief Renders a single preset and stores the thumbnail image.
+     * @param presetFile The preset file to render.
+     * @param imageFile The image file to write.
+     * @param error[out] Receives an error message if rendering failed.
+     * @return True if the thumbnail was written, false on error.
+     */
+    bool RenderThumbnail(const std::string& presetFile, const std::string& imageFile, std::string& error);
+
+    /**
+     * @brief Calculates the luminance variance of an image, used to pick the most interesting frame.
+     * @param pixels RGBA pixel data.
+     * @return The luminance variance.
+     */
+    static double ImageDetail(const std::vector<uint8_t>& pixels);
+
+    /**
+     * @brief Writes RGBA pixel data read from OpenGL into a BMP file.
+     * @param pixels RGBA pixel data, bottom row first.
+     * @param fileName The file to write.
+     * @return True if the image was written successfully.
+     */
+    bool SaveImage(std::vector<uint8_t>& pixels, const std::string& fileName) const;
+
+    /**
+     * @brief projectM callback. Called if a preset could not be loaded.
+     * @param presetFilename The preset file which failed to load.
+     * @param message The error message.
+     * @param context Callback context, e.g. "this" pointer.
+     */
+    static void PresetSwitchFailedEvent(const char* presetFilename, const char* message, void* context);
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "thumbnails" configuration subkey.
+
+    ProjectMWrapper& _projectMWrapper; //!< The projectM instance used for rendering.
+
+    std::unique_ptr<AudioFile> _audioFile; //!< The reference audio.
+
+    int _width{256}; //!< Thumbnail width.
+    int _height{144}; //!< Thumbnail height.
+    int _fps{30}; //!< Frames rendered per second of audio.
+    double _duration{3.0}; //!< Rendered audio duration in seconds.
+
+    bool _loadFailed{false}; //!< Set by PresetSwitchFailedEvent().
+    std::string _loadError; //!< Error message reported by PresetSwitchFailedEvent().
+
+    Poco::Logger& _logger{Poco::Logger::get("ThumbnailWorker")}; //!< The class logger.
+};
@@ -0,0 +1,225 @@
+#include "Tracer.h"
+
+#include <Poco/Clock.h>
+#include <Poco/Format.h>
+#include <Poco/Process.h>
+
+#include <Poco/JSON/Object.h>
+
+std::atomic<bool> Tracer::_enabled{false};
+
+Tracer& Tracer::Instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+int64_t Tracer::Now()
+{
+    return Poco::Clock().microseconds();
+}
+
+void Tracer::Start(const std::string& traceFile)
+{
+    if (_enabled)
+    {
+        return;
+    }
+
+    _output.reset(new Poco::FileOutputStream(traceFile));
+    *_output << R"({"displayTimeUnit":"ms","traceEvents":[)" << "\n";
+    _firstEvent = true;
+
+    _startTime = Now();
+    _mainThreadId = Poco::Thread::currentTid();
+    _processId = static_cast<uint32_t>(Poco::Process::id());
+
+    // Discard anything left over from a previous run.
+    {
+        Poco::FastMutex::ScopedLock lock(_buffersMutex);
+        for (auto& buffer : _buffers)
+        {
+            buffer->_readIndex.store(buffer->_writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->_droppedEvents = 0;
+        }
+    }
+
+    _stopEvent.reset();
+    _writerThread.start(*this);
+
+    _enabled = true;
+
+    poco_information_f1(_logger, R"(Writing trace events to "%s".)", traceFile);
+}
+
+void Tracer::Stop()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _enabled = false;
+
+    _stopEvent.set();
+    _writerThread.join();
+
+    Flush();
+
+    // Name the threads, and the process.
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+    uint32_t droppedEvents{0};
+    for (const auto& buffer : _buffers)
+    {
+        Poco::JSON::Object::Ptr args = new Poco::JSON::Object;
+        args->set("name", buffer->_threadName);
+
+        Poco::JSON::Object metadata;
+        metadata.set("name", "thread_name");
+        metadata.set("ph", "M");
+        metadata.set("pid", _processId);
+        metadata.set("tid", buffer->_threadId);
+        metadata.set("args", args);
+
+        *_output << (_firstEvent ? "" : ",\n");
+        metadata.stringify(*_output);
+        _firstEvent = false;
+
+        droppedEvents += buffer->_droppedEvents;
+    }
+
+    *_output << "\n]}\n";
+    _output->close();
+    _output.reset();
+
+    if (droppedEvents > 0)
+    {
+        poco_warning_f1(_logger, "Dropped %?u trace events, as they were recorded faster than written.", droppedEvents);
+    }
+
+    poco_information(_logger, "Stopped tracing.");
+}
+
+void Tracer::Complete(const char* name, const char* category, int64_t start, int64_t duration)
+{
+    Record({name, category, start, duration});
+}
+
+void Tracer::Instant(const char* name, const char* category)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+
+    Record({name, category, Now(), -1});
+}
+
+void Tracer::run()
+{
+    while (!_stopEvent.tryWait(200))
+    {
+        Flush();
+    }
+}
+
+Tracer::ThreadBuffer& Tracer::CurrentThreadBuffer(const char* category)
+{
+    static thread_local ThreadBuffer* threadBuffer{nullptr};
+
+    if (threadBuffer)
+    {
+        return *threadBuffer;
+    }
+
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    buffer->_threadId = static_cast<uint32_t>(_buffers.size() + 1);
+
+    auto* pocoThread = Poco::Thread::current();
+    if (pocoThread)
+    {
+        buffer->_threadName = pocoThread->getName();
+    }
+    else if (Poco::Thread::currentTid() == _mainThreadId)
+    {
+        buffer->_threadName = "Main";
+    }
+    else
+    {
+        // Threads created by libraries, e.g. SDL's audio thread.
+        buffer->_threadName = Poco::format("Thread %?u (%s)", buffer->_threadId, std::string(category));
+    }
+
+    threadBuffer = buffer.get();
+    _buffers.push_back(std::move(buffer));
+
+    return *threadBuffer;
+}
+
+void Tracer::Record(const Event& event)
+{
+    auto& buffer = CurrentThreadBuffer(event._category);
+
+    auto writeIndex = buffer._writeIndex.load(std::memory_order_relaxed);
+    auto readIndex = buffer._readIndex.load(std::memory_order_acquire);
+
+    if (writeIndex - readIndex >= ThreadBuffer::Capacity)
+    {
+        buffer._droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer._events[writeIndex % ThreadBuffer::Capacity] = event;
+    buffer._writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void Tracer::Flush()
+{
+    // Copy the list, so threads recording their first event aren't blocked while writing.
+    std::vector<ThreadBuffer*> buffers;
+    {
+        Poco::FastMutex::ScopedLock lock(_buffersMutex);
+        for (const auto& buffer : _buffers)
+        {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    for (auto* buffer : buffers)
+    {
+        auto writeIndex = buffer->_writeIndex.load(std::memory_order_acquire);
+        auto readIndex = buffer->_readIndex.load(std::memory_order_relaxed);
+
+        for (; readIndex != writeIndex; readIndex++)
+        {
+            const auto& event = buffer->_events[readIndex % ThreadBuffer::Capacity];
+
+            Poco::JSON::Object traceEvent;
+            traceEvent.set("name", event._name);
+            traceEvent.set("cat", event._category);
+            traceEvent.set("pid", _processId);
+            traceEvent.set("tid", buffer->_threadId);
+            traceEvent.set("ts", event._start - _startTime);
+            if (event._duration >= 0)
+            {
+                traceEvent.set("ph", "X");
+                traceEvent.set("dur", event._duration);
+            }
+            else
+            {
+                traceEvent.set("ph", "i");
+                traceEvent.set("s", "t");
+            }
+
+            *_output << (_firstEvent ? "" : ",\n");
+            traceEvent.stringify(*_output);
+            _firstEvent = false;
+        }
+
+        buffer->_readIndex.store(writeIndex, std::memory_order_release);
+    }
+
+    _output->flush();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <Poco/Event.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records timed zones and writes them into a Chrome trace event JSON file, e.g. to be loaded into Perfetto.
+ *
+ * Each thread writes its events into its own lock-free ring buffer, so recording never blocks. A background
+ * thread drains all buffers a few times per second and appends the events to the trace file. If a buffer fills up
+ * faster than it is drained, new events are dropped and counted.
+ *
+ * Zones are recorded with the TRACE_ZONE() macro. While tracing is disabled, a zone only reads an atomic flag.
+ */
+class Tracer : public Poco::Runnable
+{
+public:
+    /**
+     * @brief Returns the global tracer instance.
+     * @return The tracer.
+     */
+    static Tracer& Instance();
+
+    /**
+     * @brief Returns whether tracing is currently enabled.
+     * @return True if zones are recorded.
+     */
+    static bool Enabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the current time in microseconds, as used for trace events.
+     * @return The monotonic clock time in microseconds.
+     */
+    static int64_t Now();
+
+    /**
+     * @brief Creates the trace file and starts recording.
+     * @param traceFile The trace file to write.
+     * @throws Poco::FileException if the file can't be created.
+     */
+    void Start(const std::string& traceFile);
+
+    /**
+     * @brief Stops recording, writes all remaining events and closes the trace file.
+     */
+    void Stop();
+
+    /**
+     * @brief Records a completed zone.
+     * @param name Zone name. Must be a string literal, as only the pointer is stored.
+     * @param category Zone category. Must be a string literal.
+     * @param start Start time, as returned by Now().
+     * @param duration Duration in microseconds.
+     */
+    void Complete(const char* name, const char* category, int64_t start, int64_t duration);
+
+    /**
+     * @brief Records a single point in time, if tracing is enabled.
+     * @param name Event name. Must be a string literal, as only the pointer is stored.
+     * @param category Event category. Must be a string literal.
+     */
+    void Instant(const char* name, const char* category);
+
+    /**
+     * @brief Writer thread entry point.
+     */
+    void run() override;
+
+protected:
+    /**
+     * @brief A recorded trace event.
+     */
+    struct Event {
+        const char* _name{nullptr}; //!< Event name.
+        const char* _category{nullptr}; //!< Event category.
+        int64_t _start{0}; //!< Start time in microseconds.
+        int64_t _duration{-1}; //!< Duration in microseconds, -1 for instant events.
+    };
+
+    /**
+     * @brief Single-producer, single-consumer ring buffer of one thread's events.
+     */
+    struct ThreadBuffer {
+        static constexpr uint32_t Capacity{16384}; //!< Maximum number of buffered events.
+
+        std::string _threadName; //!< Thread name shown in the trace.
+        uint32_t _threadId{0}; //!< Thread ID used in the trace.
+        std::atomic<uint32_t> _writeIndex{0}; //!< Next event to write. Only changed by the owning thread.
+        std::atomic<uint32_t> _readIndex{0}; //!< Next event to read. Only changed by the writer thread.
+        std::atomic<uint32_t> _droppedEvents{0}; //!< Number of events dropped because the buffer was full.
+        Event _events[Capacity]; //!< The ring buffer.
+    };
+
+    Tracer() = default;
+
+    /**
+     * @brief Returns the calling thread's buffer, creating it on first use.
+     * @param category Category of the first event, used to name threads not created by Poco.
+     * @return The thread's event buffer.
+     */
+    ThreadBuffer& CurrentThreadBuffer(const char* category);
+
+    /**
+     * @brief Adds an event to the calling thread's buffer.
+     * @param event The event to add.
+     */
+    void Record(const Event& event);
+
+    /**
+     * @brief Drains all thread buffers into the trace file.
+     */
+    void Flush();
+
+    static std::atomic<bool> _enabled; //!< True while recording.
+
+    Poco::FastMutex _buffersMutex; //!< Protects _buffers. Only locked when a thread records its first event.
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers; //!< Buffers of all threads which recorded events. Never freed while running.
+
+    std::unique_ptr<Poco::FileOutputStream> _output; //!< The trace file.
+    bool _firstEvent{true}; //!< If false, a separator is needed before the next event.
+    int64_t _startTime{0}; //!< Time tracing was started, trace timestamps are relative to it.
+    Poco::Thread::TID _mainThreadId{}; //!< Native ID of the thread which started tracing.
+    uint32_t _processId{0}; //!< Process ID used in the trace.
+
+    Poco::Thread _writerThread{"Trace writer"}; //!< Drains the buffers periodically.
+    Poco::Event _stopEvent; //!< Signals the writer thread to exit.
+
+    Poco::Logger& _logger{Poco::Logger::get("Tracer")}; //!< The class logger.
+};
+
+/**
+ * @brief Records the lifetime of this object as a trace zone. Use TRACE_ZONE() instead of creating it directly.
+ */
+class TraceZone
+{
+public:
+    TraceZone(const char* name, const char* category)
+        : _name(name)
+        , _category(category)
+    {
+        if (Tracer::Enabled())
+        {
+            _start = Tracer::Now();
+        }
+    }
+
+    ~TraceZone()
+    {
+        if (_start >= 0)
+        {
+            Tracer::Instance().Complete(_name, _category, _start, Tracer::Now() - _start);
+        }
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* _name; //!< Zone name.
+    const char* _category; //!< Zone category.
+    int64_t _start{-1}; //!< Start time, or -1 if tracing was disabled when the zone was entered.
+};
+
+#define TRACE_ZONE_CONCAT_INNER(a, b) a##b
+#define TRACE_ZONE_CONCAT(a, b) TRACE_ZONE_CONCAT_INNER(a, b)
+
+/**
+ * @brief Traces the remainder of the current scope.
+ * @param name Zone name, must be a string literal.
+ * @param category Zone category, must be a string literal.
+ */
+#define TRACE_ZONE(name, category) TraceZone TRACE_ZONE_CONCAT(traceZone, __LINE__)(name, category)
@@ -0,0 +1,234 @@
+#include "TransitionBudget.h"
+
+#include "Metrics.h"
+
+#include <Poco/Format.h>
+
+#include <algorithm>
+
+constexpr int TransitionBudget::SettleFrames;
+
+void TransitionBudget::Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config,
+                             projectm_handle projectM, projectm_playlist_handle playlist, int targetFPS)
+{
+    if (!config->getBool("enabled", true) || targetFPS <= 0)
+    {
+        return;
+    }
+
+    _projectM = projectM;
+    _playlist = playlist;
+
+    _frameBudget = 1000000.0 / targetFPS * std::min(1.0, std::max(0.1, config->getDouble("headroom", 0.9)));
+    _hardCutRatio = std::max(1.0, config->getDouble("hardCutRatio", 2.0));
+    _minTransitionDuration = std::max(0.0, config->getDouble("minTransitionDuration", 1.0));
+    _reduceMesh = config->getBool("reduceMesh", true);
+    _meshScale = std::min(1.0, std::max(0.1, config->getDouble("meshScale", 0.5)));
+
+    _transitionDuration = projectm_get_soft_cut_duration(_projectM);
+    projectm_get_mesh_size(_projectM, &_meshWidth, &_meshHeight);
+
+    _presetCosts.clear();
+    _overhead = 0.0;
+    _activePreset.clear();
+    _framesSinceSwitch = 0;
+    _inTransition = false;
+    _adapted = false;
+
+    // Replaces the playlist's own handler, which only plays the next item.
+    projectm_set_preset_switch_requested_event_callback(_projectM, &TransitionBudget::SwitchRequestedEvent, this);
+
+    _enabled = true;
+
+    poco_debug_f1(_logger, "Transition budgeting started, frame budget is %.2f ms.", _frameBudget / 1000.0);
+}
+
+void TransitionBudget::PresetSwitched(const std::string& presetFile, bool isHardCut)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    // A new switch replaces a running soft cut. Adapted settings are kept if the new one was adapted as well.
+    if (isHardCut && _adapted)
+    {
+        RestoreSettings();
+    }
+
+    _activePreset = presetFile;
+    _framesSinceSwitch = 0;
+    _inTransition = !isHardCut;
+    _runningTransitionDuration = projectm_get_soft_cut_duration(_projectM);
+    _transitionStart.update();
+}
+
+void TransitionBudget::FrameFinished(const FlightRecorder::FrameSummary* lastFrame)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    if (_inTransition)
+    {
+        if (static_cast<double>(_transitionStart.elapsed()) < _runningTransitionDuration * 1000000.0)
+        {
+            return;
+        }
+
+        _inTransition = false;
+        _framesSinceSwitch = 0;
+        if (_adapted)
+        {
+            RestoreSettings();
+        }
+    }
+
+    if (!lastFrame || _activePreset.empty() || ++_framesSinceSwitch <= SettleFrames)
+    {
+        return;
+    }
+
+    double cost = lastFrame->_renderTime;
+    if (lastFrame->_gpuTimeValid)
+    {
+        cost = std::max(cost, static_cast<double>(lastFrame->_gpuTime));
+    }
+
+    auto& presetCost = _presetCosts[_activePreset];
+    presetCost = presetCost > 0.0 ? presetCost * 0.9 + cost * 0.1 : cost;
+
+    double overhead = static_cast<double>(lastFrame->_cpuTime - std::min(lastFrame->_cpuTime, lastFrame->_renderTime));
+    _overhead = _overhead > 0.0 ? _overhead * 0.9 + overhead * 0.1 : overhead;
+}
+
+void TransitionBudget::Stop()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    _enabled = false;
+
+    if (_adapted)
+    {
+        RestoreSettings();
+    }
+
+    // Reconnecting restores the playlist's own switch request handler.
+    projectm_playlist_connect(_playlist, _projectM);
+}
+
+void TransitionBudget::SwitchRequestedEvent(bool isHardCut, void* context)
+{
+    auto that = reinterpret_cast<TransitionBudget*>(context);
+    that->SwitchRequested(isHardCut);
+}
+
+void TransitionBudget::SwitchRequested(bool isHardCut)
+{
+    auto activeCost = _presetCosts.find(_activePreset);
+    if (isHardCut || _inTransition || activeCost == _presetCosts.end())
+    {
+        projectm_playlist_play_next(_playlist, isHardCut);
+        return;
+    }
+
+    double predictedCost = _overhead + activeCost->second + NextPresetCost();
+
+    if (predictedCost <= _frameBudget)
+    {
+        projectm_playlist_play_next(_playlist, false);
+        return;
+    }
+
+    if (predictedCost > _frameBudget * _hardCutRatio)
+    {
+        poco_debug(_logger, Poco::format("Predicted transition frame cost %.2f ms exceeds the budget of %.2f ms, "
+                                         "doing a hard cut.",
+                                         predictedCost / 1000.0, _frameBudget / 1000.0));
+        projectm_playlist_play_next(_playlist, true);
+        return;
+    }
+
+    // Shorten the soft cut the more the prediction exceeds the budget, down to the minimum at the hard cut ratio.
+    double overrun = (predictedCost - _frameBudget) / (_frameBudget * _hardCutRatio - _frameBudget);
+    double duration = std::min(_transitionDuration,
+                               _transitionDuration - (_transitionDuration - _minTransitionDuration) * overrun);
+
+    projectm_set_soft_cut_duration(_projectM, duration);
+
+    if (_reduceMesh)
+    {
+        auto meshWidth = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_meshWidth) * _meshScale));
+        auto meshHeight = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_meshHeight) * _meshScale));
+        projectm_set_mesh_size(_projectM, meshWidth, meshHeight);
+        Metrics::Instance().SetMeshSize(meshWidth, meshHeight);
+    }
+
+    _adapted = true;
+
+    poco_debug(_logger, Poco::format("Predicted transition frame cost %.2f ms exceeds the budget of %.2f ms, "
+                                     "shortening the soft cut to %.1f s%s.",
+                                     predictedCost / 1000.0, _frameBudget / 1000.0, duration,
+                                     std::string(_reduceMesh ? " and lowering the mesh size" : "")));
+
+    projectm_playlist_play_next(_playlist, false);
+}
+
+double TransitionBudget::NextPresetCost() const
+{
+    auto playlistSize = projectm_playlist_size(_playlist);
+    if (!projectm_playlist_get_shuffle(_playlist) && playlistSize > 0)
+    {
+        auto nextPresetName = projectm_playlist_item(_playlist, (projectm_playlist_get_position(_playlist) + 1) % playlistSize);
+        if (nextPresetName)
+        {
+            auto nextCost = _presetCosts.find(nextPresetName);
+            projectm_playlist_free_string(nextPresetName);
+
+            if (nextCost != _presetCosts.end())
+            {
+                return nextCost->second;
+            }
+        }
+    }
+
+    // Unknown next preset, assume an average one.
+    double totalCost{0.0};
+    for (const auto& presetCost : _presetCosts)
+    {
+        totalCost += presetCost.second;
+    }
+
+    return totalCost / static_cast<double>(_presetCosts.size());
+}
+
+void TransitionBudget::SetMeshSize(size_t meshWidth, size_t meshHeight)
+{
+    _meshWidth = meshWidth;
+    _meshHeight = meshHeight;
+
+    if (_enabled && _adapted && _reduceMesh)
+    {
+        meshWidth = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_meshWidth) * _meshScale));
+        meshHeight = std::max<size_t>(8, static_cast<size_t>(static_cast<double>(_meshHeight) * _meshScale));
+        projectm_set_mesh_size(_projectM, meshWidth, meshHeight);
+        Metrics::Instance().SetMeshSize(meshWidth, meshHeight);
+    }
+}
+
+void TransitionBudget::RestoreSettings()
+{
+    projectm_set_soft_cut_duration(_projectM, _transitionDuration);
+
+    if (_reduceMesh)
+    {
+        projectm_set_mesh_size(_projectM, _meshWidth, _meshHeight);
+        Metrics::Instance().SetMeshSize(_meshWidth, _meshHeight);
+    }
+
+    _adapted = false;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "FlightRecorder.h"
+
+#include <projectM-4/playlist.h>
+#include <projectM-4/projectM.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @brief Adapts automatic preset transitions so soft cuts stay within the frame budget.
+ *
+ * During a soft cut, projectM renders both the outgoing and the incoming preset, so a frame costs roughly as much
+ * as both presets together. This controller learns the render cost of each preset while it's displayed alone and
+ * takes over projectM's automatic switch requests from the playlist. Before each automatic switch, it predicts the
+ * transition frame cost from the costs of the active and the next preset:
+ *
+ * - If the prediction fits the budget, the switch is done as configured.
+ * - If it exceeds the budget, the soft cut is shortened and the mesh size is lowered until the transition ends.
+ * - If it exceeds the budget by more than the hard cut ratio, a hard cut is done instead.
+ *
+ * With shuffle enabled, the next preset isn't known, so the mean cost of all measured presets is used instead.
+ * Preset costs are taken from the flight recorder, so nothing is adapted if it's disabled.
+ *
+ * Configured via the "transitionBudget" configuration subkey.
+ */
+class TransitionBudget
+{
+public:
+    TransitionBudget() = default;
+
+    /**
+     * @brief Takes over automatic switch requests and starts measuring preset costs.
+     *
+     * Until this is called, all other methods do nothing. Does nothing if "enabled" is false in the configuration.
+     *
+     * @param config View of the "transitionBudget" configuration subkey.
+     * @param projectM The projectM instance whose transitions are adapted.
+     * @param playlist The playlist connected to the projectM instance.
+     * @param targetFPS The target frame rate, defining the frame budget.
+     */
+    void Start(const Poco::AutoPtr<Poco::Util::AbstractConfiguration>& config,
+               projectm_handle projectM, projectm_playlist_handle playlist, int targetFPS);
+
+    /**
+     * @brief Remembers a preset switch and whether it started a soft cut.
+     * @param presetFile The file of the new preset.
+     * @param isHardCut True if the switch was a hard cut.
+     */
+    void PresetSwitched(const std::string& presetFile, bool isHardCut);
+
+    /**
+     * @brief Updates the cost of the active preset and ends an adapted transition once it's done.
+     * @param lastFrame Timings of the finished frame, or nullptr if none were measured.
+     */
+    void FrameFinished(const FlightRecorder::FrameSummary* lastFrame);
+
+    /**
+     * @brief Changes the mesh size restored after over-budget transitions, e.g. when the power governor lowers it.
+     *
+     * If a transition is currently adapted, the reduced mesh size is recalculated from the new size.
+     *
+     * @param meshWidth The new mesh width.
+     * @param meshHeight The new mesh height.
+     */
+    void SetMeshSize(size_t meshWidth, size_t meshHeight);
+
+    /**
+     * @brief Restores the configured transition settings and hands switch requests back to the playlist.
+     */
+    void Stop();
+
+protected:
+    /**
+     * @brief projectM callback. Called when projectM requests an automatic preset switch.
+     * @param isHardCut True if projectM requested a hard cut.
+     * @param context Callback context, the "this" pointer.
+     */
+    static void SwitchRequestedEvent(bool isHardCut, void* context);
+
+    /**
+     * @brief Switches to the next playlist item, adapting the transition to the predicted cost.
+     * @param isHardCut True if projectM requested a hard cut.
+     */
+    void SwitchRequested(bool isHardCut);
+
+    /**
+     * @brief Estimates the render cost of the preset the playlist switches to next.
+     * @return The estimated cost in microseconds.
+     */
+    double NextPresetCost() const;
+
+    /**
+     * @brief Restores the configured soft cut duration and mesh size after an adapted transition.
+     */
+    void RestoreSettings();
+
+    static constexpr int SettleFrames{10}; //!< Frames after a switch which aren't used to measure the preset cost.
+
+    bool _enabled{false}; //!< True while adapting transitions.
+    projectm_handle _projectM{nullptr}; //!< The projectM instance.
+    projectm_playlist_handle _playlist{nullptr}; //!< The playlist switching presets.
+
+    double _frameBudget{0.0}; //!< Usable frame time in microseconds.
+    double _hardCutRatio{0.0}; //!< Predicted cost over budget ratio above which a hard cut is done instead.
+    double _minTransitionDuration{0.0}; //!< Shortest soft cut duration in seconds.
+    bool _reduceMesh{false}; //!< If true, the mesh size is lowered during over-budget transitions.
+    double _meshScale{0.0}; //!< Factor applied to the mesh size during over-budget transitions.
+
+    double _transitionDuration{0.0}; //!< Configured soft cut duration in seconds.
+    size_t _meshWidth{0}; //!< Mesh width outside of adapted transitions.
+    size_t _meshHeight{0}; //!< Mesh height outside of adapted transitions.
+
+    std::map<std::string, double> _presetCosts; //!< Smoothed render cost in microseconds, by preset file.
+    double _overhead{0.0}; //!< Smoothed CPU time per frame spent outside of projectM's rendering.
+    std::string _activePreset; //!< File of the active preset, empty if unknown.
+    int _framesSinceSwitch{0}; //!< Frames rendered since the last switch.
+
+    bool _inTransition{false}; //!< True while a soft cut is running.
+    bool _adapted{false}; //!< True if the settings were changed for the running soft cut.
+    double _runningTransitionDuration{0.0}; //!< Duration of the running soft cut in seconds.
+    Poco::Clock _transitionStart; //!< Start of the running soft cut.
+
+    Poco::Logger& _logger{Poco::Logger::get("TransitionBudget")}; //!< The class logger.
+};
@@ -0,0 +1,108 @@
+#include "UnixSocketFile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+UnixSocketFile::UnixSocketFile(Poco::Logger& logger)
+    : _logger(logger)
+{
+}
+
+bool UnixSocketFile::Prepare(const std::string& path)
+{
+    _path = path;
+    _claimed = false;
+
+    struct stat fileStatus{};
+    if (lstat(_path.c_str(), &fileStatus) != 0)
+    {
+        if (errno == ENOENT)
+        {
+            return true;
+        }
+
+        poco_error_f2(_logger, R"(Could not check the socket path "%s": %s)", _path, std::string(std::strerror(errno)));
+        return false;
+    }
+
+    if (!S_ISSOCK(fileStatus.st_mode))
+    {
+        poco_error_f1(_logger, R"(Not using "%s" as socket, the file exists and is no socket.)", _path);
+        return false;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+
+    // Non-blocking, so a listener with a full backlog doesn't stall the probe. It still counts as in use.
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+    {
+        poco_error_f1(_logger, "Could not create a socket to probe the socket file: %s", std::string(std::strerror(errno)));
+        return false;
+    }
+    fcntl(probe, F_SETFL, fcntl(probe, F_GETFL) | O_NONBLOCK);
+
+    int result = connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    int error = result == 0 ? 0 : errno;
+    close(probe);
+
+    if (error != ECONNREFUSED)
+    {
+        if (error == 0 || error == EAGAIN || error == EINPROGRESS)
+        {
+            poco_error_f1(_logger, R"(The socket "%s" is in use by another process.)", _path);
+        }
+        else
+        {
+            poco_error_f2(_logger, R"(Could not check if the socket "%s" is still in use: %s)", _path,
+                          std::string(std::strerror(error)));
+        }
+        return false;
+    }
+
+    // Nobody listens on it anymore, so it was left behind by an instance which didn't shut down cleanly.
+    if (unlink(_path.c_str()) != 0 && errno != ENOENT)
+    {
+        poco_error_f2(_logger, R"(Could not remove the stale socket "%s": %s)", _path, std::string(std::strerror(errno)));
+        return false;
+    }
+
+    poco_debug_f1(_logger, R"(Removed the stale socket "%s".)", _path);
+
+    return true;
+}
+
+void UnixSocketFile::Claim()
+{
+    struct stat fileStatus{};
+    if (lstat(_path.c_str(), &fileStatus) == 0 && S_ISSOCK(fileStatus.st_mode))
+    {
+        _claimed = true;
+        _device = fileStatus.st_dev;
+        _inode = fileStatus.st_ino;
+    }
+}
+
+void UnixSocketFile::Remove()
+{
+    if (!_claimed)
+    {
+        return;
+    }
+    _claimed = false;
+
+    struct stat fileStatus{};
+    if (lstat(_path.c_str(), &fileStatus) == 0 && S_ISSOCK(fileStatus.st_mode)
+        && fileStatus.st_dev == _device && fileStatus.st_ino == _inode)
+    {
+        unlink(_path.c_str());
+    }
+}
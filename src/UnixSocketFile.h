@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <sys/types.h>
+
+#include <string>
+
+/**
+ * @brief Manages the file system entry of a listening Unix domain socket.
+ *
+ * Binding fails if the path exists, so a socket file left behind by a crashed instance has to be removed first.
+ * The path is only ever removed if it's a socket nobody listens on anymore, never a regular file at a mistyped path
+ * or the socket of another running instance. On shutdown, the file is only removed if it's still the socket this
+ * instance bound, identified by device and inode, and not one another instance bound at the same path meanwhile.
+ */
+class UnixSocketFile
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param logger Logger receiving the reasons for refusing a path.
+     */
+    explicit UnixSocketFile(Poco::Logger& logger);
+
+    /**
+     * @brief Checks if a socket can be bound at the given path, removing a stale socket file.
+     *
+     * A socket file is stale if connecting to it is refused. Any other outcome of the probe keeps the file.
+     *
+     * @param path The socket path.
+     * @return True if nothing exists at the path anymore.
+     */
+    bool Prepare(const std::string& path);
+
+    /**
+     * @brief Remembers the socket file just created by bind(), so Remove() only deletes this file.
+     */
+    void Claim();
+
+    /**
+     * @brief Removes the socket file if it was claimed and is still the same file.
+     */
+    void Remove();
+
+protected:
+    Poco::Logger& _logger; //!< The logger of the socket's owner.
+
+    std::string _path; //!< The socket path.
+    bool _claimed{false}; //!< True if the file at the path was created by this instance.
+    dev_t _device{0}; //!< Device of the claimed socket file.
+    ino_t _inode{0}; //!< Inode of the claimed socket file.
+};
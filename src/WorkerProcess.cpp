@@ -0,0 +1,214 @@
+#include "WorkerProcess.h"
+
+#include <Poco/Path.h>
+#include <Poco/Timestamp.h>
+
+#include <csignal>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+
+#include <poll.h>
+#endif
+
+WorkerProcess::WorkerProcess(std::string name, std::string command, std::vector<std::string> args,
+                             Poco::Process::Env environment)
+    : _name(std::move(name))
+    , _command(std::move(command))
+    , _args(std::move(args))
+    , _environment(std::move(environment))
+{
+}
+
+WorkerProcess::~WorkerProcess()
+{
+    Stop();
+}
+
+const std::string& WorkerProcess::Name() const
+{
+    return _name;
+}
+
+void WorkerProcess::Start()
+{
+    if (_processHandle)
+    {
+        Kill();
+    }
+
+#ifndef _WIN32
+    // Writing to the pipe of a crashed worker must not terminate the parent process.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    _inputPipe.reset(new Poco::Pipe);
+    _outputPipe.reset(new Poco::Pipe);
+
+    _processHandle.reset(new Poco::ProcessHandle(
+        Poco::Process::launch(_command, _args, Poco::Path::current(), _inputPipe.get(), _outputPipe.get(), nullptr, _environment)));
+
+    _input.reset(new Poco::PipeOutputStream(*_inputPipe));
+    _outputBuffer.clear();
+
+    poco_debug_f2(_logger, "Started %s with process ID %?d.", _name, _processHandle->id());
+}
+
+int WorkerProcess::Stop()
+{
+    if (!_processHandle)
+    {
+        return -1;
+    }
+
+    // Closing stdin tells the worker that no more jobs will follow.
+    _input->close();
+    int exitCode = _processHandle->wait();
+
+    poco_debug_f2(_logger, "%s exited with code %?d.", _name, exitCode);
+
+    _input.reset();
+    _outputBuffer.clear();
+    _processHandle.reset();
+    _inputPipe.reset();
+    _outputPipe.reset();
+
+    return exitCode;
+}
+
+void WorkerProcess::Kill()
+{
+    if (!_processHandle)
+    {
+        return;
+    }
+
+    poco_debug_f2(_logger, "Killing %s (process ID %?d).", _name, _processHandle->id());
+
+    Poco::Process::kill(*_processHandle);
+    _processHandle->wait();
+
+    _input.reset();
+    _outputBuffer.clear();
+    _processHandle.reset();
+    _inputPipe.reset();
+    _outputPipe.reset();
+}
+
+bool WorkerProcess::Running() const
+{
+    return _processHandle && Poco::Process::isRunning(*_processHandle);
+}
+
+long WorkerProcess::ProcessID() const
+{
+    return _processHandle ? static_cast<long>(_processHandle->id()) : 0;
+}
+
+bool WorkerProcess::SendLine(const std::string& line)
+{
+    if (!_input)
+    {
+        return false;
+    }
+
+    *_input << line << std::endl;
+
+    return _input->good();
+}
+
+bool WorkerProcess::ReadLine(std::string& line, long timeout)
+{
+    _timedOut = false;
+
+    if (!_outputPipe)
+    {
+        return false;
+    }
+
+    // The pipe is read directly instead of through a stream, as buffered stream data would hide from the wait.
+    Poco::Timestamp startTime;
+    for (;;)
+    {
+        auto lineEnd = _outputBuffer.find('\n');
+        if (lineEnd != std::string::npos)
+        {
+            line = _outputBuffer.substr(0, lineEnd);
+            _outputBuffer.erase(0, lineEnd + 1);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            return true;
+        }
+
+        if (timeout >= 0)
+        {
+            auto remaining = timeout - static_cast<long>(startTime.elapsed() / 1000);
+            if (remaining <= 0 || !WaitForOutput(remaining))
+            {
+                _timedOut = true;
+                return false;
+            }
+        }
+
+        char buffer[1024];
+        int bytesRead{0};
+        try
+        {
+            bytesRead = _outputPipe->readBytes(buffer, sizeof(buffer));
+        }
+        catch (Poco::Exception&)
+        {
+            return false;
+        }
+
+        if (bytesRead <= 0)
+        {
+            return false;
+        }
+
+        _outputBuffer.append(buffer, static_cast<size_t>(bytesRead));
+    }
+}
+
+bool WorkerProcess::TimedOut() const
+{
+    return _timedOut;
+}
+
+bool WorkerProcess::WaitForOutput(long timeout)
+{
+#ifdef _WIN32
+    // Anonymous pipes can't be waited on, so poll the available byte count.
+    Poco::Timestamp startTime;
+    for (;;)
+    {
+        DWORD available{0};
+        if (!PeekNamedPipe(_outputPipe->readHandle(), nullptr, 0, nullptr, &available, nullptr) || available > 0)
+        {
+            // A broken pipe is reported by the next read.
+            return true;
+        }
+
+        if (startTime.elapsed() / 1000 >= timeout)
+        {
+            return false;
+        }
+
+        Sleep(10);
+    }
+#else
+    pollfd pollFd{_outputPipe->readHandle(), POLLIN, 0};
+    int result;
+    do
+    {
+        result = poll(&pollFd, 1, static_cast<int>(timeout));
+    } while (result < 0 && errno == EINTR);
+
+    // Errors and hangups are reported by the next read as well.
+    return result != 0;
+#endif
+}
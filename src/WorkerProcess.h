@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Poco/Logger.h>
+#include <Poco/Pipe.h>
+#include <Poco/PipeStream.h>
+#include <Poco/Process.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A child process used by the batch modes, controlled via line-based messages on stdin/stdout.
+ *
+ * The child process is a projectMSDL instance running in a worker mode. The parent sends one job per line
+ * on the child's standard input and reads one result line per job from its standard output. Standard error
+ * is inherited, so worker log output ends up in the parent's console.
+ */
+class WorkerProcess
+{
+public:
+    /**
+     * @brief Constructor. Does not launch the process yet.
+     * @param name Worker name used in log messages.
+     * @param command The executable to launch.
+     * @param args The command line arguments.
+     * @param environment Additional environment variables for the child process.
+     */
+    WorkerProcess(std::string name, std::string command, std::vector<std::string> args,
+                  Poco::Process::Env environment);
+
+    /**
+     * @brief Destructor. Stops the process if it's still running.
+     */
+    ~WorkerProcess();
+
+    /**
+     * @brief Returns the worker name.
+     * @return The worker name.
+     */
+    const std::string& Name() const;
+
+    /**
+     * @brief Launches the process. If it's already running, it is killed first.
+     * @throws Poco::SystemException if the process could not be launched.
+     */
+    void Start();
+
+    /**
+     * @brief Closes the child's standard input and waits for it to exit.
+     * @return The process exit code, or -1 if the process wasn't running.
+     */
+    int Stop();
+
+    /**
+     * @brief Kills the child process immediately.
+     */
+    void Kill();
+
+    /**
+     * @brief Returns whether the process is currently running.
+     * @return True if the child process is running.
+     */
+    bool Running() const;
+
+    /**
+     * @brief Returns the child's process ID.
+     * @return The process ID or 0 if the process isn't running.
+     */
+    long ProcessID() const;
+
+    /**
+     * @brief Sends a single line to the child's standard input.
+     * @param line The text to send, without line terminator.
+     * @return True if the line was sent, false if the pipe is broken.
+     */
+    bool SendLine(const std::string& line);
+
+    /**
+     * @brief Reads a single line from the child's standard output.
+     * @param line[out] Receives the text, without line terminator.
+     * @param timeout Longest time to wait for the line in milliseconds, or -1 to block until it's available.
+     * @return True if a line was read, false if the child closed its output, e.g. because it crashed, or if the
+     *         timeout expired. Use TimedOut() to tell both apart.
+     */
+    bool ReadLine(std::string& line, long timeout = -1);
+
+    /**
+     * @brief Returns whether the last ReadLine() call failed because its timeout expired.
+     * @return True if the last read timed out.
+     */
+    bool TimedOut() const;
+
+protected:
+    /**
+     * @brief Waits until the child's standard output has data to read, or was closed.
+     * @param timeout Longest time to wait in milliseconds.
+     * @return True if reading won't block, false if the timeout expired.
+     */
+    bool WaitForOutput(long timeout);
+
+    std::string _name; //!< The worker name.
+    std::string _command; //!< The executable to launch.
+    std::vector<std::string> _args; //!< Command line arguments.
+    Poco::Process::Env _environment; //!< Additional environment variables.
+
+    std::unique_ptr<Poco::ProcessHandle> _processHandle; //!< Handle of the running process.
+    std::unique_ptr<Poco::Pipe> _inputPipe; //!< Pipe connected to the child's standard input.
+    std::unique_ptr<Poco::Pipe> _outputPipe; //!< Pipe connected to the child's standard output.
+    std::unique_ptr<Poco::PipeOutputStream> _input; //!< Stream writing to the child's standard input.
+    std::string _outputBuffer; //!< Data read from the child's standard output, not yet returned as a line.
+    bool _timedOut{false}; //!< True if the last ReadLine() call timed out.
+
+    Poco::Logger& _logger{Poco::Logger::get("WorkerProcess")}; //!< The class logger.
+};
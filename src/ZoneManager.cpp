@@ -0,0 +1,157 @@
+#include "ZoneManager.h"
+
+#include "ProjectMWrapper.h"
+#include "SDLRenderingWindow.h"
+#include "Tracer.h"
+
+#include <Poco/Util/Application.h>
+#include <Poco/Util/LayeredConfiguration.h>
+
+const char* ZoneManager::name() const
+{
+    return "Render Zones";
+}
+
+void ZoneManager::initialize(Poco::Util::Application& app)
+{
+    TRACE_ZONE("ZoneManager::initialize", "init");
+
+    _config = app.config().createView("zones");
+
+    Poco::Util::AbstractConfiguration::Keys zoneNames;
+    _config->keys(zoneNames);
+
+    if (zoneNames.empty())
+    {
+        return;
+    }
+
+    if (app.config().getBool("window.hidden", false))
+    {
+        poco_debug(_logger, "Main window is hidden, not creating any render zones.");
+        return;
+    }
+
+    auto globalPresetPath = app.config().getString("projectM.presetPath", "");
+
+    for (const auto& zoneName : zoneNames)
+    {
+        if (!_config->getBool(zoneName + ".enabled", true))
+        {
+            poco_debug_f1(_logger, R"(Zone "%s" is disabled.)", zoneName);
+            continue;
+        }
+
+        // Zone settings override the global ones, anything not set for the zone is inherited.
+        Poco::AutoPtr<Poco::Util::LayeredConfiguration> zoneConfig(new Poco::Util::LayeredConfiguration);
+        zoneConfig->add(_config->createView(zoneName), 0);
+        zoneConfig->add(Poco::AutoPtr<Poco::Util::AbstractConfiguration>(&app.config(), true), 1);
+
+        bool sharesPresetIndex = zoneConfig->getString("projectM.presetPath", "") == globalPresetPath;
+        if (sharesPresetIndex && _presetIndex.empty())
+        {
+            BuildPresetIndex(app);
+        }
+
+        try
+        {
+            _zones.emplace_back(new RenderZone(zoneName, zoneConfig, sharesPresetIndex ? _presetIndex : _emptyPresetIndex));
+        }
+        catch (Poco::Exception& ex)
+        {
+            poco_error_f2(_logger, R"(Could not create zone "%s": %s)", zoneName, ex.displayText());
+        }
+    }
+
+    // Creating the zone windows changed the current OpenGL context of the main thread.
+    app.getSubsystem<SDLRenderingWindow>().MakeCurrent();
+
+    for (auto& zone : _zones)
+    {
+        zone->Start();
+    }
+
+    poco_information_f1(_logger, "Started %?d additional render zone(s).", _zones.size());
+}
+
+void ZoneManager::uninitialize()
+{
+    for (auto& zone : _zones)
+    {
+        zone->Stop();
+    }
+
+    _zones.clear();
+    _presetIndex.clear();
+}
+
+bool ZoneManager::DispatchEvent(const SDL_Event& event)
+{
+    if (_zones.empty())
+    {
+        return false;
+    }
+
+    uint32_t windowId{0};
+
+    switch (event.type)
+    {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            windowId = event.key.windowID;
+            break;
+
+        case SDL_MOUSEWHEEL:
+            windowId = event.wheel.windowID;
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            windowId = event.button.windowID;
+            break;
+
+        case SDL_MOUSEMOTION:
+            windowId = event.motion.windowID;
+            break;
+
+        case SDL_WINDOWEVENT:
+            windowId = event.window.windowID;
+            break;
+
+        default:
+            return false;
+    }
+
+    for (auto& zone : _zones)
+    {
+        if (zone->WindowID() == windowId)
+        {
+            zone->PushEvent(event);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ZoneManager::BuildPresetIndex(Poco::Util::Application& app)
+{
+    auto playlist = app.getSubsystem<ProjectMWrapper>().Playlist();
+
+    auto presetCount = projectm_playlist_size(playlist);
+    auto presetFiles = projectm_playlist_items(playlist, 0, presetCount);
+    if (!presetFiles)
+    {
+        return;
+    }
+
+    _presetIndex.reserve(presetCount);
+    for (auto presetFile = presetFiles; *presetFile; presetFile++)
+    {
+        _presetIndex.emplace_back(*presetFile);
+    }
+
+    projectm_playlist_free_string_array(presetFiles);
+
+    poco_debug_f1(_logger, "Sharing preset index with %?d items between zones.", _presetIndex.size());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "RenderZone.h"
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+#include <Poco/Util/Subsystem.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Creates and runs additional render zones.
+ *
+ * The main window, projectM instance and audio device form the primary zone. Any additional zones are
+ * configured in the "zones.<name>" subkeys and run on their own threads. Zones share the preset index
+ * of the primary playlist if they use the same preset path, so the library is only scanned once.
+ */
+class ZoneManager : public Poco::Util::Subsystem
+{
+public:
+    const char* name() const override;
+
+    void initialize(Poco::Util::Application& app) override;
+
+    void uninitialize() override;
+
+    /**
+     * @brief Forwards an SDL event to the zone owning the target window.
+     * @param event The event to dispatch.
+     * @return True if the event was forwarded to a zone, false if it should be handled by the main loop.
+     */
+    bool DispatchEvent(const SDL_Event& event);
+
+protected:
+    /**
+     * @brief Copies the primary playlist items into the shared preset index.
+     * @param app The application instance.
+     */
+    void BuildPresetIndex(Poco::Util::Application& app);
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "zones" configuration subkey.
+
+    std::vector<std::string> _presetIndex; //!< Preset files of the primary playlist, shared with all zones.
+    const std::vector<std::string> _emptyPresetIndex; //!< Passed to zones with their own preset path.
+
+    std::vector<std::unique_ptr<RenderZone>> _zones; //!< The additional render zones.
+
+    Poco::Logger& _logger{Poco::Logger::get("ZoneManager")}; //!< The class logger.
+};
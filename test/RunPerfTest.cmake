@@ -0,0 +1,173 @@
+# Replays one session recording and compares the frame time report against a baseline.
+#
+# Expected variables: PROJECTMSDL, SESSION, PRESET_PATH, REALTIME, REPORT, BASELINE, METRICS, TOLERANCE_PERCENT,
+# UPDATE_BASELINE and BASELINE_RUNS, with METRICS as a comma-separated list. See CMakeLists.txt in this directory.
+
+set(replay_args
+        --replay "${SESSION}"
+        --replayReport "${REPORT}"
+        --presetPath "${PRESET_PATH}"
+        )
+
+if(REALTIME)
+    list(APPEND replay_args --replayRealtime 1)
+endif()
+
+string(REPLACE "," ";" METRICS "${METRICS}")
+
+# Replays the session once and stores the report's JSON text in the given variable.
+function(replay_session output_variable)
+    file(REMOVE "${REPORT}")
+
+    execute_process(COMMAND "${PROJECTMSDL}" ${replay_args}
+            RESULT_VARIABLE replay_result
+            )
+
+    if(NOT replay_result EQUAL 0)
+        message(FATAL_ERROR "Replay of \"${SESSION}\" failed: ${replay_result}")
+    endif()
+
+    if(NOT EXISTS "${REPORT}")
+        message(FATAL_ERROR "Replay of \"${SESSION}\" did not write the report \"${REPORT}\".")
+    endif()
+
+    file(READ "${REPORT}" report)
+    set(${output_variable} "${report}" PARENT_SCOPE)
+endfunction()
+
+# Returns true in the given variable if a report or baseline contains the timings of a metric.
+# GPU timings are missing if the driver has no timer queries.
+function(has_metric output_variable json metric)
+    string(JSON metric_type ERROR_VARIABLE json_error TYPE "${json}" ${metric})
+    if(json_error OR NOT metric_type STREQUAL "OBJECT")
+        set(${output_variable} FALSE PARENT_SCOPE)
+    else()
+        set(${output_variable} TRUE PARENT_SCOPE)
+    endif()
+endfunction()
+
+if(UPDATE_BASELINE)
+    # Frame times vary between runs even on the reference machine. The baseline is the median of several runs, and
+    # the tolerance twice the largest deviation above the median observed while recording, but at least 1%.
+    if(NOT BASELINE_RUNS MATCHES "^[0-9]+$" OR BASELINE_RUNS LESS 3)
+        message(FATAL_ERROR "At least 3 runs are needed to record a baseline, got \"${BASELINE_RUNS}\".")
+    endif()
+
+    foreach(run RANGE 1 ${BASELINE_RUNS})
+        replay_session(report_${run})
+    endforeach()
+
+    set(baseline "${report_1}")
+    set(tolerance_hundredths 100)
+    math(EXPR median_index "${BASELINE_RUNS} / 2")
+
+    foreach(metric IN LISTS METRICS)
+        has_metric(metric_measured "${report_1}" ${metric})
+        if(NOT metric_measured)
+            message(STATUS "Metric \"${metric}\" not measured, not recorded.")
+            continue()
+        endif()
+
+        foreach(statistic p50 p99)
+            set(values "")
+            foreach(run RANGE 1 ${BASELINE_RUNS})
+                string(JSON value GET "${report_${run}}" ${metric} ${statistic})
+                list(APPEND values ${value})
+            endforeach()
+
+            list(SORT values COMPARE NATURAL)
+            list(GET values ${median_index} median)
+            list(GET values -1 maximum)
+            string(JSON baseline SET "${baseline}" ${metric} ${statistic} ${median})
+
+            if(median GREATER 0)
+                math(EXPR spread_hundredths "(${maximum} - ${median}) * 20000 / ${median}")
+                if(spread_hundredths GREATER tolerance_hundredths)
+                    set(tolerance_hundredths ${spread_hundredths})
+                endif()
+            endif()
+
+            string(REPLACE ";" ", " value_list "${values}")
+            message(STATUS "${metric}.${statistic}: ${value_list} us, baseline ${median} us")
+        endforeach()
+    endforeach()
+
+    math(EXPR tolerance_integer "${tolerance_hundredths} / 100")
+    math(EXPR tolerance_fraction "${tolerance_hundredths} % 100")
+    if(tolerance_fraction LESS 10)
+        set(tolerance_fraction "0${tolerance_fraction}")
+    endif()
+    set(tolerance "${tolerance_integer}.${tolerance_fraction}")
+
+    string(JSON baseline SET "${baseline}" runs ${BASELINE_RUNS})
+    string(JSON baseline SET "${baseline}" tolerancePercent ${tolerance})
+
+    file(WRITE "${BASELINE}" "${baseline}")
+    message(STATUS "Updated baseline \"${BASELINE}\" from ${BASELINE_RUNS} runs, tolerance ${tolerance}%.")
+    return()
+endif()
+
+replay_session(report)
+
+if(NOT EXISTS "${BASELINE}")
+    # Report only, so the numbers are visible in the test log until a baseline is recorded on the reference machine.
+    foreach(metric IN LISTS METRICS)
+        has_metric(metric_measured "${report}" ${metric})
+        if(metric_measured)
+            string(JSON p50 GET "${report}" ${metric} p50)
+            string(JSON p99 GET "${report}" ${metric} p99)
+            message(STATUS "${metric}: p50 ${p50} us, p99 ${p99} us")
+        endif()
+    endforeach()
+
+    message(STATUS "PERF_TEST_SKIPPED: No baseline \"${BASELINE}\" recorded yet.")
+    return()
+endif()
+
+file(READ "${BASELINE}" baseline)
+
+string(JSON tolerance ERROR_VARIABLE json_error GET "${baseline}" tolerancePercent)
+if(json_error)
+    set(tolerance "${TOLERANCE_PERCENT}")
+endif()
+
+# math() only handles integers, so the tolerance is converted to hundredths of a percent, e.g. "2.5" to 250.
+if(NOT tolerance MATCHES "^([0-9]+)(\\.([0-9]*))?$")
+    message(FATAL_ERROR "Invalid frame time tolerance \"${tolerance}\", expected a non-negative number of percent.")
+endif()
+set(tolerance_integer "${CMAKE_MATCH_1}")
+set(tolerance_fraction "${CMAKE_MATCH_3}00")
+string(SUBSTRING "${tolerance_fraction}" 0 2 tolerance_fraction)
+math(EXPR tolerance_hundredths "${tolerance_integer} * 100 + ${tolerance_fraction}")
+
+set(failures "")
+
+foreach(metric IN LISTS METRICS)
+    has_metric(metric_measured "${report}" ${metric})
+    if(NOT metric_measured)
+        message(STATUS "Metric \"${metric}\" not measured, not compared.")
+        continue()
+    endif()
+
+    has_metric(metric_in_baseline "${baseline}" ${metric})
+    if(NOT metric_in_baseline)
+        message(STATUS "Metric \"${metric}\" not in baseline, not compared.")
+        continue()
+    endif()
+
+    foreach(statistic p50 p99)
+        string(JSON measured GET "${report}" ${metric} ${statistic})
+        string(JSON expected GET "${baseline}" ${metric} ${statistic})
+        math(EXPR limit "${expected} * (10000 + ${tolerance_hundredths}) / 10000")
+
+        message(STATUS "${metric}.${statistic}: ${measured} us, baseline ${expected} us, limit ${limit} us")
+
+        if(measured GREATER limit)
+            string(APPEND failures "\n  ${metric}.${statistic} is ${measured} us, more than ${tolerance}% over the baseline of ${expected} us")
+        endif()
+    endforeach()
+endforeach()
+
+if(NOT failures STREQUAL "")
+    message(FATAL_ERROR "Frame time regression in \"${SESSION}\":${failures}")
+endif()
@@ -0,0 +1,284 @@
+/**
+ * @file SessionGenerator.cpp
+ * @brief Writes synthetic session recordings for the performance regression tests.
+ *
+ * Each scenario is a fixed, fully deterministic sequence of audio, viewport changes and preset switches,
+ * using the presets in the given directory. The recordings are replayed with "projectMSDL --replay".
+ *
+ * Usage: projectMSDL-session-generator <scenario> <preset directory> <output file>
+ */
+
+#include "SessionRecorder.h"
+
+#include <Poco/DirectoryIterator.h>
+#include <Poco/Exception.h>
+#include <Poco/Path.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int SampleRate{44100};
+constexpr int Channels{2};
+constexpr int FramesPerSecond{60};
+constexpr double Pi{3.14159265358979323846};
+
+/**
+ * @brief Generates a deterministic test signal with a kick drum on every beat, a slow sine sweep and noise bursts.
+ */
+class SignalGenerator
+{
+public:
+    /**
+     * @brief Appends the next sample frames of the signal.
+     * @param frames Number of sample frames to generate.
+     * @param samples[out] Receives the interleaved stereo samples.
+     */
+    void Generate(unsigned int frames, std::vector<float>& samples)
+    {
+        samples.resize(static_cast<size_t>(frames) * Channels);
+
+        for (unsigned int frame = 0; frame < frames; frame++, _position++)
+        {
+            double time = static_cast<double>(_position) / SampleRate;
+
+            // 120 BPM kick drum, a decaying 60 Hz sine.
+            double beatTime = std::fmod(time, 0.5);
+            double kick = std::sin(2.0 * Pi * 60.0 * beatTime) * std::exp(-beatTime * 12.0);
+
+            // Sweep between 200 Hz and 2 kHz every 8 seconds.
+            double sweepFrequency = 200.0 + 1800.0 * (0.5 + 0.5 * std::sin(2.0 * Pi * time / 8.0));
+            _sweepPhase += 2.0 * Pi * sweepFrequency / SampleRate;
+            double sweep = 0.3 * std::sin(_sweepPhase);
+
+            // Noise burst on the off-beat, like a hi-hat. Fixed-seed LCG, so the signal is identical on all platforms.
+            _noiseState = _noiseState * 1664525u + 1013904223u;
+            double noise = (static_cast<double>(_noiseState >> 8) / 8388608.0 - 1.0);
+            double offBeatTime = std::fmod(time + 0.25, 0.5);
+            double hihat = 0.2 * noise * std::exp(-offBeatTime * 40.0);
+
+            samples[frame * Channels] = static_cast<float>(0.6 * kick + sweep + hihat);
+            samples[frame * Channels + 1] = static_cast<float>(0.6 * kick - sweep + hihat);
+        }
+    }
+
+protected:
+    uint64_t _position{0}; //!< Current position in sample frames.
+    double _sweepPhase{0.0}; //!< Phase of the sine sweep.
+    uint32_t _noiseState{12345}; //!< Noise generator state.
+};
+
+/**
+ * @brief Builds a scenario's recording.
+ */
+class ScenarioWriter
+{
+public:
+    ScenarioWriter(const std::string& outputFile, std::vector<std::string> presets)
+        : _recorder(outputFile)
+        , _presets(std::move(presets))
+    {
+    }
+
+    /**
+     * @brief Steady playback: a new preset with a soft transition every five seconds.
+     * @param frames Number of frames to write.
+     */
+    void Steady(int frames)
+    {
+        _recorder.RecordViewport(1280, 720);
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            if (frame % (FramesPerSecond * 5) == 0)
+            {
+                SwitchPreset(frame == 0);
+            }
+
+            AddAudio(SampleRate / FramesPerSecond);
+            EndFrame(frame);
+        }
+    }
+
+    /**
+     * @brief Audio handoff jitter: audio arrives in device-sized periods and stalls now and then.
+     * @param frames Number of frames to write.
+     */
+    void AudioJitter(int frames)
+    {
+        constexpr unsigned int devicePeriod{1024};
+
+        _recorder.RecordViewport(1280, 720);
+        SwitchPreset(true);
+
+        uint64_t deliveredFrames{0};
+        for (int frame = 0; frame < frames; frame++)
+        {
+            // Every two seconds, no audio arrives for six frames, followed by a burst with all of it.
+            bool stalled = frame % (FramesPerSecond * 2) >= FramesPerSecond * 2 - 6;
+            if (!stalled)
+            {
+                uint64_t dueFrames = static_cast<uint64_t>(frame + 1) * SampleRate / FramesPerSecond;
+                while (deliveredFrames + devicePeriod <= dueFrames)
+                {
+                    AddAudio(devicePeriod);
+                    deliveredFrames += devicePeriod;
+                }
+            }
+
+            EndFrame(frame);
+        }
+    }
+
+    /**
+     * @brief Resize handling: changes the viewport size every 1.5 seconds, including large jumps.
+     * @param frames Number of frames to write.
+     */
+    void Resize(int frames)
+    {
+        const std::vector<std::pair<int, int>> sizes{
+            {1280, 720}, {1920, 1080}, {640, 360}, {1024, 768}, {800, 600}, {1280, 720}};
+
+        SwitchPreset(true);
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            if (frame % (FramesPerSecond * 3 / 2) == 0)
+            {
+                const auto& size = sizes.at(static_cast<size_t>(frame / (FramesPerSecond * 3 / 2)) % sizes.size());
+                _recorder.RecordViewport(size.first, size.second);
+            }
+
+            AddAudio(SampleRate / FramesPerSecond);
+            EndFrame(frame);
+        }
+    }
+
+    /**
+     * @brief Preset loading: a hard cut to the next preset every second.
+     * @param frames Number of frames to write.
+     */
+    void PresetSwitching(int frames)
+    {
+        _recorder.RecordViewport(1280, 720);
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            if (frame % FramesPerSecond == 0)
+            {
+                SwitchPreset(true);
+            }
+
+            AddAudio(SampleRate / FramesPerSecond);
+            EndFrame(frame);
+        }
+    }
+
+    void Finish()
+    {
+        _recorder.Finish();
+    }
+
+protected:
+    /**
+     * @brief Records the frame's time at the fixed frame rate and starts the next frame.
+     * @param frame Index of the finished frame.
+     */
+    void EndFrame(int frame)
+    {
+        _recorder.RecordFrameTime(static_cast<double>(frame) / FramesPerSecond);
+        _recorder.NextFrame();
+    }
+
+    void AddAudio(unsigned int frames)
+    {
+        _signal.Generate(frames, _samples);
+        _recorder.RecordAudio(_samples.data(), frames, Channels);
+    }
+
+    void SwitchPreset(bool hardCut)
+    {
+        _recorder.RecordPresetSwitch(hardCut, _presets.at(_nextPreset));
+        _nextPreset = (_nextPreset + 1) % _presets.size();
+    }
+
+    SessionRecorder _recorder; //!< Writes the recording.
+    std::vector<std::string> _presets; //!< Preset files, used round-robin.
+    size_t _nextPreset{0}; //!< Index of the next preset to switch to.
+    SignalGenerator _signal; //!< The audio signal.
+    std::vector<float> _samples; //!< Sample buffer, reused for each audio chunk.
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <steady|audio_jitter|resize|preset_switching> <preset directory> <output file>" << std::endl;
+        return 1;
+    }
+
+    std::string scenario(argv[1]);
+    std::string presetDirectory(argv[2]);
+    std::string outputFile(argv[3]);
+
+    try
+    {
+        std::vector<std::string> presets;
+        for (Poco::DirectoryIterator it(presetDirectory), end; it != end; ++it)
+        {
+            if (it.path().getExtension() == "milk")
+            {
+                presets.push_back(Poco::Path(it.path()).absolute().toString());
+            }
+        }
+
+        if (presets.empty())
+        {
+            std::cerr << "No presets found in " << presetDirectory << std::endl;
+            return 1;
+        }
+
+        // Directory order is platform-dependent.
+        std::sort(presets.begin(), presets.end());
+
+        ScenarioWriter writer(outputFile, presets);
+
+        if (scenario == "steady")
+        {
+            writer.Steady(FramesPerSecond * 20);
+        }
+        else if (scenario == "audio_jitter")
+        {
+            writer.AudioJitter(FramesPerSecond * 20);
+        }
+        else if (scenario == "resize")
+        {
+            writer.Resize(FramesPerSecond * 18);
+        }
+        else if (scenario == "preset_switching")
+        {
+            writer.PresetSwitching(FramesPerSecond * 15);
+        }
+        else
+        {
+            std::cerr << "Unknown scenario: " << scenario << std::endl;
+            return 1;
+        }
+
+        writer.Finish();
+    }
+    catch (Poco::Exception& ex)
+    {
+        std::cerr << "Could not write session recording: " << ex.displayText() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}